@@ -0,0 +1,83 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <glm/glm.hpp>
+
+/**
+ * Shared helpers of the CPU benchmarks under bench/.
+ *
+ * Every benchmark checks its results against a reference implementation and
+ * returns non-zero on a mismatch, so ctest runs them as tests as well. With
+ * --quick (what ctest passes) they use small sizes and few repeats; the checks
+ * stay the same. Timings are only meaningful in an optimised build.
+ */
+namespace bench {
+
+inline bool isQuick(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0)
+            return true;
+    }
+    return false;
+}
+
+// Fastest of 'repeats' runs in milliseconds: the run least disturbed by the rest of the system
+inline double bestMs(int repeats, const std::function<void()> &body) {
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        const auto start = std::chrono::steady_clock::now();
+        body();
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+// Failed checks so far; main returns non-zero if there are any
+inline int &failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void check(bool condition, const char *what) {
+    if (!condition) {
+        std::fprintf(stderr, "-- FAILED: %s\n", what);
+        failures()++;
+    }
+}
+
+// Frustum of a symmetric perspective camera at 'eye' looking along 'forward' (normalised), in the
+// Camera::extractFrustumPlanes convention: inward unit normals, inside where dot(n, p) + w >= 0
+inline std::array<glm::vec4, 6> frustumPlanes(const glm::vec3 &eye, const glm::vec3 &forward, float halfAngle,
+                                              float near, float far) {
+    const glm::vec3 helper = std::fabs(forward.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    const glm::vec3 right = glm::normalize(glm::cross(forward, helper));
+    const glm::vec3 up = glm::cross(right, forward);
+    const float slope = std::tan(halfAngle);
+
+    // 'offset' moves the plane along its normal; only the near and far planes have one
+    auto plane = [&](const glm::vec3 &normal, float offset) {
+        const glm::vec3 n = glm::normalize(normal);
+        return glm::vec4(n, offset - glm::dot(n, eye));
+    };
+    return {
+        plane(right + forward * slope, 0.0f),
+        plane(-right + forward * slope, 0.0f),
+        plane(up + forward * slope, 0.0f),
+        plane(-up + forward * slope, 0.0f),
+        plane(forward, -near),
+        plane(-forward, far),
+    };
+}
+
+}
@@ -0,0 +1,210 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+// BVH queries (frustum, ray, sphere) against a linear scan over the same boxes, from 10k to 1M objects.
+// Every query result is compared with the scan's, after a serial build, a parallel build, a partial
+// refit and a full refit, so the benchmark checks all four paths as well.
+
+#include <cfloat>
+#include <random>
+#include <vector>
+
+#include "Bench.hpp"
+#include "common/JobSystem.hpp"
+#include "scene/Bvh.hpp"
+
+namespace {
+struct Queries {
+    std::vector<std::array<glm::vec4, 6>> frustums;
+    std::vector<Ray> rays;
+    std::vector<glm::vec4> spheres; // xyz = centre, w = radius
+};
+
+// Boxes of 0.5 to 2 units at a constant density, like a large scene of props
+std::vector<Aabb> makeScene(uint32_t count, float worldSize, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    std::uniform_real_distribution<float> size(0.25f, 1.0f);
+    std::vector<Aabb> boxes(count);
+    for (auto &box : boxes) {
+        const glm::vec3 c(position(rng), position(rng), position(rng));
+        const glm::vec3 e(size(rng), size(rng), size(rng));
+        box = {c - e, c + e};
+    }
+    return boxes;
+}
+
+glm::vec3 randomDirection(std::mt19937 &rng) {
+    std::normal_distribution<float> normal;
+    glm::vec3 d;
+    do {
+        d = glm::vec3(normal(rng), normal(rng), normal(rng));
+    } while (glm::dot(d, d) < 1e-6f);
+    return glm::normalize(d);
+}
+
+Queries makeQueries(uint32_t frustumCount, uint32_t rayCount, uint32_t sphereCount, float worldSize,
+                    std::mt19937 &rng) {
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    Queries queries;
+    for (uint32_t i = 0; i < frustumCount; i++) {
+        const glm::vec3 eye(position(rng), position(rng), position(rng));
+        queries.frustums.push_back(bench::frustumPlanes(eye, randomDirection(rng), 0.5f, 0.1f, worldSize * 0.25f));
+    }
+    for (uint32_t i = 0; i < rayCount; i++) {
+        queries.rays.push_back({glm::vec3(position(rng), position(rng), position(rng)), randomDirection(rng)});
+    }
+    for (uint32_t i = 0; i < sphereCount; i++) {
+        queries.spheres.emplace_back(position(rng), position(rng), position(rng), 8.0f);
+    }
+    return queries;
+}
+
+// Reference results: every box tested on its own
+void scanFrustum(const std::vector<Aabb> &boxes, const std::array<glm::vec4, 6> &planes, std::vector<uint32_t> &out) {
+    for (uint32_t i = 0; i < boxes.size(); i++) {
+        if (testFrustumAabb(planes, boxes[i]) != Containment::Outside)
+            out.push_back(i);
+    }
+}
+
+std::optional<Bvh::RayHit> scanRay(const std::vector<Aabb> &boxes, const Ray &ray) {
+    const glm::vec3 invDirection = 1.0f / ray.direction;
+    std::optional<Bvh::RayHit> best;
+    float bestDistance = FLT_MAX;
+    for (uint32_t i = 0; i < boxes.size(); i++) {
+        float distance;
+        if (intersectRayAabb(ray, invDirection, boxes[i], bestDistance, distance) && distance < bestDistance) {
+            bestDistance = distance;
+            best = Bvh::RayHit{i, distance};
+        }
+    }
+    return best;
+}
+
+void scanSphere(const std::vector<Aabb> &boxes, const glm::vec4 &sphere, std::vector<uint32_t> &out) {
+    for (uint32_t i = 0; i < boxes.size(); i++) {
+        if (intersectSphereAabb(glm::vec3(sphere), sphere.w, boxes[i]))
+            out.push_back(i);
+    }
+}
+
+// Same primitive sets in any order; ray hits at the same distance (ties may pick either box)
+void checkQueries(const Bvh &bvh, const std::vector<Aabb> &boxes, const Queries &queries, const char *stage) {
+    std::vector<uint32_t> expected, actual;
+    bool frustumsMatch = true;
+    for (const auto &planes : queries.frustums) {
+        expected.clear();
+        actual.clear();
+        scanFrustum(boxes, planes, expected);
+        bvh.queryFrustum(planes, actual);
+        std::sort(actual.begin(), actual.end());
+        frustumsMatch &= actual == expected;
+    }
+    bool raysMatch = true;
+    for (const auto &ray : queries.rays) {
+        const auto expectedHit = scanRay(boxes, ray);
+        const auto actualHit = bvh.raycast(ray);
+        raysMatch &= expectedHit.has_value() == actualHit.has_value() &&
+                     (!expectedHit || expectedHit->distance == actualHit->distance);
+    }
+    bool spheresMatch = true;
+    for (const auto &sphere : queries.spheres) {
+        expected.clear();
+        actual.clear();
+        scanSphere(boxes, sphere, expected);
+        bvh.querySphere(glm::vec3(sphere), sphere.w, actual);
+        std::sort(actual.begin(), actual.end());
+        spheresMatch &= actual == expected;
+    }
+
+    char what[128];
+    std::snprintf(what, sizeof(what), "frustum queries match the scan after %s", stage);
+    bench::check(frustumsMatch, what);
+    std::snprintf(what, sizeof(what), "ray queries match the scan after %s", stage);
+    bench::check(raysMatch, what);
+    std::snprintf(what, sizeof(what), "sphere queries match the scan after %s", stage);
+    bench::check(spheresMatch, what);
+}
+
+void run(uint32_t count, bool quick, JobSystem &jobSystem) {
+    std::mt19937 rng(count);
+    // About one box per 64 cubic units, whatever the count
+    const float worldSize = std::cbrt(static_cast<float>(count) * 64.0f);
+    std::vector<Aabb> boxes = makeScene(count, worldSize, rng);
+    const Queries queries = quick ? makeQueries(4, 64, 64, worldSize, rng) : makeQueries(16, 256, 256, worldSize, rng);
+    const int repeats = quick ? 1 : 3;
+
+    Bvh bvh;
+    const double serialBuildMs = bench::bestMs(repeats, [&]() { bvh.build(boxes); });
+    checkQueries(bvh, boxes, queries, "a serial build");
+    const double parallelBuildMs = bench::bestMs(repeats, [&]() { bvh.build(boxes, &jobSystem); });
+    checkQueries(bvh, boxes, queries, "a parallel build");
+
+    // Move 1% of the boxes for the incremental refit, then everything for the full one
+    std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+    std::vector<uint32_t> moved;
+    for (uint32_t i = 0; i < count; i += 100) {
+        const glm::vec3 delta(offset(rng), offset(rng), offset(rng));
+        boxes[i] = {boxes[i].min + delta, boxes[i].max + delta};
+        moved.push_back(i);
+    }
+    const double refitMs = bench::bestMs(1, [&]() { bvh.refit(boxes, moved); });
+    checkQueries(bvh, boxes, queries, "a partial refit");
+    for (auto &box : boxes) {
+        const glm::vec3 delta(offset(rng), offset(rng), offset(rng));
+        box = {box.min + delta, box.max + delta};
+    }
+    const double refitAllMs = bench::bestMs(1, [&]() { bvh.refitAll(boxes); });
+    checkQueries(bvh, boxes, queries, "a full refit");
+
+    // Query timings on a fresh build over the final boxes
+    bvh.build(boxes, &jobSystem);
+    std::vector<uint32_t> out;
+    size_t sink = 0;
+    auto timeQueries = [&](auto &&query, size_t queryCount) {
+        return bench::bestMs(repeats, [&]() {
+            for (size_t q = 0; q < queryCount; q++) {
+                out.clear();
+                query(q);
+                sink += out.size();
+            }
+        }) * 1000.0 / static_cast<double>(queryCount);
+    };
+    const double bvhFrustumUs = timeQueries([&](size_t q) { bvh.queryFrustum(queries.frustums[q], out); },
+                                            queries.frustums.size());
+    const double scanFrustumUs = timeQueries([&](size_t q) { scanFrustum(boxes, queries.frustums[q], out); },
+                                             queries.frustums.size());
+    const double bvhRayUs = timeQueries([&](size_t q) { sink += bvh.raycast(queries.rays[q]).has_value(); },
+                                        queries.rays.size());
+    const double scanRayUs = timeQueries([&](size_t q) { sink += scanRay(boxes, queries.rays[q]).has_value(); },
+                                         queries.rays.size());
+    const double bvhSphereUs = timeQueries([&](size_t q) {
+        bvh.querySphere(glm::vec3(queries.spheres[q]), queries.spheres[q].w, out);
+    }, queries.spheres.size());
+    const double scanSphereUs = timeQueries([&](size_t q) { scanSphere(boxes, queries.spheres[q], out); },
+                                            queries.spheres.size());
+
+    std::printf("-- %8u objects: build %.2f ms serial, %.2f ms on the job system (%u workers + caller)\n", count,
+                serialBuildMs, parallelBuildMs, jobSystem.getThreadCount());
+    std::printf("   refit 1%% %.3f ms, all %.2f ms\n", refitMs, refitAllMs);
+    std::printf("   frustum %10.2f us vs scan %10.2f us (x%.1f)\n", bvhFrustumUs, scanFrustumUs,
+                scanFrustumUs / bvhFrustumUs);
+    std::printf("   ray     %10.2f us vs scan %10.2f us (x%.1f)\n", bvhRayUs, scanRayUs, scanRayUs / bvhRayUs);
+    std::printf("   sphere  %10.2f us vs scan %10.2f us (x%.1f)\n", bvhSphereUs, scanSphereUs,
+                scanSphereUs / bvhSphereUs);
+    if (sink == 0)
+        std::printf("   (no query hit anything)\n");
+}
+}
+
+int main(int argc, char **argv) {
+    const bool quick = bench::isQuick(argc, argv);
+    JobSystem jobSystem;
+    const std::vector<uint32_t> counts = quick ? std::vector<uint32_t>{10000}
+                                               : std::vector<uint32_t>{10000, 100000, 1000000};
+    for (uint32_t count : counts) {
+        run(count, quick, jobSystem);
+    }
+    return bench::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+// Frustum culling throughput (objects/ns) of every ISA path this CPU runs, on the same SoA bounds.
+// Each path's visible list must equal the scalar reference; the only differences allowed are objects
+// lying on a plane to within float rounding, which the paths sum in different orders (AVX2 uses FMA).
+
+#include <random>
+#include <vector>
+
+#include "Bench.hpp"
+#include "scene/Culling.hpp"
+
+namespace {
+// How far inside the frustum an object reaches: the smallest (distance + radius) over the planes, in doubles
+double margin(const culling::SoaBounds &b, const std::array<glm::vec4, 6> &planes, culling::Shape shape,
+              uint32_t i) {
+    double result = 1e30;
+    for (const auto &p : planes) {
+        const double d = double(p.x) * b.centerX[i] + double(p.y) * b.centerY[i] + double(p.z) * b.centerZ[i] + p.w;
+        const double r = shape == culling::Shape::Sphere
+                             ? double(b.radius[i])
+                             : std::fabs(p.x) * double(b.extentX[i]) + std::fabs(p.y) * double(b.extentY[i]) +
+                               std::fabs(p.z) * double(b.extentZ[i]);
+        result = std::min(result, d + r);
+    }
+    return result;
+}
+
+void run(uint32_t count, bool quick) {
+    std::mt19937 rng(count);
+    const float worldSize = std::cbrt(static_cast<float>(count) * 64.0f);
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    std::uniform_real_distribution<float> size(0.25f, 1.0f);
+
+    culling::SoaBounds bounds;
+    bounds.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const glm::vec3 c(position(rng), position(rng), position(rng));
+        const glm::vec3 e(size(rng), size(rng), size(rng));
+        bounds.set(i, {c - e, c + e});
+    }
+
+    // From the middle of the scene along each axis: a typical view sees a few percent of it
+    const glm::vec3 eye(worldSize * 0.5f);
+    const std::array<glm::vec3, 6> directions = {glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+                                                 glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)};
+    std::vector<std::array<glm::vec4, 6>> frustums;
+    for (const auto &direction : directions) {
+        frustums.push_back(bench::frustumPlanes(eye, direction, 0.6f, 0.1f, worldSize * 0.5f));
+    }
+
+    const int repeats = quick ? 1 : 5;
+    std::vector<uint32_t> expected(count), actual(count);
+    for (culling::Shape shape : {culling::Shape::Sphere, culling::Shape::Box}) {
+        for (culling::Isa isa : {culling::Isa::Scalar, culling::Isa::Sse41, culling::Isa::Avx2}) {
+            if (isa > culling::detectIsa())
+                continue;
+
+            uint32_t visible = 0;
+            const double ms = bench::bestMs(repeats, [&]() {
+                visible = 0;
+                for (const auto &planes : frustums)
+                    visible += culling::cullFrustum(bounds, planes, shape, 0, count, actual.data(), isa);
+            });
+
+            // Against the scalar path, frustum by frustum
+            uint32_t boundaryCases = 0;
+            bool match = true;
+            for (const auto &planes : frustums) {
+                const uint32_t expectedCount = culling::cullFrustum(bounds, planes, shape, 0, count, expected.data(),
+                                                                    culling::Isa::Scalar);
+                const uint32_t actualCount = culling::cullFrustum(bounds, planes, shape, 0, count, actual.data(), isa);
+                // Both lists are ascending; walk them together
+                uint32_t e = 0, a = 0;
+                while (e < expectedCount || a < actualCount) {
+                    if (e < expectedCount && a < actualCount && expected[e] == actual[a]) {
+                        e++;
+                        a++;
+                        continue;
+                    }
+                    const bool onlyExpected = a == actualCount || (e < expectedCount && expected[e] < actual[a]);
+                    const uint32_t object = onlyExpected ? expected[e++] : actual[a++];
+                    if (std::fabs(margin(bounds, planes, shape, object)) <= 1e-5 * worldSize)
+                        boundaryCases++;
+                    else
+                        match = false;
+                }
+            }
+
+            const double objectsPerNs = static_cast<double>(count) * frustums.size() / (ms * 1e6);
+            std::printf("-- %8u objects, %-6s %-6s: %6.3f objects/ns (%5.2f%% visible)", count,
+                        shape == culling::Shape::Sphere ? "sphere" : "box", culling::isaName(isa), objectsPerNs,
+                        100.0 * visible / (static_cast<double>(count) * frustums.size()));
+            if (boundaryCases > 0)
+                std::printf(", %u on a plane within rounding", boundaryCases);
+            std::printf("\n");
+
+            char what[96];
+            std::snprintf(what, sizeof(what), "%s visible list matches the scalar path", culling::isaName(isa));
+            bench::check(match, what);
+        }
+    }
+}
+}
+
+int main(int argc, char **argv) {
+    const bool quick = bench::isQuick(argc, argv);
+    std::printf("-- CPU culling: best path %s\n", culling::isaName(culling::detectIsa()));
+    const std::vector<uint32_t> counts = quick ? std::vector<uint32_t>{10000}
+                                               : std::vector<uint32_t>{10000, 100000, 1000000};
+    for (uint32_t count : counts) {
+        run(count, quick);
+    }
+    return bench::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+// Job system overhead and scaling: the cost of scheduling an empty job (from a thread outside the pool,
+// through the injection queue, and from a worker, through its own deque), and parallelFor over a fixed
+// workload with 1 to hardware_concurrency workers. Every job must run exactly once and parallelFor must
+// reproduce the serial result.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Bench.hpp"
+#include "common/JobSystem.hpp"
+
+namespace {
+// Jobs a worker spawns before waiting on them; well below a deque's capacity
+constexpr uint32_t SPAWN_BATCH = 1024;
+
+// A few dozen cycles of integer work per item, so the result is exact in any order
+uint64_t work(size_t i) {
+    uint64_t x = i * 0x9e3779b97f4a7c15ull;
+    for (int round = 0; round < 8; round++) {
+        x ^= x >> 29;
+        x *= 0xbf58476d1ce4e5b9ull;
+    }
+    return x;
+}
+
+// ns per job for 'jobCount' empty jobs submitted from this thread
+double injectedJobNs(JobSystem &jobSystem, uint32_t jobCount, int repeats) {
+    std::atomic<uint32_t> ran{0};
+    const double ms = bench::bestMs(repeats, [&]() {
+        JobCounter counter;
+        for (uint32_t i = 0; i < jobCount; i++)
+            jobSystem.run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+        jobSystem.wait(counter);
+    });
+    bench::check(ran.load() == jobCount * static_cast<uint32_t>(repeats), "every injected job runs exactly once");
+    return ms * 1e6 / jobCount;
+}
+
+// ns per job for 'jobCount' empty jobs spawned by a job, i.e. pushed onto a worker's own deque
+double spawnedJobNs(JobSystem &jobSystem, uint32_t jobCount, int repeats) {
+    std::atomic<uint32_t> ran{0};
+    const double ms = bench::bestMs(repeats, [&]() {
+        JobCounter root;
+        jobSystem.run([&]() {
+            for (uint32_t spawned = 0; spawned < jobCount; spawned += SPAWN_BATCH) {
+                JobCounter batch;
+                for (uint32_t i = spawned; i < std::min(jobCount, spawned + SPAWN_BATCH); i++)
+                    jobSystem.run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &batch);
+                jobSystem.wait(batch);
+            }
+        }, &root);
+        jobSystem.wait(root);
+    });
+    bench::check(ran.load() == jobCount * static_cast<uint32_t>(repeats), "every spawned job runs exactly once");
+    return ms * 1e6 / jobCount;
+}
+
+double parallelForMs(JobSystem &jobSystem, size_t itemCount, size_t grain, uint64_t expected, int repeats) {
+    std::atomic<uint64_t> sum{0};
+    std::atomic<size_t> items{0};
+    bool correct = true;
+    const double ms = bench::bestMs(repeats, [&]() {
+        sum.store(0);
+        items.store(0);
+        jobSystem.parallelFor(itemCount, grain, [&](size_t begin, size_t end) {
+            uint64_t local = 0;
+            for (size_t i = begin; i < end; i++)
+                local += work(i);
+            sum.fetch_add(local, std::memory_order_relaxed);
+            items.fetch_add(end - begin, std::memory_order_relaxed);
+        });
+        correct &= sum.load() == expected && items.load() == itemCount;
+    });
+    bench::check(correct, "parallelFor covers every item once and matches the serial result");
+    return ms;
+}
+}
+
+int main(int argc, char **argv) {
+    const bool quick = bench::isQuick(argc, argv);
+    const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t jobCount = quick ? 10000 : 200000;
+    const size_t itemCount = quick ? (1u << 18) : (1u << 24);
+    const size_t grain = 4096;
+    const int repeats = quick ? 1 : 5;
+
+    uint64_t expected = 0;
+    const double serialMs = bench::bestMs(repeats, [&]() {
+        expected = 0;
+        for (size_t i = 0; i < itemCount; i++)
+            expected += work(i);
+    });
+    std::printf("-- parallelFor: %zu items, grain %zu; serial %.2f ms\n", itemCount, grain, serialMs);
+
+    // In the quick run only the extremes; the checks are the point there
+    std::vector<uint32_t> workerCounts;
+    for (uint32_t workers = 1; workers <= hardwareThreads; workers++) {
+        if (!quick || workers == 1 || workers == hardwareThreads)
+            workerCounts.push_back(workers);
+    }
+
+    for (uint32_t workers : workerCounts) {
+        JobSystem jobSystem(workers);
+        const double injectedNs = injectedJobNs(jobSystem, jobCount, repeats);
+        const double spawnedNs = spawnedJobNs(jobSystem, jobCount, repeats);
+        const double ms = parallelForMs(jobSystem, itemCount, grain, expected, repeats);
+        std::printf("-- %2u workers + caller: empty job %6.0f ns injected, %6.0f ns from a worker; "
+                    "parallelFor %8.2f ms (x%.2f)\n",
+                    workers, injectedNs, spawnedNs, ms, serialMs / ms);
+    }
+    return bench::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+// radix::sort on the calling thread and on the job system against std::sort, over keys shaped like the
+// renderer's draw keys (Renderer::buildDrawList) and over uniformly random keys. Both radix paths must
+// produce exactly the std::sort order.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Bench.hpp"
+#include "common/JobSystem.hpp"
+#include "common/RadixSort.hpp"
+
+namespace {
+enum class KeyShape { Shading, Depth, Random };
+
+const char *shapeName(KeyShape shape) {
+    switch (shape) {
+        case KeyShape::Shading: return "shading";
+        case KeyShape::Depth: return "depth";
+        case KeyShape::Random: return "random";
+    }
+    return "";
+}
+
+// Shading keys: a few shading models, a few hundred materials, about a thousand meshes. Depth keys carry
+// the mesh only. Either way the low 32 bits are the object index, ascending as culling emits them.
+std::vector<uint64_t> makeKeys(KeyShape shape, size_t count) {
+    std::mt19937_64 rng(count);
+    std::vector<uint64_t> keys(count);
+    uint32_t objectIndex = 0;
+    for (auto &key : keys) {
+        objectIndex += 1 + static_cast<uint32_t>(rng() % 3);
+        const uint64_t model = rng() % 3;
+        const uint64_t material = rng() % 300;
+        const uint64_t mesh = rng() % 1200;
+        switch (shape) {
+            case KeyShape::Shading:
+                key = (mesh | (model << 28) | (material << 16)) << 32 | objectIndex;
+                break;
+            case KeyShape::Depth:
+                key = mesh << 32 | objectIndex;
+                break;
+            case KeyShape::Random:
+                key = rng();
+                break;
+        }
+    }
+    return keys;
+}
+}
+
+int main(int argc, char **argv) {
+    const bool quick = bench::isQuick(argc, argv);
+    const std::vector<size_t> sizes = quick ? std::vector<size_t>{100000} : std::vector<size_t>{100000, 1000000};
+    const int repeats = quick ? 1 : 10;
+
+    JobSystem jobSystem;
+    std::printf("-- %u workers + caller; times exclude copying the input\n", jobSystem.getThreadCount());
+
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> scratch;
+    for (size_t size : sizes) {
+        for (KeyShape shape : {KeyShape::Shading, KeyShape::Depth, KeyShape::Random}) {
+            const std::vector<uint64_t> input = makeKeys(shape, size);
+            std::vector<uint64_t> expected = input;
+            std::sort(expected.begin(), expected.end());
+
+            radix::sort(keys = input, scratch);
+            bench::check(keys == expected, "serial radix sort matches std::sort");
+            radix::sort(keys = input, scratch, &jobSystem);
+            bench::check(keys == expected, "parallel radix sort matches std::sort");
+
+            const double copyMs = bench::bestMs(repeats, [&]() { keys = input; });
+            const double stdMs = bench::bestMs(repeats, [&]() {
+                keys = input;
+                std::sort(keys.begin(), keys.end());
+            }) - copyMs;
+            const double serialMs = bench::bestMs(repeats, [&]() { radix::sort(keys = input, scratch); }) - copyMs;
+            const double parallelMs = bench::bestMs(repeats, [&]() {
+                radix::sort(keys = input, scratch, &jobSystem);
+            }) - copyMs;
+            std::printf("-- %7zu %-7s keys: std::sort %7.3f ms, radix %7.3f ms (x%.2f), "
+                        "radix on jobs %7.3f ms (x%.2f)\n",
+                        size, shapeName(shape), stdMs, serialMs, stdMs / serialMs, parallelMs, stdMs / parallelMs);
+        }
+    }
+    return bench::failures() == 0 ? 0 : 1;
+}
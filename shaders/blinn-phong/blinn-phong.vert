@@ -1,30 +0,0 @@
-#version 450
-
-layout (set = 0, binding = 0) uniform UniformBufferObject {
-    mat4 model;
-    mat4 view;
-    mat4 proj;
-} ubo;
-
-layout (location = 0) in vec3 inPosition;
-layout (location = 1) in vec3 inColor;
-layout (location = 2) in vec3 inNormal;
-layout (location = 3) in vec2 inTexCoord;
-
-layout (location = 0) out vec3 fragPos;
-layout (location = 1) out vec3 fragNormal;
-layout (location = 2) out vec3 fragColor;
-
-void main() {
-    vec4 worldPos = ubo.model * vec4(inPosition, 1.0);
-    gl_Position = ubo.proj * ubo.view * worldPos;
-
-    // Pass world-space position for lighting
-    fragPos = worldPos.xyz;
-
-    // Transform normal to world space (using Normal Matrix)
-    fragNormal = mat3(transpose(inverse(ubo.model))) * inNormal;
-
-    // Pass the raw color
-    fragColor = inColor;
-}
\ No newline at end of file
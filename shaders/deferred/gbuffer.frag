@@ -0,0 +1,31 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "frame.glsl"
+#include "material.glsl"
+#include "gbuffer.glsl"
+
+layout (location = 0) in vec3 fragPos;
+layout (location = 1) in vec3 fragNormal;
+layout (location = 2) in vec3 fragColor; // albedo, or lit color for Gouraud
+layout (location = 3) in vec2 fragTexCoord;
+layout (location = 4) in vec4 fragClip;
+layout (location = 5) in vec4 fragPrevClip;
+
+// G-buffer targets, see src/vulkan/GBuffer.hpp; position is not stored, lighting rebuilds it from depth
+layout (location = 0) out vec4 outAlbedo;
+layout (location = 1) out vec2 outNormal;
+layout (location = 2) out uvec4 outMaterial;
+layout (location = 3) out vec2 outVelocity; // stored for the temporal resolve, see src/vulkan/TemporalAA.hpp
+
+void main() {
+    Material material = materials[draw.materialIndex];
+    // materialIndex is a push constant, so this index is dynamically uniform
+    vec3 texel = texture(textures[material.albedoTexture], fragTexCoord).rgb;
+
+    // Gouraud pixels are final here; their lighting pipeline copies the albedo target through
+    outAlbedo = vec4(fragColor * texel, 1.0);
+    outNormal = encodeNormal(normalize(fragNormal));
+    outMaterial = encodeMaterial(material.roughness, material.metalness, draw.materialIndex);
+    outVelocity = motionVector(fragClip, fragPrevClip);
+}
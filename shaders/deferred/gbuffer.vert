@@ -0,0 +1,48 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "frame.glsl"
+#include "material.glsl"
+#include "shadow.glsl"
+#include "lights.glsl"
+#include "lighting.glsl"
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec3 inColor;
+layout (location = 2) in vec3 inNormal;
+layout (location = 3) in vec2 inTexCoord;
+
+layout (location = 0) out vec3 fragPos;
+layout (location = 1) out vec3 fragNormal;
+layout (location = 2) out vec3 fragColor;
+layout (location = 3) out vec2 fragTexCoord;
+layout (location = 4) out vec4 fragClip; // unjittered, for the motion vector
+layout (location = 5) out vec4 fragPrevClip;
+
+void main() {
+    ObjectData object = objects[gl_InstanceIndex];
+    vec4 worldPos = object.model * vec4(inPosition, 1.0);
+    gl_Position = camera.viewProj * worldPos;
+    fragClip = camera.unjitteredViewProj * worldPos;
+    fragPrevClip = camera.prevViewProj * (object.prevModel * vec4(inPosition, 1.0));
+
+    // Transform normal to world space (normal matrix comes from the CPU)
+    vec3 worldNormal = normalize(object.normalMatrix * inNormal);
+
+    fragPos = worldPos.xyz;
+    fragNormal = worldNormal;
+    fragTexCoord = inTexCoord;
+
+    Material material = materials[draw.materialIndex];
+    vec3 albedo = inColor * material.albedo.rgb;
+
+    if (SHADING_MODEL == SHADING_GOURAUD) {
+        // Light (and shadow, single tap) once per vertex; the fragment shader only applies the texture
+        float viewDepth = -(camera.view * worldPos).z;
+        float lit = sampleShadow(worldPos.xyz, worldNormal, viewDepth, 1);
+        fragColor = shadeBlinnPhong(worldNormal, worldPos.xyz, camera.cameraPosition.xyz, albedo, material, lit, 1.0) +
+                    shadeLocalLights(worldNormal, worldPos.xyz, camera.cameraPosition.xyz, albedo, material, 1);
+    } else {
+        fragColor = albedo;
+    }
+}
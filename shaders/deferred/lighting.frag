@@ -0,0 +1,47 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "frame.glsl"
+#include "material.glsl"
+#include "shadow.glsl"
+#include "lights.glsl"
+#include "lighting.glsl"
+#include "gbuffer.glsl"
+#include "ssao.glsl"
+
+// G-buffer of the geometry subpass plus depth, read at this pixel (set 1, see src/vulkan/GBuffer.hpp)
+layout (input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput gAlbedo;
+layout (input_attachment_index = 1, set = 1, binding = 1) uniform subpassInput gNormal;
+layout (input_attachment_index = 2, set = 1, binding = 2) uniform usubpassInput gMaterial;
+layout (input_attachment_index = 3, set = 1, binding = 3) uniform subpassInput gDepth;
+
+layout (location = 0) out vec4 outColor;
+
+void main() {
+    // One pipeline per shading model; the stencil test limits it to that model's pixels
+    vec3 albedo = subpassLoad(gAlbedo).rgb;
+    vec3 N = decodeNormal(subpassLoad(gNormal).xy);
+    uvec4 packedMaterial = subpassLoad(gMaterial);
+    float depth = subpassLoad(gDepth).r;
+    vec3 worldPos = reconstructPosition(gl_FragCoord.xy, depth);
+
+    if (camera.debugView != DEBUG_VIEW_LIT) {
+        outColor = vec4(debugChannel(camera.debugView, albedo, N, decodeRoughness(packedMaterial),
+                                     decodeMetalness(packedMaterial), decodeMaterialId(packedMaterial), worldPos), 1.0);
+        return;
+    }
+    if (SHADING_MODEL == SHADING_GOURAUD) {
+        outColor = vec4(albedo, 1.0);
+        return;
+    }
+
+    // Everything the G-buffer does not carry comes from the material table
+    Material material = materials[decodeMaterialId(packedMaterial)];
+
+    float viewDepth = -(camera.view * vec4(worldPos, 1.0)).z;
+    float lit = sampleShadow(worldPos, N, viewDepth, 3);
+    float occlusion = sampleAmbientOcclusion(gl_FragCoord.xy, viewDepth);
+    vec3 color = shadeBlinnPhong(N, worldPos, camera.cameraPosition.xyz, albedo, material, lit, occlusion) +
+                 shadeTiledLocalLights(gl_FragCoord.xy, N, worldPos, camera.cameraPosition.xyz, albedo, material, 3);
+    outColor = vec4(color, 1.0);
+}
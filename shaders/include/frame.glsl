@@ -0,0 +1,42 @@
+// Per-frame data written through the FrameAllocator.
+// Mirrors ViewUniforms and ObjectData in src/renderer/Uniform.hpp.
+// Both bindings are dynamic descriptors; the offsets select this frame's allocations.
+// Everything derived (inverses, normal matrices) is precomputed on the CPU.
+
+layout (set = 0, binding = 0) uniform ViewUniforms {
+    mat4 view;
+    mat4 proj; // jittered, as rasterized
+    mat4 viewProj;
+    mat4 invView;
+    mat4 invProj;
+    mat4 invViewProj;
+    vec4 cameraPosition;
+    vec4 frustumPlanes[6];
+    vec4 viewport; // xy = render size in pixels, zw = 1 / size
+    vec4 upscale; // xy = render size / target size (scene color UV range), zw = 1 / output size
+    mat4 unjitteredViewProj; // motion vectors: this frame ...
+    mat4 prevViewProj; // ... and the last one, both without jitter
+    vec4 temporal; // xy = jitter in render pixels, z = 1 if the history is valid, w = history read
+    uint debugView; // gbuffer::DebugView, see gbuffer.glsl
+    uvec4 lightTiles; // x = first tile of this frame's slice, y = tiles per row, z = tile size
+    vec4 ambientOcclusion; // x = radius, y = intensity, z = sample count (0 = off), see ssao.glsl
+    vec4 post; // x = bloom threshold, y = bloom intensity, z = exposure adaptation, w = compensation; see post.glsl
+} camera;
+
+struct ObjectData {
+    mat4 model;
+    mat3 normalMatrix;
+    uvec4 drawInfo; // x = mesh firstIndex, y = mesh vertexOffset, z = material; visibility mode only
+    mat4 prevModel; // last frame's model; main pass only
+};
+
+// gl_InstanceIndex includes the batch's firstInstance, so it indexes this directly
+layout (std430, set = 0, binding = 3) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+};
+
+// Screen-space motion of a surface point in UV units (current - previous), from its unjittered clip
+// positions this frame and the last
+vec2 motionVector(vec4 clip, vec4 prevClip) {
+    return (clip.xy / clip.w - prevClip.xy / prevClip.w) * 0.5;
+}
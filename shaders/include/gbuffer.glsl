@@ -0,0 +1,74 @@
+// G-buffer encoding shared by the geometry and lighting subpasses, and the debug views of both
+// render modes. Layout and formats: src/vulkan/GBuffer.hpp.
+
+#define DEBUG_VIEW_LIT 0u
+#define DEBUG_VIEW_ALBEDO 1u
+#define DEBUG_VIEW_NORMAL 2u
+#define DEBUG_VIEW_ROUGHNESS 3u
+#define DEBUG_VIEW_METALNESS 4u
+#define DEBUG_VIEW_MATERIAL_ID 5u
+#define DEBUG_VIEW_DEPTH 6u
+#define DEBUG_VIEW_POSITION 7u
+
+// Octahedral mapping of a unit vector to [-1, 1]^2 (two channels instead of three, near-uniform precision)
+vec2 octWrap(vec2 v) {
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    return n.z >= 0.0 ? n.xy : octWrap(n.xy);
+}
+
+vec3 decodeNormal(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+// r = roughness, g = metalness (8 bit each), ba = 16-bit material ID
+uvec4 encodeMaterial(float roughness, float metalness, uint materialId) {
+    return uvec4(uint(clamp(roughness, 0.0, 1.0) * 255.0 + 0.5), uint(clamp(metalness, 0.0, 1.0) * 255.0 + 0.5),
+                 materialId & 0xffu, (materialId >> 8) & 0xffu);
+}
+
+float decodeRoughness(uvec4 m) { return float(m.r) / 255.0; }
+float decodeMetalness(uvec4 m) { return float(m.g) / 255.0; }
+uint decodeMaterialId(uvec4 m) { return m.b | (m.a << 8); }
+
+// World position of the pixel at 'fragCoord' from its depth-buffer value
+vec3 reconstructPosition(vec2 fragCoord, float depth) {
+    vec2 ndc = fragCoord * camera.viewport.zw * 2.0 - 1.0;
+    vec4 world = camera.invViewProj * vec4(ndc, depth, 1.0);
+    return world.xyz / world.w;
+}
+
+vec3 materialIdColor(uint id) {
+    uint h = id * 2654435761u;
+    return vec3((h >> 8) & 0xffu, (h >> 16) & 0xffu, (h >> 24) & 0xffu) / 255.0;
+}
+
+// One decoded channel; camera.debugView is uniform, so this costs nothing in the lit view
+vec3 debugChannel(uint view, vec3 albedo, vec3 N, float roughness, float metalness, uint materialId, vec3 worldPos) {
+    if (view == DEBUG_VIEW_ALBEDO) {
+        return albedo;
+    }
+    if (view == DEBUG_VIEW_NORMAL) {
+        return N * 0.5 + 0.5;
+    }
+    if (view == DEBUG_VIEW_ROUGHNESS) {
+        return vec3(roughness);
+    }
+    if (view == DEBUG_VIEW_METALNESS) {
+        return vec3(metalness);
+    }
+    if (view == DEBUG_VIEW_MATERIAL_ID) {
+        return materialIdColor(materialId);
+    }
+    if (view == DEBUG_VIEW_DEPTH) {
+        float viewDepth = -(camera.view * vec4(worldPos, 1.0)).z;
+        return vec3(exp(-0.05 * viewDepth));
+    }
+    return fract(worldPos); // DEBUG_VIEW_POSITION
+}
@@ -0,0 +1,83 @@
+// Directional light (direction and shadows from shadow.glsl) plus the local lights
+// from lights.glsl, Blinn-Phong. Used per vertex (Gouraud) or per pixel.
+
+const vec3 LIGHT_COLOR = vec3(1.0, 1.0, 1.0);
+const float AMBIENT_STRENGTH = 0.05;
+
+// 'lit' is the shadow factor from sampleShadow(); ambient is never shadowed, only scaled by 'occlusion'
+// (ambient visibility from ssao.glsl, 1 without it)
+vec3 shadeBlinnPhong(vec3 N, vec3 worldPos, vec3 viewPos, vec3 albedo, Material material, float lit,
+                     float occlusion) {
+    // A. Ambient
+    vec3 ambient = AMBIENT_STRENGTH * occlusion * LIGHT_COLOR;
+
+    // B. Diffuse
+    vec3 lightDir = shadow.lightDirection.xyz;
+    float diff = max(dot(N, lightDir), 0.0);
+    vec3 diffuse = diff * LIGHT_COLOR * 0.4;
+
+    // C. Specular, using the halfway vector
+    vec3 viewDir = normalize(viewPos - worldPos);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(N, halfwayDir), 0.0), material.shininess);
+    vec3 specular = material.specularStrength * spec * LIGHT_COLOR;
+
+    return (ambient + lit * (diffuse + specular)) * albedo;
+}
+
+// One point/spot light with its atlas shadow; 'filterTaps' as in sampleLocalShadow
+vec3 shadeLocalLight(LocalLight light, vec3 N, vec3 worldPos, vec3 viewDir, vec3 albedo, Material material,
+                     int filterTaps) {
+    vec3 toLight = light.positionRange.xyz - worldPos;
+    float distanceSq = dot(toLight, toLight);
+    float range = light.positionRange.w;
+    if (distanceSq >= range * range) {
+        return vec3(0.0);
+    }
+    vec3 L = toLight * inversesqrt(max(distanceSq, 1e-8));
+
+    // Inverse square with a smooth window that reaches zero at the range
+    float ratio = distanceSq / (range * range);
+    float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+    float attenuation = window * window / (distanceSq + 1.0);
+    if (light.directionType.w == LIGHT_TYPE_SPOT) {
+        attenuation *= smoothstep(light.spotShadow.x, light.spotShadow.y, dot(-L, light.directionType.xyz));
+    }
+    if (attenuation <= 0.0) {
+        return vec3(0.0);
+    }
+
+    float diff = max(dot(N, L), 0.0);
+    vec3 halfwayDir = normalize(L + viewDir);
+    float spec = pow(max(dot(N, halfwayDir), 0.0), material.shininess) * material.specularStrength;
+    float lit = sampleLocalShadow(light, worldPos, N, L, filterTaps);
+
+    return (diff * albedo + spec) * light.colorIntensity.rgb * light.colorIntensity.a * attenuation * lit;
+}
+
+// Sum of every point/spot light; per vertex, where there is no screen tile to look up
+vec3 shadeLocalLights(vec3 N, vec3 worldPos, vec3 viewPos, vec3 albedo, Material material, int filterTaps) {
+    vec3 viewDir = normalize(viewPos - worldPos);
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < localLightCount; i++) {
+        result += shadeLocalLight(localLights[i], N, worldPos, viewDir, albedo, material, filterTaps);
+    }
+    return result;
+}
+
+// Same sum over only the lights binned into this pixel's screen tile (see src/renderer/LightBinning.hpp)
+vec3 shadeTiledLocalLights(vec2 fragCoord, vec3 N, vec3 worldPos, vec3 viewPos, vec3 albedo, Material material,
+                           int filterTaps) {
+    vec3 viewDir = normalize(viewPos - worldPos);
+    vec3 result = vec3(0.0);
+    uvec2 mask = lightTileMask(fragCoord);
+    for (uint word = 0u; word < 2u; word++) {
+        uint bits = mask[word];
+        while (bits != 0u) {
+            uint i = word * 32u + uint(findLSB(bits));
+            bits &= bits - 1u;
+            result += shadeLocalLight(localLights[i], N, worldPos, viewDir, albedo, material, filterTaps);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,99 @@
+// Point and spot lights with shadows from the shared atlas.
+// Mirrors LocalLightBuffer in src/renderer/Uniform.hpp; see LocalLightShadows.
+
+#define MAX_LOCAL_LIGHTS 64
+#define LOCAL_SHADOW_VIEWS_PER_LIGHT 6
+#define LIGHT_TYPE_POINT 0.0
+#define LIGHT_TYPE_SPOT 1.0
+
+struct LocalLight {
+    vec4 positionRange;
+    vec4 colorIntensity;
+    vec4 directionType;
+    vec4 spotShadow; // x = cos outer, y = cos inner, z = first shadow view or -1
+};
+
+struct ShadowView {
+    mat4 viewProj;
+    vec4 atlasRect; // xy = offset, zw = scale (atlas UV)
+};
+
+layout (std430, set = 0, binding = 6) readonly buffer LocalLightBuffer {
+    uint localLightCount;
+    LocalLight localLights[MAX_LOCAL_LIGHTS];
+    ShadowView localShadowViews[MAX_LOCAL_LIGHTS * LOCAL_SHADOW_VIEWS_PER_LIGHT];
+};
+
+layout (set = 0, binding = 7) uniform sampler2DShadow shadowAtlas;
+
+// Screen tiles of LIGHT_TILE_SIZE render pixels, one bit per light (x = lights 0..31, y = 32..63).
+// Written by shaders/compute/light_binning.comp, which declares the buffer writable itself.
+#define LIGHT_TILE_SIZE 16u
+
+#ifndef LIGHT_BINNING_PASS
+layout (std430, set = 0, binding = 10) readonly buffer LightTileBuffer {
+    uvec2 lightTileMasks[];
+};
+
+// camera.lightTiles: x = first tile of this frame's slice, y = tiles per row
+uvec2 lightTileMask(vec2 fragCoord) {
+    uvec2 tile = uvec2(fragCoord) / LIGHT_TILE_SIZE;
+    return lightTileMasks[camera.lightTiles.x + tile.y * camera.lightTiles.y + tile.x];
+}
+#endif
+
+// Cube face a point light renders 'toPoint' into: +X, -X, +Y, -Y, +Z, -Z (see LocalLightShadows::computeViews)
+uint pointLightFace(vec3 toPoint) {
+    vec3 a = abs(toPoint);
+    if (a.x >= a.y && a.x >= a.z) {
+        return toPoint.x > 0.0 ? 0u : 1u;
+    }
+    if (a.y >= a.z) {
+        return toPoint.y > 0.0 ? 2u : 3u;
+    }
+    return toPoint.z > 0.0 ? 4u : 5u;
+}
+
+// 1 = lit. 'filterTaps' = 1 samples once (per vertex), 3 does 3x3 PCF.
+float sampleLocalShadow(LocalLight light, vec3 worldPos, vec3 N, vec3 L, int filterTaps) {
+    if (light.spotShadow.z < 0.0) {
+        return 1.0;
+    }
+    uint view = uint(light.spotShadow.z);
+    if (light.directionType.w == LIGHT_TYPE_POINT) {
+        view += pointLightFace(worldPos - light.positionRange.xyz);
+    }
+    ShadowView shadowView = localShadowViews[view];
+
+    // Normal offset proportional to the tile's texel footprint at this distance
+    vec2 atlasSize = vec2(textureSize(shadowAtlas, 0));
+    float tileTexels = shadowView.atlasRect.z * atlasSize.x;
+    float distanceToLight = length(light.positionRange.xyz - worldPos);
+    float texelWorld = 2.0 * distanceToLight / tileTexels;
+    float NdotL = clamp(dot(N, L), 0.0, 1.0);
+    vec3 offsetPos = worldPos + N * texelWorld * (1.0 + 2.0 * (1.0 - NdotL));
+
+    vec4 clip = shadowView.viewProj * vec4(offsetPos, 1.0);
+    if (clip.w <= 0.0) {
+        return 1.0;
+    }
+    vec3 ndc = clip.xyz / clip.w;
+    vec2 tileUv = ndc.xy * 0.5 + 0.5;
+
+    // Keep every tap inside the tile; neighbours belong to other lights
+    vec2 texel = 1.0 / atlasSize;
+    vec2 lo = shadowView.atlasRect.xy + 1.5 * texel;
+    vec2 hi = shadowView.atlasRect.xy + shadowView.atlasRect.zw - 1.5 * texel;
+    vec2 uv = clamp(shadowView.atlasRect.xy + tileUv * shadowView.atlasRect.zw, lo, hi);
+
+    if (filterTaps <= 1) {
+        return texture(shadowAtlas, vec3(uv, ndc.z));
+    }
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            lit += texture(shadowAtlas, vec3(uv + vec2(x, y) * texel, ndc.z));
+        }
+    }
+    return lit / 9.0;
+}
@@ -0,0 +1,33 @@
+// Shared by every shader that reads the material table.
+// Mirrors GpuMaterial in src/system/MaterialSystem.hpp (std430, 48 bytes).
+
+#define MAX_BOUND_TEXTURES 64
+
+#define SHADING_GOURAUD 0u
+#define SHADING_BLINN_PHONG 1u
+
+// Baked per pipeline (see GraphicsPipeline); branches on it fold away at compile time
+layout (constant_id = 0) const uint SHADING_MODEL = SHADING_BLINN_PHONG;
+
+struct Material {
+    vec4 albedo;
+    float specularStrength;
+    float shininess;
+    float roughness;
+    float metalness;
+    uint albedoTexture;
+    uint shadingModel;
+    uint pad0;
+    uint pad1;
+};
+
+layout (std430, set = 0, binding = 2) readonly buffer MaterialTable {
+    Material materials[];
+};
+
+layout (set = 0, binding = 1) uniform sampler2D textures[MAX_BOUND_TEXTURES];
+
+layout (push_constant) uniform DrawConstants {
+    uint materialIndex;
+    uint shadowView; // shadow pass only: cascade, or SHADOW_CASCADE_COUNT + local shadow view
+} draw;
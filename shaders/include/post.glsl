@@ -0,0 +1,53 @@
+// HDR post chain, see src/renderer/PostProcess.hpp. The scene color holds linear radiance; bloom, exposure
+// and the tonemap are applied by the output pass as it writes the swapchain image.
+
+#define BLOOM_MIPS 6
+// Luminance histogram over log2 luminance [MIN_LOG_LUMINANCE, MIN_LOG_LUMINANCE + LOG_LUMINANCE_RANGE];
+// bin 0 holds the black texels, which say nothing about exposure
+#define HISTOGRAM_BINS 256
+#define MIN_LOG_LUMINANCE -10.0
+#define LOG_LUMINANCE_RANGE 16.0
+
+// Written by shaders/compute/hdr_reduce.comp, which declares the buffer writable itself
+#ifndef HDR_REDUCE_PASS
+layout (std430, set = 1, binding = 14) readonly buffer ExposureBuffer {
+    float exposure; // scale applied before the tonemap
+    float averageLuminance;
+    uint groupsDone;
+    uint histogram[HISTOGRAM_BINS];
+};
+
+layout (set = 1, binding = 13) uniform sampler2D bloomTexture;
+
+// The bloom mips at 'renderPos' (render pixels), each a 4-tap tent so the coarse ones do not show their texels.
+// Mip m texel t covers render pixels [t, t + 1) * 2^(m + 1); taps stay inside the mip's rendered region.
+vec3 sampleBloom(vec2 renderPos) {
+    ivec2 renderedMip0 = ivec2((uvec2(camera.viewport.xy) + 1u) / 2u);
+    vec3 bloom = vec3(0.0);
+    for (int mip = 0; mip < BLOOM_MIPS; mip++) {
+        vec2 size = vec2(textureSize(bloomTexture, mip));
+        vec2 rendered = vec2(max(renderedMip0 >> mip, ivec2(1)));
+        vec2 position = renderPos / float(2 << mip);
+        for (int i = 0; i < 4; i++) {
+            vec2 tap = clamp(position + vec2(i & 1, i >> 1) - 0.5, vec2(0.5), rendered - 0.5);
+            bloom += textureLod(bloomTexture, tap / size, float(mip)).rgb;
+        }
+    }
+    return bloom / float(4 * BLOOM_MIPS);
+}
+
+// ACES filmic curve (Narkowicz fit): highlights roll off instead of clipping
+vec3 tonemapAces(vec3 x) {
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+// Scene radiance at 'renderPos' -> display color; the sRGB swapchain format encodes it. Debug views show the
+// G-buffer channels as they are.
+vec3 finishColor(vec3 radiance, vec2 renderPos) {
+    if (camera.debugView != 0u) {
+        return radiance;
+    }
+    vec3 color = radiance + sampleBloom(renderPos) * camera.post.y;
+    return tonemapAces(color * exposure);
+}
+#endif
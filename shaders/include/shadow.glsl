@@ -0,0 +1,57 @@
+// Directional light shadows: cascade selection and filtering.
+// Mirrors ShadowUniforms in src/renderer/Uniform.hpp; see CascadedShadowMap for how the maps are kept.
+
+#define SHADOW_CASCADE_COUNT 4
+
+layout (set = 0, binding = 4) uniform sampler2DArrayShadow shadowMap;
+
+layout (set = 0, binding = 5) uniform ShadowUniforms {
+    mat4 cascadeViewProj[SHADOW_CASCADE_COUNT];
+    vec4 cascadeSplits; // view-space far distance per cascade
+    vec4 cascadeTexelSize; // world units per texel per cascade
+    vec4 lightDirection; // towards the light
+} shadow;
+
+// 1 = lit, 0 = fully shadowed. 'filterTaps' = 1 samples once (per-vertex use), 3 does 3x3 PCF.
+float sampleShadow(vec3 worldPos, vec3 N, float viewDepth, int filterTaps) {
+    // First cascade whose slice contains the point
+    uint cascade = 0u;
+    for (uint i = 0u; i < SHADOW_CASCADE_COUNT - 1u; i++) {
+        cascade += viewDepth > shadow.cascadeSplits[i] ? 1u : 0u;
+    }
+    if (viewDepth > shadow.cascadeSplits[SHADOW_CASCADE_COUNT - 1u]) {
+        return 1.0;
+    }
+
+    // Normal offset grows at grazing angles, where depth bias alone is not enough
+    float NdotL = clamp(dot(N, shadow.lightDirection.xyz), 0.0, 1.0);
+    float texel = shadow.cascadeTexelSize[cascade];
+    vec3 offsetPos = worldPos + N * texel * (1.0 + 2.0 * (1.0 - NdotL));
+
+    vec4 lightClip = shadow.cascadeViewProj[cascade] * vec4(offsetPos, 1.0);
+    vec3 coord = vec3(lightClip.xy * 0.5 + 0.5, lightClip.z);
+
+    // Cached cascades can lag the camera; fall through to the next one if the point left this map
+    if (any(lessThan(coord.xy, vec2(0.0))) || any(greaterThan(coord.xy, vec2(1.0)))) {
+        if (cascade + 1u >= SHADOW_CASCADE_COUNT) {
+            return 1.0;
+        }
+        cascade++;
+        lightClip = shadow.cascadeViewProj[cascade] * vec4(offsetPos, 1.0);
+        coord = vec3(lightClip.xy * 0.5 + 0.5, lightClip.z);
+    }
+
+    if (filterTaps <= 1) {
+        return texture(shadowMap, vec4(coord.xy, float(cascade), coord.z));
+    }
+
+    // 3x3 taps, each a hardware 2x2 comparison when linear filtering is available
+    vec2 texelUv = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texelUv, float(cascade), coord.z));
+        }
+    }
+    return lit / 9.0;
+}
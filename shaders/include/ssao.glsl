@@ -0,0 +1,29 @@
+// Ambient occlusion from the compute passes (src/renderer/AmbientOcclusion.hpp), applied by the deferred
+// lighting. One texel per 2x2 render pixels, centered on the top-left one: r = ambient visibility, g = the
+// view depth it was computed at. Image 0 of the set 1 array holds the blurred result.
+
+layout (set = 1, binding = 11) uniform sampler2D occlusionTextures[2];
+
+// Depth-aware upsampling: the four nearest half-res texels, bilinear weights scaled down by how far each
+// texel's depth is from this pixel's, so occlusion does not bleed across silhouettes. 1 while it is off.
+float sampleAmbientOcclusion(vec2 fragCoord, float viewDepth) {
+    if (camera.ambientOcclusion.z == 0.0) {
+        return 1.0;
+    }
+    vec2 halfPos = (fragCoord - 0.5) * 0.5;
+    ivec2 base = ivec2(floor(halfPos));
+    vec2 f = halfPos - vec2(base);
+    ivec2 halfMax = ivec2((uvec2(camera.viewport.xy) + 1u) / 2u) - 1;
+
+    float sum = 0.0;
+    float weightSum = 0.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        vec2 texel = texelFetch(occlusionTextures[0], clamp(base + offset, ivec2(0), halfMax), 0).rg;
+        vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+        float w = (bilinear.x * bilinear.y + 1e-3) / (abs(texel.g - viewDepth) / viewDepth + 1e-3);
+        sum += texel.r * w;
+        weightSum += w;
+    }
+    return sum / weightSum;
+}
@@ -0,0 +1,56 @@
+// Visibility-buffer decoding: the triangle behind a pixel, fetched again from the shared geometry buffers.
+// Layout and formats: src/vulkan/VisibilityBuffer.hpp. Needs frame.glsl and gbuffer.glsl.
+
+#define VERTEX_STRIDE_FLOATS 11u // sizeof(Vertex) / 4: pos, color, normal, texCoord, see src/renderer/Vertex.hpp
+
+layout (std430, set = 0, binding = 8) readonly buffer VertexData {
+    float vertexData[];
+};
+
+layout (std430, set = 0, binding = 9) readonly buffer IndexData {
+    uint indexData[];
+};
+
+struct VisibleTriangle {
+    vec3 position[3]; // world space
+    vec3 normal[3]; // world space, not normalized
+    vec3 color[3];
+    vec2 texCoord[3];
+};
+
+vec3 fetchVec3(uint base) {
+    return vec3(vertexData[base], vertexData[base + 1u], vertexData[base + 2u]);
+}
+
+// 'primitive' is gl_PrimitiveID of the instanced draw, i.e. the triangle within the mesh
+VisibleTriangle fetchTriangle(ObjectData object, uint primitive) {
+    VisibleTriangle tri;
+    for (uint i = 0u; i < 3u; i++) {
+        uint index = indexData[object.drawInfo.x + primitive * 3u + i];
+        uint base = (uint(int(index) + int(object.drawInfo.y))) * VERTEX_STRIDE_FLOATS;
+        tri.position[i] = (object.model * vec4(fetchVec3(base), 1.0)).xyz;
+        tri.color[i] = fetchVec3(base + 3u);
+        tri.normal[i] = object.normalMatrix * fetchVec3(base + 6u);
+        tri.texCoord[i] = vec2(vertexData[base + 9u], vertexData[base + 10u]);
+    }
+    return tri;
+}
+
+// Barycentrics where the camera ray through 'fragCoord' meets the triangle's plane (Moller-Trumbore).
+// The pixel is known to be covered, so there are no range checks; neighbouring pixels may land
+// outside the triangle, which is what the texture derivatives need.
+vec3 rayBarycentrics(vec2 fragCoord, vec3 p0, vec3 p1, vec3 p2) {
+    vec3 origin = camera.cameraPosition.xyz;
+    vec3 dir = reconstructPosition(fragCoord, 0.0) - origin;
+    vec3 e1 = p1 - p0;
+    vec3 e2 = p2 - p0;
+    vec3 p = cross(dir, e2);
+    float invDet = 1.0 / dot(e1, p);
+    vec3 t = origin - p0;
+    float u = dot(t, p) * invDet;
+    float v = dot(dir, cross(t, e1)) * invDet;
+    return vec3(1.0 - u - v, u, v);
+}
+
+vec2 interpolate(vec2 v[3], vec3 b) { return v[0] * b.x + v[1] * b.y + v[2] * b.z; }
+vec3 interpolate(vec3 v[3], vec3 b) { return v[0] * b.x + v[1] * b.y + v[2] * b.z; }
@@ -0,0 +1,145 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "frame.glsl"
+
+// Temporal resolve, see src/vulkan/TemporalAA.hpp. Inputs in set 1: the jittered scene color and motion
+// vectors (top-left render size valid) and the two history images at output size. The resolve runs on HDR
+// radiance, which the history keeps; only the swapchain output is exposed and tonemapped.
+layout (set = 1, binding = 5) uniform sampler2D sceneColor;
+layout (set = 1, binding = 6) uniform sampler2D velocity;
+layout (set = 1, binding = 7) uniform sampler2D history[2];
+
+#include "post.glsl"
+
+layout (location = 0) out vec4 outColor; // swapchain image
+layout (location = 1) out vec4 outHistory;
+
+// Weight of the current frame at a pixel one of its samples landed on; history keeps the rest
+const float CURRENT_WEIGHT = 0.1;
+const float MIN_CURRENT_WEIGHT = 0.02;
+// Width of the accepted history color range, in standard deviations of the neighborhood
+const float VARIANCE_CLIP_GAMMA = 1.25;
+
+// Luma and chroma apart, so the clip box hugs the neighborhood better than an RGB one
+vec3 rgbToYCoCg(vec3 c) {
+    return vec3(0.25 * c.r + 0.5 * c.g + 0.25 * c.b, 0.5 * c.r - 0.5 * c.b, -0.25 * c.r + 0.5 * c.g - 0.25 * c.b);
+}
+
+vec3 yCoCgToRgb(vec3 c) {
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+// Blending in tonemapped space: a single bright sample cannot flicker through the history
+float lumaWeight(vec3 yCoCg) {
+    return 1.0 / (1.0 + yCoCg.x);
+}
+
+// Moves 'color' towards the box center until it is inside, keeping its hue (unlike a per-channel clamp)
+vec3 clipToBox(vec3 color, vec3 boxMin, vec3 boxMax) {
+    vec3 center = 0.5 * (boxMax + boxMin);
+    vec3 extents = 0.5 * (boxMax - boxMin) + 1e-4;
+    vec3 offset = color - center;
+    vec3 units = abs(offset / extents);
+    float maxUnit = max(units.x, max(units.y, units.z));
+    return maxUnit > 1.0 ? center + offset / maxUnit : color;
+}
+
+// Catmull-Rom in five bilinear taps (the corners of the 4x4 footprint weigh next to nothing): sharper than
+// bilinear, which would blur the history a little more every frame it is reprojected. 'position' is in output
+// pixels; the taps stay inside the output extent, the history image may be larger.
+vec3 sampleHistory(sampler2D tex, vec2 position) {
+    vec2 size = vec2(textureSize(tex, 0));
+    vec2 outputSize = 1.0 / camera.upscale.zw;
+    vec2 center = floor(position - 0.5) + 0.5;
+    vec2 f = position - center;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+
+    vec2 uv0 = clamp(center - 1.0, vec2(0.5), outputSize - 0.5) / size;
+    vec2 uv3 = clamp(center + 2.0, vec2(0.5), outputSize - 0.5) / size;
+    vec2 uv12 = clamp(center + w2 / w12, vec2(0.5), outputSize - 0.5) / size;
+
+    vec3 result = textureLod(tex, vec2(uv12.x, uv0.y), 0.0).rgb * (w12.x * w0.y) +
+                  textureLod(tex, vec2(uv0.x, uv12.y), 0.0).rgb * (w0.x * w12.y) +
+                  textureLod(tex, uv12, 0.0).rgb * (w12.x * w12.y) +
+                  textureLod(tex, vec2(uv3.x, uv12.y), 0.0).rgb * (w3.x * w12.y) +
+                  textureLod(tex, vec2(uv12.x, uv3.y), 0.0).rgb * (w12.x * w3.y);
+    float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+    return max(result / weight, 0.0);
+}
+
+void main() {
+    // This output pixel's center, in render pixels; render pixel p was sampled at p + 0.5 + jitter
+    vec2 outputUv = gl_FragCoord.xy * camera.upscale.zw;
+    vec2 renderPos = outputUv * camera.viewport.xy;
+    vec2 jitter = camera.temporal.xy;
+    ivec2 nearest = ivec2(floor(renderPos - jitter));
+    ivec2 renderMax = ivec2(camera.viewport.xy) - 1;
+
+    // Reconstruct the current frame at the output pixel from the 3x3 samples around it, weighted by
+    // their distance (Gaussian fit of Blackman-Harris). Gather the neighborhood's color moments and its
+    // longest motion vector on the way: edges then take the motion of the foreground.
+    vec3 current = vec3(0.0);
+    float currentWeight = 0.0;
+    float closestWeight = 0.0;
+    vec3 moment1 = vec3(0.0);
+    vec3 moment2 = vec3(0.0);
+    vec3 boxMin = vec3(1e6);
+    vec3 boxMax = vec3(-1e6);
+    vec2 motion = vec2(0.0);
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            ivec2 pixel = clamp(nearest + ivec2(x, y), ivec2(0), renderMax);
+            vec3 color = rgbToYCoCg(texelFetch(sceneColor, pixel, 0).rgb);
+
+            vec2 d = vec2(pixel) + 0.5 + jitter - renderPos;
+            float w = exp(-2.29 * dot(d, d));
+            current += color * (w * lumaWeight(color));
+            currentWeight += w * lumaWeight(color);
+            closestWeight = max(closestWeight, w);
+
+            moment1 += color;
+            moment2 += color * color;
+            boxMin = min(boxMin, color);
+            boxMax = max(boxMax, color);
+
+            vec2 v = texelFetch(velocity, pixel, 0).xy;
+            if (dot(v, v) > dot(motion, motion))
+                motion = v;
+        }
+    }
+    current /= max(currentWeight, 1e-4);
+
+    vec2 previousUv = outputUv - motion;
+    bool offscreen = any(lessThan(previousUv, vec2(0.0))) || any(greaterThan(previousUv, vec2(1.0)));
+
+    vec3 result = current;
+    if (camera.temporal.z != 0.0 && !offscreen) {
+        // Variance clipping: the history may only hold colors the neighborhood could plausibly produce,
+        // which rejects what got disoccluded or changed instead of smearing it
+        vec3 mean = moment1 / 9.0;
+        vec3 sigma = sqrt(max(moment2 / 9.0 - mean * mean, 0.0));
+        vec3 clipMin = max(boxMin, mean - VARIANCE_CLIP_GAMMA * sigma);
+        vec3 clipMax = min(boxMax, mean + VARIANCE_CLIP_GAMMA * sigma);
+
+        // The history index comes from the uniform buffer, so it is dynamically uniform
+        vec3 previous = rgbToYCoCg(sampleHistory(history[int(camera.temporal.w)], previousUv / camera.upscale.zw));
+        previous = clipToBox(previous, clipMin, clipMax);
+
+        // Below full scale most output pixels only get a sample every few frames; trust the current frame
+        // in proportion to how close its nearest sample came
+        float alpha = max(CURRENT_WEIGHT * closestWeight, MIN_CURRENT_WEIGHT);
+        float wCurrent = alpha * lumaWeight(current);
+        float wPrevious = (1.0 - alpha) * lumaWeight(previous);
+        result = (current * wCurrent + previous * wPrevious) / (wCurrent + wPrevious);
+    }
+
+    vec3 rgb = max(yCoCgToRgb(result), 0.0);
+    outColor = vec4(finishColor(rgb, renderPos), 1.0);
+    outHistory = vec4(rgb, 1.0);
+}
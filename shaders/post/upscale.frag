@@ -0,0 +1,21 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "frame.glsl"
+
+// Lit output of the main pass; only the top-left render size of it is valid (set 1, see src/vulkan/GBuffer.hpp)
+layout (set = 1, binding = 5) uniform sampler2D sceneColor;
+
+#include "post.glsl"
+
+layout (location = 0) out vec4 outColor;
+
+void main() {
+    // Output pixel -> the same relative position in the rendered region, kept half a texel inside it
+    // so bilinear filtering never picks up stale texels beyond its edge
+    vec2 halfTexel = 0.5 / vec2(textureSize(sceneColor, 0));
+    vec2 uv = gl_FragCoord.xy * camera.upscale.zw * camera.upscale.xy;
+    uv = clamp(uv, halfTexel, camera.upscale.xy - halfTexel);
+    vec3 radiance = textureLod(sceneColor, uv, 0.0).rgb;
+    outColor = vec4(finishColor(radiance, uv * vec2(textureSize(sceneColor, 0))), 1.0);
+}
@@ -0,0 +1,19 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "frame.glsl"
+#include "material.glsl"
+#include "shadow.glsl"
+#include "lights.glsl"
+
+layout (location = 0) in vec3 inPosition;
+
+void main() {
+    // Cascades first, then the local lights' atlas views
+    mat4 viewProj = draw.shadowView < SHADOW_CASCADE_COUNT
+                        ? shadow.cascadeViewProj[draw.shadowView]
+                        : localShadowViews[draw.shadowView - SHADOW_CASCADE_COUNT].viewProj;
+
+    vec4 worldPos = objects[gl_InstanceIndex].model * vec4(inPosition, 1.0);
+    gl_Position = viewProj * worldPos;
+}
@@ -0,0 +1,69 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+#include "frame.glsl"
+#include "material.glsl"
+#include "shadow.glsl"
+#include "lights.glsl"
+#include "lighting.glsl"
+#include "gbuffer.glsl"
+#include "visibility.glsl"
+
+// Written by the visibility subpass at this pixel (set 1, see src/vulkan/VisibilityBuffer.hpp)
+layout (input_attachment_index = 0, set = 1, binding = 4) uniform usubpassInput visibility;
+
+layout (location = 0) out vec4 outColor;
+
+void main() {
+    // One pipeline per shading model, like deferred lighting; the stencil test limits it to that model's pixels
+    uvec2 id = subpassLoad(visibility).xy;
+    ObjectData object = objects[id.x];
+    VisibleTriangle tri = fetchTriangle(object, id.y);
+
+    // Attributes at this pixel and its right and lower neighbours, for the texture footprint
+    vec3 b = rayBarycentrics(gl_FragCoord.xy, tri.position[0], tri.position[1], tri.position[2]);
+    vec3 bx = rayBarycentrics(gl_FragCoord.xy + vec2(1.0, 0.0), tri.position[0], tri.position[1], tri.position[2]);
+    vec3 by = rayBarycentrics(gl_FragCoord.xy + vec2(0.0, 1.0), tri.position[0], tri.position[1], tri.position[2]);
+    vec2 uv = interpolate(tri.texCoord, b);
+    vec2 uvDx = interpolate(tri.texCoord, bx) - uv;
+    vec2 uvDy = interpolate(tri.texCoord, by) - uv;
+
+    vec3 worldPos = interpolate(tri.position, b);
+    vec3 N = normalize(interpolate(tri.normal, b));
+
+    // Unlike the G-buffer path the material varies per pixel here, hence the non-uniform index
+    uint materialId = object.drawInfo.z;
+    Material material = materials[materialId];
+    vec3 texel = textureGrad(textures[nonuniformEXT(material.albedoTexture)], uv, uvDx, uvDy).rgb;
+    vec3 albedo = interpolate(tri.color, b) * material.albedo.rgb;
+
+    if (camera.debugView != DEBUG_VIEW_LIT) {
+        outColor = vec4(debugChannel(camera.debugView, albedo * texel, N, material.roughness, material.metalness,
+                                     materialId, worldPos), 1.0);
+        return;
+    }
+
+    vec3 color;
+    if (SHADING_MODEL == SHADING_GOURAUD) {
+        // Same result as the vertex shader path: light the three corners (single shadow tap), then interpolate
+        vec3 corners[3];
+        for (int i = 0; i < 3; i++) {
+            vec3 n = normalize(tri.normal[i]);
+            vec3 p = tri.position[i];
+            vec3 a = tri.color[i] * material.albedo.rgb;
+            float viewDepth = -(camera.view * vec4(p, 1.0)).z;
+            float lit = sampleShadow(p, n, viewDepth, 1);
+            corners[i] = shadeBlinnPhong(n, p, camera.cameraPosition.xyz, a, material, lit, 1.0) +
+                         shadeLocalLights(n, p, camera.cameraPosition.xyz, a, material, 1);
+        }
+        color = interpolate(corners, b) * texel;
+    } else {
+        albedo *= texel;
+        float viewDepth = -(camera.view * vec4(worldPos, 1.0)).z;
+        float lit = sampleShadow(worldPos, N, viewDepth, 3);
+        color = shadeBlinnPhong(N, worldPos, camera.cameraPosition.xyz, albedo, material, lit, 1.0) +
+                shadeTiledLocalLights(gl_FragCoord.xy, N, worldPos, camera.cameraPosition.xyz, albedo, material, 3);
+    }
+    outColor = vec4(color, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "frame.glsl"
+
+layout (location = 0) flat in uint fragInstance;
+layout (location = 1) in vec4 fragClip;
+layout (location = 2) in vec4 fragPrevClip;
+
+// See src/vulkan/VisibilityBuffer.hpp: instance (ObjectData index) and triangle within the mesh
+layout (location = 0) out uvec2 outVisibility;
+layout (location = 1) out vec2 outVelocity; // stored for the temporal resolve
+
+void main() {
+    outVisibility = uvec2(fragInstance, uint(gl_PrimitiveID));
+    outVelocity = motionVector(fragClip, fragPrevClip);
+}
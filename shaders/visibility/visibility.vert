@@ -0,0 +1,20 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "frame.glsl"
+
+layout (location = 0) in vec3 inPosition;
+
+layout (location = 0) flat out uint fragInstance;
+layout (location = 1) out vec4 fragClip; // unjittered, for the motion vector
+layout (location = 2) out vec4 fragPrevClip;
+
+// Position only: everything else is fetched per pixel by the material subpass
+void main() {
+    ObjectData object = objects[gl_InstanceIndex];
+    vec4 worldPos = object.model * vec4(inPosition, 1.0);
+    gl_Position = camera.viewProj * worldPos;
+    fragInstance = gl_InstanceIndex;
+    fragClip = camera.unjitteredViewProj * worldPos;
+    fragPrevClip = camera.prevViewProj * (object.prevModel * vec4(inPosition, 1.0));
+}
@@ -7,8 +7,12 @@
 
 #include "app.hpp"
 
+#include <iostream>
+#include <utility>
 #include <stdexcept>
+#include <string>
 
+#include "renderer/CascadedShadowMap.hpp"
 #include "renderer/renderer.hpp"
 #include "vulkan/graphics_pipeline.hpp"
 #include "vulkan/render_pass.hpp"
@@ -19,6 +23,12 @@ App::App(int width, int height, const char *title)
 }
 
 App::~App() {
+    // Left early through an exception: the render thread still waits for packets
+    if (renderThread_.joinable()) {
+        packets_.close();
+        renderThread_.join();
+    }
+
     // Wait for GPU to be idle before destroying anything
     if (vulkanContext_)
         vkDeviceWaitIdle(vulkanContext_->getDevice());
@@ -53,7 +63,7 @@ void App::initWindow() {
 
 void App::framebufferResizeCallback(GLFWwindow *window, int width, int height) {
     auto app = reinterpret_cast<App *>(glfwGetWindowUserPointer(window));
-    app->framebufferResized = true;
+    app->framebufferResized_ = true;
 }
 
 void App::initVulkan() {
@@ -62,7 +72,7 @@ void App::initVulkan() {
     renderPass_ = std::make_unique<RenderPass>(*vulkanContext_,
                                                swapchain_->getColorFormat(),
                                                swapchain_->getDepthFormat());
-    swapchain_->createFramebuffers(renderPass_->getRenderPass());
+    swapchain_->createFramebuffers(*renderPass_);
 
     // --- NEW PROFESSIONAL SEQUENCE ---
 
@@ -77,40 +87,98 @@ void App::initVulkan() {
         *vulkanContext_,
         *swapchain_,
         renderPass_->getRenderPass(),
-        renderer_->getDescriptorSetLayout() // <--- This is the key link
+        renderer_->getDescriptorSetLayout(), // <--- This is the key link
+        renderer_->getGBufferSetLayout()
         );
 
     // 4. Initialize Renderer Resources (The Data)
     // Pass the pipeline layout so the Renderer knows how to bind sets
     renderer_->initResources(graphicsPipeline_->getPipelineLayout(), "assets/model/sphere_grid.obj");
+
+    // 5. Shadow caster pipeline, against the shadow map's render pass (owned by the renderer)
+    const auto &shadowMap = renderer_->getShadowMap();
+    graphicsPipeline_->createShadowPipeline(shadowMap.getRenderPass(), shadowMap.hasDepthClamp());
+
+    // 6. Upscale from the dynamic render resolution to the swapchain, plainly or with the temporal resolve
+    graphicsPipeline_->createUpscalePipeline(renderPass_->getUpscaleRenderPass());
+    graphicsPipeline_->createTemporalPipeline(renderPass_->getTemporalRenderPass());
+
+    // 7. Visibility-buffer pipelines, where the device can run that mode
+    if (vulkanContext_->supportsVisibilityBuffer()) {
+        graphicsPipeline_->createVisibilityPipelines(renderPass_->getVisibilityRenderPass());
+    }
+
+    // 8. Every pipeline exists: watch their shaders from here on
+    if (engine::SHADER_HOT_RELOAD)
+        graphicsPipeline_->enableHotReload();
 }
 
 void App::mainLoop() {
+    // This thread polls GLFW and runs the simulation; the renderer, and every Vulkan call after init, lives on
+    // the render thread. A blocked fence wait or image acquire there no longer holds up input.
+    renderThread_ = std::thread(&App::renderLoop, this);
+
     while (!glfwWindowShouldClose(window_)) {
+        // At most one frame ahead of the render thread. In low-latency mode none: the render thread hands the
+        // slot back only once its pacer lets the next frame start, and the input is sampled right after.
+        FramePacket *packet = packets_.beginWrite(lowLatency_ ? 0 : 1);
+        if (!packet)
+            break; // the render thread failed
         glfwPollEvents();
+        // Minimized: nothing can be presented, so sleep until the window changes instead of spinning
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window_, &width, &height);
+        if (width == 0 || height == 0) {
+            glfwWaitEvents();
+            continue;
+        }
         processInput();
         // Keep the logic separate from the drawing
         updateFrameTime();
-        drawFrame();
+
+        packet->camera.emplace(camera);
+        packet->transforms = std::move(transformUpdates_);
+        packet->commands = std::move(commands_);
+        transformUpdates_.clear();
+        commands_.clear();
+        packet->framebufferSize = vk::Extent2D(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+        packet->framebufferResized = std::exchange(framebufferResized_, false);
+        packet->inputTime = inputTime_;
+        packets_.publish();
     }
 
+    packets_.close();
+    renderThread_.join();
     // Wait for GPU to finish before exiting to avoid crashing during cleanup
     vkDeviceWaitIdle(vulkanContext_->getDevice());
+    if (renderError_)
+        std::rethrow_exception(renderError_);
 }
 
-void App::drawFrame() {
-    // We check the flag here, or inside renderer_->drawFrame()
-    // For a Senior architecture, the Renderer should report if it needs a resize
+void App::renderLoop() {
     try {
-        renderer_->drawFrame(graphicsPipeline_->getPipeline(), framebufferResized_, camera);
-    } catch (const std::runtime_error &e) {
-        // If the renderer encounters VK_ERROR_OUT_OF_DATE_KHR, it throws
-        renderer_->recreateSwapChain();
+        while (FramePacket *packet = packets_.acquire()) {
+            // Pipelines rebuilt after a shader edit take over between frames
+            graphicsPipeline_->applyReload(renderer_->getDeletionQueue());
+            drawFrame(*packet);
+            // Low latency: hold the slot until the queue in front of the display has drained, so the input the
+            // app samples next is as fresh as possible when it reaches the screen
+            renderer_->getFramePacer().waitForFrameStart();
+            packets_.release();
+        }
+    } catch (...) {
+        // Rethrown on the main thread once it has stopped
+        renderError_ = std::current_exception();
+        packets_.close();
     }
+}
 
-    if (framebufferResized_) {
+void App::drawFrame(FramePacket &packet) {
+    // The renderer recreates the swapchain itself when the packet reports a resize
+    try {
+        renderer_->drawFrame(*graphicsPipeline_, packet);
+    } catch (const vk::OutOfDateKHRError &) {
         renderer_->recreateSwapChain();
-        framebufferResized_ = false;
     }
 }
 
@@ -136,7 +204,12 @@ void App::updateFrameTime() {
         // std::cout << "Frame Time: " << frameTimeMs << "ms" << std::endl;
 
         // Use the window title trick for a cleaner console
-        const std::string title = "Vulkan Engine | " + std::to_string(frameTimeMs) + " ms";
+        std::string title = "Vulkan Engine | " + std::to_string(frameTimeMs) + " ms";
+        if (const float latencyMs = renderer_->getFramePacer().getLatencyMs(); latencyMs > 0.0f)
+            title += " | input to display " + std::to_string(latencyMs) + " ms";
+        if (const float latencyMs = renderer_->getFramePacer().getGpuLatencyMs(); latencyMs > 0.0f)
+            title += " | input to GPU done " + std::to_string(latencyMs) + " ms";
+        title += " | binds saved " + std::to_string(renderer_->getBindsSaved());
         glfwSetWindowTitle(window_, title.c_str());
 
         timer = 0.0f;
@@ -149,8 +222,131 @@ void App::processInput() {
     auto currentTime = std::chrono::high_resolution_clock::now();
     float dt = std::chrono::duration<float>(currentTime - lastFrameTime).count();
     lastFrameTime = currentTime;
+    // Everything below reads the input this frame will show
+    inputTime_ = std::chrono::steady_clock::now();
     if (glfwGetKey(window_, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window_, true);
     }
     camera.handleInput(window_, dt);
+
+    // Left click picks the render object under the cursor (BVH ray query)
+    const bool mouseDown = glfwGetMouseButton(window_, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    if (mouseDown && !mouseWasDown_) {
+        double x, y;
+        int width, height;
+        glfwGetCursorPos(window_, &x, &y);
+        glfwGetWindowSize(window_, &width, &height);
+        if (width > 0 && height > 0) {
+            const Ray ray = camera.screenPointToRay(static_cast<float>(x), static_cast<float>(y),
+                                                    static_cast<float>(width), static_cast<float>(height));
+            commands_.push_back([ray](Renderer &renderer) {
+                if (auto picked = renderer.pickObject(ray))
+                    std::cout << "-- Picked render object " << *picked << std::endl;
+            });
+        }
+    }
+    mouseWasDown_ = mouseDown;
+
+    // G cycles the lighting output through the decoded G-buffer channels
+    const bool debugViewKeyDown = glfwGetKey(window_, GLFW_KEY_G) == GLFW_PRESS;
+    if (debugViewKeyDown && !debugViewKeyWasDown_) {
+        commands_.push_back([](Renderer &renderer) {
+            constexpr auto count = static_cast<uint32_t>(gbuffer::DebugView::COUNT);
+            const auto next = static_cast<gbuffer::DebugView>((static_cast<uint32_t>(renderer.getDebugView()) + 1) %
+                                                              count);
+            renderer.setDebugView(next);
+            std::cout << "-- G-buffer view: " << gbuffer::debugViewName(next) << std::endl;
+        });
+    }
+    debugViewKeyWasDown_ = debugViewKeyDown;
+
+    // V: switch between the G-buffer and visibility-buffer passes
+    const bool renderModeKeyDown = glfwGetKey(window_, GLFW_KEY_V) == GLFW_PRESS;
+    if (renderModeKeyDown && !renderModeKeyWasDown_) {
+        commands_.push_back([](Renderer &renderer) {
+            const bool deferred = renderer.getRenderMode() == Renderer::RenderMode::Deferred;
+            renderer.setRenderMode(deferred ? Renderer::RenderMode::VisibilityBuffer : Renderer::RenderMode::Deferred);
+            std::cout << "-- Render mode: "
+                      << (renderer.getRenderMode() == Renderer::RenderMode::Deferred ? "G-buffer" : "visibility buffer")
+                      << std::endl;
+        });
+    }
+    renderModeKeyWasDown_ = renderModeKeyDown;
+
+    // R: dynamic resolution on/off (off renders at the maximum scale)
+    const bool resolutionKeyDown = glfwGetKey(window_, GLFW_KEY_R) == GLFW_PRESS;
+    if (resolutionKeyDown && !resolutionKeyWasDown_) {
+        commands_.push_back([](Renderer &renderer) {
+            const auto &resolution = renderer.getDynamicResolution();
+            renderer.setDynamicResolution(!resolution.isEnabled());
+            std::cout << "-- Dynamic resolution: " << (resolution.isEnabled() ? "on" : "off") << " (scale "
+                      << resolution.getScale() << ", GPU " << resolution.getFilteredMs() << " ms)" << std::endl;
+        });
+    }
+    resolutionKeyWasDown_ = resolutionKeyDown;
+
+    // T: temporal anti-aliasing on/off
+    const bool temporalKeyDown = glfwGetKey(window_, GLFW_KEY_T) == GLFW_PRESS;
+    if (temporalKeyDown && !temporalKeyWasDown_) {
+        commands_.push_back([](Renderer &renderer) {
+            renderer.setTemporalAA(!renderer.getTemporalAA());
+            std::cout << "-- Temporal AA: " << (renderer.getTemporalAA() ? "on" : "off") << std::endl;
+        });
+    }
+    temporalKeyWasDown_ = temporalKeyDown;
+
+    // O: ambient occlusion off -> low -> medium -> high quality -> off
+    const bool occlusionKeyDown = glfwGetKey(window_, GLFW_KEY_O) == GLFW_PRESS;
+    if (occlusionKeyDown && !occlusionKeyWasDown_) {
+        commands_.push_back([](Renderer &renderer) {
+            using Quality = AmbientOcclusion::Quality;
+            auto settings = renderer.getAmbientOcclusion();
+            if (!settings.enabled) {
+                settings.enabled = true;
+                settings.quality = Quality::Low;
+            } else if (settings.quality == Quality::High) {
+                settings.enabled = false;
+            } else {
+                settings.quality = settings.quality == Quality::Low ? Quality::Medium : Quality::High;
+            }
+            renderer.setAmbientOcclusion(settings);
+            std::cout << "-- Ambient occlusion: "
+                      << (settings.enabled ? std::to_string(static_cast<uint32_t>(settings.quality)) + " samples"
+                                           : "off")
+                      << (engine::SSAO ? "" : " (built without engine::SSAO)") << std::endl;
+        });
+    }
+    occlusionKeyWasDown_ = occlusionKeyDown;
+
+    // P: present mode FIFO -> Mailbox -> Immediate (modes the surface lacks fall back to FIFO)
+    const bool presentKeyDown = glfwGetKey(window_, GLFW_KEY_P) == GLFW_PRESS;
+    if (presentKeyDown && !presentKeyWasDown_) {
+        commands_.push_back([](Renderer &renderer) {
+            using Mode = vk::PresentModeKHR;
+            auto settings = renderer.getPresentSettings();
+            settings.mode = settings.mode == Mode::eFifo ? Mode::eMailbox
+                            : settings.mode == Mode::eMailbox ? Mode::eImmediate
+                            : Mode::eFifo;
+            renderer.setPresentSettings(settings);
+        });
+    }
+    presentKeyWasDown_ = presentKeyDown;
+
+    // L: low-latency frame pacing on/off
+    const bool latencyKeyDown = glfwGetKey(window_, GLFW_KEY_L) == GLFW_PRESS;
+    if (latencyKeyDown && !latencyKeyWasDown_) {
+        // This thread's copy decides how far it may run ahead, the pacer's how long the render thread waits
+        lowLatency_ = !lowLatency_;
+        commands_.push_back([lowLatency = lowLatency_](Renderer &renderer) {
+            auto &pacer = renderer.getFramePacer();
+            auto settings = pacer.getSettings();
+            settings.lowLatency = lowLatency;
+            pacer.setSettings(settings);
+            std::cout << "-- Low latency: " << (settings.lowLatency ? "on" : "off") << " ("
+                      << (pacer.usesPresentWait() ? "present wait" : "GPU completion") << ", input to display "
+                      << pacer.getLatencyMs() << " ms, to GPU done " << pacer.getGpuLatencyMs() << " ms)"
+                      << std::endl;
+        });
+    }
+    latencyKeyWasDown_ = latencyKeyDown;
 }
\ No newline at end of file
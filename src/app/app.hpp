@@ -4,10 +4,16 @@
 
 #pragma once
 #include <chrono>
+#include <exception>
 #include <GLFW/glfw3.h>
 #include <memory>
+#include <thread>
+#include <vector>
 
+#include "common/DoubleBuffer.hpp"
+#include "common/config.hpp"
 #include "renderer/Camera.hpp"
+#include "renderer/FramePacket.hpp"
 #include "vulkan/VulkanContext.hpp"
 
 class Renderer;
@@ -97,9 +103,20 @@ private:
 
     void initVulkan();
 
-    void drawFrame();
-
-    bool framebufferResized = false;
+    // Render thread: draws every packet the main loop publishes
+    void renderLoop();
+    void drawFrame(FramePacket &packet);
+
+    // Main thread -> render thread, one frame per packet (see FramePacket)
+    DoubleBuffer<FramePacket> packets_;
+    std::thread renderThread_;
+    std::exception_ptr renderError_;
+    // Collected while processing input, moved into the next packet. The demo scene is static, so only the
+    // camera moves; node transforms set by simulation code go through transformUpdates_.
+    std::vector<FramePacket::Command> commands_;
+    std::vector<FramePacket::TransformUpdate> transformUpdates_;
+    std::chrono::steady_clock::time_point inputTime_;
+    bool lowLatency_ = engine::LOW_LATENCY;
 
     static void framebufferResizeCallback(GLFWwindow *window, int width, int height);
 
@@ -115,4 +132,12 @@ private:
     std::chrono::time_point<std::chrono::high_resolution_clock> lastFrameTime;
 
     void processInput();
+    bool mouseWasDown_ = false;
+    bool debugViewKeyWasDown_ = false;
+    bool renderModeKeyWasDown_ = false;
+    bool resolutionKeyWasDown_ = false;
+    bool temporalKeyWasDown_ = false;
+    bool occlusionKeyWasDown_ = false;
+    bool presentKeyWasDown_ = false;
+    bool latencyKeyWasDown_ = false;
 };
\ No newline at end of file
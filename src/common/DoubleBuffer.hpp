@@ -0,0 +1,84 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * DoubleBuffer
+ *
+ * Hands values from one producer thread to one consumer thread through two
+ * slots, without locks: the producer fills one slot while the consumer works
+ * on the other. Two counters (values published, values released) decide who
+ * owns which slot; a thread that has to wait sleeps on the other's counter
+ * (std::atomic::wait) instead of spinning.
+ *
+ * Nothing is dropped: every published value is acquired once, in order. The
+ * producer chooses how far ahead it may get (beginWrite()): one value while
+ * the consumer still holds the previous one, or none.
+ *
+ * close() wakes both sides; afterwards beginWrite() returns null, and acquire()
+ * does once the published values are drained.
+ */
+template<typename T>
+class DoubleBuffer {
+public:
+    DoubleBuffer() = default;
+
+    DoubleBuffer(const DoubleBuffer &) = delete;
+    DoubleBuffer &operator=(const DoubleBuffer &) = delete;
+
+    // Producer: the slot to fill, once at most 'maxAhead' (0 or 1) published values are not yet released
+    T *beginWrite(uint32_t maxAhead) {
+        const uint64_t published = published_.load(std::memory_order_relaxed) & ~CLOSED;
+        uint64_t released = released_.load(std::memory_order_acquire);
+        while (!(released & CLOSED) && published - released > maxAhead) {
+            released_.wait(released, std::memory_order_acquire);
+            released = released_.load(std::memory_order_acquire);
+        }
+        return released & CLOSED ? nullptr : &slots_[published % 2];
+    }
+
+    // Producer: the slot from beginWrite() goes to the consumer
+    void publish() {
+        published_.fetch_add(1, std::memory_order_release);
+        published_.notify_one();
+    }
+
+    // Consumer: the oldest published value, waiting for one if needed
+    T *acquire() {
+        const uint64_t released = released_.load(std::memory_order_relaxed) & ~CLOSED;
+        uint64_t published = published_.load(std::memory_order_acquire);
+        while (!(published & CLOSED) && published == released) {
+            published_.wait(published, std::memory_order_acquire);
+            published = published_.load(std::memory_order_acquire);
+        }
+        return (published & ~CLOSED) == released ? nullptr : &slots_[released % 2];
+    }
+
+    // Consumer: done with the value from acquire(); its slot can be refilled
+    void release() {
+        released_.fetch_add(1, std::memory_order_release);
+        released_.notify_one();
+    }
+
+    // Either side: stop the exchange. Changing both counters is what wakes a waiting thread.
+    void close() {
+        published_.fetch_or(CLOSED, std::memory_order_release);
+        released_.fetch_or(CLOSED, std::memory_order_release);
+        published_.notify_all();
+        released_.notify_all();
+    }
+
+private:
+    static constexpr uint64_t CLOSED = 1ull << 63;
+
+    std::array<T, 2> slots_{};
+    // Each written by one side only (plus close()); kept on separate cache lines
+    alignas(64) std::atomic<uint64_t> published_{0};
+    alignas(64) std::atomic<uint64_t> released_{0};
+};
@@ -0,0 +1,256 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+struct JobSystem::Job {
+    Function function;
+    JobCounter *counter = nullptr;
+    // Dependencies not yet finished, plus one held until submit()
+    std::atomic<uint32_t> unfinished{1};
+    std::vector<Job *> dependents;
+};
+
+namespace {
+// Which worker of which system the calling thread is; -1 for any other thread
+thread_local const JobSystem *tlsSystem = nullptr;
+thread_local int32_t tlsWorker = -1;
+
+// Failed attempts to find work before a worker goes to sleep
+constexpr uint32_t SPIN_ROUNDS = 64;
+}
+
+bool JobSystem::WorkDeque::push(Job *job) {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top >= CAPACITY)
+        return false;
+    buffer_[bottom & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+JobSystem::Job *JobSystem::WorkDeque::pop() {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        // Empty
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Job *job = buffer_[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // The last job: race the thieves for it
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job *JobSystem::WorkDeque::steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom)
+        return nullptr;
+
+    Job *job = buffer_[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr; // lost to the owner or another thief
+    return job;
+}
+
+JobSystem::JobSystem(uint32_t threadCount) {
+    if (threadCount == 0) {
+        const uint32_t hw = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = std::max(1u, hw - 1);
+    }
+
+    for (uint32_t i = 0; i < threadCount; i++) {
+        deques_.push_back(std::make_unique<WorkDeque>());
+    }
+    workers_.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        workers_.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    stopping_.store(true);
+    epoch_.fetch_add(1);
+    epoch_.notify_all();
+
+    for (auto &worker : workers_) {
+        if (worker.joinable())
+            worker.join();
+    }
+}
+
+JobSystem::Job *JobSystem::create(Function function, JobCounter *counter) {
+    if (counter)
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+    Job *job = new Job;
+    job->function = std::move(function);
+    job->counter = counter;
+    return job;
+}
+
+void JobSystem::dependsOn(Job *job, Job *dependency) {
+    job->unfinished.fetch_add(1, std::memory_order_relaxed);
+    dependency->dependents.push_back(job);
+}
+
+void JobSystem::submit(Job *job) {
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        schedule(job);
+}
+
+void JobSystem::schedule(Job *job) {
+    const bool worker = tlsSystem == this && tlsWorker >= 0;
+    if (!worker || !deques_[tlsWorker]->push(job)) {
+        std::lock_guard lock(injectionMutex_);
+        injection_.push_back(job);
+    }
+
+    // seq_cst, as in sleep(): either this sees the sleeper, or the sleeper sees the new epoch
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_seq_cst) > 0)
+        epoch_.notify_one();
+}
+
+void JobSystem::execute(Job *job) {
+    job->function();
+
+    for (Job *dependent : job->dependents) {
+        if (dependent->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            schedule(dependent);
+    }
+
+    JobCounter *counter = job->counter;
+    delete job;
+    // Last access to the counter: a waiter may free it as soon as it reads zero
+    if (counter && counter->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) > 0)
+            epoch_.notify_all();
+    }
+}
+
+JobSystem::Job *JobSystem::findJob(int32_t self) {
+    if (self >= 0) {
+        if (Job *job = deques_[self]->pop())
+            return job;
+    }
+    {
+        std::lock_guard lock(injectionMutex_);
+        if (!injection_.empty()) {
+            Job *job = injection_.front();
+            injection_.pop_front();
+            return job;
+        }
+    }
+    // Start after ourselves, so thieves spread over the victims
+    const auto count = static_cast<int32_t>(deques_.size());
+    for (int32_t i = 1; i <= count; i++) {
+        const int32_t victim = (self + i + count) % count;
+        if (victim == self)
+            continue;
+        if (Job *job = deques_[victim]->steal())
+            return job;
+    }
+    return nullptr;
+}
+
+void JobSystem::sleep(uint32_t epoch) {
+    // Store-buffering handshake with schedule() / execute(): the sleeper publishes itself and then reads the
+    // epoch, the waker bumps the epoch and then reads the sleepers. All four accesses are seq_cst, so they
+    // cannot both read the old value; with release/acquire alone they could, and the wake-up would be lost.
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    epoch_.wait(epoch, std::memory_order_seq_cst);
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void JobSystem::workerLoop(uint32_t index) {
+    tlsSystem = this;
+    tlsWorker = static_cast<int32_t>(index);
+
+    uint32_t idleRounds = 0;
+    while (true) {
+        // Read before looking for work: a push after this changes it, so the sleep below cannot miss it
+        const uint32_t epoch = epoch_.load(std::memory_order_acquire);
+        if (Job *job = findJob(tlsWorker)) {
+            execute(job);
+            idleRounds = 0;
+            continue;
+        }
+        if (stopping_.load())
+            return;
+        if (++idleRounds < SPIN_ROUNDS) {
+            std::this_thread::yield();
+            continue;
+        }
+        sleep(epoch);
+        idleRounds = 0;
+    }
+}
+
+void JobSystem::wait(JobCounter &counter) {
+    const int32_t self = tlsSystem == this ? tlsWorker : -1;
+    uint32_t idleRounds = 0;
+    while (true) {
+        const uint32_t epoch = epoch_.load(std::memory_order_acquire);
+        if (counter.isDone())
+            return;
+        if (Job *job = findJob(self)) {
+            execute(job);
+            idleRounds = 0;
+            continue;
+        }
+        // The remaining jobs run elsewhere: spin briefly, then sleep until a push or a drained counter
+        if (++idleRounds < SPIN_ROUNDS) {
+            std::this_thread::yield();
+            continue;
+        }
+        sleep(epoch);
+        idleRounds = 0;
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &body) {
+    if (count == 0)
+        return;
+
+    grainSize = std::max<size_t>(1, grainSize);
+    const size_t chunkCount = (count + grainSize - 1) / grainSize;
+    if (chunkCount == 1) {
+        body(0, count);
+        return;
+    }
+
+    // Chunks are claimed through a shared counter so fast threads take more of them. Helpers that start
+    // after everything is claimed return at once; wait() below outlives all of them, so the state can live
+    // on this stack.
+    std::atomic<size_t> nextChunk{0};
+    auto runChunks = [&]() {
+        for (size_t chunk = nextChunk.fetch_add(1); chunk < chunkCount; chunk = nextChunk.fetch_add(1)) {
+            const size_t begin = chunk * grainSize;
+            body(begin, std::min(count, begin + grainSize));
+        }
+    };
+
+    JobCounter helpers;
+    const size_t helperCount = std::min<size_t>(workers_.size(), chunkCount - 1);
+    for (size_t i = 0; i < helperCount; i++) {
+        run(runChunks, &helpers);
+    }
+    runChunks();
+    wait(helpers);
+}
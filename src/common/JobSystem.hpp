@@ -0,0 +1,115 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * JobCounter
+ *
+ * Counts unfinished jobs (JobSystem::create() adds one, the job's completion
+ * removes it). JobSystem::wait() blocks on it. The completing job touches the
+ * counter last with its decrement, so a counter on the waiter's stack is safe.
+ */
+class JobCounter {
+public:
+    [[nodiscard]] bool isDone() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<uint32_t> pending_{0};
+};
+
+/**
+ * JobSystem
+ *
+ * Work-stealing scheduler behind everything the engine runs in parallel.
+ *
+ * Every worker owns a Chase-Lev deque: it pushes and pops its own end without
+ * locks (newest first, while the data is still in cache), and idle threads
+ * steal the oldest jobs from the other end. Jobs created on threads that are
+ * not workers (main, render) go through a shared injection queue. Idle workers
+ * sleep on an epoch counter bumped by every push, so the cost of scheduling
+ * is a couple of atomics when everyone is busy and nothing while idle.
+ *
+ * - create() / dependsOn() / submit(): a job graph. A job becomes runnable
+ *   once it is submitted and every job it depends on has finished; edges must
+ *   be added before the dependency is submitted.
+ * - run():         create + submit.
+ * - wait():        until a counter drains. The waiting thread runs jobs in the
+ *                  meantime (any thread, workers included), so waits nest
+ *                  without deadlocking and without idling a core.
+ * - parallelFor(): chunks of a range, claimed dynamically; the caller helps.
+ */
+class JobSystem {
+public:
+    struct Job;
+    using Function = std::function<void()>;
+
+    // 0 = one worker per core but one, which is left to the main thread (it helps while waiting)
+    explicit JobSystem(uint32_t threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // Not runnable before submit(); 'counter' counts it from now until it has finished
+    Job *create(Function function, JobCounter *counter = nullptr);
+    // 'job' waits for 'dependency'; both must still be unsubmitted
+    void dependsOn(Job *job, Job *dependency);
+    void submit(Job *job);
+    void run(Function function, JobCounter *counter = nullptr) { submit(create(std::move(function), counter)); }
+
+    void wait(JobCounter &counter);
+
+    // body(begin, end) is called once per chunk of at most 'grainSize' items
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &body);
+
+    [[nodiscard]] uint32_t getThreadCount() const { return static_cast<uint32_t>(workers_.size()); }
+
+private:
+    // Chase-Lev work-stealing deque of fixed capacity (Le et al., "Correct and Efficient Work-Stealing for
+    // Weak Memory Models", 2013). push/pop by the owner only, steal by anyone.
+    class WorkDeque {
+    public:
+        static constexpr int64_t CAPACITY = 4096;
+
+        bool push(Job *job); // false when full
+        Job *pop();
+        Job *steal();
+
+    private:
+        alignas(64) std::atomic<int64_t> top_{0};
+        alignas(64) std::atomic<int64_t> bottom_{0};
+        std::unique_ptr<std::atomic<Job *>[]> buffer_{new std::atomic<Job *>[CAPACITY]};
+    };
+
+    void schedule(Job *job);
+    void execute(Job *job);
+    // A runnable job: own deque, then the injection queue, then the other workers' deques
+    Job *findJob(int32_t self);
+    // Blocks until the epoch moves on from 'epoch' (a push or a drained counter)
+    void sleep(uint32_t epoch);
+    void workerLoop(uint32_t index);
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<WorkDeque>> deques_;
+
+    std::mutex injectionMutex_;
+    std::deque<Job *> injection_;
+
+    // Bumped on every push and every drained counter; sleepers wait on it
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> sleepers_{0};
+    std::atomic<bool> stopping_{false};
+};
@@ -0,0 +1,139 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "RadixSort.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "JobSystem.hpp"
+
+namespace {
+constexpr uint32_t DIGIT_BITS = 8;
+constexpr uint32_t BUCKET_COUNT = 1u << DIGIT_BITS;
+constexpr uint32_t PASS_COUNT = 64 / DIGIT_BITS;
+
+// Inputs below this sort on the calling thread; a pass over them takes a few microseconds
+constexpr size_t PARALLEL_SORT_SIZE = 32768;
+// Keys per chunk of a parallel pass, at least
+constexpr size_t CHUNK_SIZE = 8192;
+
+using Histogram = std::array<uint32_t, BUCKET_COUNT>;
+
+uint32_t digit(uint64_t key, uint32_t pass) {
+    return static_cast<uint32_t>(key >> (pass * DIGIT_BITS)) & (BUCKET_COUNT - 1);
+}
+
+// Passes where the keys differ in that digit, lowest first
+std::vector<uint32_t> activePasses(const std::array<Histogram, PASS_COUNT> &histograms, size_t count) {
+    std::vector<uint32_t> passes;
+    for (uint32_t pass = 0; pass < PASS_COUNT; pass++) {
+        const auto &histogram = histograms[pass];
+        if (std::none_of(histogram.begin(), histogram.end(), [&](uint32_t n) { return n == count; }))
+            passes.push_back(pass);
+    }
+    return passes;
+}
+
+void sortSerial(std::vector<uint64_t> &keys, std::vector<uint64_t> &scratch) {
+    std::array<Histogram, PASS_COUNT> histograms{};
+    for (uint64_t key : keys) {
+        for (uint32_t pass = 0; pass < PASS_COUNT; pass++) {
+            histograms[pass][digit(key, pass)]++;
+        }
+    }
+
+    // A histogram does not depend on the order, so the ones counted up front serve every pass
+    for (uint32_t pass : activePasses(histograms, keys.size())) {
+        Histogram offsets;
+        uint32_t sum = 0;
+        for (uint32_t b = 0; b < BUCKET_COUNT; b++) {
+            offsets[b] = sum;
+            sum += histograms[pass][b];
+        }
+        for (uint64_t key : keys) {
+            scratch[offsets[digit(key, pass)]++] = key;
+        }
+        std::swap(keys, scratch);
+    }
+}
+
+void sortParallel(std::vector<uint64_t> &keys, std::vector<uint64_t> &scratch, JobSystem &jobSystem) {
+    const size_t count = keys.size();
+    const size_t chunkCount = std::min<size_t>(jobSystem.getThreadCount() + 1, (count + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    // Which passes are needed: every digit's histogram in one sweep, summed over the chunks
+    std::vector<std::array<Histogram, PASS_COUNT>> chunkHistograms(chunkCount);
+    jobSystem.parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t chunk = first; chunk < last; chunk++) {
+            auto &histograms = chunkHistograms[chunk];
+            histograms = {};
+            const size_t end = std::min(count, (chunk + 1) * chunkSize);
+            for (size_t i = chunk * chunkSize; i < end; i++) {
+                for (uint32_t pass = 0; pass < PASS_COUNT; pass++) {
+                    histograms[pass][digit(keys[i], pass)]++;
+                }
+            }
+        }
+    });
+    std::array<Histogram, PASS_COUNT> histograms{};
+    for (const auto &chunk : chunkHistograms) {
+        for (uint32_t pass = 0; pass < PASS_COUNT; pass++) {
+            for (uint32_t b = 0; b < BUCKET_COUNT; b++) {
+                histograms[pass][b] += chunk[pass][b];
+            }
+        }
+    }
+
+    std::vector<Histogram> offsets(chunkCount);
+    for (uint32_t pass : activePasses(histograms, count)) {
+        // Per-chunk counts of this pass' digit; the earlier passes reordered the keys
+        jobSystem.parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+            for (size_t chunk = first; chunk < last; chunk++) {
+                Histogram &histogram = offsets[chunk];
+                histogram = {};
+                const size_t end = std::min(count, (chunk + 1) * chunkSize);
+                for (size_t i = chunk * chunkSize; i < end; i++) {
+                    histogram[digit(keys[i], pass)]++;
+                }
+            }
+        });
+
+        // Bucket-major, then chunk order: each chunk writes its keys of a bucket after the previous chunk's
+        uint32_t sum = 0;
+        for (uint32_t b = 0; b < BUCKET_COUNT; b++) {
+            for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+                const uint32_t n = offsets[chunk][b];
+                offsets[chunk][b] = sum;
+                sum += n;
+            }
+        }
+
+        jobSystem.parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+            for (size_t chunk = first; chunk < last; chunk++) {
+                Histogram &offset = offsets[chunk];
+                const size_t end = std::min(count, (chunk + 1) * chunkSize);
+                for (size_t i = chunk * chunkSize; i < end; i++) {
+                    scratch[offset[digit(keys[i], pass)]++] = keys[i];
+                }
+            }
+        });
+        std::swap(keys, scratch);
+    }
+}
+}
+
+namespace radix {
+
+void sort(std::vector<uint64_t> &keys, std::vector<uint64_t> &scratch, JobSystem *jobSystem) {
+    scratch.resize(keys.size());
+    if (jobSystem && keys.size() >= PARALLEL_SORT_SIZE && jobSystem->getThreadCount() > 0)
+        sortParallel(keys, scratch, *jobSystem);
+    else
+        sortSerial(keys, scratch);
+}
+
+}
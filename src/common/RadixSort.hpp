@@ -0,0 +1,31 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+/**
+ * RadixSort
+ *
+ * LSD radix sort of 64-bit keys, 8 bits per pass. One counting sweep up front
+ * gives every digit's global histogram; passes whose digit is the same for
+ * all keys (the high bits of small indices, material bits of a one-material
+ * scene) are skipped, so the sort only pays for the bits that actually vary.
+ *
+ * Large inputs run each remaining pass on the job system: every chunk counts
+ * its digits, the per-chunk offsets are a prefix sum over (digit, chunk), and
+ * every chunk scatters its keys in order, so the passes stay stable. Small
+ * inputs sort on the calling thread, which reuses the up-front histogram.
+ */
+namespace radix {
+
+// Sorts 'keys' ascending. 'scratch' is resized to match and may end up swapped with 'keys';
+// pass the same pair every frame and neither reallocates once grown.
+void sort(std::vector<uint64_t> &keys, std::vector<uint64_t> &scratch, JobSystem *jobSystem = nullptr);
+
+}
@@ -0,0 +1,108 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "SimdMath.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define SIMD_MATH_SSE 1
+#endif
+
+namespace simd {
+
+namespace {
+constexpr float DET_EPSILON = 1e-12f;
+
+const float *matrixAt(const float *base, size_t stride, size_t i) {
+    return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(base) + stride * i);
+}
+
+float *matrixAt(float *base, size_t stride, size_t i) {
+    return reinterpret_cast<float *>(reinterpret_cast<uint8_t *>(base) + stride * i);
+}
+
+// Columns of inverse-transpose(A) are (a1 x a2, a2 x a0, a0 x a1) / det(A)
+void normalMatrixScalar(const float *m, float *out) {
+    const float *a0 = m, *a1 = m + 4, *a2 = m + 8;
+
+    const float c0[3] = {a1[1] * a2[2] - a1[2] * a2[1], a1[2] * a2[0] - a1[0] * a2[2], a1[0] * a2[1] - a1[1] * a2[0]};
+    const float c1[3] = {a2[1] * a0[2] - a2[2] * a0[1], a2[2] * a0[0] - a2[0] * a0[2], a2[0] * a0[1] - a2[1] * a0[0]};
+    const float c2[3] = {a0[1] * a1[2] - a0[2] * a1[1], a0[2] * a1[0] - a0[0] * a1[2], a0[0] * a1[1] - a0[1] * a1[0]};
+
+    const float det = a0[0] * c0[0] + a0[1] * c0[1] + a0[2] * c0[2];
+    const float invDet = std::fabs(det) > DET_EPSILON ? 1.0f / det : 1.0f;
+
+    for (int r = 0; r < 3; r++) {
+        out[0 + r] = c0[r] * invDet;
+        out[4 + r] = c1[r] * invDet;
+        out[8 + r] = c2[r] * invDet;
+    }
+    out[3] = out[7] = out[11] = 0.0f;
+}
+}
+
+void normalMatrices(const float *src, size_t srcStride, float *dst, size_t dstStride, size_t count) {
+    size_t i = 0;
+
+#ifdef SIMD_MATH_SSE
+    // Four matrices at a time in SoA form: after the transpose, lane j of x0 is
+    // element (0,0) of matrix i + j, and so on. Every op below does four matrices.
+    for (; i + 4 <= count; i += 4) {
+        __m128 x[3], y[3], z[3];
+        for (int c = 0; c < 3; c++) {
+            __m128 r0 = _mm_loadu_ps(matrixAt(src, srcStride, i + 0) + 4 * c);
+            __m128 r1 = _mm_loadu_ps(matrixAt(src, srcStride, i + 1) + 4 * c);
+            __m128 r2 = _mm_loadu_ps(matrixAt(src, srcStride, i + 2) + 4 * c);
+            __m128 r3 = _mm_loadu_ps(matrixAt(src, srcStride, i + 3) + 4 * c);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            x[c] = r0;
+            y[c] = r1;
+            z[c] = r2;
+        }
+
+        auto cross = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz, __m128 out[3]) {
+            out[0] = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+            out[1] = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+            out[2] = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+        };
+
+        __m128 c0[3], c1[3], c2[3];
+        cross(x[1], y[1], z[1], x[2], y[2], z[2], c0);
+        cross(x[2], y[2], z[2], x[0], y[0], z[0], c1);
+        cross(x[0], y[0], z[0], x[1], y[1], z[1], c2);
+
+        const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x[0], c0[0]), _mm_mul_ps(y[0], c0[1])),
+                                      _mm_mul_ps(z[0], c0[2]));
+
+        // |det| <= epsilon -> 1, so singular matrices stay finite
+        const __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+        const __m128 singular = _mm_cmple_ps(absDet, _mm_set1_ps(DET_EPSILON));
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 safeDet = _mm_or_ps(_mm_and_ps(singular, one), _mm_andnot_ps(singular, det));
+        const __m128 invDet = _mm_div_ps(one, safeDet);
+
+        __m128 *columns[3] = {c0, c1, c2};
+        for (int c = 0; c < 3; c++) {
+            __m128 r0 = _mm_mul_ps(columns[c][0], invDet);
+            __m128 r1 = _mm_mul_ps(columns[c][1], invDet);
+            __m128 r2 = _mm_mul_ps(columns[c][2], invDet);
+            __m128 r3 = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(matrixAt(dst, dstStride, i + 0) + 4 * c, r0);
+            _mm_storeu_ps(matrixAt(dst, dstStride, i + 1) + 4 * c, r1);
+            _mm_storeu_ps(matrixAt(dst, dstStride, i + 2) + 4 * c, r2);
+            _mm_storeu_ps(matrixAt(dst, dstStride, i + 3) + 4 * c, r3);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        normalMatrixScalar(matrixAt(src, srcStride, i), matrixAt(dst, dstStride, i));
+    }
+}
+
+}
@@ -0,0 +1,23 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * SimdMath
+ *
+ * Batch matrix kernels for per-object data that used to be computed per
+ * vertex in the shaders. Matrices are column-major float[16] (glm layout);
+ * inputs and outputs are strided so they can live inside larger structs.
+ * SSE path processes four matrices per iteration, the tail runs scalar.
+ */
+namespace simd {
+
+// dst = transpose(inverse(mat3(src))), written as three float[4] columns
+// (std430 mat3 layout, w = 0). Singular matrices yield the cofactor matrix.
+void normalMatrices(const float *src, size_t srcStride, float *dst, size_t dstStride, size_t count);
+
+}
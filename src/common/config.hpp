@@ -4,10 +4,98 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+
 namespace engine {
     // We use 'inline' so it can be included in multiple files without linker errors
     inline constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
+    // Presentation (SwapChain::PresentSettings, FramePacer). 0 images = the surface minimum + 1. In low-latency
+    // mode a frame only starts, and samples input, once no more than MAX_QUEUED_FRAMES frames are still on
+    // their way to the display (VK_KHR_present_wait) or, without it, to the end of the GPU work.
+    inline constexpr uint32_t SWAPCHAIN_IMAGE_COUNT = 0;
+    inline constexpr bool LOW_LATENCY = true;
+    inline constexpr uint32_t MAX_QUEUED_FRAMES = 1;
+
+    // Size of the sampler2D array at set 0, binding 1 (MAX_BOUND_TEXTURES in shaders/include/material.glsl)
+    inline constexpr uint32_t MAX_BOUND_TEXTURES = 64;
+
+    // Bytes of transient per-frame data (view uniforms, object transforms) per frame in flight
+    inline constexpr uint64_t FRAME_ALLOCATOR_SIZE = 8ull << 20;
+    // Sets the first descriptor pool of each frame in flight holds; each pool chained after it doubles that
+    inline constexpr uint32_t DESCRIPTOR_SETS_PER_POOL = 16;
+
+    // The loaded model is instanced over a GRID x GRID layout on the XY plane (Z is up)
+    inline constexpr uint32_t SCENE_GRID_SIZE = 1;
+    inline constexpr float SCENE_GRID_SPACING = 4.0f;
+
+    // CPU frustum culling: flat SIMD kernel over SoA bounds, or hierarchical through the scene BVH
+    inline constexpr bool CULL_WITH_BVH = false;
+
+    // Cascaded shadow maps for the directional light. Splits blend logarithmic and uniform
+    // distribution by LAMBDA over the first SHADOW_DISTANCE units of the view.
+    inline constexpr uint32_t SHADOW_CASCADE_COUNT = 4; // shaders pack the splits in a vec4
+    inline constexpr uint32_t SHADOW_MAP_SIZE = 2048;
+    inline constexpr float SHADOW_DISTANCE = 60.0f;
+    inline constexpr float SHADOW_SPLIT_LAMBDA = 0.75f;
+    // Each cascade covers PADDING x its slice, so the camera can move before the static cache is re-rendered
+    inline constexpr float SHADOW_CASCADE_PADDING = 1.2f;
+    // Dynamic casters are redrawn every N frames per cascade; far cascades get away with less
+    inline constexpr std::array<uint32_t, SHADOW_CASCADE_COUNT> SHADOW_CASCADE_UPDATE_INTERVAL = {1, 1, 2, 4};
+
+    // Point and spot lights. Their shadows share one depth atlas; tiles are sized by screen
+    // coverage and at most SHADOW_ATLAS_UPDATE_BUDGET texels are re-rendered per frame.
+    inline constexpr uint32_t MAX_LOCAL_LIGHTS = 64; // MAX_LOCAL_LIGHTS in shaders/include/lights.glsl
+    inline constexpr uint32_t SHADOW_ATLAS_SIZE = 4096;
+    inline constexpr uint32_t SHADOW_ATLAS_MIN_TILE = 128;
+    inline constexpr uint32_t SHADOW_ATLAS_MAX_TILE = 1024;
+    inline constexpr uint64_t SHADOW_ATLAS_UPDATE_BUDGET = 2ull * 1024 * 1024;
+
+    // Local lights are binned into screen tiles by a compute pass (LightBinning), so per-pixel
+    // lighting only walks the lights whose volume touches its tile. The pass runs on a dedicated
+    // compute queue when the GPU has one, overlapping the shadow and geometry work.
+    inline constexpr uint32_t LIGHT_TILE_SIZE = 16; // LIGHT_TILE_SIZE in shaders/include/lights.glsl
+    inline constexpr bool ASYNC_COMPUTE = true;
+
+    // Dynamic resolution: the scene renders at a fraction of the output size, picked from the measured
+    // GPU frame time to hold TARGET_GPU_FRAME_MS, and an upscale pass fills the swapchain. Targets are
+    // allocated at MAX_RENDER_SCALE, so a new scale only changes the viewport.
+    inline constexpr bool DYNAMIC_RESOLUTION = true;
+    inline constexpr float TARGET_GPU_FRAME_MS = 15.0f; // 60 Hz with some headroom for the CPU side
+    inline constexpr float MIN_RENDER_SCALE = 0.5f;
+    inline constexpr float MAX_RENDER_SCALE = 1.0f;
+    // Render targets and history are sized in steps of this many pixels and only reallocated when a resize
+    // outgrows them or leaves most of them unused (SwapChain::recreate), so dragging a window edge is cheap
+    inline constexpr uint32_t TARGET_GRANULARITY = 128;
+
+    // Temporal anti-aliasing: the projection is jittered by a sub-pixel Halton offset every frame and the
+    // resolve pass accumulates the frames in a history at output resolution, which also upsamples when the
+    // render scale is below 1. The sequence repeats every TAA_JITTER_PHASES frames at full scale, more
+    // below it, so each output pixel still sees about as many distinct samples.
+    inline constexpr bool TEMPORAL_AA = true;
+    inline constexpr uint32_t TAA_JITTER_PHASES = 8;
+
+    // Screen-space ambient occlusion of the deferred lighting (AmbientOcclusion): half resolution, bilateral
+    // blur, depth-aware upsampling. It needs the G-buffer in memory between geometry and lighting, so while
+    // it is off (always with SSAO = false) the G-buffer stays transient instead. It starts off on devices with
+    // lazily allocated memory, where that keeps the G-buffer on chip. Enabled, radius, intensity and quality
+    // are runtime settings; these are the defaults.
+    inline constexpr bool SSAO = true;
+    inline constexpr float SSAO_RADIUS = 0.5f; // world units
+    inline constexpr float SSAO_INTENSITY = 1.0f;
+
+    // HDR post chain (PostProcess): lighting accumulates in RGBA16F, one compute dispatch builds the bloom mips
+    // and the luminance histogram, and the output pass applies exposure, bloom and the tonemap on its way to the
+    // swapchain. Runtime settings; these are the defaults.
+    inline constexpr float BLOOM_THRESHOLD = 1.0f; // scene radiance where bloom starts, before exposure
+    inline constexpr float BLOOM_INTENSITY = 0.05f;
+    inline constexpr float EXPOSURE_COMPENSATION = 0.0f; // EV on top of the auto exposure
+    inline constexpr float EXPOSURE_ADAPTATION_RATE = 1.5f; // per second; higher adapts faster
+
+    // Recompile edited shaders and swap in the rebuilt pipelines while running (ShaderLibrary, GraphicsPipeline)
+    inline constexpr bool SHADER_HOT_RELOAD = true;
+
     // You can also put other engine-wide settings here later
     inline constexpr bool ENABLE_VALIDATION_LAYERS = true;
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "AmbientOcclusion.hpp"
+
+#include <stdexcept>
+
+#include "vulkan/DeletionQueue.hpp"
+#include "vulkan/VulkanContext.hpp"
+
+namespace {
+// local_size of shaders/compute/ssao.comp and ssao_blur.comp
+constexpr uint32_t GROUP_SIZE = 8;
+
+// Which image each pass writes (and the blurs read the other one)
+constexpr std::array<uint32_t, AmbientOcclusion::PASS_COUNT> PASS_TARGET = {0, 1, 0};
+
+vk::Extent2D halfExtent(vk::Extent2D extent) {
+    return {(extent.width + 1) / 2, (extent.height + 1) / 2};
+}
+}
+
+AmbientOcclusion::AmbientOcclusion(VulkanContext &context, VmaAllocator allocator)
+    : context_(context), allocator_(allocator) {
+    // Everything is read with texelFetch; the sampler only has to exist
+    sampler_ = context_.getDevice().createSampler(
+        vk::SamplerCreateInfo()
+        .setMagFilter(vk::Filter::eNearest)
+        .setMinFilter(vk::Filter::eNearest)
+        .setMipmapMode(vk::SamplerMipmapMode::eNearest)
+        .setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+        .setMaxLod(0.0f));
+}
+
+AmbientOcclusion::~AmbientOcclusion() {
+    destroyImages(images_);
+    if (sampler_)
+        context_.getDevice().destroySampler(sampler_);
+}
+
+void AmbientOcclusion::destroyImages(std::array<Image, IMAGE_COUNT> &images) const {
+    for (auto &image : images) {
+        if (image.view)
+            context_.getDevice().destroyImageView(image.view);
+        if (image.image)
+            vmaDestroyImage(allocator_, image.image, image.allocation);
+        image = {};
+    }
+}
+
+void AmbientOcclusion::resize(vk::Extent2D maxExtent, DeletionQueue &deletionQueue) {
+    // Frames in flight may still sample the old images
+    deletionQueue.push([this, images = images_]() mutable { destroyImages(images); });
+    const auto extent = halfExtent(maxExtent);
+
+    for (auto &image : images_) {
+        VkImageCreateInfo imageInfo = vk::ImageCreateInfo()
+                                      .setImageType(vk::ImageType::e2D)
+                                      .setExtent({extent.width, extent.height, 1})
+                                      .setMipLevels(1)
+                                      .setArrayLayers(1)
+                                      .setFormat(FORMAT)
+                                      .setTiling(vk::ImageTiling::eOptimal)
+                                      .setInitialLayout(vk::ImageLayout::eUndefined)
+                                      .setUsage(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled)
+                                      .setSamples(vk::SampleCountFlagBits::e1)
+                                      .setSharingMode(vk::SharingMode::eExclusive);
+
+        VmaAllocationCreateInfo allocInfo{};
+        allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+        VkImage rawImage;
+        if (vmaCreateImage(allocator_, &imageInfo, &allocInfo, &rawImage, &image.allocation, nullptr) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create ambient occlusion image!");
+        }
+        image.image = rawImage;
+        image.view = context_.getDevice().createImageView(
+            vk::ImageViewCreateInfo()
+            .setImage(image.image)
+            .setViewType(vk::ImageViewType::e2D)
+            .setFormat(FORMAT)
+            .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1}));
+    }
+}
+
+void AmbientOcclusion::record(vk::CommandBuffer commandBuffer, vk::Extent2D renderExtent,
+                              const BindCallback &bind) const {
+    // Last frame's lighting is done reading; the contents are rewritten, so they are discarded
+    std::array<vk::ImageMemoryBarrier2, IMAGE_COUNT> discard;
+    for (uint32_t i = 0; i < IMAGE_COUNT; i++) {
+        discard[i] = vk::ImageMemoryBarrier2()
+                     .setSrcStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+                     .setSrcAccessMask(vk::AccessFlagBits2::eNone)
+                     .setDstStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+                     .setDstAccessMask(vk::AccessFlagBits2::eShaderStorageWrite)
+                     .setOldLayout(vk::ImageLayout::eUndefined)
+                     .setNewLayout(vk::ImageLayout::eGeneral)
+                     .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                     .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                     .setImage(images_[i].image)
+                     .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
+    }
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(discard));
+
+    const auto extent = halfExtent(renderExtent);
+    for (uint32_t pass = 0; pass < PASS_COUNT; pass++) {
+        bind(commandBuffer, static_cast<Pass>(pass));
+        commandBuffer.dispatch((extent.width + GROUP_SIZE - 1) / GROUP_SIZE,
+                               (extent.height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+        // The next pass samples what this one wrote; after the last one, the lighting does
+        const bool last = pass + 1 == PASS_COUNT;
+        auto barrier = vk::ImageMemoryBarrier2()
+                       .setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+                       .setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageWrite)
+                       .setDstStageMask(last ? vk::PipelineStageFlagBits2::eFragmentShader
+                                             : vk::PipelineStageFlagBits2::eComputeShader)
+                       .setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead)
+                       .setOldLayout(vk::ImageLayout::eGeneral)
+                       .setNewLayout(vk::ImageLayout::eGeneral)
+                       .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                       .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                       .setImage(images_[PASS_TARGET[pass]].image)
+                       .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(barrier));
+    }
+}
+
+glm::vec4 AmbientOcclusion::getUniform(bool active) const {
+    const float samples = active ? static_cast<float>(settings_.quality) : 0.0f;
+    return {settings_.radius, settings_.intensity, samples, 0.0f};
+}
+
+std::array<vk::DescriptorImageInfo, AmbientOcclusion::IMAGE_COUNT> AmbientOcclusion::getStorageInfos() const {
+    std::array<vk::DescriptorImageInfo, IMAGE_COUNT> infos;
+    for (uint32_t i = 0; i < IMAGE_COUNT; i++) {
+        infos[i] = vk::DescriptorImageInfo(nullptr, images_[i].view, vk::ImageLayout::eGeneral);
+    }
+    return infos;
+}
+
+std::array<vk::DescriptorImageInfo, AmbientOcclusion::IMAGE_COUNT> AmbientOcclusion::getTextureInfos() const {
+    std::array<vk::DescriptorImageInfo, IMAGE_COUNT> infos;
+    for (uint32_t i = 0; i < IMAGE_COUNT; i++) {
+        infos[i] = vk::DescriptorImageInfo(sampler_, images_[i].view, vk::ImageLayout::eGeneral);
+    }
+    return infos;
+}
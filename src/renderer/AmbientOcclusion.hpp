@@ -0,0 +1,111 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <glm/glm.hpp>
+#include <vma/vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+#include "common/config.hpp"
+
+class DeletionQueue;
+class VulkanContext;
+
+/**
+ * AmbientOcclusion
+ *
+ * Screen-space ambient occlusion for the deferred lighting, at half the render
+ * resolution. Three compute passes run between the two halves of the split
+ * G-buffer pass (RenderPass::getGeometryRenderPass):
+ *   OCCLUSION  samples a normal-oriented hemisphere of 'radius' around each
+ *              half-res pixel against the full-res depth (shaders/compute/ssao.comp)
+ *   BLUR_X/Y   separable bilateral blur: neighbours across a depth edge do not
+ *              bleed into each other (shaders/compute/ssao_blur.comp)
+ * The result holds the occlusion and the view depth it was computed at, so the
+ * lighting pass can upsample it depth-aware (shaders/include/ssao.glsl) and scale
+ * its ambient term with it.
+ *
+ * Two half-res images ping-pong between the passes; both stay in the general
+ * layout and are sampled from set 1 by index. The settings are plain uniforms
+ * (ViewUniforms::ambientOcclusion), so changing them costs nothing.
+ */
+class AmbientOcclusion {
+public:
+    enum Pass : uint32_t {
+        OCCLUSION = 0,
+        BLUR_X,
+        BLUR_Y,
+        PASS_COUNT
+    };
+
+    // Hemisphere samples per half-res pixel
+    enum class Quality : uint32_t {
+        Low = 4,
+        Medium = 8,
+        High = 16,
+    };
+
+    struct Settings {
+        bool enabled = engine::SSAO;
+        Quality quality = Quality::Medium;
+        float radius = engine::SSAO_RADIUS; // world units
+        float intensity = engine::SSAO_INTENSITY; // 0 = no darkening
+    };
+
+    // Set 1 bindings, after the temporal resolve's (taa::HISTORY_BINDING). The images are an array of
+    // IMAGE_COUNT, as storage images and as textures; the final result is always in image 0.
+    static constexpr uint32_t DEPTH_BINDING = 8;
+    static constexpr uint32_t NORMAL_BINDING = 9;
+    static constexpr uint32_t IMAGE_BINDING = 10;
+    static constexpr uint32_t TEXTURE_BINDING = 11;
+    static constexpr uint32_t IMAGE_COUNT = 2;
+    // r = ambient visibility, g = view depth; a guaranteed storage format
+    static constexpr vk::Format FORMAT = vk::Format::eR16G16B16A16Sfloat;
+
+    // Binds the pipeline of 'pass' and both sets at the compute bind point; the dispatch is recorded here
+    using BindCallback = std::function<void(vk::CommandBuffer, Pass)>;
+
+    AmbientOcclusion(VulkanContext &context, VmaAllocator allocator);
+    ~AmbientOcclusion();
+
+    AmbientOcclusion(const AmbientOcclusion &) = delete;
+    AmbientOcclusion &operator=(const AmbientOcclusion &) = delete;
+
+    // (Re)creates the images at half of 'maxExtent'; the old ones go to 'deletionQueue'
+    void resize(vk::Extent2D maxExtent, DeletionQueue &deletionQueue);
+
+    // All three passes over half of 'renderExtent'. The G-buffer writes were made visible by the geometry
+    // half of the main pass; the result is made visible to the lighting fragment shaders.
+    void record(vk::CommandBuffer commandBuffer, vk::Extent2D renderExtent, const BindCallback &bind) const;
+
+    void setSettings(const Settings &settings) { settings_ = settings; }
+    [[nodiscard]] const Settings &getSettings() const { return settings_; }
+    // ViewUniforms::ambientOcclusion: x = radius, y = intensity, z = sample count (0 = off this frame)
+    [[nodiscard]] glm::vec4 getUniform(bool active) const;
+
+    [[nodiscard]] std::array<vk::DescriptorImageInfo, IMAGE_COUNT> getStorageInfos() const;
+    [[nodiscard]] std::array<vk::DescriptorImageInfo, IMAGE_COUNT> getTextureInfos() const;
+    // Point sampler for the depth and normal inputs as well
+    [[nodiscard]] vk::Sampler getSampler() const { return sampler_; }
+
+private:
+    struct Image {
+        vk::Image image;
+        VmaAllocation allocation = nullptr;
+        vk::ImageView view;
+    };
+
+    VulkanContext &context_;
+    VmaAllocator allocator_;
+    Settings settings_{};
+
+    std::array<Image, IMAGE_COUNT> images_{};
+    vk::Sampler sampler_;
+
+    void destroyImages(std::array<Image, IMAGE_COUNT> &images) const;
+};
@@ -2,4 +2,55 @@
 // Created by johnny on 1/25/26.
 //
 
-#include "Camera.hpp"
\ No newline at end of file
+#include "Camera.hpp"
+
+namespace {
+// Radical inverse of 'index' in 'base': its digits mirrored around the point, in [0, 1)
+float halton(uint32_t index, uint32_t base) {
+    float result = 0.0f;
+    float fraction = 1.0f;
+    while (index > 0) {
+        fraction /= static_cast<float>(base);
+        result += fraction * static_cast<float>(index % base);
+        index /= base;
+    }
+    return result;
+}
+}
+
+std::array<glm::vec4, 6> Camera::extractFrustumPlanes(const glm::mat4 &viewProj) {
+    // Gribb/Hartmann on the rows of the matrix (glm is column-major, so row i is m[*][i]).
+    // Clip space is -w <= x, y <= w and 0 <= z <= w (GLM_FORCE_DEPTH_ZERO_TO_ONE).
+    auto row = [&](int i) { return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]); };
+    const glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+    std::array<glm::vec4, 6> planes = {
+        r3 + r0, // left
+        r3 - r0, // right
+        r3 + r1, // bottom (top in Vulkan's flipped Y; the pair is what matters)
+        r3 - r1, // top
+        r2, // near
+        r3 - r2, // far
+    };
+    for (auto &plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return planes;
+}
+
+Ray Camera::screenPointToRay(float x, float y, float width, float height) const {
+    // The projection already flips Y for Vulkan, so pixel (0, 0) maps straight to NDC (-1, -1)
+    const glm::vec2 ndc(2.0f * x / width - 1.0f, 2.0f * y / height - 1.0f);
+    const glm::mat4 invViewProj = glm::inverse(getProjectionMatrix(width / height) * getViewMatrix());
+
+    glm::vec4 nearPoint = invViewProj * glm::vec4(ndc, 0.0f, 1.0f);
+    glm::vec4 farPoint = invViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+    nearPoint /= nearPoint.w;
+    farPoint /= farPoint.w;
+
+    return {glm::vec3(nearPoint), glm::normalize(glm::vec3(farPoint - nearPoint))};
+}
+
+glm::vec2 Camera::haltonJitter(uint32_t index) {
+    return glm::vec2(halton(index, 2), halton(index, 3)) - 0.5f;
+}
@@ -7,11 +7,14 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <GLFW/glfw3.h>
 #include <algorithm>
+#include <array>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 #include <ostream>
 
+#include "scene/Bounds.hpp"
+
 class Camera {
 public:
     // Position state
@@ -29,6 +32,8 @@ public:
     float movementSpeed = 2.5f;
     float mouseSensitivity = 0.02f;
     float fov = 45.0f;
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
 
     Camera(glm::vec3 startPosition = glm::vec3(-2.0f, -2.0f, 2.0f),
            float startYaw = 45.0f, float startPitch = -30.0f)
@@ -41,13 +46,27 @@ public:
         return glm::lookAt(position, position + forward, up);
     }
 
-    // Returns the projection matrix for the UBO
-    [[nodiscard]] glm::mat4 getProjectionMatrix(float aspectRatio) const {
-        auto proj = glm::perspective(glm::radians(fov), aspectRatio, 0.1f, 100.0f);
+    // Returns the projection matrix for the UBO. 'jitter' shifts the whole image by that much NDC
+    // (2 * pixels / size), for temporal anti-aliasing; see haltonJitter.
+    [[nodiscard]] glm::mat4 getProjectionMatrix(float aspectRatio, glm::vec2 jitter = glm::vec2(0.0f)) const {
+        auto proj = glm::perspective(glm::radians(fov), aspectRatio, nearPlane, farPlane);
         proj[1][1] *= -1; // Vulkan Y-flip
+        // Applied after the projection: clip xy += jitter * w, so NDC moves by exactly 'jitter' at any depth
+        proj = glm::translate(glm::mat4(1.0f), glm::vec3(jitter, 0.0f)) * proj;
         return proj;
     }
 
+    // Sub-pixel offset of frame 'index' (from 1) in pixels, within [-0.5, 0.5): the Halton (2, 3) sequence,
+    // which covers the pixel evenly for any number of consecutive frames
+    static glm::vec2 haltonJitter(uint32_t index);
+
+    // World-space planes (xyz = inward normal, w = distance) of the clip volume of 'viewProj',
+    // in the order left, right, bottom, top, near, far. Normalised, so dot(p.xyz, x) + p.w is a distance.
+    static std::array<glm::vec4, 6> extractFrustumPlanes(const glm::mat4 &viewProj);
+
+    // World-space ray through a window pixel (origin top-left), for picking
+    [[nodiscard]] Ray screenPointToRay(float x, float y, float width, float height) const;
+
     // Process keyboard input
     void handleInput(GLFWwindow *window, float deltaTime) {
         float velocity = movementSpeed * deltaTime;
@@ -0,0 +1,387 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "CascadedShadowMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "vulkan/VulkanContext.hpp"
+
+CascadedShadowMap::CascadedShadowMap(VulkanContext &context, VmaAllocator allocator)
+    : context_(context), allocator_(allocator) {
+    chooseFormat();
+    createRenderPasses();
+    createDepthArray(shadowMap_, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+                     dynamicPass_);
+    createDepthArray(staticCache_, vk::ImageUsageFlagBits::eTransferSrc, staticPass_);
+
+    arrayView_ = context_.getDevice().createImageView(
+        vk::ImageViewCreateInfo()
+        .setImage(shadowMap_.image)
+        .setViewType(vk::ImageViewType::e2DArray)
+        .setFormat(format_)
+        .setSubresourceRange({vk::ImageAspectFlagBits::eDepth, 0, 1, 0, engine::SHADOW_CASCADE_COUNT}));
+
+    createSampler();
+    setLightDirection(lightDirection_);
+}
+
+CascadedShadowMap::~CascadedShadowMap() {
+    auto device = context_.getDevice();
+    device.destroySampler(sampler_);
+    device.destroyImageView(arrayView_);
+    destroyDepthArray(staticCache_);
+    destroyDepthArray(shadowMap_);
+    device.destroyRenderPass(dynamicPass_);
+    device.destroyRenderPass(staticPass_);
+}
+
+void CascadedShadowMap::chooseFormat() {
+    format_ = context_.findShadowMapFormat(linearFilter_);
+
+    // Casters between the light and the near plane are clamped instead of clipped
+    depthClamp_ = context_.getPhysicalDevice().getFeatures().depthClamp;
+}
+
+void CascadedShadowMap::createRenderPasses() {
+    auto depthRef = vk::AttachmentReference()
+                    .setAttachment(0)
+                    .setLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal);
+
+    auto subpass = vk::SubpassDescription()
+                   .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+                   .setPDepthStencilAttachment(&depthRef);
+
+    const auto fragmentTests = vk::PipelineStageFlagBits::eEarlyFragmentTests |
+                               vk::PipelineStageFlagBits::eLateFragmentTests;
+
+    // Static layer: cleared, rendered, then only ever read by the copy into the sampled layer
+    {
+        auto attachment = vk::AttachmentDescription()
+                          .setFormat(format_)
+                          .setSamples(vk::SampleCountFlagBits::e1)
+                          .setLoadOp(vk::AttachmentLoadOp::eClear)
+                          .setStoreOp(vk::AttachmentStoreOp::eStore)
+                          .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
+                          .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
+                          .setInitialLayout(vk::ImageLayout::eUndefined)
+                          .setFinalLayout(vk::ImageLayout::eTransferSrcOptimal);
+
+        std::array<vk::SubpassDependency, 2> dependencies = {
+            // Earlier copies out of this layer finish before it is cleared
+            vk::SubpassDependency()
+            .setSrcSubpass(VK_SUBPASS_EXTERNAL)
+            .setDstSubpass(0)
+            .setSrcStageMask(vk::PipelineStageFlagBits::eTransfer)
+            .setSrcAccessMask({})
+            .setDstStageMask(fragmentTests)
+            .setDstAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentRead |
+                              vk::AccessFlagBits::eDepthStencilAttachmentWrite),
+            vk::SubpassDependency()
+            .setSrcSubpass(0)
+            .setDstSubpass(VK_SUBPASS_EXTERNAL)
+            .setSrcStageMask(vk::PipelineStageFlagBits::eLateFragmentTests)
+            .setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+            .setDstStageMask(vk::PipelineStageFlagBits::eTransfer)
+            .setDstAccessMask(vk::AccessFlagBits::eTransferRead)
+        };
+
+        staticPass_ = context_.getDevice().createRenderPass(
+            vk::RenderPassCreateInfo().setAttachments(attachment).setSubpasses(subpass).setDependencies(dependencies));
+    }
+
+    // Sampled layer: starts from the copied static depth, dynamic casters on top, then read by lighting
+    {
+        auto attachment = vk::AttachmentDescription()
+                          .setFormat(format_)
+                          .setSamples(vk::SampleCountFlagBits::e1)
+                          .setLoadOp(vk::AttachmentLoadOp::eLoad)
+                          .setStoreOp(vk::AttachmentStoreOp::eStore)
+                          .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
+                          .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
+                          .setInitialLayout(vk::ImageLayout::eTransferDstOptimal)
+                          .setFinalLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+        std::array<vk::SubpassDependency, 2> dependencies = {
+            vk::SubpassDependency()
+            .setSrcSubpass(VK_SUBPASS_EXTERNAL)
+            .setDstSubpass(0)
+            .setSrcStageMask(vk::PipelineStageFlagBits::eTransfer)
+            .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+            .setDstStageMask(fragmentTests)
+            .setDstAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentRead |
+                              vk::AccessFlagBits::eDepthStencilAttachmentWrite),
+            vk::SubpassDependency()
+            .setSrcSubpass(0)
+            .setDstSubpass(VK_SUBPASS_EXTERNAL)
+            .setSrcStageMask(vk::PipelineStageFlagBits::eLateFragmentTests)
+            .setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+            .setDstStageMask(vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader)
+            .setDstAccessMask(vk::AccessFlagBits::eShaderRead)
+        };
+
+        dynamicPass_ = context_.getDevice().createRenderPass(
+            vk::RenderPassCreateInfo().setAttachments(attachment).setSubpasses(subpass).setDependencies(dependencies));
+    }
+}
+
+void CascadedShadowMap::createDepthArray(DepthArray &target, vk::ImageUsageFlags usage, vk::RenderPass renderPass) {
+    VkImageCreateInfo imageInfo = vk::ImageCreateInfo()
+                                  .setImageType(vk::ImageType::e2D)
+                                  .setExtent({engine::SHADOW_MAP_SIZE, engine::SHADOW_MAP_SIZE, 1})
+                                  .setMipLevels(1)
+                                  .setArrayLayers(engine::SHADOW_CASCADE_COUNT)
+                                  .setFormat(format_)
+                                  .setTiling(vk::ImageTiling::eOptimal)
+                                  .setInitialLayout(vk::ImageLayout::eUndefined)
+                                  .setUsage(usage | vk::ImageUsageFlagBits::eDepthStencilAttachment)
+                                  .setSamples(vk::SampleCountFlagBits::e1)
+                                  .setSharingMode(vk::SharingMode::eExclusive);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+
+    VkImage rawImage;
+    if (vmaCreateImage(allocator_, &imageInfo, &allocInfo, &rawImage, &target.allocation, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow map image!");
+    }
+    target.image = rawImage;
+
+    auto device = context_.getDevice();
+    for (uint32_t layer = 0; layer < engine::SHADOW_CASCADE_COUNT; layer++) {
+        target.layerViews[layer] = device.createImageView(
+            vk::ImageViewCreateInfo()
+            .setImage(target.image)
+            .setViewType(vk::ImageViewType::e2D)
+            .setFormat(format_)
+            .setSubresourceRange({vk::ImageAspectFlagBits::eDepth, 0, 1, layer, 1}));
+
+        target.framebuffers[layer] = device.createFramebuffer(
+            vk::FramebufferCreateInfo()
+            .setRenderPass(renderPass)
+            .setAttachments(target.layerViews[layer])
+            .setWidth(engine::SHADOW_MAP_SIZE)
+            .setHeight(engine::SHADOW_MAP_SIZE)
+            .setLayers(1));
+    }
+}
+
+void CascadedShadowMap::destroyDepthArray(DepthArray &target) {
+    auto device = context_.getDevice();
+    for (uint32_t layer = 0; layer < engine::SHADOW_CASCADE_COUNT; layer++) {
+        device.destroyFramebuffer(target.framebuffers[layer]);
+        device.destroyImageView(target.layerViews[layer]);
+    }
+    if (target.image) {
+        vmaDestroyImage(allocator_, target.image, target.allocation);
+        target.image = nullptr;
+    }
+}
+
+void CascadedShadowMap::createSampler() {
+    // Comparison sampler: with linear filtering the hardware returns a 2x2 PCF result per tap.
+    // Outside the map counts as lit.
+    const vk::Filter filter = linearFilter_ ? vk::Filter::eLinear : vk::Filter::eNearest;
+    auto samplerInfo = vk::SamplerCreateInfo()
+                       .setMagFilter(filter)
+                       .setMinFilter(filter)
+                       .setMipmapMode(vk::SamplerMipmapMode::eNearest)
+                       .setAddressModeU(vk::SamplerAddressMode::eClampToBorder)
+                       .setAddressModeV(vk::SamplerAddressMode::eClampToBorder)
+                       .setAddressModeW(vk::SamplerAddressMode::eClampToBorder)
+                       .setBorderColor(vk::BorderColor::eFloatOpaqueWhite)
+                       .setCompareEnable(true)
+                       .setCompareOp(vk::CompareOp::eLessOrEqual)
+                       .setMinLod(0.0f)
+                       .setMaxLod(0.0f);
+
+    sampler_ = context_.getDevice().createSampler(samplerInfo);
+}
+
+vk::DescriptorImageInfo CascadedShadowMap::getDescriptorInfo() const {
+    return {sampler_, arrayView_, vk::ImageLayout::eShaderReadOnlyOptimal};
+}
+
+void CascadedShadowMap::setLightDirection(const glm::vec3 &towardsLight) {
+    const glm::vec3 direction = glm::normalize(towardsLight);
+    if (!invalidated_ && glm::dot(direction, lightDirection_) > 0.999999f)
+        return;
+
+    lightDirection_ = direction;
+    // Fixed basis per light direction: camera motion only ever translates the cascades
+    const glm::vec3 up = std::abs(direction.z) > 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+    lightRotation_ = glm::lookAt(glm::vec3(0.0f), -direction, up);
+    invalidateStatic();
+}
+
+void CascadedShadowMap::invalidateStatic() {
+    invalidated_ = true;
+}
+
+void CascadedShadowMap::buildMatrix(Cascade &cascade, float halfSize) const {
+    const glm::mat4 projection = glm::ortho(cascade.anchor.x - halfSize, cascade.anchor.x + halfSize,
+                                            cascade.anchor.y - halfSize, cascade.anchor.y + halfSize,
+                                            cascade.depthNear, cascade.depthFar);
+    cascade.viewProj = projection * lightRotation_;
+    cascade.planes = Camera::extractFrustumPlanes(cascade.viewProj);
+    // Casters between the light and the box still cast into it (depth clamp), so never cull on the near plane
+    cascade.planes[4] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+void CascadedShadowMap::update(const Camera &camera, float aspectRatio, const Aabb &casterBounds,
+                               uint64_t frameNumber) {
+    const float nearPlane = camera.nearPlane;
+    const float farPlane = std::min(camera.farPlane, engine::SHADOW_DISTANCE);
+
+    // Squared slope of the frustum's corner rays: a slice corner at depth d is d * sqrt(k2) off the axis
+    const float tanHalfFov = std::tan(glm::radians(camera.fov) * 0.5f);
+    const float k2 = tanHalfFov * tanHalfFov * (1.0f + aspectRatio * aspectRatio);
+
+    // Light-space depth range of the casters, taken at each re-anchor
+    float casterNear = -1.0f, casterFar = 1.0f;
+    if (!casterBounds.isEmpty()) {
+        const Aabb lightBounds = casterBounds.transformed(lightRotation_);
+        // Looking down -z: the box's max z is closest to the light
+        const float margin = 1.0f + 0.05f * (lightBounds.max.z - lightBounds.min.z);
+        casterNear = -lightBounds.max.z - margin;
+        casterFar = -lightBounds.min.z + margin;
+    }
+
+    float sliceNear = nearPlane;
+    for (uint32_t i = 0; i < engine::SHADOW_CASCADE_COUNT; i++) {
+        Cascade &cascade = cascades_[i];
+
+        // Practical split scheme
+        const float p = static_cast<float>(i + 1) / static_cast<float>(engine::SHADOW_CASCADE_COUNT);
+        const float logSplit = nearPlane * std::pow(farPlane / nearPlane, p);
+        const float uniformSplit = nearPlane + (farPlane - nearPlane) * p;
+        const float sliceFar = glm::mix(uniformSplit, logSplit, engine::SHADOW_SPLIT_LAMBDA);
+        cascade.splitFar = sliceFar;
+
+        // Smallest sphere through the slice's near and far corners, centred on the view axis.
+        // Depends only on the slice, never on the camera's orientation.
+        const float centerDistance = std::min(0.5f * (sliceNear + sliceFar) * (1.0f + k2), sliceFar);
+        float radius = std::sqrt((sliceFar - centerDistance) * (sliceFar - centerDistance) +
+                                 sliceFar * sliceFar * k2);
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+        sliceNear = sliceFar;
+
+        const glm::vec3 center = camera.position + camera.forward * centerDistance;
+        const glm::vec2 lightCenter(lightRotation_ * glm::vec4(center, 1.0f));
+
+        // Re-anchor once the sphere leaves the padded box (or it grew, e.g. the FOV changed)
+        const float halfSize = cascade.radius * engine::SHADOW_CASCADE_PADDING;
+        const glm::vec2 reach = glm::abs(lightCenter - cascade.anchor) + radius;
+        if (invalidated_ || radius > cascade.radius || reach.x > halfSize || reach.y > halfSize) {
+            cascade.radius = radius;
+            const float newHalfSize = radius * engine::SHADOW_CASCADE_PADDING;
+            cascade.texelSize = 2.0f * newHalfSize / static_cast<float>(engine::SHADOW_MAP_SIZE);
+            // Snap to whole texels so every re-anchor rasterises on the same grid
+            cascade.anchor = glm::floor(lightCenter / cascade.texelSize) * cascade.texelSize;
+            cascade.depthNear = casterNear;
+            cascade.depthFar = casterFar;
+            buildMatrix(cascade, newHalfSize);
+            cascade.staticDirty = true;
+        }
+
+        const uint32_t interval = engine::SHADOW_CASCADE_UPDATE_INTERVAL[i];
+        cascade.scheduled = cascade.staticDirty || (frameNumber + i) % interval == 0;
+        cascade.renderStatic = cascade.staticDirty;
+        cascade.render = false;
+    }
+    invalidated_ = false;
+}
+
+void CascadedShadowMap::setDynamicCasters(uint32_t cascade, bool present) {
+    Cascade &c = cascades_[cascade];
+    // Nothing to do when the layer already holds exactly the static casters
+    c.render = c.scheduled && (c.renderStatic || present || c.hasDynamic);
+    if (c.render) {
+        c.hasDynamic = present;
+        c.staticDirty = false;
+    }
+}
+
+uint32_t CascadedShadowMap::getRenderedCascadeCount() const {
+    return static_cast<uint32_t>(std::count_if(cascades_.begin(), cascades_.end(),
+                                               [](const Cascade &c) { return c.render; }));
+}
+
+bool CascadedShadowMap::drawsPass(uint32_t cascade, bool staticPass) const {
+    const Cascade &c = cascades_[cascade];
+    return c.render && (staticPass ? c.renderStatic : c.hasDynamic);
+}
+
+vk::CommandBufferInheritanceInfo CascadedShadowMap::getInheritanceInfo(uint32_t cascade, bool staticPass) const {
+    return vk::CommandBufferInheritanceInfo()
+           .setRenderPass(staticPass ? staticPass_ : dynamicPass_)
+           .setSubpass(0)
+           .setFramebuffer(staticPass ? staticCache_.framebuffers[cascade] : shadowMap_.framebuffers[cascade]);
+}
+
+void CascadedShadowMap::record(vk::CommandBuffer commandBuffer, const DrawCallback &draw,
+                               vk::SubpassContents contents) const {
+    const vk::Rect2D area({0, 0}, {engine::SHADOW_MAP_SIZE, engine::SHADOW_MAP_SIZE});
+    vk::ClearValue clearDepth;
+    clearDepth.depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+
+    for (uint32_t i = 0; i < engine::SHADOW_CASCADE_COUNT; i++) {
+        if (!cascades_[i].render)
+            continue;
+
+        if (cascades_[i].renderStatic) {
+            commandBuffer.beginRenderPass(vk::RenderPassBeginInfo()
+                                          .setRenderPass(staticPass_)
+                                          .setFramebuffer(staticCache_.framebuffers[i])
+                                          .setRenderArea(area)
+                                          .setClearValues(clearDepth),
+                                          contents);
+            draw(commandBuffer, i, true);
+            commandBuffer.endRenderPass();
+        }
+
+        // The whole layer is overwritten, so its old contents can be discarded. Earlier frames'
+        // lighting reads of it must be done first.
+        auto barrier = vk::ImageMemoryBarrier2()
+                       .setSrcStageMask(vk::PipelineStageFlagBits2::eVertexShader |
+                                        vk::PipelineStageFlagBits2::eFragmentShader)
+                       .setSrcAccessMask({})
+                       .setDstStageMask(vk::PipelineStageFlagBits2::eCopy)
+                       .setDstAccessMask(vk::AccessFlagBits2::eTransferWrite)
+                       .setOldLayout(vk::ImageLayout::eUndefined)
+                       .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+                       .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                       .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                       .setImage(shadowMap_.image)
+                       .setSubresourceRange({vk::ImageAspectFlagBits::eDepth, 0, 1, i, 1});
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(barrier));
+
+        const vk::ImageSubresourceLayers layer(vk::ImageAspectFlagBits::eDepth, 0, i, 1);
+        commandBuffer.copyImage(staticCache_.image, vk::ImageLayout::eTransferSrcOptimal,
+                                shadowMap_.image, vk::ImageLayout::eTransferDstOptimal,
+                                vk::ImageCopy(layer, {0, 0, 0}, layer, {0, 0, 0},
+                                              {engine::SHADOW_MAP_SIZE, engine::SHADOW_MAP_SIZE, 1}));
+
+        commandBuffer.beginRenderPass(vk::RenderPassBeginInfo()
+                                      .setRenderPass(dynamicPass_)
+                                      .setFramebuffer(shadowMap_.framebuffers[i])
+                                      .setRenderArea(area),
+                                      contents);
+        if (cascades_[i].hasDynamic)
+            draw(commandBuffer, i, false);
+        commandBuffer.endRenderPass();
+    }
+}
+
+void CascadedShadowMap::fillUniforms(ShadowUniforms &uniforms) const {
+    for (uint32_t i = 0; i < engine::SHADOW_CASCADE_COUNT; i++) {
+        uniforms.cascadeViewProj[i] = cascades_[i].viewProj;
+        uniforms.cascadeSplits[i] = cascades_[i].splitFar;
+        uniforms.cascadeTexelSize[i] = cascades_[i].texelSize;
+    }
+    uniforms.lightDirection = glm::vec4(lightDirection_, 0.0f);
+}
@@ -0,0 +1,138 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <vma/vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+#include "Camera.hpp"
+#include "Uniform.hpp"
+#include "common/config.hpp"
+#include "scene/Bounds.hpp"
+
+class VulkanContext;
+
+/**
+ * CascadedShadowMap
+ *
+ * Shadow maps for one directional light, one layer of a depth array image per
+ * cascade. The view range [near, SHADOW_DISTANCE] is split with the practical
+ * (log/uniform blend) scheme, and each cascade is an orthographic box around
+ * the bounding sphere of its slice of the camera frustum.
+ *
+ * Caching: every cascade has a second layer holding static casters only. The
+ * cascade's matrix is anchored - it stays fixed while the camera moves inside
+ * the padding around the slice (a sphere, so rotation never changes it) - and
+ * the static layer is only re-rendered when the anchor moves, the light
+ * changes or invalidateStatic() is called. A normal update copies the static
+ * layer into the sampled layer and draws the dynamic casters on top; a cascade
+ * without dynamic casters is not touched at all. Dynamic casters are redrawn
+ * every SHADOW_CASCADE_UPDATE_INTERVAL[i] frames, staggered across cascades.
+ *
+ * The anchor is snapped to the shadow texel grid in light space, so static and
+ * dynamic passes always rasterise with the same sample positions.
+ */
+class CascadedShadowMap {
+public:
+    struct Cascade {
+        glm::mat4 viewProj{1.0f}; // light view-projection the layer is rendered with
+        std::array<glm::vec4, 6> planes{}; // of viewProj, for caster culling
+        float splitFar = 0.0f; // view-space distance where the next cascade takes over
+        float texelSize = 0.0f; // world units per texel
+        float radius = 0.0f; // of the slice's bounding sphere at the last re-anchor
+        glm::vec2 anchor{0.0f}; // light-space centre the box is built around
+        float depthNear = 0.0f; // light-space depth range of the casters at the last re-anchor
+        float depthFar = 0.0f;
+
+        bool staticDirty = true; // static layer must be re-rendered before use
+        bool scheduled = false; // this frame's update wants the cascade refreshed
+        bool hasDynamic = false; // sampled layer currently contains dynamic casters
+        bool renderStatic = false; // this frame: re-render the static layer
+        bool render = false; // this frame: copy static -> sampled and draw dynamic casters
+    };
+
+    // (cascade, staticPass): record the casters' draws; the render pass is already begun
+    using DrawCallback = std::function<void(vk::CommandBuffer, uint32_t, bool)>;
+
+    CascadedShadowMap(VulkanContext &context, VmaAllocator allocator);
+    ~CascadedShadowMap();
+
+    CascadedShadowMap(const CascadedShadowMap &) = delete;
+    CascadedShadowMap &operator=(const CascadedShadowMap &) = delete;
+
+    // 'towardsLight' need not be normalised. Changing it invalidates every cascade.
+    void setLightDirection(const glm::vec3 &towardsLight);
+
+    // Static casters were added, removed or moved
+    void invalidateStatic();
+
+    // Fits the cascades to the camera and decides which ones update this frame.
+    // 'casterBounds' bounds every caster; it sets the depth range of re-anchored cascades.
+    void update(const Camera &camera, float aspectRatio, const Aabb &casterBounds, uint64_t frameNumber);
+
+    // Second half of the schedule, once the renderer knows whether the scheduled cascade has
+    // dynamic casters in view. Decides whether the cascade is recorded at all.
+    void setDynamicCasters(uint32_t cascade, bool present);
+
+    // Static pass (if due), copy, dynamic pass - for every cascade that renders this frame. With
+    // eSecondaryCommandBuffers 'draw' executes secondaries begun with getInheritanceInfo() of the same pass.
+    void record(vk::CommandBuffer commandBuffer, const DrawCallback &draw,
+                vk::SubpassContents contents = vk::SubpassContents::eInline) const;
+
+    void fillUniforms(ShadowUniforms &uniforms) const;
+
+    [[nodiscard]] const Cascade &getCascade(uint32_t cascade) const { return cascades_[cascade]; }
+    [[nodiscard]] uint32_t getRenderedCascadeCount() const;
+    // Whether record() calls 'draw' for the pass this frame
+    [[nodiscard]] bool drawsPass(uint32_t cascade, bool staticPass) const;
+    [[nodiscard]] vk::CommandBufferInheritanceInfo getInheritanceInfo(uint32_t cascade, bool staticPass) const;
+
+    // Pipelines are built against this pass; the static one is compatible with it
+    [[nodiscard]] vk::RenderPass getRenderPass() const { return dynamicPass_; }
+    [[nodiscard]] vk::DescriptorImageInfo getDescriptorInfo() const;
+    [[nodiscard]] vk::Format getFormat() const { return format_; }
+    [[nodiscard]] bool hasDepthClamp() const { return depthClamp_; }
+
+private:
+    struct DepthArray {
+        vk::Image image;
+        VmaAllocation allocation = nullptr;
+        std::array<vk::ImageView, engine::SHADOW_CASCADE_COUNT> layerViews{};
+        std::array<vk::Framebuffer, engine::SHADOW_CASCADE_COUNT> framebuffers{};
+    };
+
+    void chooseFormat();
+    void createRenderPasses();
+    void createDepthArray(DepthArray &target, vk::ImageUsageFlags usage, vk::RenderPass renderPass);
+    void destroyDepthArray(DepthArray &target);
+    void createSampler();
+
+    // Light-space basis and orthographic box of 'cascade' around its anchor
+    void buildMatrix(Cascade &cascade, float halfSize) const;
+
+    VulkanContext &context_;
+    VmaAllocator allocator_;
+
+    vk::Format format_ = vk::Format::eD16Unorm;
+    bool linearFilter_ = false;
+    bool depthClamp_ = false;
+
+    vk::RenderPass staticPass_; // clear -> transfer source
+    vk::RenderPass dynamicPass_; // load from transfer destination -> shader read
+
+    DepthArray shadowMap_; // sampled by the lighting shaders
+    DepthArray staticCache_; // static casters only
+    vk::ImageView arrayView_;
+    vk::Sampler sampler_;
+
+    std::array<Cascade, engine::SHADOW_CASCADE_COUNT> cascades_{};
+    glm::vec3 lightDirection_{0.0f, 0.0f, 1.0f};
+    glm::mat4 lightRotation_{1.0f}; // world -> light space, no translation
+    bool invalidated_ = true;
+};
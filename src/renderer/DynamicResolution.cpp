@@ -0,0 +1,61 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "DynamicResolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr float SMOOTHING = 0.15f; // weight of a new sample
+constexpr float HEADROOM = 0.85f; // grow only below this fraction of the target
+constexpr float MAX_STEP_DOWN = 0.1f;
+constexpr float MAX_STEP_UP = 0.025f;
+constexpr float MIN_STEP = 1.0f / 128.0f; // smaller corrections are noise
+constexpr uint32_t SETTLE_FRAMES = 8; // > MAX_FRAMES_IN_FLIGHT plus smoothing lag
+}
+
+DynamicResolution::DynamicResolution(float targetMs, float minScale, float maxScale)
+    : targetMs_(targetMs), minScale_(minScale), maxScale_(maxScale), scale_(maxScale) {
+}
+
+void DynamicResolution::update(float gpuMs) {
+    filteredMs_ = filteredMs_ == 0.0f ? gpuMs : filteredMs_ + (gpuMs - filteredMs_) * SMOOTHING;
+    if (!enabled_ || filteredMs_ <= 0.0f)
+        return;
+    if (cooldown_ > 0) {
+        cooldown_--;
+        return;
+    }
+
+    const bool over = filteredMs_ > targetMs_;
+    const bool under = filteredMs_ < targetMs_ * HEADROOM;
+    if (!over && !under)
+        return;
+
+    // Aim for the middle of the dead band when growing, so the next frame does not land over the target
+    const float aim = over ? targetMs_ : targetMs_ * (1.0f + HEADROOM) * 0.5f;
+    const float wanted = scale_ * std::sqrt(aim / filteredMs_);
+    const float step = std::clamp(wanted - scale_, -MAX_STEP_DOWN, MAX_STEP_UP);
+    const float next = std::clamp(scale_ + step, minScale_, maxScale_);
+    if (std::abs(next - scale_) < MIN_STEP)
+        return;
+
+    scale_ = next;
+    cooldown_ = SETTLE_FRAMES;
+}
+
+void DynamicResolution::setEnabled(bool enabled) {
+    enabled_ = enabled;
+    if (!enabled_)
+        scale_ = maxScale_;
+    cooldown_ = 0;
+}
+
+vk::Extent2D DynamicResolution::getRenderExtent(vk::Extent2D output) const {
+    const auto scaled = [&](uint32_t size) {
+        return std::max(1u, static_cast<uint32_t>(std::lround(static_cast<float>(size) * scale_)));
+    };
+    return {scaled(output.width), scaled(output.height)};
+}
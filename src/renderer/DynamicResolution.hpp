@@ -0,0 +1,50 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+/**
+ * DynamicResolution
+ *
+ * Picks the render scale (fraction of the output size per axis) that holds the
+ * GPU frame time at a target. GPU cost is taken as proportional to the pixel
+ * count, i.e. scale squared, so a measured time t asks for
+ * scale * sqrt(target / t).
+ *
+ * The measurement is smoothed, and arrives a couple of frames late, so the
+ * controller steps rather than jumps: down quickly when over budget, up slowly
+ * and only with clear headroom, then waits a few frames to see the effect.
+ * This keeps the scale from oscillating around the target.
+ *
+ * CPU only; the renderer feeds GpuTimer results in and applies getRenderExtent()
+ * as the viewport of targets allocated at the maximum scale.
+ */
+class DynamicResolution {
+public:
+    DynamicResolution(float targetMs, float minScale, float maxScale);
+
+    // One GPU frame time measurement, in milliseconds
+    void update(float gpuMs);
+
+    // Fixed scale (maxScale) while disabled
+    void setEnabled(bool enabled);
+    [[nodiscard]] bool isEnabled() const { return enabled_; }
+
+    [[nodiscard]] float getScale() const { return scale_; }
+    [[nodiscard]] float getFilteredMs() const { return filteredMs_; }
+    // 'output' scaled, at least one pixel per axis
+    [[nodiscard]] vk::Extent2D getRenderExtent(vk::Extent2D output) const;
+
+private:
+    float targetMs_;
+    float minScale_;
+    float maxScale_;
+    float scale_;
+    float filteredMs_ = 0.0f;
+    uint32_t cooldown_ = 0; // frames left before the next change
+    bool enabled_ = true;
+};
@@ -0,0 +1,78 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "FramePacer.hpp"
+
+#include <algorithm>
+
+#include "vulkan/VulkanContext.hpp"
+
+FramePacer::FramePacer(VulkanContext &context, vk::Semaphore frameTimeline)
+    : context_(context), frameTimeline_(frameTimeline), presentWait_(context.supportsPresentWait()) {
+}
+
+void FramePacer::waitForFrameStart() {
+    // The next frame is presented_ + 1; with N allowed in the queue, frame presented_ + 1 - N must be through
+    const uint64_t queued = std::max(settings_.maxQueuedFrames, 1u);
+    if (settings_.lowLatency && presented_ >= queued) {
+        progress(presented_ + 1 - queued, WAIT_TIMEOUT_NS);
+    }
+    // Right after the wait returned, so the frame it waited for is timed as it got through
+    sample();
+}
+
+void FramePacer::markInput(Clock::time_point time) {
+    input_ = time;
+}
+
+void FramePacer::onPresent(uint64_t frameId, vk::SwapchainKHR swapChain) {
+    swapChain_ = swapChain;
+    presented_ = frameId;
+    // Frames skipped before presenting (minimized, out of date) leave no sample
+    if (input_) {
+        pending_.push_back({frameId, *input_});
+        input_.reset();
+    }
+    sample();
+}
+
+void FramePacer::onSwapChainRecreated() {
+    swapChain_ = nullptr;
+    firstPresentId_ = presented_ + 1;
+}
+
+void FramePacer::sample() {
+    // Frames get through in order, so the first one still pending ends the scan
+    while (!pending_.empty()) {
+        const Progress state = progress(pending_.front().frameId, 0);
+        if (state == Progress::Pending)
+            break;
+
+        if (state != Progress::Dropped) {
+            auto &filtered = state == Progress::Displayed ? latencyMs_ : gpuLatencyMs_;
+            const float ms = std::chrono::duration<float, std::milli>(Clock::now() - pending_.front().input).count();
+            const float latency = filtered.load(std::memory_order_relaxed);
+            filtered.store(latency == 0.0f ? ms : latency + 0.1f * (ms - latency), std::memory_order_relaxed);
+        }
+        pending_.pop_front();
+    }
+}
+
+FramePacer::Progress FramePacer::progress(uint64_t frameId, uint64_t timeoutNs) const {
+    auto device = context_.getDevice();
+    if (presentWait_ && swapChain_ && frameId >= firstPresentId_) {
+        try {
+            return device.waitForPresentKHR(swapChain_, frameId, timeoutNs) != vk::Result::eTimeout
+                       ? Progress::Displayed
+                       : Progress::Pending;
+        } catch (const vk::OutOfDateKHRError &) {
+            return Progress::Dropped; // the recreation that follows resets the ids
+        }
+    }
+    auto waitInfo = vk::SemaphoreWaitInfo()
+                    .setSemaphores(frameTimeline_)
+                    .setValues(frameId);
+    return device.waitSemaphores(waitInfo, timeoutNs) == vk::Result::eSuccess ? Progress::Finished
+                                                                               : Progress::Pending;
+}
@@ -0,0 +1,108 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vulkan/vulkan.hpp>
+
+#include "common/config.hpp"
+
+class VulkanContext;
+
+/**
+ * FramePacer
+ *
+ * Keeps the frames queued between input sampling and the display down, and
+ * measures how long that path takes.
+ *
+ * Frames are identified by their value on the renderer's frame timeline, which
+ * doubles as the present id (VK_KHR_present_id). In low-latency mode
+ * waitForFrameStart() runs before the app samples the next input (the render
+ * thread calls it before handing the packet slot back) and blocks until at
+ * most maxQueuedFrames earlier frames are still pending:
+ *   - with VK_KHR_present_wait, pending until the presentation engine has
+ *     shown them,
+ *   - without it, until the GPU has finished them (the frame timeline), which
+ *     bounds the GPU queue but not the swapchain's.
+ * Without low latency the CPU runs ahead as far as the frames in flight and
+ * the swapchain images allow.
+ *
+ * Used on the render thread only, apart from getLatencyMs().
+ *
+ * Latency is measured from markInput() to the moment a frame is first seen
+ * through: shown on the display where its present can be waited on, finished
+ * on the GPU otherwise (no present wait, or a frame presented to a swapchain
+ * that has since been replaced). The two are kept apart, getLatencyMs() and
+ * getGpuLatencyMs(); the second says nothing about the swapchain queue.
+ * Pending frames are polled after every present and at every frame start, and
+ * the low-latency wait returns the moment its frame is through, so a sample
+ * is late by at most the time between two polls rather than a whole frame.
+ */
+class FramePacer {
+public:
+    struct Settings {
+        bool lowLatency = engine::LOW_LATENCY;
+        uint32_t maxQueuedFrames = engine::MAX_QUEUED_FRAMES; // at least 1
+    };
+
+    FramePacer(VulkanContext &context, vk::Semaphore frameTimeline);
+
+    using Clock = std::chrono::steady_clock;
+
+    // Before input is sampled for the next frame
+    void waitForFrameStart();
+    // When the input of the frame about to be recorded was sampled (FramePacket::inputTime)
+    void markInput(Clock::time_point time);
+    // Frame 'frameId' was presented to 'swapChain' with that present id (see getPresentId())
+    void onPresent(uint64_t frameId, vk::SwapchainKHR swapChain);
+    // Ids presented to the replaced swapchain can no longer be waited on; those frames fall back to the timeline
+    void onSwapChainRecreated();
+
+    void setSettings(const Settings &settings) { settings_ = settings; }
+    [[nodiscard]] const Settings &getSettings() const { return settings_; }
+    [[nodiscard]] bool usesPresentWait() const { return presentWait_; }
+    // Filtered input-to-display latency, 0 until the first frame is measured. Safe from any thread.
+    [[nodiscard]] float getLatencyMs() const { return latencyMs_.load(std::memory_order_relaxed); }
+    // Filtered input-to-GPU-completion latency of the frames that could not be waited on for display
+    [[nodiscard]] float getGpuLatencyMs() const { return gpuLatencyMs_.load(std::memory_order_relaxed); }
+
+private:
+    // Gives up on a frame after this long, so a present that never completes cannot hang the loop
+    static constexpr uint64_t WAIT_TIMEOUT_NS = 100'000'000;
+
+    struct Pending {
+        uint64_t frameId;
+        Clock::time_point input;
+    };
+
+    enum class Progress {
+        Pending,
+        Displayed,
+        Finished, // on the GPU; whether it was shown is unknown
+        Dropped, // will never be shown (out of date swapchain)
+    };
+
+    VulkanContext &context_;
+    vk::Semaphore frameTimeline_;
+    Settings settings_{};
+    bool presentWait_;
+
+    vk::SwapchainKHR swapChain_;
+    uint64_t firstPresentId_ = 1; // first frame presented to swapChain_
+    uint64_t presented_ = 0;
+    std::optional<Clock::time_point> input_;
+    std::deque<Pending> pending_;
+    std::atomic<float> latencyMs_ = 0.0f;
+    std::atomic<float> gpuLatencyMs_ = 0.0f;
+
+    // Where frame 'frameId' is; waits up to 'timeoutNs' for it to be displayed (or finished)
+    Progress progress(uint64_t frameId, uint64_t timeoutNs) const;
+    // Takes the latency sample of every pending frame that has got through since the last call
+    void sample();
+};
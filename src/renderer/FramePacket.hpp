@@ -0,0 +1,46 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include "Camera.hpp"
+#include "RenderObject.hpp"
+
+class Renderer;
+
+/**
+ * FramePacket
+ *
+ * Everything the simulation/input thread hands the render thread for one
+ * frame (App, through a DoubleBuffer). The renderer owns the scene, culls it
+ * and builds the draw list itself; the simulation only sends what changed:
+ *   - the camera, as it was when input was sampled,
+ *   - local transforms it set on scene nodes,
+ *   - commands: anything else that touches renderer state (settings, picking)
+ *     runs on the render thread, between frames, in the order it was queued.
+ * The window state comes along because GLFW may only be queried from the
+ * main thread.
+ */
+struct FramePacket {
+    struct TransformUpdate {
+        NodeHandle node;
+        glm::mat4 local;
+    };
+    using Command = std::function<void(Renderer &)>;
+
+    std::optional<Camera> camera; // Camera is not assignable
+    std::vector<TransformUpdate> transforms;
+    std::vector<Command> commands;
+
+    vk::Extent2D framebufferSize{};
+    bool framebufferResized = false;
+    std::chrono::steady_clock::time_point inputTime{}; // FramePacer's latency measurement starts here
+};
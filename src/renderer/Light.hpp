@@ -0,0 +1,28 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+using LightHandle = uint32_t;
+
+enum class LightType : uint32_t {
+    Point = 0, // six shadow views
+    Spot = 1, // one shadow view
+};
+
+// Local light with a finite range, see Renderer::addLocalLight
+struct LocalLight {
+    LightType type = LightType::Point;
+    glm::vec3 position{0.0f};
+    glm::vec3 direction{0.0f, 0.0f, -1.0f}; // spot only, normalised
+    float range = 10.0f; // no light (and no shadow casters) beyond this distance
+    glm::vec3 color{1.0f};
+    float intensity = 1.0f;
+    float innerConeCos = 0.95f; // spot only: full intensity inside, fades out to the outer cone
+    float outerConeCos = 0.85f;
+    bool castsShadows = true;
+};
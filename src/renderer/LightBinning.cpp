@@ -0,0 +1,124 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "LightBinning.hpp"
+
+#include <stdexcept>
+
+#include "vulkan/DeletionQueue.hpp"
+#include "vulkan/VulkanContext.hpp"
+
+namespace {
+// One bit per light, as a uvec2 per tile (shaders/include/lights.glsl)
+constexpr vk::DeviceSize TILE_BYTES = 2 * sizeof(uint32_t);
+static_assert(engine::MAX_LOCAL_LIGHTS == 64, "tile masks hold 64 lights");
+
+// local_size of shaders/compute/light_binning.comp, in tiles
+constexpr uint32_t GROUP_SIZE = 8;
+}
+
+LightBinning::LightBinning(VulkanContext &context, VmaAllocator allocator)
+    : context_(context), allocator_(allocator) {
+    if (!context_.hasAsyncCompute())
+        return;
+
+    auto device = context_.getDevice();
+    commandPool_ = device.createCommandPool(
+        vk::CommandPoolCreateInfo()
+        .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
+        .setQueueFamilyIndex(context_.getComputeFamily()));
+
+    auto buffers = device.allocateCommandBuffers(
+        vk::CommandBufferAllocateInfo()
+        .setCommandPool(commandPool_)
+        .setLevel(vk::CommandBufferLevel::ePrimary)
+        .setCommandBufferCount(engine::MAX_FRAMES_IN_FLIGHT));
+    for (uint32_t i = 0; i < engine::MAX_FRAMES_IN_FLIGHT; i++) {
+        commandBuffers_[i] = buffers[i];
+        semaphores_[i] = device.createSemaphore({});
+    }
+}
+
+LightBinning::~LightBinning() {
+    auto device = context_.getDevice();
+    if (buffer_)
+        vmaDestroyBuffer(allocator_, buffer_, allocation_);
+    for (auto semaphore : semaphores_) {
+        if (semaphore)
+            device.destroySemaphore(semaphore);
+    }
+    if (commandPool_)
+        device.destroyCommandPool(commandPool_);
+}
+
+void LightBinning::resize(vk::Extent2D maxExtent, DeletionQueue &deletionQueue) {
+    // Frames in flight (on either queue) may still use the old tiles
+    deletionQueue.retire(allocator_, buffer_, allocation_);
+    buffer_ = nullptr;
+    allocation_ = nullptr;
+    tilesPerFrame_ = tileColumns(maxExtent) * tileRows(maxExtent);
+
+    // Written by the compute queue, read by the graphics queue
+    const auto families = context_.getSharingFamilies();
+    VkBufferCreateInfo bufferInfo = vk::BufferCreateInfo()
+                                    .setSize(TILE_BYTES * tilesPerFrame_ * engine::MAX_FRAMES_IN_FLIGHT)
+                                    .setUsage(vk::BufferUsageFlagBits::eStorageBuffer)
+                                    .setSharingMode(families.size() > 1 ? vk::SharingMode::eConcurrent
+                                                                        : vk::SharingMode::eExclusive)
+                                    .setQueueFamilyIndices(families);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VkBuffer rawBuffer;
+    if (vmaCreateBuffer(allocator_, &bufferInfo, &allocInfo, &rawBuffer, &allocation_, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create light tile buffer!");
+    }
+    buffer_ = rawBuffer;
+}
+
+vk::DescriptorBufferInfo LightBinning::getDescriptorInfo() const {
+    return vk::DescriptorBufferInfo(buffer_, 0, VK_WHOLE_SIZE);
+}
+
+vk::Semaphore LightBinning::submit(uint32_t frame, vk::Extent2D renderExtent, const BindCallback &bind) {
+    if (!isAsync())
+        return nullptr;
+
+    // The graphics submission of this slot's last frame waited on this one, and its fence has signaled,
+    // so the command buffer and the tile slice are both free
+    vk::CommandBuffer commandBuffer = commandBuffers_[frame];
+    commandBuffer.reset();
+    commandBuffer.begin(vk::CommandBufferBeginInfo().setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    bind(commandBuffer);
+    commandBuffer.dispatch((tileColumns(renderExtent) + GROUP_SIZE - 1) / GROUP_SIZE,
+                           (tileRows(renderExtent) + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+    commandBuffer.end();
+
+    // The semaphore signal makes the tile writes available to whatever waits on it
+    auto submitInfo = vk::SubmitInfo()
+                      .setCommandBuffers(commandBuffer)
+                      .setSignalSemaphores(semaphores_[frame]);
+    context_.getComputeQueue().submit(submitInfo);
+    return semaphores_[frame];
+}
+
+void LightBinning::record(vk::CommandBuffer commandBuffer, vk::Extent2D renderExtent,
+                          const BindCallback &bind) const {
+    bind(commandBuffer);
+    commandBuffer.dispatch((tileColumns(renderExtent) + GROUP_SIZE - 1) / GROUP_SIZE,
+                           (tileRows(renderExtent) + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+    auto barrier = vk::BufferMemoryBarrier2()
+                   .setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+                   .setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageWrite)
+                   .setDstStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+                   .setDstAccessMask(vk::AccessFlagBits2::eShaderStorageRead)
+                   .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                   .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                   .setBuffer(buffer_)
+                   .setOffset(0)
+                   .setSize(VK_WHOLE_SIZE);
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo().setBufferMemoryBarriers(barrier));
+}
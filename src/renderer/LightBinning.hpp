@@ -0,0 +1,84 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vma/vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+#include "common/config.hpp"
+
+class DeletionQueue;
+class VulkanContext;
+
+/**
+ * LightBinning
+ *
+ * Sorts the local lights into LIGHT_TILE_SIZE screen tiles once per frame: a
+ * compute pass tests each light's sphere against each tile's frustum and writes
+ * one bit per light (MAX_LOCAL_LIGHTS bits per tile). Per-pixel lighting then
+ * only walks the bits of its own tile.
+ *
+ * The pass only needs the camera and the lights, not the scene's depth, so it
+ * does not have to wait for anything rendered this frame. With a dedicated
+ * compute queue (VulkanContext::hasAsyncCompute) submit() runs it there, and
+ * the graphics submission waits on the returned semaphore at the fragment
+ * shader stage: the shadow passes and the geometry pass' vertex work overlap
+ * it. Otherwise record() puts it at the start of the graphics command buffer,
+ * followed by a barrier.
+ *
+ * The tile buffer has one slice per frame in flight, sized for the largest
+ * render extent, so a frame's binning never overwrites tiles an earlier frame
+ * still shades with. Both queues use it (and the frame allocator) with
+ * concurrent sharing.
+ */
+class LightBinning {
+public:
+    // Binds the binning pipeline and set 0 at the compute bind point; the dispatch is recorded here
+    using BindCallback = std::function<void(vk::CommandBuffer)>;
+
+    LightBinning(VulkanContext &context, VmaAllocator allocator);
+    ~LightBinning();
+
+    LightBinning(const LightBinning &) = delete;
+    LightBinning &operator=(const LightBinning &) = delete;
+
+    // (Re)allocates the tile buffer for render extents up to 'maxExtent'; the old one goes to 'deletionQueue'
+    void resize(vk::Extent2D maxExtent, DeletionQueue &deletionQueue);
+
+    // Async compute: records and submits the frame's binning on the compute queue and returns the
+    // semaphore the graphics submission has to wait on. Null without a compute queue: use record().
+    vk::Semaphore submit(uint32_t frame, vk::Extent2D renderExtent, const BindCallback &bind);
+    // Same work inside a graphics command buffer, made visible to the fragment shaders
+    void record(vk::CommandBuffer commandBuffer, vk::Extent2D renderExtent, const BindCallback &bind) const;
+
+    [[nodiscard]] bool isAsync() const { return static_cast<bool>(commandPool_); }
+
+    // Set 0, binding 10 (whole buffer); shaders add getFirstTile(frame)
+    [[nodiscard]] vk::DescriptorBufferInfo getDescriptorInfo() const;
+    [[nodiscard]] uint32_t getFirstTile(uint32_t frame) const { return frame * tilesPerFrame_; }
+    // Tiles per row for a render extent; the shaders index tiles row by row
+    static uint32_t tileColumns(vk::Extent2D extent) {
+        return (extent.width + engine::LIGHT_TILE_SIZE - 1) / engine::LIGHT_TILE_SIZE;
+    }
+    static uint32_t tileRows(vk::Extent2D extent) {
+        return (extent.height + engine::LIGHT_TILE_SIZE - 1) / engine::LIGHT_TILE_SIZE;
+    }
+
+private:
+    VulkanContext &context_;
+    VmaAllocator allocator_;
+
+    vk::Buffer buffer_;
+    VmaAllocation allocation_ = nullptr;
+    uint32_t tilesPerFrame_ = 0;
+
+    // Async path only: the compute queue's own command buffers and the semaphores the graphics queue waits on
+    vk::CommandPool commandPool_;
+    std::array<vk::CommandBuffer, engine::MAX_FRAMES_IN_FLIGHT> commandBuffers_{};
+    std::array<vk::Semaphore, engine::MAX_FRAMES_IN_FLIGHT> semaphores_{};
+};
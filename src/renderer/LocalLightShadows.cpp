@@ -0,0 +1,294 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "LocalLightShadows.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "common/config.hpp"
+#include "vulkan/UploadContext.hpp"
+#include "vulkan/VulkanContext.hpp"
+
+LocalLightShadows::LocalLightShadows(VulkanContext &context, VmaAllocator allocator, UploadContext &uploadContext)
+    : context_(context), allocator_(allocator),
+      atlas_(engine::SHADOW_ATLAS_SIZE, engine::SHADOW_ATLAS_MIN_TILE),
+      scheduler_(atlas_, engine::SHADOW_ATLAS_MAX_TILE, engine::SHADOW_ATLAS_UPDATE_BUDGET) {
+    format_ = context_.findShadowMapFormat(linearFilter_);
+    createImage(uploadContext);
+    createRenderPass();
+    framebuffer_ = context_.getDevice().createFramebuffer(
+        vk::FramebufferCreateInfo()
+        .setRenderPass(renderPass_)
+        .setAttachments(view_)
+        .setWidth(engine::SHADOW_ATLAS_SIZE)
+        .setHeight(engine::SHADOW_ATLAS_SIZE)
+        .setLayers(1));
+    createSampler();
+}
+
+LocalLightShadows::~LocalLightShadows() {
+    auto device = context_.getDevice();
+    device.destroySampler(sampler_);
+    device.destroyFramebuffer(framebuffer_);
+    device.destroyRenderPass(renderPass_);
+    device.destroyImageView(view_);
+    if (image_) {
+        vmaDestroyImage(allocator_, image_, allocation_);
+    }
+}
+
+void LocalLightShadows::createImage(UploadContext &uploadContext) {
+    VkImageCreateInfo imageInfo = vk::ImageCreateInfo()
+                                  .setImageType(vk::ImageType::e2D)
+                                  .setExtent({engine::SHADOW_ATLAS_SIZE, engine::SHADOW_ATLAS_SIZE, 1})
+                                  .setMipLevels(1)
+                                  .setArrayLayers(1)
+                                  .setFormat(format_)
+                                  .setTiling(vk::ImageTiling::eOptimal)
+                                  .setInitialLayout(vk::ImageLayout::eUndefined)
+                                  .setUsage(vk::ImageUsageFlagBits::eDepthStencilAttachment |
+                                            vk::ImageUsageFlagBits::eSampled |
+                                            vk::ImageUsageFlagBits::eTransferDst)
+                                  .setSamples(vk::SampleCountFlagBits::e1)
+                                  .setSharingMode(vk::SharingMode::eExclusive);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+
+    VkImage rawImage;
+    if (vmaCreateImage(allocator_, &imageInfo, &allocInfo, &rawImage, &allocation_, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow atlas image!");
+    }
+    image_ = rawImage;
+
+    const vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1);
+    view_ = context_.getDevice().createImageView(
+        vk::ImageViewCreateInfo()
+        .setImage(image_)
+        .setViewType(vk::ImageViewType::e2D)
+        .setFormat(format_)
+        .setSubresourceRange(range));
+
+    // Cleared to the far plane once, so tiles never rendered read as unshadowed. The render
+    // pass keeps the atlas in ShaderReadOnlyOptimal between uses.
+    auto cmd = uploadContext.getCommandBuffer();
+    auto toTransfer = vk::ImageMemoryBarrier2()
+                      .setSrcStageMask(vk::PipelineStageFlagBits2::eNone)
+                      .setSrcAccessMask({})
+                      .setDstStageMask(vk::PipelineStageFlagBits2::eClear)
+                      .setDstAccessMask(vk::AccessFlagBits2::eTransferWrite)
+                      .setOldLayout(vk::ImageLayout::eUndefined)
+                      .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+                      .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                      .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                      .setImage(image_)
+                      .setSubresourceRange(range);
+    cmd.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(toTransfer));
+
+    cmd.clearDepthStencilImage(image_, vk::ImageLayout::eTransferDstOptimal, vk::ClearDepthStencilValue(1.0f, 0),
+                               range);
+
+    auto toShaderRead = vk::ImageMemoryBarrier2()
+                        .setSrcStageMask(vk::PipelineStageFlagBits2::eClear)
+                        .setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+                        .setDstStageMask(vk::PipelineStageFlagBits2::eVertexShader |
+                                         vk::PipelineStageFlagBits2::eFragmentShader |
+                                         vk::PipelineStageFlagBits2::eEarlyFragmentTests |
+                                         vk::PipelineStageFlagBits2::eLateFragmentTests)
+                        .setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead |
+                                          vk::AccessFlagBits2::eDepthStencilAttachmentRead |
+                                          vk::AccessFlagBits2::eDepthStencilAttachmentWrite)
+                        .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+                        .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+                        .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                        .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                        .setImage(image_)
+                        .setSubresourceRange(range);
+    cmd.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(toShaderRead));
+}
+
+void LocalLightShadows::createRenderPass() {
+    // Only the scheduled tiles are redrawn (cleared per tile inside the pass), the rest is kept
+    auto attachment = vk::AttachmentDescription()
+                      .setFormat(format_)
+                      .setSamples(vk::SampleCountFlagBits::e1)
+                      .setLoadOp(vk::AttachmentLoadOp::eLoad)
+                      .setStoreOp(vk::AttachmentStoreOp::eStore)
+                      .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
+                      .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
+                      .setInitialLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+                      .setFinalLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    auto depthRef = vk::AttachmentReference()
+                    .setAttachment(0)
+                    .setLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal);
+
+    auto subpass = vk::SubpassDescription()
+                   .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+                   .setPDepthStencilAttachment(&depthRef);
+
+    std::array<vk::SubpassDependency, 2> dependencies = {
+        // Earlier frames' lighting reads finish before tiles are overwritten
+        vk::SubpassDependency()
+        .setSrcSubpass(VK_SUBPASS_EXTERNAL)
+        .setDstSubpass(0)
+        .setSrcStageMask(vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader)
+        .setSrcAccessMask({})
+        .setDstStageMask(vk::PipelineStageFlagBits::eEarlyFragmentTests |
+                         vk::PipelineStageFlagBits::eLateFragmentTests)
+        .setDstAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentRead |
+                          vk::AccessFlagBits::eDepthStencilAttachmentWrite),
+        vk::SubpassDependency()
+        .setSrcSubpass(0)
+        .setDstSubpass(VK_SUBPASS_EXTERNAL)
+        .setSrcStageMask(vk::PipelineStageFlagBits::eLateFragmentTests)
+        .setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+        .setDstStageMask(vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader)
+        .setDstAccessMask(vk::AccessFlagBits::eShaderRead)
+    };
+
+    renderPass_ = context_.getDevice().createRenderPass(
+        vk::RenderPassCreateInfo().setAttachments(attachment).setSubpasses(subpass).setDependencies(dependencies));
+}
+
+void LocalLightShadows::createSampler() {
+    const vk::Filter filter = linearFilter_ ? vk::Filter::eLinear : vk::Filter::eNearest;
+    auto samplerInfo = vk::SamplerCreateInfo()
+                       .setMagFilter(filter)
+                       .setMinFilter(filter)
+                       .setMipmapMode(vk::SamplerMipmapMode::eNearest)
+                       .setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+                       .setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+                       .setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+                       .setCompareEnable(true)
+                       .setCompareOp(vk::CompareOp::eLessOrEqual)
+                       .setMinLod(0.0f)
+                       .setMaxLod(0.0f);
+
+    sampler_ = context_.getDevice().createSampler(samplerInfo);
+}
+
+vk::DescriptorImageInfo LocalLightShadows::getDescriptorInfo() const {
+    return {sampler_, view_, vk::ImageLayout::eShaderReadOnlyOptimal};
+}
+
+uint32_t LocalLightShadows::computeViews(const LocalLight &light,
+                                         std::array<glm::mat4, LOCAL_SHADOW_VIEWS_PER_LIGHT> &out) {
+    const float nearPlane = std::max(0.02f, light.range * 0.005f);
+
+    if (light.type == LightType::Spot) {
+        // Outer cone plus a little margin so PCF at the cone edge stays inside the tile
+        const float fov = std::min(2.0f * std::acos(std::clamp(light.outerConeCos, -1.0f, 1.0f)) + 0.05f,
+                                   glm::radians(170.0f));
+        const glm::vec3 up = std::abs(light.direction.z) > 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f)
+                                                                  : glm::vec3(0.0f, 0.0f, 1.0f);
+        out[0] = glm::perspective(fov, 1.0f, nearPlane, light.range) *
+                 glm::lookAt(light.position, light.position + light.direction, up);
+        return 1;
+    }
+
+    // Cube faces in the order the shaders pick them by major axis: +X, -X, +Y, -Y, +Z, -Z
+    static const std::array<glm::vec3, 6> directions = {
+        glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+        glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)
+    };
+    static const std::array<glm::vec3, 6> ups = {
+        glm::vec3(0, 0, 1), glm::vec3(0, 0, 1), glm::vec3(0, 0, 1),
+        glm::vec3(0, 0, 1), glm::vec3(0, 1, 0), glm::vec3(0, 1, 0)
+    };
+    const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, light.range);
+    for (uint32_t face = 0; face < 6; face++) {
+        out[face] = projection * glm::lookAt(light.position, light.position + directions[face], ups[face]);
+    }
+    return 6;
+}
+
+void LocalLightShadows::update(const std::vector<LocalLight> &lights,
+                               const std::vector<ShadowScheduler::Request> &requests) {
+    const auto &scheduled = scheduler_.schedule(requests);
+    renderedViewProj_.resize(lights.size());
+
+    views_.clear();
+    std::array<glm::mat4, LOCAL_SHADOW_VIEWS_PER_LIGHT> viewProj;
+    for (uint32_t light : scheduled) {
+        const auto &state = scheduler_.getState(light);
+        computeViews(lights[light], viewProj);
+        for (uint32_t face = 0; face < state.viewCount; face++) {
+            renderedViewProj_[light][face] = viewProj[face];
+            views_.push_back({light, light * LOCAL_SHADOW_VIEWS_PER_LIGHT + face, viewProj[face],
+                              Camera::extractFrustumPlanes(viewProj[face]), state.tiles[face]});
+        }
+    }
+}
+
+void LocalLightShadows::record(vk::CommandBuffer commandBuffer, const DrawCallback &draw) const {
+    if (views_.empty())
+        return;
+
+    // Only the scheduled tiles' bounding rectangle is loaded and stored
+    uint32_t minX = UINT32_MAX, minY = UINT32_MAX, maxX = 0, maxY = 0;
+    for (const auto &view : views_) {
+        minX = std::min(minX, view.tile.x);
+        minY = std::min(minY, view.tile.y);
+        maxX = std::max(maxX, view.tile.x + view.tile.size);
+        maxY = std::max(maxY, view.tile.y + view.tile.size);
+    }
+
+    commandBuffer.beginRenderPass(vk::RenderPassBeginInfo()
+                                  .setRenderPass(renderPass_)
+                                  .setFramebuffer(framebuffer_)
+                                  .setRenderArea(vk::Rect2D({static_cast<int32_t>(minX), static_cast<int32_t>(minY)},
+                                                            {maxX - minX, maxY - minY})),
+                                  vk::SubpassContents::eInline);
+
+    vk::ClearValue clearDepth;
+    clearDepth.depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+    const vk::ClearAttachment clearAttachment(vk::ImageAspectFlagBits::eDepth, 0, clearDepth);
+
+    for (uint32_t i = 0; i < views_.size(); i++) {
+        const auto &tile = views_[i].tile;
+        const vk::Rect2D rect({static_cast<int32_t>(tile.x), static_cast<int32_t>(tile.y)}, {tile.size, tile.size});
+        commandBuffer.setViewport(0, vk::Viewport(static_cast<float>(tile.x), static_cast<float>(tile.y),
+                                                  static_cast<float>(tile.size), static_cast<float>(tile.size),
+                                                  0.0f, 1.0f));
+        commandBuffer.setScissor(0, rect);
+        commandBuffer.clearAttachments(clearAttachment, vk::ClearRect(rect, 0, 1));
+        draw(commandBuffer, i);
+    }
+
+    commandBuffer.endRenderPass();
+}
+
+void LocalLightShadows::fillBuffer(const std::vector<LocalLight> &lights, LocalLightBuffer &buffer) const {
+    const auto count = static_cast<uint32_t>(std::min<size_t>(lights.size(), engine::MAX_LOCAL_LIGHTS));
+    const float atlasSize = static_cast<float>(atlas_.getSize());
+
+    buffer.lightCount = count;
+    for (uint32_t i = 0; i < count; i++) {
+        const LocalLight &light = lights[i];
+        GpuLocalLight &gpu = buffer.lights[i];
+        gpu.positionRange = glm::vec4(light.position, light.range);
+        gpu.colorIntensity = glm::vec4(light.color, light.intensity);
+        gpu.directionType = glm::vec4(light.direction, static_cast<float>(light.type));
+        gpu.spotShadow = glm::vec4(light.outerConeCos, light.innerConeCos, -1.0f, 0.0f);
+
+        // Only tiles holding a finished render are exposed; new or resized tiles stay unshadowed until drawn
+        if (i >= scheduler_.getLightCount())
+            continue;
+        const auto &state = scheduler_.getState(i);
+        if (!state.valid || state.viewCount == 0)
+            continue;
+
+        const uint32_t first = i * LOCAL_SHADOW_VIEWS_PER_LIGHT;
+        gpu.spotShadow.z = static_cast<float>(first);
+        for (uint32_t face = 0; face < state.viewCount; face++) {
+            const auto &tile = state.tiles[face];
+            buffer.shadowViews[first + face].viewProj = renderedViewProj_[i][face];
+            buffer.shadowViews[first + face].atlasRect = glm::vec4(tile.x, tile.y, tile.size, tile.size) / atlasSize;
+        }
+    }
+}
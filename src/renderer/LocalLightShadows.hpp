@@ -0,0 +1,95 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <vma/vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+#include "Camera.hpp"
+#include "Light.hpp"
+#include "ShadowAtlas.hpp"
+#include "ShadowScheduler.hpp"
+#include "Uniform.hpp"
+
+class UploadContext;
+class VulkanContext;
+
+/**
+ * LocalLightShadows
+ *
+ * Shadows for point and spot lights, all in one depth atlas. ShadowAtlas packs
+ * the tiles and ShadowScheduler decides which lights are re-rendered; this
+ * class owns the GPU side: the atlas image and its render pass, the views
+ * (one per spot light, six cube faces per point light) and the light buffer
+ * the shaders read.
+ *
+ * A light that is due but over budget keeps its old tile contents, and the
+ * shaders keep using the matrices those contents were rendered with.
+ */
+class LocalLightShadows {
+public:
+    struct View {
+        uint32_t light = 0;
+        uint32_t slot = 0; // light * LOCAL_SHADOW_VIEWS_PER_LIGHT + face, index into the shadow view buffer
+        glm::mat4 viewProj{1.0f};
+        std::array<glm::vec4, 6> planes{}; // for caster culling
+        ShadowAtlas::Tile tile;
+    };
+
+    // (view): record the view's casters; viewport, scissor and the tile clear are already set
+    using DrawCallback = std::function<void(vk::CommandBuffer, uint32_t)>;
+
+    LocalLightShadows(VulkanContext &context, VmaAllocator allocator, UploadContext &uploadContext);
+    ~LocalLightShadows();
+
+    LocalLightShadows(const LocalLightShadows &) = delete;
+    LocalLightShadows &operator=(const LocalLightShadows &) = delete;
+
+    // Runs the scheduler (requests indexed like 'lights') and builds the views of the lights it picked
+    void update(const std::vector<LocalLight> &lights, const std::vector<ShadowScheduler::Request> &requests);
+
+    // Re-renders the scheduled tiles; a no-op when nothing is scheduled
+    void record(vk::CommandBuffer commandBuffer, const DrawCallback &draw) const;
+
+    void fillBuffer(const std::vector<LocalLight> &lights, LocalLightBuffer &buffer) const;
+
+    [[nodiscard]] const std::vector<View> &getScheduledViews() const { return views_; }
+    [[nodiscard]] const ShadowAtlas &getAtlas() const { return atlas_; }
+    [[nodiscard]] const ShadowScheduler &getScheduler() const { return scheduler_; }
+
+    [[nodiscard]] vk::RenderPass getRenderPass() const { return renderPass_; }
+    [[nodiscard]] vk::DescriptorImageInfo getDescriptorInfo() const;
+
+    // Light-space view-projections of a light, as rendered into its tiles
+    static uint32_t computeViews(const LocalLight &light, std::array<glm::mat4, LOCAL_SHADOW_VIEWS_PER_LIGHT> &out);
+
+private:
+    void createImage(UploadContext &uploadContext);
+    void createRenderPass();
+    void createSampler();
+
+    VulkanContext &context_;
+    VmaAllocator allocator_;
+
+    vk::Format format_ = vk::Format::eD16Unorm;
+    bool linearFilter_ = false;
+
+    vk::Image image_;
+    VmaAllocation allocation_ = nullptr;
+    vk::ImageView view_;
+    vk::RenderPass renderPass_;
+    vk::Framebuffer framebuffer_;
+    vk::Sampler sampler_;
+
+    ShadowAtlas atlas_;
+    ShadowScheduler scheduler_;
+
+    std::vector<View> views_; // this frame's
+    std::vector<std::array<glm::mat4, LOCAL_SHADOW_VIEWS_PER_LIGHT>> renderedViewProj_; // per light
+};
@@ -0,0 +1,223 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "PostProcess.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include "vulkan/DeletionQueue.hpp"
+#include "vulkan/UploadContext.hpp"
+#include "vulkan/VulkanContext.hpp"
+
+namespace {
+// local_size of shaders/compute/hdr_reduce.comp; each thread covers 2x2 texels of bloom mip 0
+constexpr uint32_t GROUP_SIZE = 16;
+constexpr uint32_t GROUP_TEXELS = 2 * GROUP_SIZE;
+static_assert(GROUP_TEXELS == 1u << (PostProcess::BLOOM_MIPS - 1), "a group reduces its block to one texel");
+
+// ExposureBuffer in shaders/include/post.glsl: exposure, average luminance, groups done, padding, then the bins
+constexpr uint32_t HISTOGRAM_BINS = 256;
+constexpr vk::DeviceSize EXPOSURE_BYTES = 4 * sizeof(uint32_t) + HISTOGRAM_BINS * sizeof(uint32_t);
+
+vk::Extent2D halfExtent(vk::Extent2D extent) {
+    return {(extent.width + 1) / 2, (extent.height + 1) / 2};
+}
+}
+
+PostProcess::PostProcess(VulkanContext &context, VmaAllocator allocator, UploadContext &uploadContext)
+    : context_(context), allocator_(allocator) {
+    // Bilinear within a mip; the output pass picks each mip explicitly
+    bloomSampler_ = context_.getDevice().createSampler(
+        vk::SamplerCreateInfo()
+        .setMagFilter(vk::Filter::eLinear)
+        .setMinFilter(vk::Filter::eLinear)
+        .setMipmapMode(vk::SamplerMipmapMode::eNearest)
+        .setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+        .setMaxLod(static_cast<float>(BLOOM_MIPS - 1)));
+    createExposureBuffer(uploadContext);
+}
+
+PostProcess::~PostProcess() {
+    destroyBloom(bloom_);
+    if (exposureBuffer_)
+        vmaDestroyBuffer(allocator_, exposureBuffer_, exposureAllocation_);
+    if (bloomSampler_)
+        context_.getDevice().destroySampler(bloomSampler_);
+}
+
+void PostProcess::createExposureBuffer(UploadContext &uploadContext) {
+    VkBufferCreateInfo bufferInfo = vk::BufferCreateInfo()
+                                    .setSize(EXPOSURE_BYTES)
+                                    .setUsage(vk::BufferUsageFlagBits::eStorageBuffer |
+                                              vk::BufferUsageFlagBits::eTransferDst)
+                                    .setSharingMode(vk::SharingMode::eExclusive);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VkBuffer rawBuffer;
+    if (vmaCreateBuffer(allocator_, &bufferInfo, &allocInfo, &rawBuffer, &exposureAllocation_, nullptr) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to create exposure buffer!");
+    }
+    exposureBuffer_ = rawBuffer;
+
+    // Empty histogram, no groups done, and exposure 0, which the first frame takes as "nothing to adapt from"
+    auto cmd = uploadContext.getCommandBuffer();
+    cmd.fillBuffer(exposureBuffer_, 0, VK_WHOLE_SIZE, 0);
+    auto barrier = vk::BufferMemoryBarrier2()
+                   .setSrcStageMask(vk::PipelineStageFlagBits2::eClear)
+                   .setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+                   .setDstStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+                   .setDstAccessMask(vk::AccessFlagBits2::eShaderStorageRead |
+                                     vk::AccessFlagBits2::eShaderStorageWrite)
+                   .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                   .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                   .setBuffer(exposureBuffer_)
+                   .setOffset(0)
+                   .setSize(VK_WHOLE_SIZE);
+    cmd.pipelineBarrier2(vk::DependencyInfo().setBufferMemoryBarriers(barrier));
+}
+
+void PostProcess::destroyBloom(Bloom &bloom) const {
+    auto device = context_.getDevice();
+    for (auto view : bloom.mipViews) {
+        if (view)
+            device.destroyImageView(view);
+    }
+    if (bloom.view)
+        device.destroyImageView(bloom.view);
+    if (bloom.image)
+        vmaDestroyImage(allocator_, bloom.image, bloom.allocation);
+    bloom = {};
+}
+
+void PostProcess::resize(vk::Extent2D maxExtent, DeletionQueue &deletionQueue) {
+    // Frames in flight may still use the old chain
+    deletionQueue.push([this, bloom = std::exchange(bloom_, {})]() mutable { destroyBloom(bloom); });
+    // At least one group's block, so every mip exists even for a tiny window
+    const auto half = halfExtent(maxExtent);
+    const vk::Extent3D extent(std::max(half.width, GROUP_TEXELS), std::max(half.height, GROUP_TEXELS), 1);
+
+    VkImageCreateInfo imageInfo = vk::ImageCreateInfo()
+                                  .setImageType(vk::ImageType::e2D)
+                                  .setExtent(extent)
+                                  .setMipLevels(BLOOM_MIPS)
+                                  .setArrayLayers(1)
+                                  .setFormat(BLOOM_FORMAT)
+                                  .setTiling(vk::ImageTiling::eOptimal)
+                                  .setInitialLayout(vk::ImageLayout::eUndefined)
+                                  .setUsage(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled)
+                                  .setSamples(vk::SampleCountFlagBits::e1)
+                                  .setSharingMode(vk::SharingMode::eExclusive);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VkImage rawImage;
+    if (vmaCreateImage(allocator_, &imageInfo, &allocInfo, &rawImage, &bloom_.allocation, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bloom image!");
+    }
+    bloom_.image = rawImage;
+
+    auto viewInfo = vk::ImageViewCreateInfo()
+                    .setImage(bloom_.image)
+                    .setViewType(vk::ImageViewType::e2D)
+                    .setFormat(BLOOM_FORMAT)
+                    .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, BLOOM_MIPS, 0, 1});
+    bloom_.view = context_.getDevice().createImageView(viewInfo);
+    for (uint32_t mip = 0; mip < BLOOM_MIPS; mip++) {
+        viewInfo.setSubresourceRange({vk::ImageAspectFlagBits::eColor, mip, 1, 0, 1});
+        bloom_.mipViews[mip] = context_.getDevice().createImageView(viewInfo);
+    }
+}
+
+void PostProcess::record(vk::CommandBuffer commandBuffer, vk::Extent2D renderExtent,
+                         const BindCallback &bind) const {
+    // Last frame's output pass is done with both: the bloom is rewritten (so discarded) and the
+    // exposure state is read back and updated
+    auto discard = vk::ImageMemoryBarrier2()
+                   .setSrcStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+                   .setSrcAccessMask(vk::AccessFlagBits2::eNone)
+                   .setDstStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+                   .setDstAccessMask(vk::AccessFlagBits2::eShaderStorageWrite)
+                   .setOldLayout(vk::ImageLayout::eUndefined)
+                   .setNewLayout(vk::ImageLayout::eGeneral)
+                   .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                   .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                   .setImage(bloom_.image)
+                   .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, BLOOM_MIPS, 0, 1});
+    auto exposureBefore = vk::BufferMemoryBarrier2()
+                          .setSrcStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+                          .setSrcAccessMask(vk::AccessFlagBits2::eNone)
+                          .setDstStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+                          .setDstAccessMask(vk::AccessFlagBits2::eShaderStorageRead |
+                                            vk::AccessFlagBits2::eShaderStorageWrite)
+                          .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                          .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                          .setBuffer(exposureBuffer_)
+                          .setOffset(0)
+                          .setSize(VK_WHOLE_SIZE);
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo()
+                                   .setImageMemoryBarriers(discard)
+                                   .setBufferMemoryBarriers(exposureBefore));
+
+    const auto extent = halfExtent(renderExtent);
+    bind(commandBuffer);
+    commandBuffer.dispatch((extent.width + GROUP_TEXELS - 1) / GROUP_TEXELS,
+                           (extent.height + GROUP_TEXELS - 1) / GROUP_TEXELS, 1);
+
+    auto bloomAfter = vk::ImageMemoryBarrier2()
+                      .setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+                      .setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageWrite)
+                      .setDstStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+                      .setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead)
+                      .setOldLayout(vk::ImageLayout::eGeneral)
+                      .setNewLayout(vk::ImageLayout::eGeneral)
+                      .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                      .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                      .setImage(bloom_.image)
+                      .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, BLOOM_MIPS, 0, 1});
+    auto exposureAfter = vk::BufferMemoryBarrier2(exposureBefore)
+                         .setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+                         .setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageWrite)
+                         .setDstStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+                         .setDstAccessMask(vk::AccessFlagBits2::eShaderStorageRead);
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo()
+                                   .setImageMemoryBarriers(bloomAfter)
+                                   .setBufferMemoryBarriers(exposureAfter));
+}
+
+glm::vec4 PostProcess::frameUniform() {
+    // Exponential adaptation: the same share of the remaining gap closes per second at any frame rate.
+    // The first frame (and one after a long stall) jumps straight to its target.
+    const auto now = std::chrono::steady_clock::now();
+    const float seconds = lastFrame_ == std::chrono::steady_clock::time_point{}
+                              ? 1e3f
+                              : std::chrono::duration<float>(now - lastFrame_).count();
+    lastFrame_ = now;
+    const float adaptation = 1.0f - std::exp(-settings_.adaptationRate * seconds);
+    return {settings_.bloomThreshold, settings_.bloomIntensity, adaptation, settings_.exposureCompensation};
+}
+
+std::array<vk::DescriptorImageInfo, PostProcess::BLOOM_MIPS> PostProcess::getBloomStorageInfos() const {
+    std::array<vk::DescriptorImageInfo, BLOOM_MIPS> infos;
+    for (uint32_t mip = 0; mip < BLOOM_MIPS; mip++) {
+        infos[mip] = vk::DescriptorImageInfo(nullptr, bloom_.mipViews[mip], vk::ImageLayout::eGeneral);
+    }
+    return infos;
+}
+
+vk::DescriptorImageInfo PostProcess::getBloomTextureInfo() const {
+    return vk::DescriptorImageInfo(bloomSampler_, bloom_.view, vk::ImageLayout::eGeneral);
+}
+
+vk::DescriptorBufferInfo PostProcess::getExposureInfo() const {
+    return vk::DescriptorBufferInfo(exposureBuffer_, 0, VK_WHOLE_SIZE);
+}
@@ -0,0 +1,106 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <glm/glm.hpp>
+#include <vma/vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+#include "common/config.hpp"
+
+class DeletionQueue;
+class UploadContext;
+class VulkanContext;
+
+/**
+ * PostProcess
+ *
+ * HDR post chain between the main pass and the output pass. The lighting
+ * accumulates linear radiance in the RGBA16F scene color; a single compute
+ * dispatch (shaders/compute/hdr_reduce.comp) then
+ *   - bright-passes it into mip 0 of the half-res bloom chain and reduces each
+ *     group's 32x32 block down to one texel of the last mip in shared memory,
+ *     instead of one pass per mip,
+ *   - bins the same texels into a luminance histogram,
+ *   - lets the last group to finish (a global atomic counter) turn the
+ *     histogram into this frame's exposure, adapted from the last one's, and
+ *     clear it for the next frame.
+ * The output pass (upscale or temporal resolve) adds the bloom mips, applies
+ * the exposure and the tonemap in the fragment that writes the swapchain
+ * image (shaders/include/post.glsl), so no full-screen pass is added.
+ *
+ * The exposure state persists across frames in a small GPU-only buffer; frames
+ * run in submission order, so each one adapts from the previous. The bloom
+ * image stays in the general layout, read as storage images (one per mip) by
+ * the dispatch and as one mipmapped texture by the output pass.
+ */
+class PostProcess {
+public:
+    struct Settings {
+        float bloomThreshold = engine::BLOOM_THRESHOLD;
+        float bloomIntensity = engine::BLOOM_INTENSITY; // 0 = no bloom
+        float exposureCompensation = engine::EXPOSURE_COMPENSATION; // EV
+        float adaptationRate = engine::EXPOSURE_ADAPTATION_RATE; // per second
+    };
+
+    // Set 1 bindings, after the ambient occlusion's (AmbientOcclusion::TEXTURE_BINDING)
+    static constexpr uint32_t BLOOM_IMAGE_BINDING = 12; // storage image per mip
+    static constexpr uint32_t BLOOM_TEXTURE_BINDING = 13; // all mips
+    static constexpr uint32_t EXPOSURE_BINDING = 14;
+    // A group reduces 32x32 texels of mip 0 to one texel, so six mips
+    static constexpr uint32_t BLOOM_MIPS = 6;
+    static constexpr vk::Format BLOOM_FORMAT = vk::Format::eR16G16B16A16Sfloat;
+
+    // Binds the post pipeline and both sets at the compute bind point; the dispatch is recorded here
+    using BindCallback = std::function<void(vk::CommandBuffer)>;
+
+    // Records the exposure buffer's initial clear into the upload batch
+    PostProcess(VulkanContext &context, VmaAllocator allocator, UploadContext &uploadContext);
+    ~PostProcess();
+
+    PostProcess(const PostProcess &) = delete;
+    PostProcess &operator=(const PostProcess &) = delete;
+
+    // (Re)creates the bloom chain at half of 'maxExtent'; the old one goes to 'deletionQueue'
+    void resize(vk::Extent2D maxExtent, DeletionQueue &deletionQueue);
+
+    // The dispatch over the rendered region of the scene color, whose writes the main pass made visible.
+    // The bloom and the exposure are made visible to the output pass' fragment shaders.
+    void record(vk::CommandBuffer commandBuffer, vk::Extent2D renderExtent, const BindCallback &bind) const;
+
+    void setSettings(const Settings &settings) { settings_ = settings; }
+    [[nodiscard]] const Settings &getSettings() const { return settings_; }
+    // ViewUniforms::post for the next frame; advances the adaptation clock, so call it once per frame
+    [[nodiscard]] glm::vec4 frameUniform();
+
+    [[nodiscard]] std::array<vk::DescriptorImageInfo, BLOOM_MIPS> getBloomStorageInfos() const;
+    [[nodiscard]] vk::DescriptorImageInfo getBloomTextureInfo() const;
+    [[nodiscard]] vk::DescriptorBufferInfo getExposureInfo() const;
+
+private:
+    VulkanContext &context_;
+    VmaAllocator allocator_;
+    Settings settings_{};
+    std::chrono::steady_clock::time_point lastFrame_{};
+
+    struct Bloom {
+        vk::Image image;
+        VmaAllocation allocation = nullptr;
+        std::array<vk::ImageView, BLOOM_MIPS> mipViews{};
+        vk::ImageView view; // all mips
+    };
+    Bloom bloom_{};
+    vk::Sampler bloomSampler_;
+
+    vk::Buffer exposureBuffer_;
+    VmaAllocation exposureAllocation_ = nullptr;
+
+    void createExposureBuffer(UploadContext &uploadContext);
+    void destroyBloom(Bloom &bloom) const;
+};
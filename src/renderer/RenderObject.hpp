@@ -0,0 +1,38 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+
+#include "scene/Bounds.hpp"
+#include "system/MaterialSystem.hpp"
+
+using MeshHandle = uint32_t;
+using NodeHandle = uint32_t; // see Scene
+
+// Index range inside the shared vertex/index buffers
+struct Mesh {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    int32_t vertexOffset = 0;
+    Aabb bounds; // object space
+};
+
+// Mesh + material attached to a scene node; drawn with the node's world transform.
+// The renderer batches objects that share mesh + material into a single instanced draw.
+struct RenderObject {
+    MeshHandle mesh = 0;
+    MaterialHandle material = 0;
+    NodeHandle node = 0;
+    bool dynamic = false; // expected to move; kept out of the cached static shadow maps
+};
+
+// Instanced draw; firstInstance indexes the frame's ObjectData array
+struct DrawBatch {
+    MeshHandle mesh;
+    MaterialHandle material;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
@@ -0,0 +1,139 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "ShadowAtlas.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+ShadowAtlas::ShadowAtlas(uint32_t atlasSize, uint32_t minTileSize)
+    : atlasSize_(atlasSize), minTileSize_(minTileSize) {
+    if (!std::has_single_bit(atlasSize) || !std::has_single_bit(minTileSize) || minTileSize > atlasSize) {
+        throw std::runtime_error("shadow atlas sizes must be powers of two with minTileSize <= atlasSize!");
+    }
+    levelCount_ = static_cast<uint32_t>(std::countr_zero(atlasSize / minTileSize)) + 1;
+    levels_.resize(levelCount_);
+    for (uint32_t level = 0; level < levelCount_; level++) {
+        Level &l = levels_[level];
+        l.tileSize = atlasSize >> level;
+        l.tilesPerRow = 1u << level;
+        l.state.resize(static_cast<size_t>(l.tilesPerRow) * l.tilesPerRow);
+        l.freeSlot.resize(l.state.size());
+    }
+    clear();
+}
+
+void ShadowAtlas::clear() {
+    for (auto &level : levels_) {
+        std::fill(level.state.begin(), level.state.end(), NodeState::Unused);
+        level.freeList.clear();
+    }
+    pushFree(0, 0);
+    allocatedTexels_ = 0;
+}
+
+uint32_t ShadowAtlas::levelForSize(uint32_t size) const {
+    size = std::max(std::bit_ceil(size), minTileSize_);
+    if (size > atlasSize_)
+        return UINT32_MAX;
+    return static_cast<uint32_t>(std::countr_zero(atlasSize_ / size));
+}
+
+void ShadowAtlas::pushFree(uint32_t level, uint32_t node) {
+    Level &l = levels_[level];
+    l.state[node] = NodeState::Free;
+    l.freeSlot[node] = static_cast<uint32_t>(l.freeList.size());
+    l.freeList.push_back(node);
+}
+
+void ShadowAtlas::removeFree(uint32_t level, uint32_t node) {
+    // Swap-remove; keeps removal O(1) when merging
+    Level &l = levels_[level];
+    const uint32_t slot = l.freeSlot[node];
+    const uint32_t last = l.freeList.back();
+    l.freeList[slot] = last;
+    l.freeSlot[last] = slot;
+    l.freeList.pop_back();
+    l.state[node] = NodeState::Unused;
+}
+
+std::optional<ShadowAtlas::Tile> ShadowAtlas::allocate(uint32_t size) {
+    const uint32_t target = levelForSize(size);
+    if (target == UINT32_MAX)
+        return std::nullopt;
+
+    // Smallest free tile that still fits, so large tiles stay intact as long as possible
+    uint32_t level = target;
+    while (levels_[level].freeList.empty()) {
+        if (level == 0)
+            return std::nullopt;
+        level--;
+    }
+
+    uint32_t node = levels_[level].freeList.back();
+    removeFree(level, node);
+
+    // Split down: keep the first child, free the other three
+    while (level < target) {
+        const uint32_t row = levels_[level].tilesPerRow;
+        const uint32_t x = node % row, y = node / row;
+        level++;
+        const uint32_t childRow = levels_[level].tilesPerRow;
+        const uint32_t first = (2 * y) * childRow + 2 * x;
+        pushFree(level, first + 1);
+        pushFree(level, first + childRow);
+        pushFree(level, first + childRow + 1);
+        node = first;
+    }
+
+    Level &l = levels_[target];
+    l.state[node] = NodeState::Allocated;
+    allocatedTexels_ += static_cast<uint64_t>(l.tileSize) * l.tileSize;
+    return Tile{(node % l.tilesPerRow) * l.tileSize, (node / l.tilesPerRow) * l.tileSize, l.tileSize};
+}
+
+void ShadowAtlas::free(const Tile &tile) {
+    uint32_t level = levelForSize(tile.size);
+    if (level == UINT32_MAX || levels_[level].tileSize != tile.size) {
+        throw std::runtime_error("freeing a tile that was not allocated from this atlas!");
+    }
+    uint32_t x = tile.x / tile.size, y = tile.y / tile.size;
+    uint32_t node = y * levels_[level].tilesPerRow + x;
+    if (levels_[level].state[node] != NodeState::Allocated) {
+        throw std::runtime_error("freeing a tile that was not allocated from this atlas!");
+    }
+    levels_[level].state[node] = NodeState::Unused;
+    allocatedTexels_ -= static_cast<uint64_t>(tile.size) * tile.size;
+
+    // Merge upwards while all four siblings are free
+    while (level > 0) {
+        const uint32_t row = levels_[level].tilesPerRow;
+        const uint32_t first = (y & ~1u) * row + (x & ~1u);
+        const uint32_t siblings[4] = {first, first + 1, first + row, first + row + 1};
+        bool allFree = true;
+        for (uint32_t sibling : siblings) {
+            allFree &= sibling == node || levels_[level].state[sibling] == NodeState::Free;
+        }
+        if (!allFree)
+            break;
+        for (uint32_t sibling : siblings) {
+            if (sibling != node)
+                removeFree(level, sibling);
+        }
+        x >>= 1;
+        y >>= 1;
+        level--;
+        node = y * levels_[level].tilesPerRow + x;
+    }
+    pushFree(level, node);
+}
+
+uint32_t ShadowAtlas::getLargestFreeTile() const {
+    for (const auto &level : levels_) {
+        if (!level.freeList.empty())
+            return level.tileSize;
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * ShadowAtlas
+ *
+ * Quadtree (buddy) allocator for square, power-of-two tiles inside one square
+ * shadow atlas. Level 0 is the whole atlas, every level below splits a tile
+ * into four. Allocation takes the smallest free tile that fits and splits it
+ * down; freeing merges four free siblings back into their parent, so the atlas
+ * returns to one free tile once everything is released.
+ *
+ * CPU only: no Vulkan types, so packing can be exercised without a device.
+ */
+class ShadowAtlas {
+public:
+    struct Tile {
+        uint32_t x = 0; // texels from the atlas' top-left corner
+        uint32_t y = 0;
+        uint32_t size = 0; // 0 = no tile
+
+        [[nodiscard]] bool isValid() const { return size != 0; }
+        bool operator==(const Tile &) const = default;
+    };
+
+    // 'atlasSize' and 'minTileSize' must be powers of two, minTileSize <= atlasSize
+    ShadowAtlas(uint32_t atlasSize, uint32_t minTileSize);
+
+    // 'size' is rounded up to a power of two and to at least the minimum tile size
+    std::optional<Tile> allocate(uint32_t size);
+    void free(const Tile &tile);
+    void clear();
+
+    [[nodiscard]] uint32_t getSize() const { return atlasSize_; }
+    [[nodiscard]] uint32_t getMinTileSize() const { return minTileSize_; }
+    [[nodiscard]] uint32_t getLevelCount() const { return levelCount_; }
+    [[nodiscard]] uint64_t getAllocatedTexels() const { return allocatedTexels_; }
+
+    // Largest tile allocate() would currently succeed with, 0 if the atlas is full
+    [[nodiscard]] uint32_t getLargestFreeTile() const;
+
+private:
+    enum class NodeState : uint8_t { Unused, Free, Allocated };
+
+    struct Level {
+        uint32_t tileSize = 0;
+        uint32_t tilesPerRow = 0;
+        std::vector<NodeState> state; // tilesPerRow^2 entries, row-major
+        std::vector<uint32_t> freeList; // node indices
+        std::vector<uint32_t> freeSlot; // node -> position in freeList
+    };
+
+    [[nodiscard]] uint32_t levelForSize(uint32_t size) const;
+    void pushFree(uint32_t level, uint32_t node);
+    void removeFree(uint32_t level, uint32_t node);
+
+    uint32_t atlasSize_;
+    uint32_t minTileSize_;
+    uint32_t levelCount_ = 0;
+    std::vector<Level> levels_;
+    uint64_t allocatedTexels_ = 0;
+};
@@ -0,0 +1,141 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "ShadowScheduler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+ShadowScheduler::ShadowScheduler(ShadowAtlas &atlas, uint32_t maxTileSize, uint64_t texelBudget)
+    : atlas_(atlas), maxTileSize_(std::min(std::bit_floor(maxTileSize), atlas.getSize())),
+      texelBudget_(texelBudget) {
+}
+
+uint32_t ShadowScheduler::desiredTileSize(const Request &request) const {
+    if (request.importance <= 0.0f || request.viewCount == 0)
+        return 0;
+
+    // Largest power of two not above coverage * max; six-view lights one step smaller
+    const float wanted = std::min(request.importance, 1.0f) * static_cast<float>(maxTileSize_);
+    uint32_t size = std::bit_floor(static_cast<uint32_t>(std::max(wanted, 1.0f)));
+    if (request.viewCount > 1)
+        size >>= 1;
+    return std::clamp(size, atlas_.getMinTileSize(), maxTileSize_);
+}
+
+void ShadowScheduler::release(LightState &state) {
+    for (uint32_t view = 0; view < state.viewCount; view++) {
+        atlas_.free(state.tiles[view]);
+        state.tiles[view] = {};
+    }
+    state.viewCount = 0;
+    state.tileSize = 0;
+    state.valid = false;
+}
+
+bool ShadowScheduler::place(LightState &state, uint32_t tileSize, uint32_t viewCount) {
+    // All views of a light or none; a partially shadowed point light would be worse than none
+    std::array<ShadowAtlas::Tile, MAX_VIEWS> tiles{};
+    for (uint32_t view = 0; view < viewCount; view++) {
+        auto tile = atlas_.allocate(tileSize);
+        if (!tile) {
+            for (uint32_t allocated = 0; allocated < view; allocated++) {
+                atlas_.free(tiles[allocated]);
+            }
+            return false;
+        }
+        tiles[view] = *tile;
+    }
+
+    // A growing light gives its old tiles back only now, so a failed attempt leaves it as it was
+    release(state);
+    state.tiles = tiles;
+    state.viewCount = viewCount;
+    state.tileSize = tileSize;
+    state.valid = false;
+    state.dirty = true;
+    return true;
+}
+
+const std::vector<uint32_t> &ShadowScheduler::schedule(const std::vector<Request> &requests) {
+    // Lights beyond the request count are gone
+    for (size_t light = requests.size(); light < states_.size(); light++) {
+        release(states_[light]);
+    }
+    states_.resize(requests.size());
+
+    order_.resize(requests.size());
+    for (uint32_t light = 0; light < order_.size(); light++) {
+        order_[light] = light;
+    }
+    std::stable_sort(order_.begin(), order_.end(), [&](uint32_t a, uint32_t b) {
+        return requests[a].importance > requests[b].importance;
+    });
+
+    // 1. Give back every tile that no longer matches, so the placement below can reuse the space. Lights that
+    //    want a bigger tile keep theirs until step 2 has one for them.
+    std::vector<uint32_t> desired(requests.size());
+    for (uint32_t light = 0; light < requests.size(); light++) {
+        LightState &state = states_[light];
+        desired[light] = desiredTileSize(requests[light]);
+        state.dirty |= requests[light].dirty;
+
+        if (state.viewCount == 0)
+            continue;
+        const bool viewsChanged = state.viewCount != std::min(requests[light].viewCount, MAX_VIEWS);
+        const bool shrink = desired[light] * 4 <= state.tileSize; // hysteresis: keep within one step
+        if (desired[light] == 0 || viewsChanged || shrink)
+            release(state);
+    }
+
+    // 2. Place the lights without tiles and grow the others, most important first, degrading the size when
+    //    full. A light that cannot grow keeps its tiles, and its render stays valid.
+    for (uint32_t light : order_) {
+        LightState &state = states_[light];
+        if (desired[light] == 0 || (state.viewCount != 0 && desired[light] <= state.tileSize))
+            continue;
+        const uint32_t viewCount = std::min(requests[light].viewCount, MAX_VIEWS);
+        const uint32_t smallest = state.viewCount != 0 ? state.tileSize * 2 : atlas_.getMinTileSize();
+        for (uint32_t size = desired[light]; size >= smallest; size >>= 1) {
+            if (place(state, size, viewCount))
+                break;
+        }
+    }
+
+    // 3. Spend the budget on the due lights, highest priority first
+    scheduled_.clear();
+    for (uint32_t light = 0; light < states_.size(); light++) {
+        LightState &state = states_[light];
+        if (state.viewCount == 0 || !state.dirty) {
+            state.framesWaiting = 0;
+            state.priority = 0.0f;
+            continue;
+        }
+        const float age = 1.0f + static_cast<float>(state.framesWaiting);
+        state.priority = requests[light].importance * age * (state.valid ? 1.0f : 4.0f);
+        scheduled_.push_back(light);
+    }
+    std::stable_sort(scheduled_.begin(), scheduled_.end(), [&](uint32_t a, uint32_t b) {
+        return states_[a].priority > states_[b].priority;
+    });
+
+    scheduledTexels_ = 0;
+    size_t kept = 0;
+    for (uint32_t light : scheduled_) {
+        LightState &state = states_[light];
+        const uint64_t cost = static_cast<uint64_t>(state.viewCount) * state.tileSize * state.tileSize;
+        if (kept == 0 || scheduledTexels_ + cost <= texelBudget_) {
+            scheduledTexels_ += cost;
+            scheduled_[kept++] = light;
+            state.valid = true;
+            state.dirty = false;
+            state.framesWaiting = 0;
+        } else {
+            state.framesWaiting++;
+        }
+    }
+    scheduled_.resize(kept);
+    return scheduled_;
+}
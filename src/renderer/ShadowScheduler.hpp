@@ -0,0 +1,80 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "ShadowAtlas.hpp"
+
+/**
+ * ShadowScheduler
+ *
+ * Decides, once per frame, which local lights own which atlas tiles and which
+ * of them are re-rendered.
+ *
+ * Sizing: a light's tile edge follows its screen coverage (importance), as a
+ * power of two between the atlas' minimum and 'maxTileSize'. Point lights need
+ * six views and get tiles one step smaller. Tiles only shrink once the wanted
+ * size is two steps below the current one, so lights hovering around a
+ * threshold do not thrash. Lights are placed in importance order; when the
+ * atlas is full a light falls back to smaller tiles, then to no shadow. A
+ * light only grows once its bigger tiles are allocated; until then it keeps
+ * the ones it has, along with their render.
+ *
+ * Updates: a light is due when its tiles are new or the caller flags it
+ * (transform or caster set changed). Due lights are rendered in priority
+ * order - importance, scaled up the longer a light has waited and for lights
+ * whose tiles hold nothing usable yet - until the per-frame texel budget is
+ * spent. The first one always goes, so a big tile cannot starve.
+ *
+ * CPU only, like ShadowAtlas; the renderer turns the result into draws.
+ */
+class ShadowScheduler {
+public:
+    static constexpr uint32_t MAX_VIEWS = 6;
+
+    struct Request {
+        float importance = 0.0f; // screen coverage in [0, 1]; 0 drops the shadow and frees its tiles
+        uint32_t viewCount = 1; // 1 = spot, 6 = point
+        bool dirty = false; // transform or casters changed since the light was last rendered
+    };
+
+    struct LightState {
+        std::array<ShadowAtlas::Tile, MAX_VIEWS> tiles{};
+        uint32_t viewCount = 0; // views holding a tile; 0 = no shadow
+        uint32_t tileSize = 0;
+        bool valid = false; // tiles hold a render of the light's current views
+        bool dirty = false; // needs a render; carried over until the budget allows it
+        uint32_t framesWaiting = 0;
+        float priority = 0.0f;
+    };
+
+    ShadowScheduler(ShadowAtlas &atlas, uint32_t maxTileSize, uint64_t texelBudget);
+
+    // 'requests' is indexed by light; its size is the light count. Returns the lights to
+    // render this frame, highest priority first. They are considered valid from then on.
+    const std::vector<uint32_t> &schedule(const std::vector<Request> &requests);
+
+    [[nodiscard]] const LightState &getState(uint32_t light) const { return states_[light]; }
+    [[nodiscard]] size_t getLightCount() const { return states_.size(); }
+    [[nodiscard]] uint64_t getTexelBudget() const { return texelBudget_; }
+    [[nodiscard]] uint64_t getScheduledTexels() const { return scheduledTexels_; }
+
+private:
+    [[nodiscard]] uint32_t desiredTileSize(const Request &request) const;
+    void release(LightState &state);
+    bool place(LightState &state, uint32_t tileSize, uint32_t viewCount);
+
+    ShadowAtlas &atlas_;
+    uint32_t maxTileSize_;
+    uint64_t texelBudget_;
+
+    std::vector<LightState> states_;
+    std::vector<uint32_t> order_; // scratch: lights by importance
+    std::vector<uint32_t> scheduled_;
+    uint64_t scheduledTexels_ = 0;
+};
@@ -3,12 +3,92 @@
 //
 
 #pragma once
-#include <glm/fwd.hpp>
+#include <cstdint>
+#include <glm/glm.hpp>
 
+#include "common/config.hpp"
 
-struct UniformBufferObject
+
+// Per-view constants, computed once per frame on the CPU so no shader inverts a matrix.
+// Bump-allocated and bound as a dynamic UBO (set 0, binding 0).
+struct ViewUniforms
 {
-    alignas(16) glm::mat4 model;
     alignas(16) glm::mat4 view;
-    alignas(16) glm::mat4 proj;
+    alignas(16) glm::mat4 proj; // jittered, as rasterized (and so are its derivatives below)
+    alignas(16) glm::mat4 viewProj;
+    alignas(16) glm::mat4 invView;
+    alignas(16) glm::mat4 invProj;
+    alignas(16) glm::mat4 invViewProj;
+    alignas(16) glm::vec4 cameraPosition; // xyz = world position, w = 1
+    alignas(16) glm::vec4 frustumPlanes[6]; // see Camera::extractFrustumPlanes
+    alignas(16) glm::vec4 viewport; // xy = render size in pixels, zw = 1 / size
+    alignas(16) glm::vec4 upscale; // xy = render size / target size (scene color UV range), zw = 1 / output size
+    alignas(16) glm::mat4 unjitteredViewProj; // motion vectors: this frame ...
+    alignas(16) glm::mat4 prevViewProj; // ... and the last one, both without jitter
+    alignas(16) glm::vec4 temporal; // xy = jitter in render pixels, z = 1 if the history is valid, w = history read
+    alignas(16) uint32_t debugView; // gbuffer::DebugView
+    // x = first tile of this frame's slice, y = tiles per row, z = tile size; see LightBinning
+    alignas(16) glm::uvec4 lightTiles;
+    alignas(16) glm::vec4 ambientOcclusion; // x = radius, y = intensity, z = sample count (0 = off)
+    // x = bloom threshold, y = bloom intensity, z = exposure adaptation this frame (0..1), w = compensation (EV)
+    alignas(16) glm::vec4 post;
+};
+
+
+// Per-instance data, one entry per RenderObject in the frame's ObjectBuffer (set 0, binding 3).
+// Indexed with gl_InstanceIndex, so every batch's firstInstance points at its first entry.
+struct ObjectData
+{
+    alignas(16) glm::mat4 model;
+    alignas(16) glm::vec4 normalMatrix[3]; // std430 mat3: inverse-transpose of mat3(model), see simd::normalMatrices
+    alignas(16) glm::uvec4 drawInfo; // x = mesh firstIndex, y = mesh vertexOffset, z = material (visibility buffer)
+    alignas(16) glm::mat4 prevModel; // last frame's model, for motion vectors; main pass only
+};
+
+
+// Directional light and its shadow cascades (set 0, binding 5), see CascadedShadowMap.
+// cascadeViewProj[i] is the matrix layer i of the shadow map was rendered with.
+struct ShadowUniforms
+{
+    alignas(16) glm::mat4 cascadeViewProj[engine::SHADOW_CASCADE_COUNT];
+    alignas(16) glm::vec4 cascadeSplits; // view-space far distance of each cascade
+    alignas(16) glm::vec4 cascadeTexelSize; // world units per shadow texel, scales the normal offset
+    alignas(16) glm::vec4 lightDirection; // xyz = direction towards the light, normalised
+};
+static_assert(engine::SHADOW_CASCADE_COUNT == 4, "ShadowUniforms packs one cascade per vec4 component");
+
+
+// Point/spot lights and their shadow views (set 0, binding 6), see LocalLightShadows.
+// Light i owns shadow views [i * 6, i * 6 + viewCount); firstShadowView is -1 while it has no usable shadow.
+struct GpuLocalLight
+{
+    alignas(16) glm::vec4 positionRange; // xyz = world position, w = range
+    alignas(16) glm::vec4 colorIntensity; // rgb = color, a = intensity
+    alignas(16) glm::vec4 directionType; // xyz = spot direction, w = LightType
+    alignas(16) glm::vec4 spotShadow; // x = cos outer cone, y = cos inner cone, z = first shadow view
+};
+
+struct GpuShadowView
+{
+    alignas(16) glm::mat4 viewProj; // the matrix the atlas tile was rendered with
+    alignas(16) glm::vec4 atlasRect; // xy = tile offset, zw = tile scale, in atlas UV
+};
+
+inline constexpr uint32_t LOCAL_SHADOW_VIEWS_PER_LIGHT = 6;
+
+struct LocalLightBuffer
+{
+    alignas(16) uint32_t lightCount;
+    GpuLocalLight lights[engine::MAX_LOCAL_LIGHTS];
+    GpuShadowView shadowViews[engine::MAX_LOCAL_LIGHTS * LOCAL_SHADOW_VIEWS_PER_LIGHT];
+};
+
+
+// Per-draw push constants (vertex + fragment)
+struct DrawPushConstants
+{
+    uint32_t materialIndex;
+    // Shadow pass only: < SHADOW_CASCADE_COUNT selects a cascade, otherwise
+    // SHADOW_CASCADE_COUNT + the local shadow view
+    uint32_t shadowView;
 };
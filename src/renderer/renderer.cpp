@@ -7,21 +7,51 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "renderer.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstring>
+#include <optional>
 
+#include "CascadedShadowMap.hpp"
+#include "LightBinning.hpp"
+#include "LocalLightShadows.hpp"
 #include "Uniform.hpp"
 #include "Vertex.hpp"
 #include "common/config.hpp"
+#include "common/SimdMath.hpp"
+#include "common/JobSystem.hpp"
+#include "common/RadixSort.hpp"
+#include "scene/Scene.hpp"
+#include "system/TextureSystem.hpp"
+#include "vulkan/DescriptorAllocator.hpp"
+#include "vulkan/DescriptorLayoutCache.hpp"
+#include "vulkan/FrameAllocator.hpp"
+#include "vulkan/GBuffer.hpp"
+#include "vulkan/GpuTimer.hpp"
+#include "vulkan/TemporalAA.hpp"
+#include "vulkan/UploadContext.hpp"
+#include "vulkan/VisibilityBuffer.hpp"
+#include "vulkan/graphics_pipeline.hpp"
 #include "vulkan/render_pass.hpp"
 #include "vulkan/swap_chain.hpp"
 #include "vulkan/VulkanContext.hpp"
 // The C++ Bindings Header
 
+namespace {
+// Binds the main pass records between draws of batch keys 'previous' and 'next' (see buildDrawList):
+// the pipeline when the shading model (top 4 bits) changes, the material push constant when the material does
+uint32_t bindCount(uint64_t previous, uint64_t next) {
+    const bool modelChanged = (previous >> 28) != (next >> 28);
+    const bool materialChanged = ((previous >> 16) & 0xfff) != ((next >> 16) & 0xfff);
+    return static_cast<uint32_t>(modelChanged) + static_cast<uint32_t>(materialChanged);
+}
+}
+
 Renderer::Renderer(VulkanContext &context, SwapChain &swapChain, RenderPass &renderPass,
                    GLFWwindow *window_)
     : context_(context), swapChain_(swapChain), renderPass_(renderPass),
-      window_(window_) {
+      window_(window_), framebufferSize_(swapChain.getExtent()) {
 
     // 1. Initialize Memory Allocator
     createAllocator();
@@ -32,6 +62,7 @@ Renderer::Renderer(VulkanContext &context, SwapChain &swapChain, RenderPass &ren
 
     // 3. Setup Synchronization (Fences/Semaphores)
     createSyncObjects();
+    framePacer_ = std::make_unique<FramePacer>(context_, frameTimeline_);
 }
 
 /**
@@ -57,24 +88,26 @@ Renderer::~Renderer() {
     // 1. Ensure GPU is idle before we start deleting things
     std::cerr << "[Destructor] Renderer starting..." << std::endl;
     vkDeviceWaitIdle(context_.getDevice());
+    // Whatever was retired still refers to the objects below
+    deletionQueue_.flushAll();
 
-    vkDestroyDescriptorPool(context_.getDevice(), descriptorPool_, nullptr);
-    std::cerr << "[Destructor] Renderer-descriptorPool_..." << std::endl;
+    descriptorAllocator_.reset();
+    std::cerr << "[Destructor] Renderer-descriptorAllocator_..." << std::endl;
 
-    vkDestroyDescriptorSetLayout(context_.getDevice(), descriptorSetLayout_, nullptr);
-    std::cerr << "[Destructor] Renderer-descriptorSetLayout_..." << std::endl;
-    for (size_t i = 0; i < engine::MAX_FRAMES_IN_FLIGHT; i++) {
-        // VMA automatically handles the Unmapping if you used
-        // VMA_ALLOCATION_CREATE_MAPPED_BIT.
-        if (uniformBuffers_[i] != VK_NULL_HANDLE) {
-            vmaDestroyBuffer(vmaAllocator, uniformBuffers_[i], uniformBuffersAllocation_[i]);
-
-            // Safety: Clear the handles
-            uniformBuffers_[i] = VK_NULL_HANDLE;
-            uniformBuffersAllocation_[i] = nullptr;
-            uniformBuffersMapped_[i] = nullptr;
-        }
-    }
+    layoutCache_.reset();
+    std::cerr << "[Destructor] Renderer-layoutCache_..." << std::endl;
+
+    if (sceneColorSampler_)
+        context_.getDevice().destroySampler(sceneColorSampler_);
+    gpuTimer_.reset();
+    lightBinning_.reset();
+    ambientOcclusion_.reset();
+    postProcess_.reset();
+
+    // VMA unmaps persistently mapped allocations on destruction
+    frameAllocator_.reset();
+    shadowMap_.reset();
+    localShadows_.reset();
 
     // This replaces BOTH vkDestroyBuffer and vkFreeMemory
     if (vertexBuffer_ != VK_NULL_HANDLE) {
@@ -92,6 +125,11 @@ Renderer::~Renderer() {
         indexBuffer_ = VK_NULL_HANDLE;
         indexBufferAllocation_ = nullptr;
     }
+    // Materials, textures and the staging ring are VMA allocations too
+    materialSystem_.reset();
+    textureSystem_.reset();
+    uploadContext_.reset();
+
     // 3. Destroy the allocator itself
     // Note: All VMA buffers MUST be destroyed before this call
     if (vmaAllocator != VK_NULL_HANDLE) {
@@ -111,27 +149,486 @@ Renderer::~Renderer() {
     for (const auto &semaphore : renderFinishedSemaphores_) {
         vkDestroySemaphore(context_.getDevice(), semaphore, nullptr);
     }
+    vkDestroySemaphore(context_.getDevice(), frameTimeline_, nullptr);
 
     // 4. Destroy Command Pool (Implicitly frees all Command Buffers)
     if (commandPool_ != VK_NULL_HANDLE) {
         vkDestroyCommandPool(context_.getDevice(), commandPool_, nullptr);
     }
+    for (auto pool : shadowCommandPools_) {
+        if (pool)
+            context_.getDevice().destroyCommandPool(pool);
+    }
 }
 
 void Renderer::initResources(vk::PipelineLayout pipelineLayout, std::string modelPath) {
     activePipelineLayout_ = pipelineLayout;
 
+    jobSystem_ = std::make_unique<JobSystem>();
+    uploadContext_ = std::make_unique<UploadContext>(context_, vmaAllocator);
+    textureSystem_ = std::make_unique<TextureSystem>(context_, vmaAllocator, *uploadContext_, *jobSystem_);
+    materialSystem_ = std::make_unique<MaterialSystem>(context_, vmaAllocator);
+    frameAllocator_ = std::make_unique<FrameAllocator>(context_, vmaAllocator, engine::FRAME_ALLOCATOR_SIZE);
+    shadowMap_ = std::make_unique<CascadedShadowMap>(context_, vmaAllocator);
+    shadowMap_->setLightDirection(lightDirection_);
+    // Records the atlas clear into the upload batch, which createMaterials() flushes
+    localShadows_ = std::make_unique<LocalLightShadows>(context_, vmaAllocator, *uploadContext_);
+    lightBinning_ = std::make_unique<LightBinning>(context_, vmaAllocator);
+    lightBinning_->resize(swapChain_.getTargetExtent(), deletionQueue_);
+    ambientOcclusion_ = std::make_unique<AmbientOcclusion>(context_, vmaAllocator);
+    ambientOcclusion_->resize(swapChain_.getTargetExtent(), deletionQueue_);
+    // Off by default where the swapchain kept the G-buffer transient (lazily allocated memory)
+    auto occlusion = ambientOcclusion_->getSettings();
+    occlusion.enabled = occlusion.enabled && swapChain_.isGBufferStored();
+    ambientOcclusion_->setSettings(occlusion);
+    // Records the exposure buffer clear into the upload batch as well
+    postProcess_ = std::make_unique<PostProcess>(context_, vmaAllocator, *uploadContext_);
+    postProcess_->resize(swapChain_.getTargetExtent(), deletionQueue_);
+    gpuTimer_ = std::make_unique<GpuTimer>(context_, engine::MAX_FRAMES_IN_FLIGHT);
+    dynamicResolution_.setEnabled(engine::DYNAMIC_RESOLUTION && gpuTimer_->isSupported());
+    renderExtent_ = dynamicResolution_.getRenderExtent(swapChain_.getExtent());
+
+    // Bilinear, clamped: the upscale pass never samples past the rendered region anyway
+    sceneColorSampler_ = context_.getDevice().createSampler(
+        vk::SamplerCreateInfo()
+        .setMagFilter(vk::Filter::eLinear)
+        .setMinFilter(vk::Filter::eLinear)
+        .setMipmapMode(vk::SamplerMipmapMode::eNearest)
+        .setAddressModeU(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeV(vk::SamplerAddressMode::eClampToEdge)
+        .setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+        .setMaxLod(0.0f));
+    std::cout << "-- CPU culling: " << (engine::CULL_WITH_BVH ? "BVH" : culling::isaName(culling::detectIsa()))
+              << std::endl;
+
     // Load model using your system
-    ms.loadObjModel(modelPath);
+    ms.loadObjModel(modelPath, *jobSystem_);
 
     // Create resources using the helper we just built
     createVertexBuffer();
     createIndexBuffer();
-    createUniformBuffers();
-    createDescriptorPool();
-    createDescriptorSets();
+    createMaterials();
+    createScene();
+    createDescriptorAllocator();
+}
+
+
+void Renderer::createMaterials() {
+    // Handle 0 is the white fallback, so untextured materials simply point at it
+    whiteTexture_ = textureSystem_->createSolidColor(255, 255, 255, 255, TextureUsage::Color);
+
+    // Every distinct diffuse map is decoded in one parallel batch
+    const auto &modelMaterials = ms.getMaterials();
+    std::vector<TextureDesc> requests;
+    std::vector<int32_t> textureSlot(modelMaterials.size(), -1);
+    for (size_t i = 0; i < modelMaterials.size(); i++) {
+        const auto &path = modelMaterials[i].diffuseTexture;
+        if (path.empty())
+            continue;
+        auto it = std::find_if(requests.begin(), requests.end(), [&](const auto &r) { return r.path == path; });
+        textureSlot[i] = static_cast<int32_t>(it - requests.begin());
+        if (it == requests.end())
+            requests.push_back({path, TextureUsage::Color});
+    }
+
+    if (requests.size() + 1 > engine::MAX_BOUND_TEXTURES) {
+        throw std::runtime_error("model uses more textures than MAX_BOUND_TEXTURES!");
+    }
+    const auto textureHandles = textureSystem_->loadTextures(requests);
+
+    std::vector<MaterialHandle> handles;
+    for (size_t i = 0; i < modelMaterials.size(); i++) {
+        const auto &src = modelMaterials[i];
+        Material material;
+        material.name = src.name;
+        material.albedo = glm::vec4(src.diffuse[0], src.diffuse[1], src.diffuse[2], 1.0f);
+        material.specularStrength = src.specular;
+        material.shininess = src.shininess;
+        material.albedoTexture = textureSlot[i] >= 0 ? textureHandles[textureSlot[i]] : whiteTexture_;
+        handles.push_back(materialSystem_->addMaterial(material));
+    }
+
+    // Faces without a material (and .obj files without a .mtl) use the default
+    Material fallback;
+    fallback.name = "default";
+    fallback.albedoTexture = whiteTexture_;
+    const MaterialHandle fallbackHandle = materialSystem_->addMaterial(fallback);
+
+    for (const auto &submesh : ms.getSubmeshes()) {
+        Aabb bounds;
+        bounds.min = glm::vec3(submesh.boundsMin[0], submesh.boundsMin[1], submesh.boundsMin[2]);
+        bounds.max = glm::vec3(submesh.boundsMax[0], submesh.boundsMax[1], submesh.boundsMax[2]);
+        meshes_.push_back({submesh.firstIndex, submesh.indexCount, 0, bounds});
+        meshMaterials_.push_back(submesh.materialIndex >= 0 ? handles[submesh.materialIndex] : fallbackHandle);
+    }
+
+    materialSystem_->upload(*uploadContext_);
+
+    // Push the mesh + texture + material uploads out now; the first frame's submit is ordered after them
+    uploadContext_->flush();
+}
+
+void Renderer::createScene() {
+    scene_ = std::make_unique<Scene>(*jobSystem_);
+
+    // The model repeated over a grid centred on the origin, one node per copy under a
+    // common root. Every copy of a submesh shares mesh + material, so it ends up in one instanced draw.
+    const NodeHandle root = scene_->createNode();
+    const float half = 0.5f * static_cast<float>(engine::SCENE_GRID_SIZE - 1);
+    for (uint32_t y = 0; y < engine::SCENE_GRID_SIZE; y++) {
+        for (uint32_t x = 0; x < engine::SCENE_GRID_SIZE; x++) {
+            const glm::vec3 offset((static_cast<float>(x) - half) * engine::SCENE_GRID_SPACING,
+                                   (static_cast<float>(y) - half) * engine::SCENE_GRID_SPACING, 0.0f);
+            const NodeHandle node = scene_->createNode(root, glm::translate(glm::mat4(1.0f), offset));
+            for (MeshHandle mesh = 0; mesh < meshes_.size(); mesh++) {
+                scene_->addRenderObject(node, mesh, meshMaterials_[mesh]);
+            }
+        }
+    }
+
+    // A warm point light and a cool spot light above the grid
+    LocalLight point;
+    point.type = LightType::Point;
+    point.position = glm::vec3(1.5f, -1.5f, 2.0f);
+    point.range = 6.0f;
+    point.color = glm::vec3(1.0f, 0.6f, 0.3f);
+    point.intensity = 8.0f;
+    addLocalLight(point);
+
+    LocalLight spot;
+    spot.type = LightType::Spot;
+    spot.position = glm::vec3(-2.0f, 2.0f, 4.0f);
+    spot.direction = glm::normalize(glm::vec3(0.5f, -0.5f, -1.0f));
+    spot.range = 10.0f;
+    spot.color = glm::vec3(0.4f, 0.6f, 1.0f);
+    spot.intensity = 12.0f;
+    addLocalLight(spot);
+}
+
+void Renderer::updateSceneBounds() {
+    const auto &renderObjects = scene_->getRenderObjects();
+    auto worldBounds = [&](const RenderObject &object) {
+        return meshes_[object.mesh].bounds.transformed(scene_->getWorldTransform(object.node));
+    };
+
+    objectMoved_.assign(renderObjects.size(), 0);
+    boundsRebuilt_ = false;
+
+    // New objects change the primitive set: full (parallel) rebuild
+    if (renderObjects.size() != objectBounds_.size()) {
+        objectBounds_.resize(renderObjects.size());
+        cullingBounds_.resize(renderObjects.size());
+        for (size_t i = 0; i < renderObjects.size(); i++) {
+            objectBounds_[i] = worldBounds(renderObjects[i]);
+            cullingBounds_.set(i, objectBounds_[i]);
+        }
+        bvh_.build(objectBounds_, jobSystem_.get());
+        shadowMap_->invalidateStatic();
+        boundsRebuilt_ = true;
+        return;
+    }
+
+    // Moved objects only: keep the topology, refit the boxes on their paths
+    changedObjects_.clear();
+    if (scene_->getUpdatedNodeCount() > 0) {
+        for (uint32_t i = 0; i < renderObjects.size(); i++) {
+            if (scene_->wasWorldUpdated(renderObjects[i].node)) {
+                objectBounds_[i] = worldBounds(renderObjects[i]);
+                cullingBounds_.set(i, objectBounds_[i]);
+                changedObjects_.push_back(i);
+                objectMoved_[i] = 1;
+            }
+        }
+    }
+    if (changedObjects_.empty())
+        return;
+    bvh_.refit(objectBounds_, changedObjects_);
+
+    // Only dynamic objects may move without re-rendering the cached static shadows
+    const bool staticMoved = std::any_of(changedObjects_.begin(), changedObjects_.end(),
+                                         [&](uint32_t i) { return !renderObjects[i].dynamic; });
+    if (staticMoved)
+        shadowMap_->invalidateStatic();
+}
+
+void Renderer::setLightDirection(const glm::vec3 &towardsLight) {
+    lightDirection_ = glm::normalize(towardsLight);
+    if (shadowMap_)
+        shadowMap_->setLightDirection(lightDirection_);
+}
+
+LightHandle Renderer::addLocalLight(const LocalLight &light) {
+    if (localLights_.size() >= engine::MAX_LOCAL_LIGHTS) {
+        throw std::runtime_error("too many local lights, raise MAX_LOCAL_LIGHTS!");
+    }
+    localLights_.push_back(light);
+    localLightChanged_.push_back(1);
+    localCasterHashes_.push_back(0);
+    return static_cast<LightHandle>(localLights_.size() - 1);
 }
 
+void Renderer::setLocalLight(LightHandle handle, const LocalLight &light) {
+    localLights_[handle] = light;
+    localLightChanged_[handle] = 1;
+}
+
+void Renderer::setTemporalAA(bool enabled) {
+    if (enabled && !temporalAA_)
+        historyValid_ = false;
+    temporalAA_ = enabled;
+}
+
+bool Renderer::ambientOcclusionActive() const {
+    // Until the targets are recreated as stored, the G-buffer cannot be sampled yet
+    return engine::SSAO && ambientOcclusion_->getSettings().enabled && renderMode_ == RenderMode::Deferred &&
+           swapChain_.isGBufferStored();
+}
+
+void Renderer::setAmbientOcclusion(const AmbientOcclusion::Settings &settings) {
+    ambientOcclusion_->setSettings(settings);
+
+    // Occlusion samples depth and normals, so the G-buffer must be stored while it is on. Off, it only goes
+    // back to transient where that keeps it in tile memory; elsewhere reallocating would gain nothing.
+    const bool store = engine::SSAO && (settings.enabled || !swapChain_.hasLazyMemory());
+    if (store != swapChain_.getStoreGBuffer()) {
+        swapChain_.setStoreGBuffer(store);
+        swapChainStale_ = true;
+    }
+}
+
+void Renderer::setRenderMode(RenderMode mode) {
+    if (mode == RenderMode::VisibilityBuffer && !swapChain_.getVisibilityFramebuffer()) {
+        std::cout << "-- Visibility buffer unsupported (needs geometryShader and non-uniform sampler indexing)"
+                  << std::endl;
+        mode = RenderMode::Deferred;
+    }
+    renderMode_ = mode;
+}
+
+std::optional<uint32_t> Renderer::pickObject(const Ray &ray) const {
+    if (auto hit = bvh_.raycast(ray))
+        return hit->primitive;
+    return std::nullopt;
+}
+
+void Renderer::cullObjects(const std::array<glm::vec4, 6> &planes, std::vector<uint32_t> &out) const {
+    out.clear();
+    if (engine::CULL_WITH_BVH) {
+        bvh_.queryFrustum(planes, out);
+        return;
+    }
+
+    // Flat SIMD pass. Each chunk compacts into its own slice of the output, then the
+    // slices are packed together; the result stays in object order.
+    constexpr uint32_t chunkSize = 16384;
+    const auto objectCount = static_cast<uint32_t>(cullingBounds_.size());
+    const uint32_t chunkCount = (objectCount + chunkSize - 1) / chunkSize;
+    out.resize(objectCount);
+    std::vector<uint32_t> chunkVisible(chunkCount);
+
+    jobSystem_->parallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t chunk = first; chunk < last; chunk++) {
+            const auto begin = static_cast<uint32_t>(chunk * chunkSize);
+            const uint32_t end = std::min(objectCount, begin + chunkSize);
+            chunkVisible[chunk] = culling::cullFrustum(cullingBounds_, planes, culling::Shape::Box, begin, end,
+                                                       out.data() + begin);
+        }
+    });
+
+    uint32_t visible = 0;
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+        std::copy_n(out.begin() + chunk * chunkSize, chunkVisible[chunk], out.begin() + visible);
+        visible += chunkVisible[chunk];
+    }
+    out.resize(visible);
+}
+
+void Renderer::buildDrawList(const std::vector<uint32_t> &objects, BatchMode mode, DrawList &list) {
+    list.batches.clear();
+    list.objectOffset = 0;
+    list.bindsSaved = 0;
+    const auto &renderObjects = scene_->getRenderObjects();
+    const auto objectCount = static_cast<uint32_t>(objects.size());
+    if (objectCount == 0)
+        return;
+
+    // Shading: group by pipeline first, then material, then mesh. Depth-only draws share one
+    // pipeline and ignore the material, so only the mesh matters. Equal keys become one
+    // instanced draw, and consecutive batches only rebind what actually changed.
+    sortKeys_.resize(objectCount);
+    uint32_t unsortedBinds = 0; // pipeline and material changes had the objects been drawn in culling order
+    uint64_t previousKey = ~0ull;
+    for (uint32_t i = 0; i < objectCount; i++) {
+        const auto &object = renderObjects[objects[i]];
+        if (object.material >= (1u << 12) || object.mesh >= (1u << 16)) {
+            throw std::runtime_error("render object exceeds the draw batch key range!");
+        }
+        uint64_t key = object.mesh;
+        if (mode == BatchMode::Shading) {
+            const auto model = static_cast<uint32_t>(materialSystem_->getMaterial(object.material).shadingModel);
+            key |= (model << 28) | (object.material << 16);
+        }
+        sortKeys_[i] = (key << 32) | objects[i];
+        unsortedBinds += bindCount(previousKey, key);
+        previousKey = key;
+    }
+    // Only the bits that differ between the keys cost a pass; big lists sort on the job system
+    radix::sort(sortKeys_, sortScratch_, jobSystem_.get());
+
+    // Instance data is laid out in sorted order, so each batch is a contiguous run
+    objectScratch_.resize(objectCount);
+    uint64_t batchKey = ~0ull;
+    uint32_t sortedBinds = 0;
+    for (uint32_t i = 0; i < objectCount; i++) {
+        const auto &object = renderObjects[static_cast<uint32_t>(sortKeys_[i])];
+        const Mesh &mesh = meshes_[object.mesh];
+        objectScratch_[i].model = scene_->getWorldTransform(object.node);
+        objectScratch_[i].drawInfo = glm::uvec4(mesh.firstIndex, static_cast<uint32_t>(mesh.vertexOffset),
+                                                object.material, 0);
+        if (mode == BatchMode::Shading)
+            objectScratch_[i].prevModel = previousModels_[static_cast<uint32_t>(sortKeys_[i])];
+
+        if ((sortKeys_[i] >> 32) != batchKey) {
+            sortedBinds += bindCount(batchKey, sortKeys_[i] >> 32);
+            batchKey = sortKeys_[i] >> 32;
+            list.batches.push_back({object.mesh, object.material, i, 0});
+        }
+        list.batches.back().instanceCount++;
+    }
+    // Depth-only lists bind nothing per batch
+    if (mode == BatchMode::Shading)
+        list.bindsSaved = unsortedBinds - sortedBinds;
+
+    // Normal matrices for the whole list in one SIMD pass. This reads the models back,
+    // so it runs on the scratch copy rather than on (write-combined) mapped memory.
+    // Depth-only lists never read them.
+    if (mode == BatchMode::Shading) {
+        simd::normalMatrices(&objectScratch_[0].model[0][0], sizeof(ObjectData),
+                             &objectScratch_[0].normalMatrix[0][0], sizeof(ObjectData), objectCount);
+    }
+
+    vk::DeviceSize offset = 0;
+    auto *data = frameAllocator_->allocate<ObjectData>(objectCount, offset);
+    std::memcpy(data, objectScratch_.data(), sizeof(ObjectData) * objectCount);
+    list.objectOffset = static_cast<uint32_t>(offset);
+}
+
+void Renderer::buildDrawBatches() {
+    // New objects have no motion yet: their last transform is the current one
+    const auto &renderObjects = scene_->getRenderObjects();
+    for (size_t i = previousModels_.size(); i < renderObjects.size(); i++) {
+        previousModels_.push_back(scene_->getWorldTransform(renderObjects[i].node));
+    }
+
+    // Only what survives culling is batched, uploaded and recorded
+    cullObjects(frustumPlanes_, visibleObjects_);
+    buildDrawList(visibleObjects_, BatchMode::Shading, mainDrawList_);
+    bindsSaved_.store(mainDrawList_.bindsSaved, std::memory_order_relaxed);
+
+    // Where the movers are now is where next frame's motion vectors start. Everything else kept its
+    // transform; a full rebuild does not say what moved, so it refreshes them all.
+    if (boundsRebuilt_) {
+        for (uint32_t i = 0; i < renderObjects.size(); i++) {
+            previousModels_[i] = scene_->getWorldTransform(renderObjects[i].node);
+        }
+    } else {
+        for (uint32_t i : changedObjects_) {
+            previousModels_[i] = scene_->getWorldTransform(renderObjects[i].node);
+        }
+    }
+}
+
+void Renderer::updateShadows(const Camera &camera) {
+    const auto extent = swapChain_.getExtent();
+    const Aabb casterBounds = bvh_.isEmpty() ? Aabb{} : bvh_.getBounds();
+    shadowMap_->update(camera, extent.width / (float)extent.height, casterBounds, frameNumber_);
+
+    const auto &renderObjects = scene_->getRenderObjects();
+    for (uint32_t i = 0; i < engine::SHADOW_CASCADE_COUNT; i++) {
+        shadowStaticLists_[i].batches.clear();
+        shadowDynamicLists_[i].batches.clear();
+
+        const auto &cascade = shadowMap_->getCascade(i);
+        if (!cascade.scheduled)
+            continue;
+
+        cullObjects(cascade.planes, casterObjects_);
+        staticCasters_.clear();
+        dynamicCasters_.clear();
+        for (uint32_t object : casterObjects_) {
+            (renderObjects[object].dynamic ? dynamicCasters_ : staticCasters_).push_back(object);
+        }
+
+        shadowMap_->setDynamicCasters(i, !dynamicCasters_.empty());
+        if (!cascade.render)
+            continue;
+        if (cascade.renderStatic)
+            buildDrawList(staticCasters_, BatchMode::DepthOnly, shadowStaticLists_[i]);
+        buildDrawList(dynamicCasters_, BatchMode::DepthOnly, shadowDynamicLists_[i]);
+    }
+
+    ShadowUniforms uniforms{};
+    shadowMap_->fillUniforms(uniforms);
+    auto allocation = frameAllocator_->allocate(sizeof(uniforms));
+    std::memcpy(allocation.data, &uniforms, sizeof(uniforms));
+    shadowUniformOffset_ = static_cast<uint32_t>(allocation.offset);
+}
+
+void Renderer::updateLocalLights(const Camera &camera) {
+    const auto lightCount = static_cast<uint32_t>(localLights_.size());
+    const float tanHalfFov = std::tan(glm::radians(camera.fov) * 0.5f);
+
+    shadowRequests_.resize(lightCount);
+    for (uint32_t i = 0; i < lightCount; i++) {
+        const LocalLight &light = localLights_[i];
+        ShadowScheduler::Request &request = shadowRequests_[i];
+        request.viewCount = light.type == LightType::Point ? 6 : 1;
+        request.importance = 0.0f;
+        request.dirty = localLightChanged_[i] != 0 || boundsRebuilt_;
+        localLightChanged_[i] = 0;
+        if (!light.castsShadows)
+            continue;
+
+        // Lights whose range is off screen light nothing visible
+        const bool visible = std::all_of(frustumPlanes_.begin(), frustumPlanes_.end(), [&](const glm::vec4 &plane) {
+            return glm::dot(glm::vec3(plane), light.position) + plane.w >= -light.range;
+        });
+        if (!visible)
+            continue;
+
+        // Screen coverage: projected radius of the range sphere over half the screen height
+        const float distance = glm::length(light.position - camera.position);
+        request.importance = distance <= light.range ? 1.0f
+                                                     : std::min(1.0f, light.range / (distance * tanHalfFov));
+
+        // The caster set is what the range sphere touches; a new set or a moved caster needs a re-render
+        casterObjects_.clear();
+        bvh_.querySphere(light.position, light.range, casterObjects_);
+        std::sort(casterObjects_.begin(), casterObjects_.end());
+        uint64_t hash = 14695981039346656037ull; // FNV-1a
+        bool casterMoved = false;
+        for (uint32_t object : casterObjects_) {
+            hash = (hash ^ object) * 1099511628211ull;
+            casterMoved |= objectMoved_[object] != 0;
+        }
+        request.dirty |= casterMoved || hash != localCasterHashes_[i];
+        localCasterHashes_[i] = hash;
+    }
+
+    localShadows_->update(localLights_, shadowRequests_);
+
+    const auto &views = localShadows_->getScheduledViews();
+    localShadowLists_.resize(views.size());
+    for (size_t v = 0; v < views.size(); v++) {
+        cullObjects(views[v].planes, casterObjects_);
+        buildDrawList(casterObjects_, BatchMode::DepthOnly, localShadowLists_[v]);
+    }
+
+    vk::DeviceSize offset = 0;
+    auto *buffer = frameAllocator_->allocate<LocalLightBuffer>(1, offset);
+    localShadows_->fillBuffer(localLights_, *buffer);
+    localLightOffset_ = static_cast<uint32_t>(offset);
+}
 
 void Renderer::createCommandPool() {
     auto queueFamilyIndices = context_.findQueueFamilies(context_.getPhysicalDevice());
@@ -153,46 +650,250 @@ void Renderer::createCommandBuffers() {
                      .setCommandBufferCount(static_cast<uint32_t>(engine::MAX_FRAMES_IN_FLIGHT));
 
     commandBuffers_ = context_.getDevice().allocateCommandBuffers(allocInfo);
+
+    // Reset as a whole by the job that records the buffer, once per frame
+    auto queueFamilyIndices = context_.findQueueFamilies(context_.getPhysicalDevice());
+    for (uint32_t i = 0; i < SHADOW_SECONDARY_COUNT; i++) {
+        shadowCommandPools_[i] = context_.getDevice().createCommandPool(
+            vk::CommandPoolCreateInfo()
+            .setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+            .setQueueFamilyIndex(queueFamilyIndices.graphicsFamily.value()));
+        shadowCommandBuffers_[i] = context_.getDevice().allocateCommandBuffers(
+            vk::CommandBufferAllocateInfo()
+            .setCommandPool(shadowCommandPools_[i])
+            .setLevel(vk::CommandBufferLevel::eSecondary)
+            .setCommandBufferCount(1)).front();
+    }
 }
 
 
-void Renderer::recordCommandBuffer(vk::CommandBuffer commandBuffer, vk::Pipeline pipeline, uint32_t imageIndex) const {
+void Renderer::recordShadowSecondary(const GraphicsPipeline &pipelines, uint32_t cascade, bool staticPass) const {
+    const uint32_t index = shadowSecondaryIndex(cascade, staticPass);
+    // This slot's fence has signaled, so the buffer's last recording is no longer in use
+    context_.getDevice().resetCommandPool(shadowCommandPools_[index]);
+
+    const vk::CommandBuffer cmd = shadowCommandBuffers_[index];
+    const auto inheritance = shadowMap_->getInheritanceInfo(cascade, staticPass);
+    cmd.begin(vk::CommandBufferBeginInfo()
+              .setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit |
+                        vk::CommandBufferUsageFlagBits::eRenderPassContinue)
+              .setPInheritanceInfo(&inheritance));
+
+    // Secondaries inherit no state from the primary
+    cmd.bindVertexBuffers(0, {vertexBuffer_}, {0});
+    cmd.bindIndexBuffer(indexBuffer_, 0, vk::IndexType::eUint32);
+    const float size = static_cast<float>(engine::SHADOW_MAP_SIZE);
+    cmd.setViewport(0, vk::Viewport(0.0f, 0.0f, size, size, 0.0f, 1.0f));
+    cmd.setScissor(0, vk::Rect2D({0, 0}, {engine::SHADOW_MAP_SIZE, engine::SHADOW_MAP_SIZE}));
+
+    const DrawList &list = staticPass ? shadowStaticLists_[cascade] : shadowDynamicLists_[cascade];
+    recordShadowDraws(cmd, pipelines, list, cascade);
+    cmd.end();
+}
+
+void Renderer::recordShadowDraws(vk::CommandBuffer commandBuffer, const GraphicsPipeline &pipelines,
+                                 const DrawList &list, uint32_t shadowView) const {
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelines.getShadowPipeline());
+
+    const std::array<uint32_t, 4> dynamicOffsets = {uniformOffset_, list.objectOffset, shadowUniformOffset_,
+                                                    localLightOffset_};
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, activePipelineLayout_, 0, descriptorSet_,
+                                     dynamicOffsets);
+
+    const DrawPushConstants push{0, shadowView};
+    commandBuffer.pushConstants<DrawPushConstants>(activePipelineLayout_,
+                                                   vk::ShaderStageFlagBits::eVertex |
+                                                   vk::ShaderStageFlagBits::eFragment,
+                                                   0, push);
+    for (const auto &batch : list.batches) {
+        const Mesh &mesh = meshes_[batch.mesh];
+        commandBuffer.drawIndexed(mesh.indexCount, batch.instanceCount, mesh.firstIndex, mesh.vertexOffset,
+                                  batch.firstInstance);
+    }
+}
+
+void Renderer::recordCommandBuffer(vk::CommandBuffer commandBuffer, const GraphicsPipeline &pipelines,
+                                   uint32_t imageIndex) const {
+    // The cascade passes are recorded into secondaries by jobs while this thread records the primary up to
+    // them; the jobs only read this frame's draw lists and offsets, which stay unchanged until the wait
+    JobCounter shadowJobs;
+    for (uint32_t cascade = 0; cascade < engine::SHADOW_CASCADE_COUNT; cascade++) {
+        for (bool staticPass : {true, false}) {
+            if (shadowMap_->drawsPass(cascade, staticPass)) {
+                jobSystem_->run([this, &pipelines, cascade, staticPass]() {
+                    recordShadowSecondary(pipelines, cascade, staticPass);
+                }, &shadowJobs);
+            }
+        }
+    }
+
     auto beginInfo = vk::CommandBufferBeginInfo();
     commandBuffer.begin(beginInfo);
+    gpuTimer_->begin(commandBuffer, currentFrame);
 
-    std::array<vk::ClearValue, 2> clearValues;
-    clearValues[0].color = vk::ClearColorValue(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f});
-    clearValues[1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+    // Without a separate compute queue the light binning runs here, ahead of everything that shades
+    if (!lightBinning_->isAsync()) {
+        lightBinning_->record(commandBuffer, renderExtent_,
+                              [&](vk::CommandBuffer cmd) { bindLightBinning(cmd, pipelines); });
+    }
 
+    commandBuffer.bindVertexBuffers(0, {vertexBuffer_}, {0});
+    commandBuffer.bindIndexBuffer(indexBuffer_, 0, vk::IndexType::eUint32);
+
+    // Shadow cascades first; their render passes make the maps visible to the lighting shaders
+    jobSystem_->wait(shadowJobs);
+    shadowMap_->record(commandBuffer, [&](vk::CommandBuffer cmd, uint32_t cascade, bool staticPass) {
+        cmd.executeCommands(shadowCommandBuffers_[shadowSecondaryIndex(cascade, staticPass)]);
+    }, vk::SubpassContents::eSecondaryCommandBuffers);
+
+    // Then the scheduled local light tiles; the pipeline is shared, the view comes from the push constant
+    localShadows_->record(commandBuffer, [&](vk::CommandBuffer cmd, uint32_t viewIndex) {
+        const uint32_t shadowView = engine::SHADOW_CASCADE_COUNT + localShadows_->getScheduledViews()[viewIndex].slot;
+        recordShadowDraws(cmd, pipelines, localShadowLists_[viewIndex], shadowView);
+    });
+
+    // Only scene color and depth/stencil are cleared, and velocity (to zero, as the background does not
+    // move); the G-buffer or visibility targets are fully overwritten where read. Both passes put the
+    // first two first, so one array covers either; the rest is zero.
+    static_assert(gbuffer::SCENE_COLOR == visbuffer::SCENE_COLOR && gbuffer::DEPTH == visbuffer::DEPTH);
+    const bool visibility = renderMode_ == RenderMode::VisibilityBuffer;
+    std::array<vk::ClearValue, gbuffer::ATTACHMENT_COUNT> clearValues{};
+    clearValues[gbuffer::SCENE_COLOR].color = vk::ClearColorValue(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f});
+    clearValues[gbuffer::DEPTH].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+
+    // With ambient occlusion the G-buffer pass runs as two compatible halves with the occlusion in between
+    const bool splitPass = !visibility && ambientOcclusionActive();
     auto renderPassInfo = vk::RenderPassBeginInfo()
-                          .setRenderPass(renderPass_.getRenderPass())
-                          .setFramebuffer(swapChain_.getFramebuffers()[imageIndex])
-                          .setRenderArea(vk::Rect2D({0, 0}, swapChain_.getExtent()))
-                          .setClearValueCount(static_cast<uint32_t>(clearValues.size()))
+                          .setRenderPass(visibility ? renderPass_.getVisibilityRenderPass()
+                                         : splitPass ? renderPass_.getGeometryRenderPass()
+                                                     : renderPass_.getRenderPass())
+                          .setFramebuffer(visibility ? swapChain_.getVisibilityFramebuffer()
+                                                     : swapChain_.getFramebuffer())
+                          .setRenderArea(vk::Rect2D({0, 0}, renderExtent_))
+                          .setClearValueCount(visibility ? visbuffer::ATTACHMENT_COUNT : gbuffer::ATTACHMENT_COUNT)
                           .setPClearValues(clearValues.data());
 
     commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
     {
-        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
-
-        // Set Dynamic Viewport/Scissor
-        auto extent = swapChain_.getExtent();
-        commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f));
-        commandBuffer.setScissor(0, vk::Rect2D({0, 0}, extent));
-
-        commandBuffer.bindVertexBuffers(0, {vertexBuffer_}, {0});
-        commandBuffer.bindIndexBuffer(indexBuffer_, 0, vk::IndexType::eUint32);
-
+        // Set Dynamic Viewport/Scissor: this frame's render scale, in the top-left of the targets
+        commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, (float)renderExtent_.width,
+                                                  (float)renderExtent_.height, 0.0f, 1.0f));
+        commandBuffer.setScissor(0, vk::Rect2D({0, 0}, renderExtent_));
+
+        // Dynamic offsets in binding order: view UBO (0), object buffer (3), shadow UBO (5), local lights (6)
+        const std::array<uint32_t, 4> dynamicOffsets = {uniformOffset_, mainDrawList_.objectOffset,
+                                                        shadowUniformOffset_, localLightOffset_};
         commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
                                          activePipelineLayout_, 0,
-                                         {descriptorSets_[currentFrame]}, {});
+                                         descriptorSet_, dynamicOffsets);
+
+        // One permutation per shading model; only rebind when it actually changes.
+        // Batches are sorted by model, so this happens at most once per model.
+        std::optional<ShadingModel> boundModel;
+        std::optional<MaterialHandle> boundMaterial;
+        for (const auto &batch : mainDrawList_.batches) {
+            const ShadingModel model = materialSystem_->getMaterial(batch.material).shadingModel;
+            if (boundModel != model) {
+                commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
+                                           visibility ? pipelines.getVisibilityPipeline(model)
+                                                      : pipelines.getGeometryPipeline(model));
+                boundModel = model;
+            }
+
+            if (boundMaterial != batch.material) {
+                const DrawPushConstants push{batch.material, 0};
+                commandBuffer.pushConstants<DrawPushConstants>(
+                    activePipelineLayout_, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0,
+                    push);
+                boundMaterial = batch.material;
+            }
+
+            const Mesh &mesh = meshes_[batch.mesh];
+            commandBuffer.drawIndexed(mesh.indexCount, batch.instanceCount, mesh.firstIndex, mesh.vertexOffset,
+                                      batch.firstInstance);
+        }
 
-        int shadingMode = 1;
-        commandBuffer.pushConstants<int>(activePipelineLayout_, vk::ShaderStageFlagBits::eFragment, 0, shadingMode);
+        // Lighting (or material resolve): one fullscreen triangle per shading model, each limited to its
+        // pixels by the stencil. Set 0 stays bound (compatible layout); set 1 adds the input attachments.
+        commandBuffer.nextSubpass(vk::SubpassContents::eInline);
+        if (splitPass) {
+            // The geometry half ends with an empty lighting subpass; its outgoing dependency makes the
+            // G-buffer visible to the occlusion passes and to the lighting half's loads
+            commandBuffer.endRenderPass();
+            ambientOcclusion_->record(commandBuffer, renderExtent_,
+                                      [&](vk::CommandBuffer cmd, AmbientOcclusion::Pass pass) {
+                                          cmd.bindPipeline(vk::PipelineBindPoint::eCompute,
+                                                           pipelines.getAmbientOcclusionPipeline(pass));
+                                          const std::array<vk::DescriptorSet, 2> sets = {descriptorSet_, gbufferSet_};
+                                          cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+                                                                 activePipelineLayout_, 0, sets, dynamicOffsets);
+                                      });
+
+            // Viewport, scissor and the graphics bindings carry over; the geometry subpass stays empty
+            renderPassInfo.setRenderPass(renderPass_.getLightingRenderPass());
+            commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+            commandBuffer.nextSubpass(vk::SubpassContents::eInline);
+        }
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, activePipelineLayout_, 1, gbufferSet_,
+                                         nullptr);
+        for (size_t model = 0; model < SHADING_MODEL_COUNT; model++) {
+            const auto shadingModel = static_cast<ShadingModel>(model);
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
+                                       visibility ? pipelines.getVisibilityMaterialPipeline(shadingModel)
+                                                  : pipelines.getLightingPipeline(shadingModel));
+            commandBuffer.draw(3, 1, 0, 0);
+        }
+    }
+    commandBuffer.endRenderPass();
+
+    // Bloom chain, histogram and exposure in one dispatch; the main pass' outgoing dependency made the
+    // scene color visible to it
+    postProcess_->record(commandBuffer, renderExtent_, [&](vk::CommandBuffer cmd) {
+        cmd.bindPipeline(vk::PipelineBindPoint::eCompute, pipelines.getPostProcessPipeline());
+        const std::array<vk::DescriptorSet, 2> sets = {descriptorSet_, gbufferSet_};
+        const std::array<uint32_t, 4> dynamicOffsets = {uniformOffset_, mainDrawList_.objectOffset,
+                                                        shadowUniformOffset_, localLightOffset_};
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, activePipelineLayout_, 0, sets, dynamicOffsets);
+    });
+
+    // An empty history is not read, but the descriptor still needs the layout it names. An earlier
+    // resolve may still be writing the image (TAA switched off and on again).
+    const uint32_t historyRead = (historyIndex_ + 1) % taa::HISTORY_COUNT;
+    if (temporalAA_ && !historyValid_) {
+        auto barrier = vk::ImageMemoryBarrier2()
+                       .setSrcStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput)
+                       .setSrcAccessMask(vk::AccessFlagBits2::eColorAttachmentWrite)
+                       .setDstStageMask(vk::PipelineStageFlagBits2::eFragmentShader)
+                       .setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead)
+                       .setOldLayout(vk::ImageLayout::eUndefined)
+                       .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+                       .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                       .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                       .setImage(swapChain_.getHistoryImage(historyRead))
+                       .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(barrier));
+    }
 
-        commandBuffer.drawIndexed(static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+    // Resolve (or just upscale) the rendered region over the whole swapchain image; both sets stay
+    // bound from the main pass
+    auto outputPassInfo = vk::RenderPassBeginInfo()
+                          .setRenderPass(temporalAA_ ? renderPass_.getTemporalRenderPass()
+                                                     : renderPass_.getUpscaleRenderPass())
+                          .setFramebuffer(temporalAA_ ? swapChain_.getTemporalFramebuffer(imageIndex, historyIndex_)
+                                                      : swapChain_.getUpscaleFramebuffers()[imageIndex])
+                          .setRenderArea(vk::Rect2D({0, 0}, swapChain_.getExtent()));
+    commandBuffer.beginRenderPass(outputPassInfo, vk::SubpassContents::eInline);
+    {
+        const auto extent = swapChain_.getExtent();
+        commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f));
+        commandBuffer.setScissor(0, vk::Rect2D({0, 0}, extent));
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics,
+                                   temporalAA_ ? pipelines.getTemporalPipeline() : pipelines.getUpscalePipeline());
+        commandBuffer.draw(3, 1, 0, 0);
     }
     commandBuffer.endRenderPass();
+
+    gpuTimer_->end(commandBuffer, currentFrame);
     commandBuffer.end();
 }
 
@@ -207,6 +908,12 @@ void Renderer::createSyncObjects() {
     renderFinishedSemaphores_.resize(imageCount);
     imagesInFlight.resize(imageCount, nullptr);
 
+    // Counts submitted frames, starting at 0 = none
+    auto timelineInfo = vk::SemaphoreTypeCreateInfo()
+                        .setSemaphoreType(vk::SemaphoreType::eTimeline)
+                        .setInitialValue(0);
+    frameTimeline_ = device.createSemaphore(vk::SemaphoreCreateInfo().setPNext(&timelineInfo));
+
     vk::SemaphoreCreateInfo semaphoreInfo{};
     vk::FenceCreateInfo fenceInfo{};
     // Start signaled so the first frame doesn't block indefinitely
@@ -225,12 +932,41 @@ void Renderer::createSyncObjects() {
 }
 
 
-void Renderer::drawFrame(vk::Pipeline pipeline, bool framebufferResized, const Camera &camera) {
+void Renderer::drawFrame(const GraphicsPipeline &pipelines, FramePacket &packet) {
+    applyPacket(packet);
+    renderFrame(pipelines, packet.framebufferResized, *packet.camera);
+}
+
+void Renderer::applyPacket(FramePacket &packet) {
+    // Queued by the input thread against the state of the previous frame; run in order
+    for (auto &command : packet.commands) {
+        command(*this);
+    }
+    packet.commands.clear();
+
+    for (const auto &update : packet.transforms) {
+        scene_->setLocalTransform(update.node, update.local);
+    }
+    packet.transforms.clear();
+
+    framebufferSize_ = packet.framebufferSize;
+    swapChain_.setFramebufferSize(framebufferSize_);
+    framePacer_->markInput(packet.inputTime);
+}
+
+void Renderer::renderFrame(const GraphicsPipeline &pipelines, bool framebufferResized, const Camera &camera) {
     auto device = context_.getDevice();
 
     // 1. Wait for the Frame Slot to be free (CPU-GPU Sync)
     // Using (void) to acknowledge the Result, or let it throw on device loss
     (void)device.waitForFences(inFlightFences_[currentFrame], true, UINT64_MAX);
+    // Destroy whatever only frames the GPU has finished still referenced
+    deletionQueue_.collect(getCompletedFrameValue());
+
+    // Minimized during the last recreation (skip frames until the window has an area again), or asked for
+    // other present settings
+    if (swapChainStale_ && !recreateSwapChain())
+        return;
 
     // 2. Acquire Next Image
     // Note: We use the semaphore at [currentFrame] to signal acquisition
@@ -255,21 +991,59 @@ void Renderer::drawFrame(vk::Pipeline pipeline, bool framebufferResized, const C
     // 4. Reset Fence and Record Commands
     device.resetFences(inFlightFences_[currentFrame]);
 
-    updateUniformBuffer(currentFrame, camera);
+    // Recycle staging space of uploads the GPU has finished with
+    uploadContext_->collect();
+
+    // This slot's timestamps are complete as well; they steer this frame's render scale
+    if (auto gpuMs = gpuTimer_->read(currentFrame))
+        dynamicResolution_.update(*gpuMs);
+    renderExtent_ = dynamicResolution_.getRenderExtent(swapChain_.getExtent());
+
+    // The history written last frame is read by this one
+    historyIndex_ = (historyIndex_ + 1) % taa::HISTORY_COUNT;
+
+    // This slot's fence has signaled, so its region of the frame allocator is free again
+    frameAllocator_->beginFrame(currentFrame);
+    // Likewise its descriptor pools; both sets are allocated and written fresh for this frame
+    descriptorAllocator_->beginFrame(currentFrame);
+    createDescriptorSets();
+    updateUniformBuffer(camera);
+    scene_->updateTransforms();
+    updateSceneBounds();
+    buildDrawBatches();
+    updateShadows(camera);
+    updateLocalLights(camera);
+    frameAllocator_->flush();
 
     commandBuffers_[currentFrame].reset();
-    recordCommandBuffer(commandBuffers_[currentFrame], pipeline, imageIndex);
+    recordCommandBuffer(commandBuffers_[currentFrame], pipelines, imageIndex);
+    historyValid_ = temporalAA_;
+
+    // Light binning on the compute queue (null if it ran inline above). It only reads this frame's
+    // uniforms, so it overlaps the shadow and geometry work; only the lighting has to wait for it.
+    std::vector<vk::Semaphore> waitSemaphores = {imageAvailableSemaphores_[currentFrame]}; // Wait for Acquire
+    std::vector<vk::PipelineStageFlags> waitStages = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
+    if (auto binned = lightBinning_->submit(currentFrame, renderExtent_,
+                                            [&](vk::CommandBuffer cmd) { bindLightBinning(cmd, pipelines); })) {
+        waitSemaphores.push_back(binned);
+        waitStages.push_back(vk::PipelineStageFlagBits::eFragmentShader);
+    }
 
     // 5. Submit Info (Modern C++ Style)
-    vk::PipelineStageFlags waitStages[] = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
-
+    // The binary semaphore's value is ignored, the timeline's advances by one per frame
+    std::array<vk::Semaphore, 2> signalSemaphores = {renderFinishedSemaphores_[imageIndex], frameTimeline_};
+    std::array<uint64_t, 2> signalValues = {0, timelineValue_ + 1};
+    auto timelineInfo = vk::TimelineSemaphoreSubmitInfo().setSignalSemaphoreValues(signalValues);
     auto submitInfo = vk::SubmitInfo()
-                      .setWaitSemaphores(imageAvailableSemaphores_[currentFrame]) // Wait for Acquire
+                      .setWaitSemaphores(waitSemaphores)
                       .setWaitDstStageMask(waitStages)
                       .setCommandBuffers(commandBuffers_[currentFrame])
-                      .setSignalSemaphores(renderFinishedSemaphores_[imageIndex]); // Signal per IMAGE
+                      .setSignalSemaphores(signalSemaphores) // Signal per IMAGE
+                      .setPNext(&timelineInfo);
 
     context_.getGraphicsQueue().submit(submitInfo, inFlightFences_[currentFrame]);
+    // Anything released from here on may be in use by this submission
+    deletionQueue_.setSubmitted(++timelineValue_);
 
     // 6. Presentation Info
     vk::SwapchainKHR swapChainHandle = swapChain_.getHandle();
@@ -277,6 +1051,10 @@ void Renderer::drawFrame(vk::Pipeline pipeline, bool framebufferResized, const C
                        .setWaitSemaphores(renderFinishedSemaphores_[imageIndex]) // Wait for render finished
                        .setSwapchains(swapChainHandle)
                        .setPImageIndices(&imageIndex);
+    // The frame's timeline value doubles as its present id, so the pacer can wait for it to be shown
+    auto presentId = vk::PresentIdKHR().setPresentIds(timelineValue_);
+    if (framePacer_->usesPresentWait())
+        presentInfo.setPNext(&presentId);
 
     vk::Result presentResult;
     try {
@@ -284,6 +1062,8 @@ void Renderer::drawFrame(vk::Pipeline pipeline, bool framebufferResized, const C
     } catch (const vk::OutOfDateKHRError &) {
         presentResult = vk::Result::eErrorOutOfDateKHR;
     }
+    if (presentResult == vk::Result::eSuccess || presentResult == vk::Result::eSuboptimalKHR)
+        framePacer_->onPresent(timelineValue_, swapChainHandle);
 
     // 7. Check for resize/recreation
     if (presentResult == vk::Result::eErrorOutOfDateKHR || presentResult == vk::Result::eSuboptimalKHR ||
@@ -293,32 +1073,60 @@ void Renderer::drawFrame(vk::Pipeline pipeline, bool framebufferResized, const C
 
     // 8. Advance Frame Index
     currentFrame = (currentFrame + 1) % engine::MAX_FRAMES_IN_FLIGHT;
+    frameNumber_++;
 }
 
-void Renderer::recreateSwapChain() {
-    // 1. Handle Minimization (Pause the engine if width/height is 0)
-    int width = 0, height = 0;
-    glfwGetFramebufferSize(window_, &width, &height);
-    while (width == 0 || height == 0) {
-        glfwGetFramebufferSize(window_, &width, &height);
-        glfwWaitEvents();
-    }
+void Renderer::setPresentSettings(const SwapChain::PresentSettings &settings) {
+    swapChain_.setPresentSettings(settings);
+    swapChainStale_ = true;
+}
 
-    // 2. Synchronize: Stop the GPU before we delete its tools
-    vkDeviceWaitIdle(context_.getDevice());
+uint64_t Renderer::getCompletedFrameValue() const {
+    return context_.getDevice().getSemaphoreCounterValue(frameTimeline_);
+}
 
-    // 3. Cleanup size-dependent resources
-    // cleanupDepthResources();
-    // Framebuffers are cleaned inside SwapChain::cleanup() which we trigger next
+bool Renderer::recreateSwapChain() {
+    // Minimized: there is nothing to present to. Rather than blocking here, frames are skipped until the
+    // window has an area again (App sleeps in glfwWaitEvents meanwhile).
+    swapChainStale_ = framebufferSize_.width == 0 || framebufferSize_.height == 0;
+    if (swapChainStale_)
+        return false;
 
-    // 4. Recreate SwapChain (This updates images and views)
-    swapChain_.recreate(renderPass_.getRenderPass());
+    // No device idle: everything the frames in flight may still use goes through the deletion queue
+    const bool targetsChanged = swapChain_.recreate(renderPass_, deletionQueue_);
+    framePacer_->onSwapChainRecreated();
+
+    // Presents queued on the old swapchain may still wait on its render-finished semaphores, so the new
+    // images get a fresh set and the old one is destroyed with the old swapchain, once the last frame
+    // submitted for it has finished. The acquire semaphores are per frame slot and stay.
+    auto device = context_.getDevice();
+    const auto imageCount = swapChain_.getImageViews().size();
+    for (auto semaphore : renderFinishedSemaphores_) {
+        deletionQueue_.retire(device, semaphore);
+    }
+    renderFinishedSemaphores_.clear();
+    for (size_t i = 0; i < imageCount; i++) {
+        renderFinishedSemaphores_.push_back(device.createSemaphore({}));
+    }
+    for (size_t i = imageAvailableSemaphores_.size(); i < imageCount; i++) {
+        imageAvailableSemaphores_.push_back(device.createSemaphore({}));
+    }
+    // The fences carry over as well: the first frame on new image i waits for the frame that last used old
+    // image i, exactly as it would have without the recreation
+    imagesInFlight.resize(imageCount, nullptr);
 
-    // 5. Recreate Renderer resources with the NEW extent
-    // createDepthResources();
+    // Size-dependent resources follow the render targets, which are only reallocated when they no longer fit
+    if (targetsChanged) {
+        ambientOcclusion_->resize(swapChain_.getTargetExtent(), deletionQueue_);
+        postProcess_->resize(swapChain_.getTargetExtent(), deletionQueue_);
+        lightBinning_->resize(swapChain_.getTargetExtent(), deletionQueue_);
+        // No descriptor work: the next frame writes its sets fresh, frames in flight keep their own
+    }
+    historyValid_ = false; // new, empty history images (or new contents in the old ones)
 
     // Note: Since we use Dynamic State for Viewport/Scissor,
     // we do NOT need to recreate the Pipeline!
+    return true;
 }
 
 
@@ -326,72 +1134,29 @@ void Renderer::createVertexBuffer() {
     // auto& vertices = ms .getVertices();
     vk::DeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
 
-    // 1. Create Staging Buffer (CPU Visible)
-    vk::Buffer stagingBuffer;
-    VmaAllocation stagingAlloc;
-    createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc,
-                 VMA_MEMORY_USAGE_CPU_ONLY, stagingBuffer, stagingAlloc);
-
-    // 2. Map and Copy
-    void *data;
-    vmaMapMemory(vmaAllocator, stagingAlloc, &data);
-    memcpy(data, vertices.data(), (size_t)bufferSize);
-    vmaUnmapMemory(vmaAllocator, stagingAlloc);
-
-    // 3. Create GPU Local Buffer
-    createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
-                 VMA_MEMORY_USAGE_GPU_ONLY, vertexBuffer_, vertexBufferAllocation_);
-
-    // 4. Copy to GPU
-    copyBuffer(stagingBuffer, vertexBuffer_, bufferSize);
-
-    // 5. Cleanup Staging
-    vmaDestroyBuffer(vmaAllocator, stagingBuffer, stagingAlloc);
+    // 1. Create GPU Local Buffer
+    // Also a storage buffer: the visibility-buffer material pass fetches vertices itself
+    createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer |
+                 vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_GPU_ONLY, vertexBuffer_,
+                 vertexBufferAllocation_);
+
+    // 2. Stage + copy through the upload ring (no queue wait, the first frame is ordered after it)
+    uploadContext_->uploadBuffer(vertexBuffer_, vertices.data(), bufferSize,
+                                 vk::PipelineStageFlagBits2::eVertexAttributeInput |
+                                 vk::PipelineStageFlagBits2::eFragmentShader,
+                                 vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eShaderStorageRead);
 }
 
 void Renderer::createIndexBuffer() {
     vk::DeviceSize bufferSize = sizeof(indices[0]) * indices.size();
 
-    vk::Buffer stagingBuffer;
-    VmaAllocation stagingAlloc;
-    createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc,
-                 VMA_MEMORY_USAGE_CPU_ONLY, stagingBuffer, stagingAlloc);
-
-    void *data;
-    vmaMapMemory(vmaAllocator, stagingAlloc, &data);
-    memcpy(data, indices.data(), (size_t)bufferSize);
-    vmaUnmapMemory(vmaAllocator, stagingAlloc);
-
-    createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
-                 VMA_MEMORY_USAGE_GPU_ONLY, indexBuffer_, indexBufferAllocation_);
-
-    copyBuffer(stagingBuffer, indexBuffer_, bufferSize);
-    vmaDestroyBuffer(vmaAllocator, stagingBuffer, stagingAlloc);
-}
-
-void Renderer::createUniformBuffers() {
-    vk::DeviceSize bufferSize = sizeof(UniformBufferObject);
-
-    uniformBuffers_.resize(engine::MAX_FRAMES_IN_FLIGHT);
-    uniformBuffersAllocation_.resize(engine::MAX_FRAMES_IN_FLIGHT);
-    uniformBuffersMapped_.resize(engine::MAX_FRAMES_IN_FLIGHT);
-
-    for (size_t i = 0; i < engine::MAX_FRAMES_IN_FLIGHT; i++) {
-        VmaAllocationInfo allocInfo;
+    createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer |
+                 vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_GPU_ONLY, indexBuffer_,
+                 indexBufferAllocation_);
 
-        createBuffer(
-            bufferSize,
-            vk::BufferUsageFlagBits::eUniformBuffer, // Changed to vk:: enum
-            VMA_MEMORY_USAGE_CPU_TO_GPU,
-            uniformBuffers_[i], // These are now vk::Buffer
-            uniformBuffersAllocation_[i],
-            VMA_ALLOCATION_CREATE_MAPPED_BIT,
-            &allocInfo
-            );
-
-        // Store the persistent pointer provided by the MAPPED flag
-        uniformBuffersMapped_[i] = allocInfo.pMappedData;
-    }
+    uploadContext_->uploadBuffer(indexBuffer_, indices.data(), bufferSize,
+                                 vk::PipelineStageFlagBits2::eIndexInput | vk::PipelineStageFlagBits2::eFragmentShader,
+                                 vk::AccessFlagBits2::eIndexRead | vk::AccessFlagBits2::eShaderStorageRead);
 }
 
 void Renderer::createBuffer(vk::DeviceSize size,
@@ -419,31 +1184,6 @@ void Renderer::createBuffer(vk::DeviceSize size,
     buffer = rawBuffer;
 }
 
-void Renderer::copyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size) const {
-    vk::CommandBufferAllocateInfo allocInfo{};
-    allocInfo.setLevel(vk::CommandBufferLevel::ePrimary);
-    allocInfo.setCommandPool(commandPool_);
-    allocInfo.setCommandBufferCount(1);
-
-    auto cmd = context_.getDevice().allocateCommandBuffers(allocInfo)[0];
-
-    vk::CommandBufferBeginInfo beginInfo{};
-    beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-
-    cmd.begin(beginInfo);
-    vk::BufferCopy copyRegion(0, 0, size);
-    cmd.copyBuffer(srcBuffer, dstBuffer, copyRegion);
-    cmd.end();
-
-    vk::SubmitInfo submitInfo{};
-    submitInfo.setCommandBuffers(cmd);
-
-    context_.getGraphicsQueue().submit(submitInfo);
-    context_.getGraphicsQueue().waitIdle(); // Simple sync for one-time transfer
-
-    context_.getDevice().freeCommandBuffers(commandPool_, cmd);
-}
-
 void Renderer::createAllocator() {
     VmaVulkanFunctions vulkanFunctions{};
     vulkanFunctions.vkGetInstanceProcAddr = vkGetInstanceProcAddr;
@@ -465,65 +1205,490 @@ void Renderer::createAllocator() {
     assert(info.device == context_.getDevice());
 }
 
-void Renderer::updateUniformBuffer(uint32_t currentImage, const Camera &camera) const {
-    UniformBufferObject ubo{};
-    ubo.model = glm::mat4(1.0f);
-    ubo.view = camera.getViewMatrix();
-    ubo.proj = camera.getProjectionMatrix(swapChain_.getExtent().width / (float)swapChain_.getExtent().height);
+void Renderer::updateUniformBuffer(const Camera &camera) {
+    const auto extent = swapChain_.getExtent();
+    const auto target = swapChain_.getTargetExtent();
+    const glm::vec2 renderSize(renderExtent_.width, renderExtent_.height);
+    const float aspect = extent.width / (float)extent.height;
+
+    // Sub-pixel jitter, in render pixels. At a lower render scale each render pixel covers more output
+    // pixels, so the sequence gets proportionally longer before it repeats.
+    glm::vec2 jitter(0.0f);
+    if (temporalAA_) {
+        const float scale = renderSize.x / static_cast<float>(extent.width);
+        const auto phases = static_cast<uint32_t>(std::ceil(engine::TAA_JITTER_PHASES / (scale * scale)));
+        jitter = Camera::haltonJitter(static_cast<uint32_t>(frameNumber_ % phases) + 1);
+    }
 
-    std::memcpy(uniformBuffersMapped_[currentFrame], &ubo, sizeof(ubo));
+    ViewUniforms ubo{};
+    ubo.view = camera.getViewMatrix();
+    ubo.proj = camera.getProjectionMatrix(aspect, 2.0f * jitter / renderSize);
+    ubo.viewProj = ubo.proj * ubo.view;
+    ubo.invView = glm::inverse(ubo.view);
+    ubo.invProj = glm::inverse(ubo.proj);
+    ubo.invViewProj = glm::inverse(ubo.viewProj);
+    ubo.cameraPosition = glm::vec4(camera.position, 1.0f);
+    ubo.viewport = glm::vec4(renderSize, 1.0f / renderSize);
+    ubo.upscale = glm::vec4(renderSize / glm::vec2(target.width, target.height), 1.0f / extent.width,
+                            1.0f / extent.height);
+    ubo.unjitteredViewProj = camera.getProjectionMatrix(aspect) * ubo.view;
+    ubo.prevViewProj = historyValid_ ? prevViewProj_ : ubo.unjitteredViewProj;
+    ubo.temporal = glm::vec4(jitter, historyValid_ ? 1.0f : 0.0f,
+                             static_cast<float>((historyIndex_ + 1) % taa::HISTORY_COUNT));
+    ubo.debugView = static_cast<uint32_t>(debugView_);
+    ubo.lightTiles = glm::uvec4(lightBinning_->getFirstTile(currentFrame), LightBinning::tileColumns(renderExtent_),
+                                engine::LIGHT_TILE_SIZE, 0);
+    ubo.ambientOcclusion = ambientOcclusion_->getUniform(ambientOcclusionActive());
+    ubo.post = postProcess_->frameUniform();
+    prevViewProj_ = ubo.unjitteredViewProj;
+
+    frustumPlanes_ = Camera::extractFrustumPlanes(ubo.viewProj);
+    std::copy(frustumPlanes_.begin(), frustumPlanes_.end(), ubo.frustumPlanes);
+
+    auto allocation = frameAllocator_->allocate(sizeof(ubo));
+    std::memcpy(allocation.data, &ubo, sizeof(ubo));
+    uniformOffset_ = static_cast<uint32_t>(allocation.offset);
 }
 
 
-void Renderer::createDescriptorPool() {
-    auto poolSize = vk::DescriptorPoolSize()
-                    .setType(vk::DescriptorType::eUniformBuffer)
-                    .setDescriptorCount(static_cast<uint32_t>(engine::MAX_FRAMES_IN_FLIGHT));
-
-    auto poolInfo = vk::DescriptorPoolCreateInfo()
-                    .setPoolSizeCount(1)
-                    .setPPoolSizes(&poolSize)
-                    .setMaxSets(static_cast<uint32_t>(engine::MAX_FRAMES_IN_FLIGHT));
-
-    descriptorPool_ = context_.getDevice().createDescriptorPool(poolInfo);
+void Renderer::createDescriptorAllocator() {
+    // Descriptors per set, averaged over the two layouts; the allocator rounds up and grows when short
+    constexpr float sets = 2.0f;
+    std::vector<DescriptorAllocator::PoolRatio> ratios = {
+        {vk::DescriptorType::eUniformBufferDynamic, 2 / sets},
+        {vk::DescriptorType::eCombinedImageSampler,
+         (engine::MAX_BOUND_TEXTURES + 7 + taa::HISTORY_COUNT + AmbientOcclusion::IMAGE_COUNT) / sets},
+        {vk::DescriptorType::eStorageImage, (AmbientOcclusion::IMAGE_COUNT + PostProcess::BLOOM_MIPS) / sets},
+        {vk::DescriptorType::eStorageBuffer, 5 / sets},
+        {vk::DescriptorType::eStorageBufferDynamic, 2 / sets},
+        {vk::DescriptorType::eInputAttachment, (gbuffer::INPUT_COUNT + 1) / sets}
+    };
+
+    descriptorAllocator_ = std::make_unique<DescriptorAllocator>(context_.getDevice(), engine::MAX_FRAMES_IN_FLIGHT,
+                                                                 std::move(ratios), engine::DESCRIPTOR_SETS_PER_POOL);
 }
 
 void Renderer::createDescriptorSets() {
-    std::vector<vk::DescriptorSetLayout> layouts(engine::MAX_FRAMES_IN_FLIGHT, descriptorSetLayout_);
-    auto allocInfo = vk::DescriptorSetAllocateInfo()
-                     .setDescriptorPool(descriptorPool_)
-                     .setDescriptorSetCount(static_cast<uint32_t>(engine::MAX_FRAMES_IN_FLIGHT))
-                     .setPSetLayouts(layouts.data());
+    descriptorSet_ = descriptorAllocator_->allocate(descriptorSetLayout_);
+    gbufferSet_ = descriptorAllocator_->allocate(gbufferSetLayout_);
+    updateGBufferDescriptors();
+    updateLightTileDescriptor();
+
+    // Every slot of the texture array must be valid; unused ones point at the white texture
+    std::vector<vk::DescriptorImageInfo> imageInfos(engine::MAX_BOUND_TEXTURES,
+                                                    textureSystem_->getDescriptorInfo(whiteTexture_));
+    for (uint32_t t = 0; t < std::min<uint32_t>(textureSystem_->getTextureCount(), engine::MAX_BOUND_TEXTURES); t++) {
+        imageInfos[t] = textureSystem_->getDescriptorInfo(t);
+    }
 
-    descriptorSets_ = context_.getDevice().allocateDescriptorSets(allocInfo);
+    auto materialInfo = vk::DescriptorBufferInfo()
+                        .setBuffer(materialSystem_->getBuffer())
+                        .setOffset(0)
+                        .setRange(materialSystem_->getBufferSize());
+
+    // All three point at the frame allocator; the dynamic offsets at bind time pick the allocation
+    auto uniformInfo = vk::DescriptorBufferInfo()
+                       .setBuffer(frameAllocator_->getBuffer())
+                       .setOffset(0)
+                       .setRange(sizeof(ViewUniforms));
+
+    // Whole size: the range then ends at the buffer end, whatever the dynamic offset
+    auto objectInfo = vk::DescriptorBufferInfo()
+                      .setBuffer(frameAllocator_->getBuffer())
+                      .setOffset(0)
+                      .setRange(VK_WHOLE_SIZE);
+
+    auto shadowUniformInfo = vk::DescriptorBufferInfo()
+                             .setBuffer(frameAllocator_->getBuffer())
+                             .setOffset(0)
+                             .setRange(sizeof(ShadowUniforms));
+
+    auto localLightInfo = vk::DescriptorBufferInfo()
+                          .setBuffer(frameAllocator_->getBuffer())
+                          .setOffset(0)
+                          .setRange(sizeof(LocalLightBuffer));
 
-    for (size_t i = 0; i < engine::MAX_FRAMES_IN_FLIGHT; i++) {
-        auto bufferInfo = vk::DescriptorBufferInfo()
-                          .setBuffer(uniformBuffers_[i])
+    auto shadowMapInfo = shadowMap_->getDescriptorInfo();
+    auto shadowAtlasInfo = localShadows_->getDescriptorInfo();
+
+    auto vertexDataInfo = vk::DescriptorBufferInfo()
+                          .setBuffer(vertexBuffer_)
                           .setOffset(0)
-                          .setRange(sizeof(UniformBufferObject));
+                          .setRange(VK_WHOLE_SIZE);
+
+    auto indexDataInfo = vk::DescriptorBufferInfo()
+                         .setBuffer(indexBuffer_)
+                         .setOffset(0)
+                         .setRange(VK_WHOLE_SIZE);
+
+    std::array<vk::WriteDescriptorSet, 10> descriptorWrites = {
+        vk::WriteDescriptorSet()
+        .setDstSet(descriptorSet_)
+        .setDstBinding(0)
+        .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+        .setDescriptorCount(1)
+        .setPBufferInfo(&uniformInfo),
+        vk::WriteDescriptorSet()
+        .setDstSet(descriptorSet_)
+        .setDstBinding(1)
+        .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+        .setImageInfo(imageInfos),
+        vk::WriteDescriptorSet()
+        .setDstSet(descriptorSet_)
+        .setDstBinding(2)
+        .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+        .setDescriptorCount(1)
+        .setPBufferInfo(&materialInfo),
+        vk::WriteDescriptorSet()
+        .setDstSet(descriptorSet_)
+        .setDstBinding(3)
+        .setDescriptorType(vk::DescriptorType::eStorageBufferDynamic)
+        .setDescriptorCount(1)
+        .setPBufferInfo(&objectInfo),
+        vk::WriteDescriptorSet()
+        .setDstSet(descriptorSet_)
+        .setDstBinding(4)
+        .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+        .setImageInfo(shadowMapInfo),
+        vk::WriteDescriptorSet()
+        .setDstSet(descriptorSet_)
+        .setDstBinding(5)
+        .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+        .setDescriptorCount(1)
+        .setPBufferInfo(&shadowUniformInfo),
+        vk::WriteDescriptorSet()
+        .setDstSet(descriptorSet_)
+        .setDstBinding(6)
+        .setDescriptorType(vk::DescriptorType::eStorageBufferDynamic)
+        .setDescriptorCount(1)
+        .setPBufferInfo(&localLightInfo),
+        vk::WriteDescriptorSet()
+        .setDstSet(descriptorSet_)
+        .setDstBinding(7)
+        .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+        .setImageInfo(shadowAtlasInfo),
+        vk::WriteDescriptorSet()
+        .setDstSet(descriptorSet_)
+        .setDstBinding(8)
+        .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+        .setDescriptorCount(1)
+        .setPBufferInfo(&vertexDataInfo),
+        vk::WriteDescriptorSet()
+        .setDstSet(descriptorSet_)
+        .setDstBinding(9)
+        .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+        .setDescriptorCount(1)
+        .setPBufferInfo(&indexDataInfo)
+    };
+
+    context_.getDevice().updateDescriptorSets(descriptorWrites, nullptr);
+}
 
-        auto descriptorWrite = vk::WriteDescriptorSet()
-                               .setDstSet(descriptorSets_[i])
-                               .setDstBinding(0)
-                               .setDescriptorType(vk::DescriptorType::eUniformBuffer)
-                               .setDescriptorCount(1)
-                               .setPBufferInfo(&bufferInfo);
+void Renderer::updateLightTileDescriptor() {
+    auto tileInfo = lightBinning_->getDescriptorInfo();
+    auto tileWrite = vk::WriteDescriptorSet()
+                     .setDstSet(descriptorSet_)
+                     .setDstBinding(10)
+                     .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                     .setDescriptorCount(1)
+                     .setPBufferInfo(&tileInfo);
+    context_.getDevice().updateDescriptorSets(tileWrite, nullptr);
+}
+
+void Renderer::bindLightBinning(vk::CommandBuffer commandBuffer, const GraphicsPipeline &pipelines) const {
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipelines.getLightBinningPipeline());
+    // Same set and offsets as the main pass; the binning only reads the view uniforms and the local lights
+    const std::array<uint32_t, 4> dynamicOffsets = {uniformOffset_, mainDrawList_.objectOffset,
+                                                    shadowUniformOffset_, localLightOffset_};
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, activePipelineLayout_, 0, descriptorSet_,
+                                     dynamicOffsets);
+}
+
+void Renderer::updateGBufferDescriptors() {
+    const auto views = swapChain_.getGBufferViews();
+    std::array<vk::DescriptorImageInfo, gbuffer::INPUT_COUNT> imageInfos;
+    std::array<vk::WriteDescriptorSet, gbuffer::INPUT_COUNT> descriptorWrites;
+    for (uint32_t i = 0; i < gbuffer::INPUT_COUNT; i++) {
+        // Layouts as in the lighting subpass: depth stays read-only depth/stencil for the stencil test
+        const vk::ImageLayout layout = i == gbuffer::DEPTH_INPUT_INDEX ? vk::ImageLayout::eDepthStencilReadOnlyOptimal
+                                                                       : vk::ImageLayout::eShaderReadOnlyOptimal;
+        imageInfos[i] = vk::DescriptorImageInfo(nullptr, views[i], layout);
+        descriptorWrites[i] = vk::WriteDescriptorSet()
+                              .setDstSet(gbufferSet_)
+                              .setDstBinding(i)
+                              .setDescriptorType(vk::DescriptorType::eInputAttachment)
+                              .setImageInfo(imageInfos[i]);
+    }
+    context_.getDevice().updateDescriptorSets(descriptorWrites, nullptr);
+
+    // Visibility target; absent (and never read) when the device cannot run that mode
+    if (swapChain_.getVisibilityView()) {
+        auto visibilityInfo = vk::DescriptorImageInfo(nullptr, swapChain_.getVisibilityView(),
+                                                      vk::ImageLayout::eShaderReadOnlyOptimal);
+        auto visibilityWrite = vk::WriteDescriptorSet()
+                               .setDstSet(gbufferSet_)
+                               .setDstBinding(visbuffer::INPUT_BINDING)
+                               .setDescriptorType(vk::DescriptorType::eInputAttachment)
+                               .setImageInfo(visibilityInfo);
+        context_.getDevice().updateDescriptorSets(visibilityWrite, nullptr);
+    }
 
-        context_.getDevice().updateDescriptorSets(descriptorWrite, nullptr);
+    auto sceneColorInfo = vk::DescriptorImageInfo(sceneColorSampler_, swapChain_.getSceneColorView(),
+                                                  vk::ImageLayout::eShaderReadOnlyOptimal);
+    auto sceneColorWrite = vk::WriteDescriptorSet()
+                           .setDstSet(gbufferSet_)
+                           .setDstBinding(gbuffer::SCENE_COLOR_BINDING)
+                           .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                           .setImageInfo(sceneColorInfo);
+    context_.getDevice().updateDescriptorSets(sceneColorWrite, nullptr);
+
+    // Temporal resolve inputs; velocity is read with texelFetch, so the sampler does not matter
+    auto velocityInfo = vk::DescriptorImageInfo(sceneColorSampler_, swapChain_.getVelocityView(),
+                                                vk::ImageLayout::eShaderReadOnlyOptimal);
+    std::array<vk::DescriptorImageInfo, taa::HISTORY_COUNT> historyInfos;
+    for (uint32_t h = 0; h < taa::HISTORY_COUNT; h++) {
+        historyInfos[h] = vk::DescriptorImageInfo(sceneColorSampler_, swapChain_.getHistoryView(h),
+                                                  vk::ImageLayout::eShaderReadOnlyOptimal);
     }
+    std::array<vk::WriteDescriptorSet, 2> temporalWrites = {
+        vk::WriteDescriptorSet()
+        .setDstSet(gbufferSet_)
+        .setDstBinding(taa::VELOCITY_BINDING)
+        .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+        .setImageInfo(velocityInfo),
+        vk::WriteDescriptorSet()
+        .setDstSet(gbufferSet_)
+        .setDstBinding(taa::HISTORY_BINDING)
+        .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+        .setImageInfo(historyInfos)
+    };
+    context_.getDevice().updateDescriptorSets(temporalWrites, nullptr);
+
+    // Ambient occlusion: its images always (the lighting pipelines declare them), the G-buffer inputs only
+    // where those images can be sampled
+    const auto storageInfos = ambientOcclusion_->getStorageInfos();
+    const auto textureInfos = ambientOcclusion_->getTextureInfos();
+    std::array<vk::WriteDescriptorSet, 2> occlusionWrites = {
+        vk::WriteDescriptorSet()
+        .setDstSet(gbufferSet_)
+        .setDstBinding(AmbientOcclusion::IMAGE_BINDING)
+        .setDescriptorType(vk::DescriptorType::eStorageImage)
+        .setImageInfo(storageInfos),
+        vk::WriteDescriptorSet()
+        .setDstSet(gbufferSet_)
+        .setDstBinding(AmbientOcclusion::TEXTURE_BINDING)
+        .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+        .setImageInfo(textureInfos)
+    };
+    context_.getDevice().updateDescriptorSets(occlusionWrites, nullptr);
+
+    if (swapChain_.isGBufferStored()) {
+        auto depthInfo = vk::DescriptorImageInfo(ambientOcclusion_->getSampler(), views[gbuffer::DEPTH_INPUT_INDEX],
+                                                 vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+        auto normalInfo = vk::DescriptorImageInfo(ambientOcclusion_->getSampler(), views[1],
+                                                  vk::ImageLayout::eShaderReadOnlyOptimal);
+        static_assert(gbuffer::TARGETS[1] == gbuffer::NORMAL);
+        std::array<vk::WriteDescriptorSet, 2> inputWrites = {
+            vk::WriteDescriptorSet()
+            .setDstSet(gbufferSet_)
+            .setDstBinding(AmbientOcclusion::DEPTH_BINDING)
+            .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+            .setImageInfo(depthInfo),
+            vk::WriteDescriptorSet()
+            .setDstSet(gbufferSet_)
+            .setDstBinding(AmbientOcclusion::NORMAL_BINDING)
+            .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+            .setImageInfo(normalInfo)
+        };
+        context_.getDevice().updateDescriptorSets(inputWrites, nullptr);
+    }
+
+    // Post chain: the bloom mips it writes, the chain the output pass samples, the exposure state
+    const auto bloomStorageInfos = postProcess_->getBloomStorageInfos();
+    const auto bloomTextureInfo = postProcess_->getBloomTextureInfo();
+    const auto exposureInfo = postProcess_->getExposureInfo();
+    std::array<vk::WriteDescriptorSet, 3> postWrites = {
+        vk::WriteDescriptorSet()
+        .setDstSet(gbufferSet_)
+        .setDstBinding(PostProcess::BLOOM_IMAGE_BINDING)
+        .setDescriptorType(vk::DescriptorType::eStorageImage)
+        .setImageInfo(bloomStorageInfos),
+        vk::WriteDescriptorSet()
+        .setDstSet(gbufferSet_)
+        .setDstBinding(PostProcess::BLOOM_TEXTURE_BINDING)
+        .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+        .setImageInfo(bloomTextureInfo),
+        vk::WriteDescriptorSet()
+        .setDstSet(gbufferSet_)
+        .setDstBinding(PostProcess::EXPOSURE_BINDING)
+        .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+        .setBufferInfo(exposureInfo)
+    };
+    context_.getDevice().updateDescriptorSets(postWrites, nullptr);
 }
 
 void Renderer::createDescriptorSetLayout() {
+    layoutCache_ = std::make_unique<DescriptorLayoutCache>(context_.getDevice());
+
     auto uboLayoutBinding = vk::DescriptorSetLayoutBinding()
                             .setBinding(0)
-                            .setDescriptorType(vk::DescriptorType::eUniformBuffer)
+                            .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
                             .setDescriptorCount(1)
-                            .setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment);
+                            .setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment |
+                                           vk::ShaderStageFlagBits::eCompute);
+
+    auto textureLayoutBinding = vk::DescriptorSetLayoutBinding()
+                                .setBinding(1)
+                                .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                                .setDescriptorCount(engine::MAX_BOUND_TEXTURES)
+                                .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+
+    auto materialLayoutBinding = vk::DescriptorSetLayoutBinding()
+                                 .setBinding(2)
+                                 .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                                 .setDescriptorCount(1)
+                                 .setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment);
+
+    // Per vertex, and per pixel by the visibility-buffer material pass
+    auto objectLayoutBinding = vk::DescriptorSetLayoutBinding()
+                               .setBinding(3)
+                               .setDescriptorType(vk::DescriptorType::eStorageBufferDynamic)
+                               .setDescriptorCount(1)
+                               .setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment);
+
+    // Sampled per vertex by the Gouraud permutation, per pixel otherwise
+    auto shadowMapLayoutBinding = vk::DescriptorSetLayoutBinding()
+                                  .setBinding(4)
+                                  .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                                  .setDescriptorCount(1)
+                                  .setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment);
+
+    auto shadowUniformLayoutBinding = vk::DescriptorSetLayoutBinding()
+                                      .setBinding(5)
+                                      .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+                                      .setDescriptorCount(1)
+                                      .setStageFlags(vk::ShaderStageFlagBits::eVertex |
+                                                     vk::ShaderStageFlagBits::eFragment);
+
+    // Local lights and their atlas: shadow.vert reads the views, both lighting paths and the light binning
+    // the rest
+    auto localLightLayoutBinding = vk::DescriptorSetLayoutBinding()
+                                   .setBinding(6)
+                                   .setDescriptorType(vk::DescriptorType::eStorageBufferDynamic)
+                                   .setDescriptorCount(1)
+                                   .setStageFlags(vk::ShaderStageFlagBits::eVertex |
+                                                  vk::ShaderStageFlagBits::eFragment |
+                                                  vk::ShaderStageFlagBits::eCompute);
+
+    auto shadowAtlasLayoutBinding = vk::DescriptorSetLayoutBinding()
+                                    .setBinding(7)
+                                    .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                                    .setDescriptorCount(1)
+                                    .setStageFlags(vk::ShaderStageFlagBits::eVertex |
+                                                   vk::ShaderStageFlagBits::eFragment);
+
+    // The shared vertex and index buffers, fetched per pixel by the visibility-buffer material pass
+    auto vertexDataLayoutBinding = vk::DescriptorSetLayoutBinding()
+                                   .setBinding(8)
+                                   .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                                   .setDescriptorCount(1)
+                                   .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+
+    auto indexDataLayoutBinding = vk::DescriptorSetLayoutBinding()
+                                  .setBinding(9)
+                                  .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                                  .setDescriptorCount(1)
+                                  .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+
+    // Light masks per screen tile: written by the light binning, read by the per-pixel lighting
+    auto lightTileLayoutBinding = vk::DescriptorSetLayoutBinding()
+                                  .setBinding(10)
+                                  .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                                  .setDescriptorCount(1)
+                                  .setStageFlags(vk::ShaderStageFlagBits::eCompute |
+                                                 vk::ShaderStageFlagBits::eFragment);
+
+    std::array<vk::DescriptorSetLayoutBinding, 11> bindings = {
+        uboLayoutBinding, textureLayoutBinding, materialLayoutBinding, objectLayoutBinding, shadowMapLayoutBinding,
+        shadowUniformLayoutBinding, localLightLayoutBinding, shadowAtlasLayoutBinding, vertexDataLayoutBinding,
+        indexDataLayoutBinding, lightTileLayoutBinding
+    };
 
     auto layoutInfo = vk::DescriptorSetLayoutCreateInfo()
-                      .setBindingCount(1)
-                      .setPBindings(&uboLayoutBinding);
-
-    descriptorSetLayout_ = context_.getDevice().createDescriptorSetLayout(layoutInfo);
+                      .setBindings(bindings);
+
+    descriptorSetLayout_ = layoutCache_->get(layoutInfo);
+
+    // Set 1: one input attachment per G-buffer target plus depth, binding = input_attachment_index,
+    // then the visibility target, the scene color, the temporal resolve inputs, the ambient occlusion
+    // images and the post chain's. Each pass only reads its own bindings.
+    std::array<vk::DescriptorSetLayoutBinding, gbuffer::INPUT_COUNT + 11> gbufferBindings;
+    for (uint32_t i = 0; i < gbuffer::INPUT_COUNT; i++) {
+        gbufferBindings[i] = vk::DescriptorSetLayoutBinding()
+                             .setBinding(i)
+                             .setDescriptorType(vk::DescriptorType::eInputAttachment)
+                             .setDescriptorCount(1)
+                             .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+    }
+    gbufferBindings[gbuffer::INPUT_COUNT] = vk::DescriptorSetLayoutBinding()
+                                            .setBinding(visbuffer::INPUT_BINDING)
+                                            .setDescriptorType(vk::DescriptorType::eInputAttachment)
+                                            .setDescriptorCount(1)
+                                            .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+    gbufferBindings[gbuffer::INPUT_COUNT + 1] = vk::DescriptorSetLayoutBinding()
+                                                .setBinding(gbuffer::SCENE_COLOR_BINDING)
+                                                .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                                                .setDescriptorCount(1)
+                                                .setStageFlags(vk::ShaderStageFlagBits::eCompute |
+                                                               vk::ShaderStageFlagBits::eFragment);
+    gbufferBindings[gbuffer::INPUT_COUNT + 2] = vk::DescriptorSetLayoutBinding()
+                                                .setBinding(taa::VELOCITY_BINDING)
+                                                .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                                                .setDescriptorCount(1)
+                                                .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+    gbufferBindings[gbuffer::INPUT_COUNT + 3] = vk::DescriptorSetLayoutBinding()
+                                                .setBinding(taa::HISTORY_BINDING)
+                                                .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                                                .setDescriptorCount(taa::HISTORY_COUNT)
+                                                .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+    // Ambient occlusion: its G-buffer inputs and both images, the result upsampled by the lighting
+    gbufferBindings[gbuffer::INPUT_COUNT + 4] = vk::DescriptorSetLayoutBinding()
+                                                .setBinding(AmbientOcclusion::DEPTH_BINDING)
+                                                .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                                                .setDescriptorCount(1)
+                                                .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+    gbufferBindings[gbuffer::INPUT_COUNT + 5] = vk::DescriptorSetLayoutBinding()
+                                                .setBinding(AmbientOcclusion::NORMAL_BINDING)
+                                                .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                                                .setDescriptorCount(1)
+                                                .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+    gbufferBindings[gbuffer::INPUT_COUNT + 6] = vk::DescriptorSetLayoutBinding()
+                                                .setBinding(AmbientOcclusion::IMAGE_BINDING)
+                                                .setDescriptorType(vk::DescriptorType::eStorageImage)
+                                                .setDescriptorCount(AmbientOcclusion::IMAGE_COUNT)
+                                                .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+    gbufferBindings[gbuffer::INPUT_COUNT + 7] = vk::DescriptorSetLayoutBinding()
+                                                .setBinding(AmbientOcclusion::TEXTURE_BINDING)
+                                                .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                                                .setDescriptorCount(AmbientOcclusion::IMAGE_COUNT)
+                                                .setStageFlags(vk::ShaderStageFlagBits::eCompute |
+                                                               vk::ShaderStageFlagBits::eFragment);
+    // Post chain: bloom mips written by the dispatch, the whole chain and the exposure read by the output pass
+    gbufferBindings[gbuffer::INPUT_COUNT + 8] = vk::DescriptorSetLayoutBinding()
+                                                .setBinding(PostProcess::BLOOM_IMAGE_BINDING)
+                                                .setDescriptorType(vk::DescriptorType::eStorageImage)
+                                                .setDescriptorCount(PostProcess::BLOOM_MIPS)
+                                                .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+    gbufferBindings[gbuffer::INPUT_COUNT + 9] = vk::DescriptorSetLayoutBinding()
+                                                .setBinding(PostProcess::BLOOM_TEXTURE_BINDING)
+                                                .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                                                .setDescriptorCount(1)
+                                                .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+    gbufferBindings[gbuffer::INPUT_COUNT + 10] = vk::DescriptorSetLayoutBinding()
+                                                 .setBinding(PostProcess::EXPOSURE_BINDING)
+                                                 .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                                                 .setDescriptorCount(1)
+                                                 .setStageFlags(vk::ShaderStageFlagBits::eCompute |
+                                                                vk::ShaderStageFlagBits::eFragment);
+    gbufferSetLayout_ = layoutCache_->get(vk::DescriptorSetLayoutCreateInfo().setBindings(gbufferBindings));
 }
\ No newline at end of file
@@ -1,21 +1,58 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <GLFW/glfw3.h>
 #include <vma/vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
 
+#include "AmbientOcclusion.hpp"
 #include "Camera.hpp"
+#include "DynamicResolution.hpp"
+#include "FramePacer.hpp"
+#include "FramePacket.hpp"
+#include "Light.hpp"
+#include "PostProcess.hpp"
+#include "RenderObject.hpp"
+#include "Uniform.hpp"
+#include "common/config.hpp"
+#include "scene/Bvh.hpp"
+#include "scene/Culling.hpp"
+#include "ShadowScheduler.hpp"
+#include "system/MaterialSystem.hpp"
 #include "system/ModelSystem.hpp"
+#include "system/TextureSystem.hpp"
+#include "vulkan/DeletionQueue.hpp"
+#include "vulkan/GBuffer.hpp"
+#include "vulkan/swap_chain.hpp"
 
 // Forward declarations
+class CascadedShadowMap;
+class DescriptorAllocator;
+class DescriptorLayoutCache;
+class FrameAllocator;
+class GpuTimer;
+class GraphicsPipeline;
+class JobSystem;
+class LightBinning;
+class LocalLightShadows;
 class RenderPass;
-class SwapChain;
+class Scene;
+class UploadContext;
 class VulkanContext;
 
 class Renderer {
 public:
+    // Main pass: G-buffer + lighting (GBuffer.hpp), or visibility buffer + material (VisibilityBuffer.hpp)
+    enum class RenderMode {
+        Deferred,
+        VisibilityBuffer,
+    };
+
     Renderer(VulkanContext &context,
              SwapChain &swapChain,
              RenderPass &renderPass,
@@ -29,12 +66,80 @@ public:
     void initResources(vk::PipelineLayout pipelineLayout, std::string modelPath);
     void createDescriptorSetLayout();
 
-    // Changed to vk::Pipeline for C++ style consistency
-    void drawFrame(vk::Pipeline pipeline, bool framebufferResized, const Camera &camera);
+    // Render thread: applies the packet (commands, transforms, window state) and draws it. Pipelines are
+    // picked per draw from the material's shading model.
+    void drawFrame(const GraphicsPipeline &pipelines, FramePacket &packet);
+
+    // Without idling the device (SwapChain::recreate). False while the window has no area: nothing is
+    // rendered then, and the next drawFrame() tries again.
+    bool recreateSwapChain();
 
-    void recreateSwapChain();
+    // Defers destruction until the GPU is past every frame submitted so far; for anything replaced at runtime
+    [[nodiscard]] DeletionQueue &getDeletionQueue() { return deletionQueue_; }
+    // Last frame timeline value the GPU has reached
+    [[nodiscard]] uint64_t getCompletedFrameValue() const;
 
     [[nodiscard]] vk::DescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout_; }
+    [[nodiscard]] vk::DescriptorSetLayout getGBufferSetLayout() const { return gbufferSetLayout_; }
+
+    // Everything drawn each frame; identical mesh + material pairs are instanced automatically
+    [[nodiscard]] Scene &getScene() { return *scene_; }
+    [[nodiscard]] const std::vector<Mesh> &getMeshes() const { return meshes_; }
+
+    // Closest render object whose world bounds the ray hits
+    [[nodiscard]] std::optional<uint32_t> pickObject(const Ray &ray) const;
+    [[nodiscard]] uint32_t getVisibleObjectCount() const { return static_cast<uint32_t>(visibleObjects_.size()); }
+    // Pipeline and material binds the main pass skipped last frame thanks to the draw sort. Safe from any thread.
+    [[nodiscard]] uint32_t getBindsSaved() const { return bindsSaved_.load(std::memory_order_relaxed); }
+
+    // Directional light; 'towardsLight' points from the scene to the light
+    void setLightDirection(const glm::vec3 &towardsLight);
+    [[nodiscard]] const CascadedShadowMap &getShadowMap() const { return *shadowMap_; }
+
+    // Point and spot lights, up to MAX_LOCAL_LIGHTS; shadows share one atlas, see LocalLightShadows
+    LightHandle addLocalLight(const LocalLight &light);
+    void setLocalLight(LightHandle handle, const LocalLight &light);
+    [[nodiscard]] const LocalLight &getLocalLight(LightHandle handle) const { return localLights_[handle]; }
+    [[nodiscard]] const LocalLightShadows &getLocalLightShadows() const { return *localShadows_; }
+
+    // Lit output or one decoded G-buffer channel
+    void setDebugView(gbuffer::DebugView view) { debugView_ = view; }
+    [[nodiscard]] gbuffer::DebugView getDebugView() const { return debugView_; }
+
+    // Takes effect with the next recorded frame; falls back to Deferred if the device lacks the
+    // visibility-buffer features (see VulkanContext::supportsVisibilityBuffer)
+    void setRenderMode(RenderMode mode);
+    [[nodiscard]] RenderMode getRenderMode() const { return renderMode_; }
+
+    // Present mode and image count; the swapchain is recreated with them at the next frame start
+    void setPresentSettings(const SwapChain::PresentSettings &settings);
+    [[nodiscard]] const SwapChain::PresentSettings &getPresentSettings() const {
+        return swapChain_.getPresentSettings();
+    }
+    [[nodiscard]] vk::PresentModeKHR getPresentMode() const { return swapChain_.getPresentMode(); }
+    // Low-latency throttling and the input latency measurement; the app calls into it around input sampling
+    [[nodiscard]] FramePacer &getFramePacer() { return *framePacer_; }
+
+    // Render scale steered by the GPU frame time (see DynamicResolution); off = always the maximum scale
+    void setDynamicResolution(bool enabled) { dynamicResolution_.setEnabled(enabled); }
+    [[nodiscard]] const DynamicResolution &getDynamicResolution() const { return dynamicResolution_; }
+
+    // Jittered rendering resolved against a reprojected history (TemporalAA.hpp); off = plain upscale.
+    // Switching it on restarts the history.
+    void setTemporalAA(bool enabled);
+    [[nodiscard]] bool getTemporalAA() const { return temporalAA_; }
+
+    // Screen-space ambient occlusion of the deferred lighting (AmbientOcclusion.hpp); no effect without
+    // engine::SSAO or in visibility-buffer mode. Switching it on stores the G-buffer, which recreates the
+    // render targets before the next frame; so does switching it off where that frees tile memory.
+    void setAmbientOcclusion(const AmbientOcclusion::Settings &settings);
+    [[nodiscard]] const AmbientOcclusion::Settings &getAmbientOcclusion() const {
+        return ambientOcclusion_->getSettings();
+    }
+
+    // HDR post chain (PostProcess.hpp): bloom, auto exposure and the tonemap of the output pass
+    void setPostProcess(const PostProcess::Settings &settings) { postProcess_->setSettings(settings); }
+    [[nodiscard]] const PostProcess::Settings &getPostProcess() const { return postProcess_->getSettings(); }
 
 private:
     void createCommandPool();
@@ -42,10 +147,13 @@ private:
     void createSyncObjects();
 
     // Updated to use vk:: types
-    void recordCommandBuffer(vk::CommandBuffer commandBuffer, vk::Pipeline pipeline, uint32_t imageIndex) const;
+    void recordCommandBuffer(vk::CommandBuffer commandBuffer, const GraphicsPipeline &pipelines,
+                             uint32_t imageIndex) const;
 
     void createVertexBuffer();
     void createIndexBuffer();
+    void createMaterials();
+    void createScene();
 
     // Your updated C++ style buffer helper
     void createBuffer(vk::DeviceSize size,
@@ -56,13 +164,44 @@ private:
                       VmaAllocationCreateFlags vmaFlags = 0,
                       VmaAllocationInfo *outAllocInfo = nullptr) const;
 
-    void copyBuffer(vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size) const;
+    // Instanced draws plus the ObjectData range their firstInstance indexes into
+    struct DrawList {
+        std::vector<DrawBatch> batches;
+        uint32_t objectOffset = 0; // dynamic offset of the list's ObjectBuffer
+        uint32_t bindsSaved = 0; // pipeline and material binds the sort spared over drawing in culling order
+    };
+
+    enum class BatchMode {
+        Shading, // grouped by pipeline, material, mesh; normal matrices computed
+        DepthOnly, // grouped by mesh only; transforms only
+    };
 
     void createAllocator();
-    void createUniformBuffers();
-    void updateUniformBuffer(uint32_t currentFrame, const Camera &camera) const;
-    void createDescriptorPool();
-    void createDescriptorSets();
+    void updateUniformBuffer(const Camera &camera);
+    void updateSceneBounds();
+    void cullObjects(const std::array<glm::vec4, 6> &planes, std::vector<uint32_t> &out) const;
+    void buildDrawList(const std::vector<uint32_t> &objects, BatchMode mode, DrawList &list);
+    void buildDrawBatches();
+    void updateShadows(const Camera &camera);
+    void updateLocalLights(const Camera &camera);
+    // One cascade pass' draws into its secondary command buffer; runs as a job
+    void recordShadowSecondary(const GraphicsPipeline &pipelines, uint32_t cascade, bool staticPass) const;
+    // Pipeline, set 0 and the view's push constant, then the list's batches
+    void recordShadowDraws(vk::CommandBuffer commandBuffer, const GraphicsPipeline &pipelines, const DrawList &list,
+                           uint32_t shadowView) const;
+    [[nodiscard]] uint32_t shadowSecondaryIndex(uint32_t cascade, bool staticPass) const {
+        return (currentFrame * engine::SHADOW_CASCADE_COUNT + cascade) * 2 + (staticPass ? 1 : 0);
+    }
+    void applyPacket(FramePacket &packet);
+    void renderFrame(const GraphicsPipeline &pipelines, bool framebufferResized, const Camera &camera);
+    void createDescriptorAllocator();
+    void createDescriptorSets(); // allocates and writes both sets from this frame's pools, every frame
+    void updateGBufferDescriptors();
+    void updateLightTileDescriptor();
+    // This frame splits the G-buffer pass around the ambient occlusion passes
+    [[nodiscard]] bool ambientOcclusionActive() const;
+    // Binds the light binning pipeline and set 0 at the compute bind point
+    void bindLightBinning(vk::CommandBuffer commandBuffer, const GraphicsPipeline &pipelines) const;
 
     // --- Members ---
     VulkanContext &context_;
@@ -74,14 +213,28 @@ private:
     vk::PipelineLayout activePipelineLayout_;
     vk::CommandPool commandPool_;
     std::vector<vk::CommandBuffer> commandBuffers_;
+    // Secondary command buffers for the cascade passes, per frame slot x cascade x static/dynamic. Each has
+    // its own pool (pools are externally synchronised), so the jobs recording them never share one.
+    static constexpr uint32_t SHADOW_SECONDARY_COUNT = engine::MAX_FRAMES_IN_FLIGHT * engine::SHADOW_CASCADE_COUNT * 2;
+    std::array<vk::CommandPool, SHADOW_SECONDARY_COUNT> shadowCommandPools_{};
+    std::array<vk::CommandBuffer, SHADOW_SECONDARY_COUNT> shadowCommandBuffers_{};
 
     // Synchronization (C++ style)
     std::vector<vk::Semaphore> imageAvailableSemaphores_;
     std::vector<vk::Semaphore> renderFinishedSemaphores_;
     std::vector<vk::Fence> inFlightFences_;
     std::vector<vk::Fence> imagesInFlight;
+    // Every frame's graphics submission signals the next value; a value the GPU has reached means all work
+    // submitted up to that frame, on either queue, has completed
+    vk::Semaphore frameTimeline_;
+    uint64_t timelineValue_ = 0;
 
     uint32_t currentFrame = 0;
+    // Objects released while submitted frames may still use them, keyed by frameTimeline_
+    DeletionQueue deletionQueue_;
+    bool swapChainStale_ = false; // minimized when it had to be recreated, or new present settings
+    vk::Extent2D framebufferSize_; // from the packets: GLFW is only queried on the main thread
+    std::unique_ptr<FramePacer> framePacer_;
 
     // Memory Resources (VMA + vk::Buffer)
     VmaAllocator vmaAllocator = nullptr;
@@ -92,15 +245,91 @@ private:
     vk::Buffer indexBuffer_;
     VmaAllocation indexBufferAllocation_ = nullptr;
 
-    // Uniform Resources
-    std::vector<vk::Buffer> uniformBuffers_;
-    std::vector<VmaAllocation> uniformBuffersAllocation_;
-    std::vector<void *> uniformBuffersMapped_;
+    // Asset streaming
+    std::unique_ptr<JobSystem> jobSystem_;
+    std::unique_ptr<UploadContext> uploadContext_;
+    std::unique_ptr<TextureSystem> textureSystem_;
+    std::unique_ptr<MaterialSystem> materialSystem_;
+    TextureHandle whiteTexture_ = 0;
+
+    // One mesh per model submesh; scene render objects reference them
+    std::vector<Mesh> meshes_;
+    std::vector<MaterialHandle> meshMaterials_; // material each mesh was authored with
+    std::unique_ptr<Scene> scene_;
+
+    // World bounds per render object and the BVH over them. Rebuilt when objects are
+    // added, refitted when transforms change.
+    std::vector<Aabb> objectBounds_;
+    culling::SoaBounds cullingBounds_; // same boxes, SoA for the SIMD kernels
+    std::vector<uint32_t> changedObjects_;
+    Bvh bvh_;
+    std::array<glm::vec4, 6> frustumPlanes_{};
+    std::vector<uint32_t> visibleObjects_;
+
+    // Directional light with cascaded shadows. Casters are culled per scheduled cascade and
+    // split into static (cached) and dynamic lists, each with its own ObjectData range.
+    std::unique_ptr<CascadedShadowMap> shadowMap_;
+    glm::vec3 lightDirection_ = glm::normalize(glm::vec3(-10.0f, -10.0f, 30.0f));
+    std::array<DrawList, engine::SHADOW_CASCADE_COUNT> shadowStaticLists_;
+    std::array<DrawList, engine::SHADOW_CASCADE_COUNT> shadowDynamicLists_;
+    std::vector<uint32_t> casterObjects_;
+    std::vector<uint32_t> staticCasters_;
+    std::vector<uint32_t> dynamicCasters_;
+    uint64_t frameNumber_ = 0;
+
+    // Local lights. A shadow is re-requested when the light changed, its caster set (hashed
+    // from a sphere query) changed or one of its casters moved; the scheduler decides when.
+    std::unique_ptr<LocalLightShadows> localShadows_;
+    std::vector<LocalLight> localLights_;
+    std::vector<uint8_t> localLightChanged_;
+    std::vector<uint64_t> localCasterHashes_;
+    std::vector<ShadowScheduler::Request> shadowRequests_;
+    std::vector<DrawList> localShadowLists_; // per scheduled view
+    std::vector<uint8_t> objectMoved_; // this frame, per render object
+    bool boundsRebuilt_ = false; // this frame
+
+    // Per-frame data, bump-allocated; the offsets are this frame's dynamic descriptor offsets
+    std::unique_ptr<FrameAllocator> frameAllocator_;
+    uint32_t uniformOffset_ = 0;
+    uint32_t shadowUniformOffset_ = 0;
+    uint32_t localLightOffset_ = 0;
+    // Local lights per screen tile, binned on the compute queue when there is a separate one
+    std::unique_ptr<LightBinning> lightBinning_;
+    std::unique_ptr<AmbientOcclusion> ambientOcclusion_;
+    std::unique_ptr<PostProcess> postProcess_;
+    gbuffer::DebugView debugView_ = gbuffer::DebugView::LIT;
+
+    // Dynamic resolution: the main pass renders renderExtent_ of the targets, the upscale pass
+    // stretches that over the swapchain image
+    std::unique_ptr<GpuTimer> gpuTimer_;
+    DynamicResolution dynamicResolution_{engine::TARGET_GPU_FRAME_MS, engine::MIN_RENDER_SCALE,
+                                         engine::MAX_RENDER_SCALE};
+    vk::Extent2D renderExtent_;
+    vk::Sampler sceneColorSampler_;
+    RenderMode renderMode_ = RenderMode::Deferred;
+
+    // Temporal anti-aliasing. historyIndex_ is the history image this frame writes, the other one is read
+    // unless historyValid_ is false (first frame, resize, just switched on).
+    bool temporalAA_ = engine::TEMPORAL_AA;
+    bool historyValid_ = false;
+    uint32_t historyIndex_ = 0;
+    glm::mat4 prevViewProj_{1.0f}; // unjittered
+    std::vector<glm::mat4> previousModels_; // per render object, its world transform last frame
+    DrawList mainDrawList_;
+    std::vector<uint64_t> sortKeys_; // (batch key << 32) | object index, reused every frame
+    std::vector<uint64_t> sortScratch_; // radix sort ping-pong buffer; swapped with sortKeys_
+    std::atomic<uint32_t> bindsSaved_ = 0; // main pass, last built frame
+    std::vector<ObjectData> objectScratch_; // built in cached memory, then copied to the frame allocator
 
-    // Descriptors (C++ style)
-    vk::DescriptorPool descriptorPool_;
-    std::vector<vk::DescriptorSet> descriptorSets_;
+    // Descriptors (C++ style). Both sets are transient: allocated from this frame's pools and written every
+    // frame, so a change of render targets simply shows up in the next frame's sets. The layouts belong to
+    // the cache.
+    std::unique_ptr<DescriptorLayoutCache> layoutCache_;
+    std::unique_ptr<DescriptorAllocator> descriptorAllocator_;
+    vk::DescriptorSet descriptorSet_;
     vk::DescriptorSetLayout descriptorSetLayout_;
+    vk::DescriptorSet gbufferSet_; // set 1: input attachments of the lighting / material subpass, scene color
+    vk::DescriptorSetLayout gbufferSetLayout_;
 
     ModelSystem ms;
 };
\ No newline at end of file
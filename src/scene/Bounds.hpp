@@ -0,0 +1,87 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cfloat>
+#include <glm/glm.hpp>
+
+// Axis-aligned bounding box; default constructed empty so expand() works from scratch
+struct Aabb {
+    glm::vec3 min{FLT_MAX};
+    glm::vec3 max{-FLT_MAX};
+
+    void expand(const glm::vec3 &point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void expand(const Aabb &other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    [[nodiscard]] bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+    [[nodiscard]] glm::vec3 center() const { return 0.5f * (min + max); }
+    [[nodiscard]] glm::vec3 extent() const { return 0.5f * (max - min); }
+
+    [[nodiscard]] float surfaceArea() const {
+        if (isEmpty())
+            return 0.0f;
+        const glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    // Box around the transformed box (Arvo): centre moves, extent goes through |M|
+    [[nodiscard]] Aabb transformed(const glm::mat4 &m) const {
+        const glm::vec3 c = glm::vec3(m * glm::vec4(center(), 1.0f));
+        const glm::mat3 absM(glm::abs(glm::vec3(m[0])), glm::abs(glm::vec3(m[1])), glm::abs(glm::vec3(m[2])));
+        const glm::vec3 e = absM * extent();
+        return {c - e, c + e};
+    }
+};
+
+struct Ray {
+    glm::vec3 origin{0.0f};
+    glm::vec3 direction{0.0f, 0.0f, -1.0f}; // normalised
+};
+
+// Slab test. 'invDirection' is 1 / ray.direction, precomputed once per ray.
+inline bool intersectRayAabb(const Ray &ray, const glm::vec3 &invDirection, const Aabb &box, float tMax,
+                             float &tEntry) {
+    const glm::vec3 t0 = (box.min - ray.origin) * invDirection;
+    const glm::vec3 t1 = (box.max - ray.origin) * invDirection;
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar = glm::max(t0, t1);
+    const float entry = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+    const float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, tMax));
+    tEntry = entry;
+    return entry <= exit;
+}
+
+enum class Containment { Outside, Intersecting, Inside };
+
+// Planes as produced by Camera::extractFrustumPlanes (inward normals, normalised)
+inline Containment testFrustumAabb(const std::array<glm::vec4, 6> &planes, const Aabb &box) {
+    const glm::vec3 c = box.center();
+    const glm::vec3 e = box.extent();
+    Containment result = Containment::Inside;
+    for (const auto &plane : planes) {
+        const glm::vec3 n(plane);
+        const float distance = glm::dot(n, c) + plane.w;
+        const float radius = glm::dot(glm::abs(n), e);
+        if (distance + radius < 0.0f)
+            return Containment::Outside;
+        if (distance - radius < 0.0f)
+            result = Containment::Intersecting;
+    }
+    return result;
+}
+
+inline bool intersectSphereAabb(const glm::vec3 &center, float radius, const Aabb &box) {
+    const glm::vec3 closest = glm::clamp(center, box.min, box.max);
+    const glm::vec3 d = closest - center;
+    return glm::dot(d, d) <= radius * radius;
+}
@@ -0,0 +1,442 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "Bvh.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#include "common/JobSystem.hpp"
+
+namespace {
+constexpr uint32_t BIN_COUNT = 16;
+constexpr uint32_t MAX_LEAF_SIZE = 8;
+constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+// Ranges above this are split on the calling thread with parallel binning;
+// below it they become independent subtree jobs
+constexpr uint32_t SUBTREE_JOB_SIZE = 4096;
+// Per-primitive passes only go wide when there is enough work to amortise it
+constexpr uint32_t PARALLEL_PASS_SIZE = 32768;
+constexpr size_t PASS_GRAIN = 8192;
+
+// SAH cost of a node visit relative to one primitive test
+constexpr float TRAVERSAL_COST = 1.0f;
+
+struct Bin {
+    Aabb bounds;
+    uint32_t count = 0;
+};
+
+struct RangeStats {
+    Aabb bounds;
+    Aabb centroidBounds;
+    std::array<std::array<Bin, BIN_COUNT>, 3> bins{};
+};
+
+// Runs body(begin, end, stats) over [first, first + count), in chunks on the job system if it is worth it,
+// and merges the per-chunk results
+template <typename Body>
+void accumulate(uint32_t first, uint32_t count, JobSystem *jobSystem, RangeStats &result, const Body &body) {
+    if (!jobSystem || count < PARALLEL_PASS_SIZE) {
+        body(first, first + count, result);
+        return;
+    }
+
+    std::mutex mutex;
+    jobSystem->parallelFor(count, PASS_GRAIN, [&](size_t begin, size_t end) {
+        RangeStats local;
+        body(first + static_cast<uint32_t>(begin), first + static_cast<uint32_t>(end), local);
+
+        std::lock_guard lock(mutex);
+        result.bounds.expand(local.bounds);
+        result.centroidBounds.expand(local.centroidBounds);
+        for (int axis = 0; axis < 3; axis++) {
+            for (uint32_t b = 0; b < BIN_COUNT; b++) {
+                result.bins[axis][b].bounds.expand(local.bins[axis][b].bounds);
+                result.bins[axis][b].count += local.bins[axis][b].count;
+            }
+        }
+    });
+}
+}
+
+void Bvh::build(std::vector<Aabb> primitiveBounds, JobSystem *jobSystem) {
+    primitiveBounds_ = std::move(primitiveBounds);
+    const auto count = static_cast<uint32_t>(primitiveBounds_.size());
+
+    nodes_.clear();
+    parents_.clear();
+    nodeCount_ = 0;
+    if (count == 0) {
+        primitiveIndices_.clear();
+        primitiveLeaf_.clear();
+        centroids_.clear();
+        return;
+    }
+
+    primitiveIndices_.resize(count);
+    centroids_.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        primitiveIndices_[i] = i;
+        centroids_[i] = primitiveBounds_[i].center();
+    }
+
+    // A binary tree with leaves of at least one primitive never needs more than 2n - 1 nodes
+    nodes_.resize(2 * static_cast<size_t>(count) - 1);
+    nextNode_.store(1);
+
+    // Top of the tree: few, large ranges. Split them here, binning across the workers.
+    std::vector<BuildRange> jobs;
+    std::vector<BuildRange> pending{{0, 0, count}};
+    while (!pending.empty()) {
+        const BuildRange range = pending.back();
+        pending.pop_back();
+
+        if (!jobSystem || range.count <= SUBTREE_JOB_SIZE) {
+            jobs.push_back(range);
+            continue;
+        }
+
+        BuildRange children[2];
+        if (splitNode(range, jobSystem, children) == 2) {
+            pending.push_back(children[0]);
+            pending.push_back(children[1]);
+        }
+    }
+
+    // Bottom: independent subtrees, one job each
+    if (jobSystem && jobs.size() > 1) {
+        jobSystem->parallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; j++)
+                buildSubtree(jobs[j]);
+        });
+    } else {
+        for (const auto &job : jobs)
+            buildSubtree(job);
+    }
+
+    nodeCount_ = nextNode_.load();
+    nodes_.resize(nodeCount_);
+    linkParents();
+}
+
+uint32_t Bvh::splitNode(const BuildRange &range, JobSystem *jobSystem, BuildRange children[2]) {
+    Node &node = nodes_[range.node];
+
+    // Pass 1: node bounds and the bounds of the centroids (what the bins span)
+    RangeStats stats;
+    accumulate(range.first, range.count, jobSystem, stats, [&](uint32_t begin, uint32_t end, RangeStats &out) {
+        for (uint32_t i = begin; i < end; i++) {
+            const uint32_t primitive = primitiveIndices_[i];
+            out.bounds.expand(primitiveBounds_[primitive]);
+            out.centroidBounds.expand(centroids_[primitive]);
+        }
+    });
+    node.bounds = stats.bounds;
+
+    auto makeLeaf = [&]() {
+        node.leftOrFirst = range.first;
+        node.count = range.count;
+        return 0u;
+    };
+
+    if (range.count <= 2)
+        return makeLeaf();
+
+    const glm::vec3 centroidMin = stats.centroidBounds.min;
+    const glm::vec3 centroidExtent = stats.centroidBounds.max - stats.centroidBounds.min;
+    glm::vec3 binScale(0.0f);
+    for (int axis = 0; axis < 3; axis++) {
+        if (centroidExtent[axis] > 0.0f)
+            binScale[axis] = static_cast<float>(BIN_COUNT) * (1.0f - 1e-5f) / centroidExtent[axis];
+    }
+
+    auto binOf = [&](uint32_t primitive, int axis) {
+        const float offset = (centroids_[primitive][axis] - centroidMin[axis]) * binScale[axis];
+        return std::min(BIN_COUNT - 1, static_cast<uint32_t>(offset));
+    };
+
+    // Pass 2: bin every primitive on all three axes
+    accumulate(range.first, range.count, jobSystem, stats, [&](uint32_t begin, uint32_t end, RangeStats &out) {
+        for (uint32_t i = begin; i < end; i++) {
+            const uint32_t primitive = primitiveIndices_[i];
+            for (int axis = 0; axis < 3; axis++) {
+                Bin &bin = out.bins[axis][binOf(primitive, axis)];
+                bin.bounds.expand(primitiveBounds_[primitive]);
+                bin.count++;
+            }
+        }
+    });
+
+    // Sweep the bin boundaries: cost = A_left * N_left + A_right * N_right
+    float bestCost = FLT_MAX;
+    int bestAxis = -1;
+    uint32_t bestSplit = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        if (binScale[axis] == 0.0f)
+            continue;
+
+        const auto &bins = stats.bins[axis];
+        std::array<float, BIN_COUNT - 1> rightCost{};
+        Aabb rightBounds;
+        uint32_t rightCount = 0;
+        for (uint32_t b = BIN_COUNT - 1; b > 0; b--) {
+            rightBounds.expand(bins[b].bounds);
+            rightCount += bins[b].count;
+            rightCost[b - 1] = rightBounds.surfaceArea() * static_cast<float>(rightCount);
+        }
+
+        Aabb leftBounds;
+        uint32_t leftCount = 0;
+        for (uint32_t b = 0; b < BIN_COUNT - 1; b++) {
+            leftBounds.expand(bins[b].bounds);
+            leftCount += bins[b].count;
+            if (leftCount == 0 || leftCount == range.count)
+                continue;
+            const float cost = leftBounds.surfaceArea() * static_cast<float>(leftCount) + rightCost[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    const float parentArea = std::max(node.bounds.surfaceArea(), FLT_MIN);
+    const float leafCost = static_cast<float>(range.count);
+    const float splitCost = TRAVERSAL_COST + bestCost / parentArea;
+    if (range.count <= MAX_LEAF_SIZE && (bestAxis < 0 || splitCost >= leafCost))
+        return makeLeaf();
+
+    uint32_t *first = primitiveIndices_.data() + range.first;
+    uint32_t *last = first + range.count;
+    uint32_t *middle;
+    if (bestAxis >= 0) {
+        middle = std::partition(first, last, [&](uint32_t primitive) { return binOf(primitive, bestAxis) <= bestSplit; });
+    } else {
+        // All centroids coincide: no plane separates them, so split the range in half
+        middle = first + range.count / 2;
+    }
+
+    const auto leftCount = static_cast<uint32_t>(middle - first);
+    const uint32_t left = nextNode_.fetch_add(2);
+    node.leftOrFirst = left;
+    node.count = 0;
+
+    children[0] = {left, range.first, leftCount};
+    children[1] = {left + 1, range.first + leftCount, range.count - leftCount};
+    return 2;
+}
+
+void Bvh::buildSubtree(const BuildRange &root) {
+    std::vector<BuildRange> stack{root};
+    while (!stack.empty()) {
+        const BuildRange range = stack.back();
+        stack.pop_back();
+
+        BuildRange children[2];
+        if (splitNode(range, nullptr, children) == 2) {
+            stack.push_back(children[0]);
+            stack.push_back(children[1]);
+        }
+    }
+}
+
+void Bvh::linkParents() {
+    parents_.assign(nodeCount_, NO_PARENT);
+    primitiveLeaf_.resize(primitiveBounds_.size());
+    for (uint32_t i = 0; i < nodeCount_; i++) {
+        const Node &node = nodes_[i];
+        if (node.isLeaf()) {
+            for (uint32_t k = node.leftOrFirst; k < node.leftOrFirst + node.count; k++)
+                primitiveLeaf_[primitiveIndices_[k]] = i;
+        } else {
+            parents_[node.leftOrFirst] = i;
+            parents_[node.leftOrFirst + 1] = i;
+        }
+    }
+}
+
+void Bvh::refitAll(const std::vector<Aabb> &primitiveBounds) {
+    primitiveBounds_ = primitiveBounds;
+
+    // Children always have higher indices than their parent
+    for (uint32_t i = nodeCount_; i-- > 0;) {
+        Node &node = nodes_[i];
+        Aabb bounds;
+        if (node.isLeaf()) {
+            for (uint32_t k = node.leftOrFirst; k < node.leftOrFirst + node.count; k++)
+                bounds.expand(primitiveBounds_[primitiveIndices_[k]]);
+        } else {
+            bounds = nodes_[node.leftOrFirst].bounds;
+            bounds.expand(nodes_[node.leftOrFirst + 1].bounds);
+        }
+        node.bounds = bounds;
+    }
+}
+
+void Bvh::refit(const std::vector<Aabb> &primitiveBounds, const std::vector<uint32_t> &changed) {
+    if (nodeCount_ == 0)
+        return;
+
+    // Past a point the walks overlap so much that one linear sweep is cheaper
+    if (changed.size() * 4 > primitiveBounds_.size()) {
+        refitAll(primitiveBounds);
+        return;
+    }
+
+    for (uint32_t primitive : changed)
+        primitiveBounds_[primitive] = primitiveBounds[primitive];
+
+    for (uint32_t primitive : changed) {
+        for (uint32_t i = primitiveLeaf_[primitive]; i != NO_PARENT; i = parents_[i]) {
+            Node &node = nodes_[i];
+            Aabb bounds;
+            if (node.isLeaf()) {
+                for (uint32_t k = node.leftOrFirst; k < node.leftOrFirst + node.count; k++)
+                    bounds.expand(primitiveBounds_[primitiveIndices_[k]]);
+            } else {
+                bounds = nodes_[node.leftOrFirst].bounds;
+                bounds.expand(nodes_[node.leftOrFirst + 1].bounds);
+            }
+
+            // Unchanged box: nothing above can change because of this path
+            if (bounds.min == node.bounds.min && bounds.max == node.bounds.max)
+                break;
+            node.bounds = bounds;
+        }
+    }
+}
+
+void Bvh::collectSubtree(uint32_t root, std::vector<uint32_t> &out) const {
+    std::vector<uint32_t> stack{root};
+    while (!stack.empty()) {
+        const Node &node = nodes_[stack.back()];
+        stack.pop_back();
+        if (node.isLeaf()) {
+            out.insert(out.end(), primitiveIndices_.begin() + node.leftOrFirst,
+                       primitiveIndices_.begin() + node.leftOrFirst + node.count);
+        } else {
+            stack.push_back(node.leftOrFirst);
+            stack.push_back(node.leftOrFirst + 1);
+        }
+    }
+}
+
+void Bvh::queryFrustum(const std::array<glm::vec4, 6> &planes, std::vector<uint32_t> &out) const {
+    if (nodeCount_ == 0)
+        return;
+
+    std::vector<uint32_t> stack{0};
+    while (!stack.empty()) {
+        const uint32_t index = stack.back();
+        stack.pop_back();
+        const Node &node = nodes_[index];
+
+        const Containment containment = testFrustumAabb(planes, node.bounds);
+        if (containment == Containment::Outside)
+            continue;
+        if (containment == Containment::Inside) {
+            // Whole subtree visible: no more plane tests below this node
+            collectSubtree(index, out);
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            for (uint32_t k = node.leftOrFirst; k < node.leftOrFirst + node.count; k++) {
+                const uint32_t primitive = primitiveIndices_[k];
+                if (testFrustumAabb(planes, primitiveBounds_[primitive]) != Containment::Outside)
+                    out.push_back(primitive);
+            }
+        } else {
+            stack.push_back(node.leftOrFirst);
+            stack.push_back(node.leftOrFirst + 1);
+        }
+    }
+}
+
+std::optional<Bvh::RayHit> Bvh::raycast(const Ray &ray, float maxDistance) const {
+    if (nodeCount_ == 0)
+        return std::nullopt;
+
+    const glm::vec3 invDirection = 1.0f / ray.direction;
+    std::optional<RayHit> best;
+    float bestDistance = maxDistance;
+
+    float entry;
+    if (!intersectRayAabb(ray, invDirection, nodes_[0].bounds, bestDistance, entry))
+        return std::nullopt;
+
+    struct Entry {
+        uint32_t node;
+        float distance;
+    };
+    std::vector<Entry> stack{{0, entry}};
+    while (!stack.empty()) {
+        const Entry current = stack.back();
+        stack.pop_back();
+        if (current.distance > bestDistance)
+            continue;
+
+        const Node &node = nodes_[current.node];
+        if (node.isLeaf()) {
+            for (uint32_t k = node.leftOrFirst; k < node.leftOrFirst + node.count; k++) {
+                const uint32_t primitive = primitiveIndices_[k];
+                float distance;
+                if (intersectRayAabb(ray, invDirection, primitiveBounds_[primitive], bestDistance, distance) &&
+                    distance < bestDistance) {
+                    bestDistance = distance;
+                    best = RayHit{primitive, distance};
+                }
+            }
+            continue;
+        }
+
+        // Push the far child first so the near one is popped (and can tighten bestDistance) first
+        float leftDistance, rightDistance;
+        const bool hitLeft = intersectRayAabb(ray, invDirection, nodes_[node.leftOrFirst].bounds, bestDistance,
+                                              leftDistance);
+        const bool hitRight = intersectRayAabb(ray, invDirection, nodes_[node.leftOrFirst + 1].bounds, bestDistance,
+                                               rightDistance);
+        if (hitLeft && hitRight) {
+            if (leftDistance <= rightDistance) {
+                stack.push_back({node.leftOrFirst + 1, rightDistance});
+                stack.push_back({node.leftOrFirst, leftDistance});
+            } else {
+                stack.push_back({node.leftOrFirst, leftDistance});
+                stack.push_back({node.leftOrFirst + 1, rightDistance});
+            }
+        } else if (hitLeft) {
+            stack.push_back({node.leftOrFirst, leftDistance});
+        } else if (hitRight) {
+            stack.push_back({node.leftOrFirst + 1, rightDistance});
+        }
+    }
+    return best;
+}
+
+void Bvh::querySphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &out) const {
+    if (nodeCount_ == 0)
+        return;
+
+    std::vector<uint32_t> stack{0};
+    while (!stack.empty()) {
+        const Node &node = nodes_[stack.back()];
+        stack.pop_back();
+        if (!intersectSphereAabb(center, radius, node.bounds))
+            continue;
+
+        if (node.isLeaf()) {
+            for (uint32_t k = node.leftOrFirst; k < node.leftOrFirst + node.count; k++) {
+                const uint32_t primitive = primitiveIndices_[k];
+                if (intersectSphereAabb(center, radius, primitiveBounds_[primitive]))
+                    out.push_back(primitive);
+            }
+        } else {
+            stack.push_back(node.leftOrFirst);
+            stack.push_back(node.leftOrFirst + 1);
+        }
+    }
+}
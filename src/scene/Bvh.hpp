@@ -0,0 +1,104 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cfloat>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+
+class JobSystem;
+
+/**
+ * Bvh
+ *
+ * Bounding volume hierarchy over an array of primitive AABBs (one per render
+ * object). The primitives' indices are what the queries return.
+ *
+ * Build: binned SAH (16 bins, all three axes). The upper levels, where ranges
+ * are large, bin their primitives across the job system; once a range drops
+ * below a threshold it becomes an independent subtree job, and the jobs are
+ * built in parallel. Children are allocated in pairs and always after their
+ * parent, so a reverse sweep over the node array is a valid bottom-up order.
+ *
+ * Refit: keeps the topology and only recomputes boxes, either for everything
+ * or by walking up from the leaves of the primitives that moved. Cheap enough
+ * for per-frame dynamic content; quality degrades with large motion, at which
+ * point the owner should rebuild.
+ */
+class Bvh {
+public:
+    struct Node {
+        Aabb bounds;
+        uint32_t leftOrFirst = 0; // left child (right = left + 1), or first primitive slot for leaves
+        uint32_t count = 0; // primitives in the leaf; 0 for interior nodes
+
+        [[nodiscard]] bool isLeaf() const { return count > 0; }
+    };
+
+    struct RayHit {
+        uint32_t primitive;
+        float distance;
+    };
+
+    Bvh() = default;
+    Bvh(const Bvh &) = delete;
+    Bvh &operator=(const Bvh &) = delete;
+
+    // Full rebuild. Without a job system everything runs on the calling thread.
+    void build(std::vector<Aabb> primitiveBounds, JobSystem *jobSystem = nullptr);
+
+    // Updates the boxes of 'changed' primitives and every ancestor that grows or shrinks
+    void refit(const std::vector<Aabb> &primitiveBounds, const std::vector<uint32_t> &changed);
+    void refitAll(const std::vector<Aabb> &primitiveBounds);
+
+    // Primitives whose box is at least partially inside the frustum (appended to 'out')
+    void queryFrustum(const std::array<glm::vec4, 6> &planes, std::vector<uint32_t> &out) const;
+
+    // Closest primitive box hit by the ray
+    [[nodiscard]] std::optional<RayHit> raycast(const Ray &ray, float maxDistance = FLT_MAX) const;
+
+    // Primitives whose box touches the sphere, e.g. objects within a light's radius
+    void querySphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &out) const;
+
+    [[nodiscard]] bool isEmpty() const { return nodeCount_ == 0; }
+    [[nodiscard]] uint32_t getNodeCount() const { return nodeCount_; }
+    [[nodiscard]] size_t getPrimitiveCount() const { return primitiveBounds_.size(); }
+    [[nodiscard]] const Aabb &getBounds() const { return nodes_[0].bounds; }
+    [[nodiscard]] const Aabb &getPrimitiveBounds(uint32_t primitive) const { return primitiveBounds_[primitive]; }
+    [[nodiscard]] const std::vector<Node> &getNodes() const { return nodes_; }
+
+    // Leaf slot -> primitive index, i.e. leaf primitives are primitiveIndices_[first, first + count)
+    [[nodiscard]] const std::vector<uint32_t> &getPrimitiveIndices() const { return primitiveIndices_; }
+
+private:
+    struct BuildRange {
+        uint32_t node;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    // Sets the node's bounds and either makes it a leaf (returns 0) or splits it into
+    // two child ranges (returns 2). 'jobSystem' parallelises the per-primitive passes.
+    uint32_t splitNode(const BuildRange &range, JobSystem *jobSystem, BuildRange children[2]);
+    void buildSubtree(const BuildRange &root);
+    void linkParents();
+    void collectSubtree(uint32_t node, std::vector<uint32_t> &out) const;
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> parents_;
+    std::vector<uint32_t> primitiveIndices_;
+    std::vector<uint32_t> primitiveLeaf_;
+    std::vector<Aabb> primitiveBounds_;
+    std::vector<glm::vec3> centroids_;
+
+    std::atomic<uint32_t> nextNode_{0};
+    uint32_t nodeCount_ = 0;
+};
@@ -0,0 +1,189 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "Culling.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CULLING_X86 1
+#endif
+
+namespace culling {
+
+void SoaBounds::resize(size_t count) {
+    for (auto *array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius})
+        array->resize(count);
+}
+
+void SoaBounds::set(size_t index, const Aabb &box) {
+    const glm::vec3 c = box.center();
+    const glm::vec3 e = box.extent();
+    centerX[index] = c.x;
+    centerY[index] = c.y;
+    centerZ[index] = c.z;
+    extentX[index] = e.x;
+    extentY[index] = e.y;
+    extentZ[index] = e.z;
+    radius[index] = glm::length(e);
+}
+
+namespace {
+// Plane components split out and |n| precomputed, shared by every path
+struct Planes {
+    float nx[6], ny[6], nz[6], w[6];
+    float ax[6], ay[6], az[6];
+
+    explicit Planes(const std::array<glm::vec4, 6> &planes) {
+        for (int p = 0; p < 6; p++) {
+            nx[p] = planes[p].x;
+            ny[p] = planes[p].y;
+            nz[p] = planes[p].z;
+            w[p] = planes[p].w;
+            ax[p] = std::fabs(nx[p]);
+            ay[p] = std::fabs(ny[p]);
+            az[p] = std::fabs(nz[p]);
+        }
+    }
+};
+
+uint32_t cullScalar(const SoaBounds &b, const Planes &pl, Shape shape, uint32_t begin, uint32_t end, uint32_t *out) {
+    uint32_t written = 0;
+    for (uint32_t i = begin; i < end; i++) {
+        bool visible = true;
+        for (int p = 0; p < 6; p++) {
+            const float d = pl.nx[p] * b.centerX[i] + pl.ny[p] * b.centerY[i] + pl.nz[p] * b.centerZ[i] + pl.w[p];
+            const float r = shape == Shape::Sphere
+                                ? b.radius[i]
+                                : pl.ax[p] * b.extentX[i] + pl.ay[p] * b.extentY[i] + pl.az[p] * b.extentZ[i];
+            visible &= d + r >= 0.0f;
+        }
+        out[written] = i;
+        written += visible ? 1 : 0;
+    }
+    return written;
+}
+
+#ifdef CULLING_X86
+__attribute__((target("sse4.1"))) uint32_t cullSse41(const SoaBounds &b, const Planes &pl, Shape shape,
+                                                     uint32_t begin, uint32_t end, uint32_t *out) {
+    uint32_t written = 0;
+    uint32_t i = begin;
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= end; i += 4) {
+        const __m128 cx = _mm_loadu_ps(&b.centerX[i]);
+        const __m128 cy = _mm_loadu_ps(&b.centerY[i]);
+        const __m128 cz = _mm_loadu_ps(&b.centerZ[i]);
+        const __m128 ex = _mm_loadu_ps(shape == Shape::Sphere ? &b.radius[i] : &b.extentX[i]);
+        const __m128 ey = _mm_loadu_ps(&b.extentY[i]);
+        const __m128 ez = _mm_loadu_ps(&b.extentZ[i]);
+
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl.nx[p]), cx), _mm_set1_ps(pl.w[p]));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(pl.ny[p]), cy));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(pl.nz[p]), cz));
+
+            __m128 r;
+            if (shape == Shape::Sphere) {
+                r = ex;
+            } else {
+                r = _mm_mul_ps(_mm_set1_ps(pl.ax[p]), ex);
+                r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pl.ay[p]), ey));
+                r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pl.az[p]), ez));
+            }
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(d, r), zero));
+        }
+
+        const int mask = _mm_movemask_ps(visible);
+        for (int lane = 0; lane < 4; lane++) {
+            out[written] = i + lane;
+            written += (mask >> lane) & 1;
+        }
+    }
+    return written + cullScalar(b, pl, shape, i, end, out + written);
+}
+
+__attribute__((target("avx2,fma"))) uint32_t cullAvx2(const SoaBounds &b, const Planes &pl, Shape shape,
+                                                      uint32_t begin, uint32_t end, uint32_t *out) {
+    uint32_t written = 0;
+    uint32_t i = begin;
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= end; i += 8) {
+        const __m256 cx = _mm256_loadu_ps(&b.centerX[i]);
+        const __m256 cy = _mm256_loadu_ps(&b.centerY[i]);
+        const __m256 cz = _mm256_loadu_ps(&b.centerZ[i]);
+        const __m256 ex = _mm256_loadu_ps(shape == Shape::Sphere ? &b.radius[i] : &b.extentX[i]);
+        const __m256 ey = _mm256_loadu_ps(&b.extentY[i]);
+        const __m256 ez = _mm256_loadu_ps(&b.extentZ[i]);
+
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 d = _mm256_fmadd_ps(_mm256_set1_ps(pl.nx[p]), cx, _mm256_set1_ps(pl.w[p]));
+            d = _mm256_fmadd_ps(_mm256_set1_ps(pl.ny[p]), cy, d);
+            d = _mm256_fmadd_ps(_mm256_set1_ps(pl.nz[p]), cz, d);
+
+            __m256 r;
+            if (shape == Shape::Sphere) {
+                r = ex;
+            } else {
+                r = _mm256_mul_ps(_mm256_set1_ps(pl.ax[p]), ex);
+                r = _mm256_fmadd_ps(_mm256_set1_ps(pl.ay[p]), ey, r);
+                r = _mm256_fmadd_ps(_mm256_set1_ps(pl.az[p]), ez, r);
+            }
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_GE_OQ));
+        }
+
+        const int mask = _mm256_movemask_ps(visible);
+        for (int lane = 0; lane < 8; lane++) {
+            out[written] = i + lane;
+            written += (mask >> lane) & 1;
+        }
+    }
+    return written + cullScalar(b, pl, shape, i, end, out + written);
+}
+#endif
+}
+
+Isa detectIsa() {
+#ifdef CULLING_X86
+    static const Isa isa = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return Isa::Avx2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return Isa::Sse41;
+        return Isa::Scalar;
+    }();
+    return isa;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+const char *isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Avx2: return "AVX2";
+        case Isa::Sse41: return "SSE4.1";
+        default: return "scalar";
+    }
+}
+
+uint32_t cullFrustum(const SoaBounds &bounds, const std::array<glm::vec4, 6> &planes, Shape shape, uint32_t begin,
+                     uint32_t end, uint32_t *out, Isa isa) {
+    const Planes split(planes);
+#ifdef CULLING_X86
+    // Never run a path the CPU cannot execute, whatever was asked for
+    if (isa > detectIsa())
+        isa = detectIsa();
+    if (isa == Isa::Avx2)
+        return cullAvx2(bounds, split, shape, begin, end, out);
+    if (isa == Isa::Sse41)
+        return cullSse41(bounds, split, shape, begin, end, out);
+#endif
+    return cullScalar(bounds, split, shape, begin, end, out);
+}
+
+}
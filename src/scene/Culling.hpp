@@ -0,0 +1,54 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+
+/**
+ * Flat CPU frustum culling over structure-of-arrays bounds.
+ *
+ * Each object is a centre, a half extent and a bounding-sphere radius, stored
+ * one component per array so the kernels load 4 (SSE4.1) or 8 (AVX2) objects
+ * per instruction and test them against all six planes at once. The survivors
+ * are written as a compacted index list (branch-free: every lane is stored and
+ * the write cursor only advances for visible ones).
+ *
+ * The ISA is picked at runtime from CPUID; the scalar path is the reference
+ * and the fallback on other architectures.
+ */
+namespace culling {
+
+enum class Isa { Scalar, Sse41, Avx2 };
+
+enum class Shape {
+    Sphere, // one dot product per plane; conservative, cheapest
+    Box, // centre/extent test; tighter for elongated objects
+};
+
+struct SoaBounds {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<float> radius;
+
+    void resize(size_t count);
+    void set(size_t index, const Aabb &box);
+    [[nodiscard]] size_t size() const { return centerX.size(); }
+};
+
+// Best ISA this CPU supports (detected once)
+Isa detectIsa();
+const char *isaName(Isa isa);
+
+// Culls objects [begin, end) and writes the visible indices to 'out', which must have room
+// for (end - begin) entries. Returns how many were written.
+uint32_t cullFrustum(const SoaBounds &bounds, const std::array<glm::vec4, 6> &planes, Shape shape, uint32_t begin,
+                     uint32_t end, uint32_t *out, Isa isa = detectIsa());
+
+}
@@ -0,0 +1,139 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "Scene.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+#include "common/JobSystem.hpp"
+
+namespace {
+constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+
+// Nodes per parallelFor chunk; one 4x4 multiply each, so chunks need to be fairly large
+constexpr size_t UPDATE_GRAIN = 2048;
+}
+
+Scene::Scene(JobSystem &jobSystem) : jobSystem_(jobSystem) {
+}
+
+NodeHandle Scene::createNode(NodeHandle parent, const glm::mat4 &local) {
+    if (parent != INVALID_NODE && parent >= slotOf_.size()) {
+        throw std::runtime_error("scene node parent does not exist!");
+    }
+
+    const auto handle = static_cast<NodeHandle>(slotOf_.size());
+    const auto slot = static_cast<uint32_t>(local_.size());
+
+    // Appended at the end for now; the depth order is restored by the next update
+    slotOf_.push_back(slot);
+    parentOf_.push_back(parent);
+    depthOf_.push_back(parent == INVALID_NODE ? 0 : depthOf_[parent] + 1);
+
+    parentSlot_.push_back(parent == INVALID_NODE ? NO_PARENT : slotOf_[parent]);
+    local_.push_back(local);
+    world_.push_back(local);
+    localDirty_.push_back(1);
+    worldDirty_.push_back(0);
+
+    layoutDirty_ = true;
+    anyDirty_ = true;
+    return handle;
+}
+
+void Scene::setLocalTransform(NodeHandle node, const glm::mat4 &local) {
+    const uint32_t slot = slotOf_[node];
+    local_[slot] = local;
+    localDirty_[slot] = 1;
+    anyDirty_ = true;
+}
+
+void Scene::addRenderObject(NodeHandle node, MeshHandle mesh, MaterialHandle material, bool dynamic) {
+    if (node >= slotOf_.size()) {
+        throw std::runtime_error("render object attached to a node that does not exist!");
+    }
+    renderObjects_.push_back({mesh, material, node, dynamic});
+}
+
+void Scene::rebuildLayout() {
+    const size_t count = slotOf_.size();
+    const uint32_t levelCount = count == 0 ? 0 : *std::max_element(depthOf_.begin(), depthOf_.end()) + 1;
+
+    // Counting sort by depth; stable, so siblings keep their creation order
+    levelOffsets_.assign(levelCount + 1, 0);
+    for (uint32_t depth : depthOf_)
+        levelOffsets_[depth + 1]++;
+    for (uint32_t d = 0; d < levelCount; d++)
+        levelOffsets_[d + 1] += levelOffsets_[d];
+
+    std::vector<uint32_t> cursor(levelOffsets_.begin(), levelOffsets_.end() - 1);
+    std::vector<uint32_t> newSlotOf(count);
+    for (size_t handle = 0; handle < count; handle++)
+        newSlotOf[handle] = cursor[depthOf_[handle]]++;
+
+    std::vector<glm::mat4> local(count), world(count);
+    std::vector<uint8_t> localDirty(count), worldDirty(count);
+    for (size_t handle = 0; handle < count; handle++) {
+        const uint32_t from = slotOf_[handle];
+        const uint32_t to = newSlotOf[handle];
+        local[to] = local_[from];
+        world[to] = world_[from];
+        localDirty[to] = localDirty_[from];
+        worldDirty[to] = worldDirty_[from];
+    }
+
+    local_ = std::move(local);
+    world_ = std::move(world);
+    localDirty_ = std::move(localDirty);
+    worldDirty_ = std::move(worldDirty);
+    slotOf_ = std::move(newSlotOf);
+
+    for (size_t handle = 0; handle < count; handle++) {
+        const NodeHandle parent = parentOf_[handle];
+        parentSlot_[slotOf_[handle]] = parent == INVALID_NODE ? NO_PARENT : slotOf_[parent];
+    }
+
+    layoutDirty_ = false;
+}
+
+void Scene::updateTransforms() {
+    if (layoutDirty_ || levelOffsets_.empty())
+        rebuildLayout();
+
+    // Results of the previous update are only valid until this one
+    if (updatedCount_ > 0) {
+        std::fill(worldDirty_.begin(), worldDirty_.end(), 0);
+        updatedCount_ = 0;
+    }
+    if (!anyDirty_)
+        return;
+
+    std::atomic<uint32_t> updated{0};
+    for (size_t level = 0; level + 1 < levelOffsets_.size(); level++) {
+        const uint32_t levelBegin = levelOffsets_[level];
+        const uint32_t levelEnd = levelOffsets_[level + 1];
+
+        // Parents are all in earlier levels, so their worldDirty_ flags are final by now
+        jobSystem_.parallelFor(levelEnd - levelBegin, UPDATE_GRAIN, [&](size_t begin, size_t end) {
+            uint32_t changed = 0;
+            for (size_t slot = levelBegin + begin; slot < levelBegin + end; slot++) {
+                const uint32_t parent = parentSlot_[slot];
+                const bool parentChanged = parent != NO_PARENT && worldDirty_[parent];
+                if (!localDirty_[slot] && !parentChanged)
+                    continue;
+
+                world_[slot] = parent == NO_PARENT ? local_[slot] : world_[parent] * local_[slot];
+                localDirty_[slot] = 0;
+                worldDirty_[slot] = 1;
+                changed++;
+            }
+            updated.fetch_add(changed, std::memory_order_relaxed);
+        });
+    }
+
+    updatedCount_ = updated.load();
+    anyDirty_ = false;
+}
@@ -0,0 +1,90 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "renderer/RenderObject.hpp"
+
+class JobSystem;
+
+inline constexpr NodeHandle INVALID_NODE = std::numeric_limits<NodeHandle>::max();
+
+/**
+ * Scene
+ *
+ * Transform hierarchy stored as structure-of-arrays, sorted by depth.
+ *
+ * Nodes live in "slots": every array is indexed by slot, and slots are ordered
+ * so that all nodes of depth d come before any node of depth d + 1. A parent
+ * therefore always sits in an earlier level than its children, and one level
+ * can be updated in parallel once the previous one is done - no recursion, no
+ * pointer chasing, and each level is a linear sweep over contiguous memory.
+ *
+ * Handles stay stable; adding nodes only marks the layout for a re-sort
+ * (counting sort by depth) at the next updateTransforms().
+ *
+ * Dirty tracking: setLocalTransform() flags the node. During the update a node
+ * is recomputed if it is flagged or its parent's world matrix changed this
+ * update. wasWorldUpdated() exposes the result until the next update, which is
+ * what culling structures and the GPU transform upload key off.
+ */
+class Scene {
+public:
+    explicit Scene(JobSystem &jobSystem);
+
+    Scene(const Scene &) = delete;
+    Scene &operator=(const Scene &) = delete;
+
+    NodeHandle createNode(NodeHandle parent = INVALID_NODE, const glm::mat4 &local = glm::mat4(1.0f));
+    void setLocalTransform(NodeHandle node, const glm::mat4 &local);
+
+    // Attaches a mesh + material to a node; a node may carry any number of them.
+    // Dynamic objects are expected to move every frame, see RenderObject::dynamic.
+    void addRenderObject(NodeHandle node, MeshHandle mesh, MaterialHandle material, bool dynamic = false);
+
+    // Propagates dirty transforms, level by level, each level across the job system
+    void updateTransforms();
+
+    [[nodiscard]] const glm::mat4 &getLocalTransform(NodeHandle node) const { return local_[slotOf_[node]]; }
+    [[nodiscard]] const glm::mat4 &getWorldTransform(NodeHandle node) const { return world_[slotOf_[node]]; }
+    [[nodiscard]] bool wasWorldUpdated(NodeHandle node) const { return worldDirty_[slotOf_[node]] != 0; }
+
+    [[nodiscard]] size_t getNodeCount() const { return slotOf_.size(); }
+    [[nodiscard]] size_t getLevelCount() const { return levelOffsets_.empty() ? 0 : levelOffsets_.size() - 1; }
+    [[nodiscard]] uint32_t getUpdatedNodeCount() const { return updatedCount_; }
+
+    [[nodiscard]] const std::vector<RenderObject> &getRenderObjects() const { return renderObjects_; }
+
+private:
+    // Re-sorts slots by depth after nodes were added
+    void rebuildLayout();
+
+    JobSystem &jobSystem_;
+
+    // Per handle
+    std::vector<uint32_t> slotOf_;
+    std::vector<NodeHandle> parentOf_;
+    std::vector<uint32_t> depthOf_;
+
+    // Per slot (depth-sorted)
+    std::vector<uint32_t> parentSlot_; // UINT32_MAX for roots
+    std::vector<glm::mat4> local_;
+    std::vector<glm::mat4> world_;
+    std::vector<uint8_t> localDirty_;
+    std::vector<uint8_t> worldDirty_;
+
+    // Level d occupies slots [levelOffsets_[d], levelOffsets_[d + 1])
+    std::vector<uint32_t> levelOffsets_;
+
+    std::vector<RenderObject> renderObjects_;
+
+    bool layoutDirty_ = false;
+    bool anyDirty_ = false;
+    uint32_t updatedCount_ = 0;
+};
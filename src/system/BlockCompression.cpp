@@ -0,0 +1,341 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "BlockCompression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace bc {
+namespace {
+
+// Principal axis of 16 texels over the first 'channels' components (power iteration).
+// Returns the mean in 'mean' and a unit axis in 'axis'.
+template <int Channels>
+void principalAxis(const uint8_t *rgba, std::array<float, Channels> &mean, std::array<float, Channels> &axis) {
+    mean.fill(0.0f);
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < Channels; c++)
+            mean[c] += rgba[i * 4 + c];
+    }
+    for (int c = 0; c < Channels; c++)
+        mean[c] /= 16.0f;
+
+    float cov[Channels][Channels] = {};
+    for (int i = 0; i < 16; i++) {
+        float d[Channels];
+        for (int c = 0; c < Channels; c++)
+            d[c] = rgba[i * 4 + c] - mean[c];
+        for (int r = 0; r < Channels; r++) {
+            for (int c = 0; c < Channels; c++)
+                cov[r][c] += d[r] * d[c];
+        }
+    }
+
+    // Start from the bounding-box diagonal, it converges in a handful of steps
+    std::array<float, Channels> v{};
+    for (int c = 0; c < Channels; c++) {
+        uint8_t lo = 255, hi = 0;
+        for (int i = 0; i < 16; i++) {
+            lo = std::min(lo, rgba[i * 4 + c]);
+            hi = std::max(hi, rgba[i * 4 + c]);
+        }
+        v[c] = static_cast<float>(hi - lo) + 1e-3f;
+    }
+
+    for (int iter = 0; iter < 8; iter++) {
+        std::array<float, Channels> next{};
+        for (int r = 0; r < Channels; r++) {
+            for (int c = 0; c < Channels; c++)
+                next[r] += cov[r][c] * v[c];
+        }
+        float len = 0.0f;
+        for (int c = 0; c < Channels; c++)
+            len += next[c] * next[c];
+        if (len < 1e-12f)
+            break;
+        len = 1.0f / std::sqrt(len);
+        for (int c = 0; c < Channels; c++)
+            v[c] = next[c] * len;
+    }
+
+    float len = 0.0f;
+    for (int c = 0; c < Channels; c++)
+        len += v[c] * v[c];
+    len = len > 0.0f ? 1.0f / std::sqrt(len) : 0.0f;
+    for (int c = 0; c < Channels; c++)
+        axis[c] = v[c] * len;
+}
+
+// Projects the block onto its principal axis and returns the two extreme points
+template <int Channels>
+void fitEndpoints(const uint8_t *rgba, std::array<float, Channels> &e0, std::array<float, Channels> &e1) {
+    std::array<float, Channels> mean, axis;
+    principalAxis<Channels>(rgba, mean, axis);
+
+    float tMin = std::numeric_limits<float>::max();
+    float tMax = std::numeric_limits<float>::lowest();
+    for (int i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < Channels; c++)
+            t += (rgba[i * 4 + c] - mean[c]) * axis[c];
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+
+    for (int c = 0; c < Channels; c++) {
+        e0[c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+        e1[c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+    }
+}
+
+uint16_t packRGB565(const std::array<float, 3> &c) {
+    const auto r = static_cast<uint16_t>(std::lround(c[0] * 31.0f / 255.0f));
+    const auto g = static_cast<uint16_t>(std::lround(c[1] * 63.0f / 255.0f));
+    const auto b = static_cast<uint16_t>(std::lround(c[2] * 31.0f / 255.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+std::array<int, 3> unpackRGB565(uint16_t c) {
+    const int r = (c >> 11) & 31;
+    const int g = (c >> 5) & 63;
+    const int b = c & 31;
+    return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+}
+
+// Little-endian bit writer for the 128-bit BC7 block
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t *out) : out_(out) { std::memset(out_, 0, 16); }
+
+    void write(uint32_t value, uint32_t bitCount) {
+        for (uint32_t i = 0; i < bitCount; i++, pos_++) {
+            if (value & (1u << i))
+                out_[pos_ >> 3] |= static_cast<uint8_t>(1u << (pos_ & 7));
+        }
+    }
+
+private:
+    uint8_t *out_;
+    uint32_t pos_ = 0;
+};
+
+constexpr std::array<int, 16> BC7_WEIGHTS4 = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// Quantize an 8-bit RGBA endpoint to 7 bits + shared p-bit, choosing the p-bit with lower error
+void quantizeBC7Endpoint(const std::array<float, 4> &e, std::array<uint32_t, 4> &q, uint32_t &pBit) {
+    float bestError = std::numeric_limits<float>::max();
+    for (uint32_t p = 0; p < 2; p++) {
+        std::array<uint32_t, 4> candidate{};
+        float error = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            const long v = std::lround((e[c] - static_cast<float>(p)) * 0.5f);
+            candidate[c] = static_cast<uint32_t>(std::clamp(v, 0L, 127L));
+            const float rebuilt = static_cast<float>((candidate[c] << 1) | p);
+            error += (rebuilt - e[c]) * (rebuilt - e[c]);
+        }
+        if (error < bestError) {
+            bestError = error;
+            q = candidate;
+            pBit = p;
+        }
+    }
+}
+
+} // namespace
+
+size_t blockBytes(BlockFormat format) {
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+size_t compressedSize(BlockFormat format, uint32_t width, uint32_t height) {
+    const size_t blocksX = (width + BLOCK_DIM - 1) / BLOCK_DIM;
+    const size_t blocksY = (height + BLOCK_DIM - 1) / BLOCK_DIM;
+    return blocksX * blocksY * blockBytes(format);
+}
+
+void encodeBC1(const uint8_t *rgba, uint8_t *out) {
+    std::array<float, 3> e0{}, e1{};
+    fitEndpoints<3>(rgba, e0, e1);
+
+    uint16_t c0 = packRGB565(e0);
+    uint16_t c1 = packRGB565(e1);
+    // c0 > c1 selects the opaque 4-color mode
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        const auto p0 = unpackRGB565(c0);
+        const auto p1 = unpackRGB565(c1);
+        std::array<std::array<int, 3>, 4> palette{};
+        for (int c = 0; c < 3; c++) {
+            palette[0][c] = p0[c];
+            palette[1][c] = p1[c];
+            palette[2][c] = (2 * p0[c] + p1[c]) / 3;
+            palette[3][c] = (p0[c] + 2 * p1[c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            int bestError = std::numeric_limits<int>::max();
+            for (int p = 0; p < 4; p++) {
+                int error = 0;
+                for (int c = 0; c < 3; c++) {
+                    const int d = rgba[i * 4 + c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (i * 2);
+        }
+    }
+
+    out[0] = static_cast<uint8_t>(c0 & 0xFF);
+    out[1] = static_cast<uint8_t>(c0 >> 8);
+    out[2] = static_cast<uint8_t>(c1 & 0xFF);
+    out[3] = static_cast<uint8_t>(c1 >> 8);
+    std::memcpy(out + 4, &indices, sizeof(indices));
+}
+
+void encodeBC4(const uint8_t *values, uint8_t *out) {
+    uint8_t lo = 255, hi = 0;
+    for (int i = 0; i < 16; i++) {
+        lo = std::min(lo, values[i]);
+        hi = std::max(hi, values[i]);
+    }
+
+    out[0] = hi;
+    out[1] = lo;
+
+    uint64_t indices = 0;
+    if (hi != lo) {
+        // a0 > a1 selects the 8-value interpolation mode
+        std::array<int, 8> palette{};
+        palette[0] = hi;
+        palette[1] = lo;
+        for (int k = 1; k < 7; k++)
+            palette[k + 1] = ((7 - k) * hi + k * lo) / 7;
+
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            int bestError = std::numeric_limits<int>::max();
+            for (int p = 0; p < 8; p++) {
+                const int error = std::abs(values[i] - palette[p]);
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(best) << (i * 3);
+        }
+    }
+
+    for (int b = 0; b < 6; b++)
+        out[2 + b] = static_cast<uint8_t>((indices >> (b * 8)) & 0xFF);
+}
+
+void encodeBC5(const uint8_t *rgba, uint8_t *out) {
+    uint8_t red[16], green[16];
+    for (int i = 0; i < 16; i++) {
+        red[i] = rgba[i * 4 + 0];
+        green[i] = rgba[i * 4 + 1];
+    }
+    encodeBC4(red, out);
+    encodeBC4(green, out + 8);
+}
+
+void encodeBC7(const uint8_t *rgba, uint8_t *out) {
+    std::array<float, 4> e0{}, e1{};
+    fitEndpoints<4>(rgba, e0, e1);
+
+    std::array<uint32_t, 4> q0{}, q1{};
+    uint32_t p0 = 0, p1 = 0;
+    quantizeBC7Endpoint(e0, q0, p0);
+    quantizeBC7Endpoint(e1, q1, p1);
+
+    std::array<int, 4> d0{}, d1{};
+    for (int c = 0; c < 4; c++) {
+        d0[c] = static_cast<int>((q0[c] << 1) | p0);
+        d1[c] = static_cast<int>((q1[c] << 1) | p1);
+    }
+
+    std::array<uint32_t, 16> indices{};
+    for (int i = 0; i < 16; i++) {
+        int bestError = std::numeric_limits<int>::max();
+        for (uint32_t w = 0; w < 16; w++) {
+            int error = 0;
+            for (int c = 0; c < 4; c++) {
+                const int v = ((64 - BC7_WEIGHTS4[w]) * d0[c] + BC7_WEIGHTS4[w] * d1[c] + 32) >> 6;
+                const int d = rgba[i * 4 + c] - v;
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                indices[i] = w;
+            }
+        }
+    }
+
+    // The anchor (texel 0) index is stored with its MSB implied zero
+    if (indices[0] & 8) {
+        std::swap(q0, q1);
+        std::swap(p0, p1);
+        for (auto &index : indices)
+            index = 15 - index;
+    }
+
+    BitWriter bits(out);
+    bits.write(1u << 6, 7); // mode 6
+    for (int c = 0; c < 4; c++) {
+        bits.write(q0[c], 7);
+        bits.write(q1[c], 7);
+    }
+    bits.write(p0, 1);
+    bits.write(p1, 1);
+    bits.write(indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        bits.write(indices[i], 4);
+}
+
+void compressBlockRows(BlockFormat format, const uint8_t *rgba, uint32_t width, uint32_t height,
+                       uint32_t blockRowBegin, uint32_t blockRowEnd, uint8_t *out) {
+    const uint32_t blocksX = (width + BLOCK_DIM - 1) / BLOCK_DIM;
+    const size_t bytesPerBlock = blockBytes(format);
+
+    uint8_t block[16 * 4];
+    for (uint32_t by = blockRowBegin; by < blockRowEnd; by++) {
+        for (uint32_t bx = 0; bx < blocksX; bx++) {
+            // Gather the 4x4 tile, clamping at the image edge
+            for (uint32_t y = 0; y < BLOCK_DIM; y++) {
+                const uint32_t sy = std::min(by * BLOCK_DIM + y, height - 1);
+                for (uint32_t x = 0; x < BLOCK_DIM; x++) {
+                    const uint32_t sx = std::min(bx * BLOCK_DIM + x, width - 1);
+                    std::memcpy(&block[(y * BLOCK_DIM + x) * 4], &rgba[(static_cast<size_t>(sy) * width + sx) * 4], 4);
+                }
+            }
+
+            uint8_t *dst = out + (static_cast<size_t>(by) * blocksX + bx) * bytesPerBlock;
+            switch (format) {
+            case BlockFormat::BC1:
+                encodeBC1(block, dst);
+                break;
+            case BlockFormat::BC5:
+                encodeBC5(block, dst);
+                break;
+            case BlockFormat::BC7:
+                encodeBC7(block, dst);
+                break;
+            }
+        }
+    }
+}
+
+} // namespace bc
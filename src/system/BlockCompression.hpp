@@ -0,0 +1,52 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * CPU block compressors for the BCn formats we ship textures in.
+ *
+ *  - BC1: RGB, 4 bpp. Opaque color maps.
+ *  - BC4: one channel, 4 bpp. Building block for BC5.
+ *  - BC5: two channels, 8 bpp. Tangent-space normal maps (RG, Z rebuilt in shader).
+ *  - BC7: RGBA, 8 bpp. Mode 6 only (one subset, 4-bit indices), which is the
+ *         mode that matters for smooth color and alpha.
+ *
+ * The encoders are single-pass bounding-box/principal-axis fits. They are meant
+ * for import time, not for real-time encoding, and favour predictable output
+ * over squeezing out the last fraction of a dB.
+ */
+namespace bc {
+
+enum class BlockFormat {
+    BC1,
+    BC5,
+    BC7,
+};
+
+inline constexpr uint32_t BLOCK_DIM = 4;
+
+[[nodiscard]] size_t blockBytes(BlockFormat format);
+
+// Size of a whole compressed level, edge blocks included
+[[nodiscard]] size_t compressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+// Single-block encoders. 'rgba' is 16 texels of RGBA8, row-major.
+void encodeBC1(const uint8_t *rgba, uint8_t *out);
+void encodeBC4(const uint8_t *values, uint8_t *out);
+void encodeBC5(const uint8_t *rgba, uint8_t *out);
+void encodeBC7(const uint8_t *rgba, uint8_t *out);
+
+/**
+ * Compresses block rows [blockRowBegin, blockRowEnd) of an RGBA8 image into 'out'.
+ * 'out' points at the start of the full compressed level. Partial edge blocks
+ * replicate the last row/column. Callers split block rows across threads.
+ */
+void compressBlockRows(BlockFormat format, const uint8_t *rgba, uint32_t width, uint32_t height,
+                       uint32_t blockRowBegin, uint32_t blockRowEnd, uint8_t *out);
+
+} // namespace bc
@@ -0,0 +1,67 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "MaterialSystem.hpp"
+
+#include <stdexcept>
+
+#include "vulkan/UploadContext.hpp"
+#include "vulkan/VulkanContext.hpp"
+
+MaterialSystem::MaterialSystem(VulkanContext &context, VmaAllocator allocator)
+    : context_(context), allocator_(allocator) {
+}
+
+MaterialSystem::~MaterialSystem() {
+    if (buffer_)
+        vmaDestroyBuffer(allocator_, buffer_, allocation_);
+}
+
+MaterialHandle MaterialSystem::addMaterial(const Material &material) {
+    materials_.push_back(material);
+    return static_cast<MaterialHandle>(materials_.size() - 1);
+}
+
+void MaterialSystem::upload(UploadContext &uploader) {
+    if (materials_.empty())
+        throw std::runtime_error("material table is empty!");
+    if (buffer_)
+        throw std::runtime_error("material table already uploaded!");
+
+    std::vector<GpuMaterial> table;
+    table.reserve(materials_.size());
+    for (const auto &material : materials_) {
+        GpuMaterial &gpu = table.emplace_back();
+        gpu.albedo = material.albedo;
+        gpu.specularStrength = material.specularStrength;
+        gpu.shininess = material.shininess;
+        gpu.roughness = material.roughness;
+        gpu.metalness = material.metalness;
+        gpu.albedoTexture = material.albedoTexture;
+        gpu.shadingModel = static_cast<uint32_t>(material.shadingModel);
+        gpu.pad0 = 0;
+        gpu.pad1 = 0;
+    }
+
+    bufferSize_ = sizeof(GpuMaterial) * table.size();
+
+    VkBufferCreateInfo bufferInfo = vk::BufferCreateInfo()
+                                    .setSize(bufferSize_)
+                                    .setUsage(vk::BufferUsageFlagBits::eStorageBuffer |
+                                              vk::BufferUsageFlagBits::eTransferDst)
+                                    .setSharingMode(vk::SharingMode::eExclusive);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VkBuffer rawBuffer;
+    if (vmaCreateBuffer(allocator_, &bufferInfo, &allocInfo, &rawBuffer, &allocation_, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create material table!");
+    }
+    buffer_ = rawBuffer;
+
+    uploader.uploadBuffer(buffer_, table.data(), bufferSize_,
+                          vk::PipelineStageFlagBits2::eVertexShader | vk::PipelineStageFlagBits2::eFragmentShader,
+                          vk::AccessFlagBits2::eShaderStorageRead);
+}
@@ -0,0 +1,95 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <vma/vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+#include "TextureSystem.hpp"
+
+class UploadContext;
+class VulkanContext;
+
+using MaterialHandle = uint32_t;
+
+/**
+ * Shading models are compiled into separate pipelines through the
+ * SHADING_MODEL specialization constant (constant_id = 0) of shaders/deferred/.
+ * The value is baked in at pipeline creation, so the shaders carry no
+ * runtime branch on it.
+ */
+enum class ShadingModel : uint32_t {
+    Gouraud = 0, // lighting per vertex
+    BlinnPhong = 1, // lighting per pixel
+    Count
+};
+
+inline constexpr size_t SHADING_MODEL_COUNT = static_cast<size_t>(ShadingModel::Count);
+
+struct Material {
+    std::string name;
+    glm::vec4 albedo{1.0f};
+    float specularStrength = 0.7f;
+    float shininess = 64.0f;
+    float roughness = 0.5f;
+    float metalness = 0.0f;
+    TextureHandle albedoTexture = 0;
+    ShadingModel shadingModel = ShadingModel::BlinnPhong;
+};
+
+// std430 mirror of 'struct Material' in shaders/include/material.glsl
+struct GpuMaterial {
+    glm::vec4 albedo;
+    float specularStrength;
+    float shininess;
+    float roughness;
+    float metalness;
+    uint32_t albedoTexture;
+    uint32_t shadingModel;
+    uint32_t pad0;
+    uint32_t pad1;
+};
+static_assert(sizeof(GpuMaterial) == 48, "GpuMaterial must match the std430 layout in material.glsl");
+
+/**
+ * MaterialSystem
+ *
+ * CPU list of materials mirrored into one storage buffer (the material table).
+ * Draws pass their MaterialHandle as a push constant and the shaders index the
+ * table with it.
+ */
+class MaterialSystem {
+public:
+    MaterialSystem(VulkanContext &context, VmaAllocator allocator);
+    ~MaterialSystem();
+
+    MaterialSystem(const MaterialSystem &) = delete;
+    MaterialSystem &operator=(const MaterialSystem &) = delete;
+
+    MaterialHandle addMaterial(const Material &material);
+
+    [[nodiscard]] const Material &getMaterial(MaterialHandle handle) const { return materials_[handle]; }
+    [[nodiscard]] size_t getMaterialCount() const { return materials_.size(); }
+
+    // Builds the GPU table from every material added so far. Call once after loading.
+    void upload(UploadContext &uploader);
+
+    [[nodiscard]] vk::Buffer getBuffer() const { return buffer_; }
+    [[nodiscard]] vk::DeviceSize getBufferSize() const { return bufferSize_; }
+
+private:
+    VulkanContext &context_;
+    VmaAllocator allocator_;
+
+    std::vector<Material> materials_;
+
+    vk::Buffer buffer_;
+    VmaAllocation allocation_ = nullptr;
+    vk::DeviceSize bufferSize_ = 0;
+};
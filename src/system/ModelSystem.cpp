@@ -4,29 +4,88 @@
 
 #include "ModelSystem.hpp"
 
+#include <algorithm>
+#include <cfloat>
+#include <filesystem>
 #include <ostream>
 
+#include "common/JobSystem.hpp"
 #include "renderer/Vertex.hpp"
 #include "tiny_obj_loader.h"
 
 struct Vertex;
 
-void ModelSystem::loadObjModel(const std::string &filePath) {
+namespace {
+// Face corners per expand / write job
+constexpr size_t IMPORT_GRAIN = 16384;
+}
+
+void ModelSystem::loadObjModel(const std::string &filePath, JobSystem &jobSystem) {
   tinyobj::attrib_t attrib;
   std::vector<tinyobj::shape_t> shapes;
   std::vector<tinyobj::material_t> materials;
   std::string warn, err;
 
+  // .mtl files and the textures they name are relative to the .obj
+  const std::string baseDir =
+      std::filesystem::path(filePath).parent_path().string() + "/";
+
   if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err,
-                        filePath.c_str())) {
+                        filePath.c_str(), baseDir.c_str())) {
     throw std::runtime_error(warn + err);
   }
 
-  std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+  for (const auto &material : materials) {
+    ModelMaterial &out = materials_.emplace_back();
+    out.name = material.name;
+    if (!material.diffuse_texname.empty()) {
+      out.diffuseTexture = baseDir + material.diffuse_texname;
+    }
+    for (int c = 0; c < 3; c++) {
+      out.diffuse[c] = material.diffuse[c];
+    }
+    out.specular = (material.specular[0] + material.specular[1] +
+                    material.specular[2]) / 3.0f;
+    if (material.shininess > 0.0f) {
+      out.shininess = material.shininess;
+    }
+  }
+
+  // Every face corner in file order; shapes are concatenated
+  std::vector<size_t> shapeFirst(shapes.size() + 1, 0);
+  for (size_t s = 0; s < shapes.size(); s++) {
+    shapeFirst[s + 1] = shapeFirst[s] + shapes[s].mesh.indices.size();
+  }
+  const size_t cornerCount = shapeFirst.back();
+  const uint32_t materialCount = static_cast<uint32_t>(materials.size());
+  const uint32_t firstVertex = static_cast<uint32_t>(vertices.size());
+
+  // The import runs as a job graph (ModelSystem.hpp):
+  //   expand[c] -> dedupe[p] (each after all expands) -> offsets -> place[p], write[c]
+  std::vector<Vertex> corners(cornerCount);
+  std::vector<size_t> cornerHash(cornerCount);
+  std::vector<uint32_t> cornerMaterial(cornerCount);
+  std::vector<uint32_t> cornerLocal(cornerCount);
+  const uint32_t partitionCount = std::max(1u, jobSystem.getThreadCount() + 1);
+  std::vector<std::vector<uint32_t>> partitionCorners(partitionCount);
+  std::vector<uint32_t> partitionOffset(partitionCount + 1, 0);
+  std::vector<uint32_t> cornerIndex(cornerCount);
+
+  auto partitionOf = [&](size_t hash) {
+    // std::hash of floats is weak in the low bits, so mix before reducing
+    return static_cast<uint32_t>((hash * 0x9E3779B97F4A7C15ull >> 32) % partitionCount);
+  };
 
-  for (const auto &shape : shapes) {
-    for (const auto &index : shape.mesh.indices) {
-      Vertex vertex{};
+  auto expand = [&](size_t begin, size_t end) {
+    size_t s = std::upper_bound(shapeFirst.begin(), shapeFirst.end(), begin) - shapeFirst.begin() - 1;
+    for (size_t c = begin; c < end; c++) {
+      while (c >= shapeFirst[s + 1]) {
+        s++;
+      }
+      const auto &mesh = shapes[s].mesh;
+      const size_t i = c - shapeFirst[s];
+      const auto &index = mesh.indices[i];
+      Vertex &vertex = corners[c];
 
       vertex.pos = {attrib.vertices[3 * index.vertex_index + 0],
                     attrib.vertices[3 * index.vertex_index + 1],
@@ -50,13 +109,127 @@ void ModelSystem::loadObjModel(const std::string &filePath) {
       }
 
       vertex.color = {1.0f, 1.0f, 1.0f};
+      cornerHash[c] = std::hash<Vertex>()(vertex);
+
+      // Triangulated by tinyobj, so face = index / 3
+      const size_t face = i / 3;
+      int materialId = face < mesh.material_ids.size() ? mesh.material_ids[face] : -1;
+      if (materialId < 0 || materialId >= static_cast<int>(materialCount)) {
+        materialId = static_cast<int>(materialCount);
+      }
+      cornerMaterial[c] = static_cast<uint32_t>(materialId);
+    }
+  };
+
+  // Equal vertices hash alike, so each partition dedupes on its own. Scanning
+  // in file order keeps the result independent of the scheduling.
+  auto dedupe = [&](uint32_t partition) {
+    std::unordered_map<Vertex, uint32_t> unique;
+    auto &owned = partitionCorners[partition];
+    for (size_t c = 0; c < cornerCount; c++) {
+      if (partitionOf(cornerHash[c]) != partition) {
+        continue;
+      }
+      auto [it, inserted] = unique.try_emplace(corners[c], static_cast<uint32_t>(owned.size()));
+      if (inserted) {
+        owned.push_back(static_cast<uint32_t>(c));
+      }
+      cornerLocal[c] = it->second;
+    }
+  };
+
+  auto offsets = [&]() {
+    for (uint32_t p = 0; p < partitionCount; p++) {
+      partitionOffset[p + 1] = partitionOffset[p] + static_cast<uint32_t>(partitionCorners[p].size());
+    }
+    vertices.resize(firstVertex + partitionOffset[partitionCount]);
+  };
+
+  auto place = [&](uint32_t partition) {
+    const auto &owned = partitionCorners[partition];
+    for (uint32_t local = 0; local < owned.size(); local++) {
+      vertices[firstVertex + partitionOffset[partition] + local] = corners[owned[local]];
+    }
+  };
+
+  auto write = [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; c++) {
+      cornerIndex[c] = firstVertex + partitionOffset[partitionOf(cornerHash[c])] + cornerLocal[c];
+    }
+  };
+
+  JobCounter done;
+  std::vector<JobSystem::Job *> expandJobs, dedupeJobs, placeJobs, writeJobs;
+  for (size_t begin = 0; begin < cornerCount; begin += IMPORT_GRAIN) {
+    const size_t end = std::min(cornerCount, begin + IMPORT_GRAIN);
+    expandJobs.push_back(jobSystem.create([&, begin, end]() { expand(begin, end); }, &done));
+    writeJobs.push_back(jobSystem.create([&, begin, end]() { write(begin, end); }, &done));
+  }
+  for (uint32_t p = 0; p < partitionCount; p++) {
+    dedupeJobs.push_back(jobSystem.create([&, p]() { dedupe(p); }, &done));
+    placeJobs.push_back(jobSystem.create([&, p]() { place(p); }, &done));
+  }
+  JobSystem::Job *offsetJob = jobSystem.create(offsets, &done);
+
+  for (JobSystem::Job *job : dedupeJobs) {
+    for (JobSystem::Job *dependency : expandJobs) {
+      jobSystem.dependsOn(job, dependency);
+    }
+    jobSystem.dependsOn(offsetJob, job);
+  }
+  for (auto *jobs : {&placeJobs, &writeJobs}) {
+    for (JobSystem::Job *job : *jobs) {
+      jobSystem.dependsOn(job, offsetJob);
+    }
+  }
+  for (auto *jobs : {&placeJobs, &writeJobs, &dedupeJobs, &expandJobs}) {
+    for (JobSystem::Job *job : *jobs) {
+      jobSystem.submit(job);
+    }
+  }
+  jobSystem.submit(offsetJob);
+  jobSystem.wait(done);
+
+  // Faces are bucketed per material so each material becomes one index range.
+  // The last bucket collects faces without a material.
+  std::vector<std::vector<uint32_t>> buckets(materials.size() + 1);
+  for (size_t c = 0; c < cornerCount; c++) {
+    buckets[cornerMaterial[c]].push_back(cornerIndex[c]);
+  }
+
+  for (size_t m = 0; m < buckets.size(); m++) {
+    if (buckets[m].empty()) {
+      continue;
+    }
 
-      if (uniqueVertices.count(vertex) == 0) {
-        uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-        vertices.push_back(vertex);
+    Submesh &submesh = submeshes_.emplace_back();
+    submesh.firstIndex = static_cast<uint32_t>(indices.size());
+    submesh.indexCount = static_cast<uint32_t>(buckets[m].size());
+    submesh.materialIndex =
+        m < materials.size() ? static_cast<int32_t>(m) : -1;
+
+    indices.insert(indices.end(), buckets[m].begin(), buckets[m].end());
+
+    // Bounds feed the scene BVH (culling, picking)
+    for (int c = 0; c < 3; c++) {
+      submesh.boundsMin[c] = FLT_MAX;
+      submesh.boundsMax[c] = -FLT_MAX;
+    }
+    for (uint32_t index : buckets[m]) {
+      const auto &pos = vertices[index].pos;
+      for (int c = 0; c < 3; c++) {
+        submesh.boundsMin[c] = std::min(submesh.boundsMin[c], pos[c]);
+        submesh.boundsMax[c] = std::max(submesh.boundsMax[c], pos[c]);
       }
+    }
+  }
 
-      indices.push_back(uniqueVertices[vertex]);
+  for (int c = 0; c < 3; c++) {
+    boundsMin_[c] = FLT_MAX;
+    boundsMax_[c] = -FLT_MAX;
+    for (const auto &submesh : submeshes_) {
+      boundsMin_[c] = std::min(boundsMin_[c], submesh.boundsMin[c]);
+      boundsMax_[c] = std::max(boundsMax_[c], submesh.boundsMax[c]);
     }
   }
 }
@@ -3,9 +3,30 @@
 //
 
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
+class JobSystem;
+
+// Material as described by the source file (.mtl); paths are already resolved
+struct ModelMaterial {
+    std::string name;
+    std::string diffuseTexture;
+    float diffuse[3] = {1.0f, 1.0f, 1.0f}; // Kd
+    float specular = 0.7f; // Ks (averaged)
+    float shininess = 64.0f; // Ns
+};
+
+// Contiguous index range drawn with one material
+struct Submesh {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    int32_t materialIndex = -1; // into getMaterials(); -1 = file had no material
+    float boundsMin[3] = {0.0f, 0.0f, 0.0f}; // object-space AABB of the range's vertices
+    float boundsMax[3] = {0.0f, 0.0f, 0.0f};
+};
 
 class ModelSystem
 {
@@ -13,5 +34,20 @@ public:
     // This function will use tinygltf to load vertices into VMA buffers
     // std::shared_ptr<ModelData> loadModel(const std::string& path);
     void loadModel(const std::string& filePath){}
-    void loadObjModel(const std::string& filePath);
+    // Parsing is serial; expanding the face corners, deduplicating the vertices
+    // (hash-partitioned) and remapping the indices run as jobs on 'jobSystem'
+    void loadObjModel(const std::string& filePath, JobSystem& jobSystem);
+
+    [[nodiscard]] const std::vector<ModelMaterial>& getMaterials() const { return materials_; }
+    [[nodiscard]] const std::vector<Submesh>& getSubmeshes() const { return submeshes_; }
+
+    // Union of the submesh bounds
+    [[nodiscard]] const float* getBoundsMin() const { return boundsMin_; }
+    [[nodiscard]] const float* getBoundsMax() const { return boundsMax_; }
+
+private:
+    std::vector<ModelMaterial> materials_;
+    std::vector<Submesh> submeshes_;
+    float boundsMin_[3] = {0.0f, 0.0f, 0.0f};
+    float boundsMax_[3] = {0.0f, 0.0f, 0.0f};
 };
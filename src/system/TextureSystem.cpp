@@ -0,0 +1,567 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "TextureSystem.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stb_image.h>
+
+#include "BlockCompression.hpp"
+#include "common/JobSystem.hpp"
+#include "vulkan/UploadContext.hpp"
+#include "vulkan/VulkanContext.hpp"
+
+namespace {
+// Bump whenever the encoders or the file layout change; old entries are then ignored
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr uint32_t CACHE_MAGIC = 0x58455442; // "BTEX"
+
+uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+const std::array<float, 256> &srgbToLinearTable() {
+    static const std::array<float, 256> table = []() {
+        std::array<float, 256> t{};
+        for (int i = 0; i < 256; i++) {
+            const float c = i / 255.0f;
+            t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return t;
+    }();
+    return table;
+}
+
+uint8_t linearToSrgb(float c) {
+    c = std::clamp(c, 0.0f, 1.0f);
+    const float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(std::lround(s * 255.0f));
+}
+
+uint8_t unitToByte(float c) {
+    return static_cast<uint8_t>(std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f));
+}
+
+std::optional<bc::BlockFormat> blockFormatOf(vk::Format format) {
+    switch (format) {
+    case vk::Format::eBc1RgbSrgbBlock:
+    case vk::Format::eBc1RgbUnormBlock:
+        return bc::BlockFormat::BC1;
+    case vk::Format::eBc5UnormBlock:
+        return bc::BlockFormat::BC5;
+    case vk::Format::eBc7SrgbBlock:
+    case vk::Format::eBc7UnormBlock:
+        return bc::BlockFormat::BC7;
+    default:
+        return std::nullopt;
+    }
+}
+
+uint32_t fullMipCount(uint32_t width, uint32_t height) {
+    return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+// Bytes of one mip level as the encoders write it: 4x4 blocks for BCn, RGBA8 otherwise
+size_t levelSize(vk::Format format, uint32_t width, uint32_t height) {
+    if (const auto blockFormat = blockFormatOf(format))
+        return bc::compressedSize(*blockFormat, width, height);
+    return static_cast<size_t>(width) * height * 4;
+}
+
+// The header is not trusted: an entry whose format isn't one of 'formats', whose mip chain is longer than
+// the extent allows or whose level sizes don't match the format is treated as a miss, so it gets decoded
+// and rewritten. Level sizes are also checked against what is left of the file before allocating.
+std::optional<TextureSystem::ImageData> readCache(const std::filesystem::path &path,
+                                                  const std::array<vk::Format, 2> &formats) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return std::nullopt;
+    uint64_t remaining = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    uint32_t header[6] = {};
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (!file || header[0] != CACHE_MAGIC || header[1] != CACHE_VERSION)
+        return std::nullopt;
+    remaining -= sizeof(header);
+
+    TextureSystem::ImageData image;
+    image.format = static_cast<vk::Format>(header[2]);
+    image.width = header[3];
+    image.height = header[4];
+    const uint32_t levelCount = header[5];
+    if (std::find(formats.begin(), formats.end(), image.format) == formats.end() || image.width == 0 ||
+        image.height == 0 || levelCount == 0 || levelCount > fullMipCount(image.width, image.height))
+        return std::nullopt;
+
+    image.levels.resize(levelCount);
+    for (uint32_t i = 0; i < levelCount; i++) {
+        const size_t expected = levelSize(image.format, std::max(1u, image.width >> i),
+                                          std::max(1u, image.height >> i));
+        uint64_t size = 0;
+        file.read(reinterpret_cast<char *>(&size), sizeof(size));
+        if (!file)
+            return std::nullopt;
+        remaining -= sizeof(size);
+        if (size != expected || size > remaining)
+            return std::nullopt;
+        remaining -= size;
+
+        image.levels[i].resize(static_cast<size_t>(size));
+        file.read(reinterpret_cast<char *>(image.levels[i].data()), static_cast<std::streamsize>(size));
+    }
+
+    if (!file)
+        return std::nullopt;
+    return image;
+}
+
+void writeCache(const std::filesystem::path &path, const TextureSystem::ImageData &image) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    // Write to a temporary name first so a crash never leaves a truncated entry behind
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return;
+
+        const uint32_t header[6] = {CACHE_MAGIC, CACHE_VERSION, static_cast<uint32_t>(image.format),
+                                    image.width, image.height, static_cast<uint32_t>(image.levels.size())};
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        for (const auto &level : image.levels) {
+            const uint64_t size = level.size();
+            file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+            file.write(reinterpret_cast<const char *>(level.data()), static_cast<std::streamsize>(size));
+        }
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+}
+}
+
+TextureSystem::TextureSystem(VulkanContext &context, VmaAllocator allocator, UploadContext &uploader,
+                             JobSystem &jobSystem, TextureSettings settings)
+    : context_(context), allocator_(allocator), uploader_(uploader), jobSystem_(jobSystem),
+      settings_(std::move(settings)) {
+    // Without BC support in the sampler there is nothing to compress into
+    if (settings_.compress && !isFormatUsable(vk::Format::eBc7SrgbBlock, vk::FormatFeatureFlagBits::eSampledImage)) {
+        std::cout << "-- Texture compression: BCn not supported, falling back to RGBA8" << std::endl;
+        settings_.compress = false;
+    }
+
+    createSampler();
+}
+
+TextureSystem::~TextureSystem() {
+    auto device = context_.getDevice();
+    for (auto &texture : textures_) {
+        if (texture.view)
+            device.destroyImageView(texture.view);
+        if (texture.image)
+            vmaDestroyImage(allocator_, texture.image, texture.allocation);
+    }
+    textures_.clear();
+
+    if (sampler_)
+        device.destroySampler(sampler_);
+}
+
+bool TextureSystem::isFormatUsable(vk::Format format, vk::FormatFeatureFlags features) const {
+    auto props = context_.getPhysicalDevice().getFormatProperties(format);
+    return (props.optimalTilingFeatures & features) == features;
+}
+
+vk::Format TextureSystem::chooseFormat(TextureUsage usage, bool hasAlpha, bool compress) const {
+    switch (usage) {
+    case TextureUsage::Color:
+        if (!compress)
+            return vk::Format::eR8G8B8A8Srgb;
+        return hasAlpha ? vk::Format::eBc7SrgbBlock : vk::Format::eBc1RgbSrgbBlock;
+    case TextureUsage::Normal:
+        return compress ? vk::Format::eBc5UnormBlock : vk::Format::eR8G8B8A8Unorm;
+    case TextureUsage::Data:
+        return compress ? vk::Format::eBc7UnormBlock : vk::Format::eR8G8B8A8Unorm;
+    }
+    return vk::Format::eR8G8B8A8Unorm;
+}
+
+std::filesystem::path TextureSystem::cachePath(const TextureDesc &desc) const {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(desc.path, ec);
+    const auto mtime = std::filesystem::last_write_time(desc.path, ec).time_since_epoch().count();
+
+    uint64_t hash = fnv1a(desc.path.data(), desc.path.size());
+    hash = fnv1a(&size, sizeof(size), hash);
+    hash = fnv1a(&mtime, sizeof(mtime), hash);
+    const uint32_t key[3] = {static_cast<uint32_t>(desc.usage), settings_.compress ? 1u : 0u, CACHE_VERSION};
+    hash = fnv1a(key, sizeof(key), hash);
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.btex", static_cast<unsigned long long>(hash));
+    return settings_.cacheDirectory / name;
+}
+
+std::vector<TextureHandle> TextureSystem::loadTextures(const std::vector<TextureDesc> &descs) {
+    const size_t count = descs.size();
+    // Block compression needs every level on the CPU, so the GPU blit chain is only an option without it
+    const bool gpuMips = settings_.mipGeneration == MipGeneration::Gpu && !settings_.compress;
+
+    std::vector<ImageData> images(count);
+    std::vector<std::filesystem::path> cacheFiles(count);
+    std::vector<uint8_t> fromCache(count, 0);
+    std::vector<uint8_t> hasAlpha(count, 0);
+    std::vector<std::string> errors(count);
+
+    for (size_t i = 0; i < count; i++) {
+        cacheFiles[i] = cachePath(descs[i]);
+    }
+
+    // 1. Cache lookup / decode, one texture per task
+    jobSystem_.parallelFor(count, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (!gpuMips) {
+                // An entry holds whichever of the two formats the alpha check picked
+                const std::array<vk::Format, 2> formats = {
+                    chooseFormat(descs[i].usage, false, settings_.compress),
+                    chooseFormat(descs[i].usage, true, settings_.compress)
+                };
+                if (auto cached = readCache(cacheFiles[i], formats)) {
+                    images[i] = std::move(*cached);
+                    fromCache[i] = 1;
+                    continue;
+                }
+            }
+
+            int width = 0, height = 0, channels = 0;
+            stbi_uc *pixels = stbi_load(descs[i].path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+            if (!pixels) {
+                errors[i] = stbi_failure_reason() ? stbi_failure_reason() : "unknown error";
+                continue;
+            }
+
+            const size_t byteCount = static_cast<size_t>(width) * height * 4;
+            images[i].width = static_cast<uint32_t>(width);
+            images[i].height = static_cast<uint32_t>(height);
+            images[i].levels.emplace_back(pixels, pixels + byteCount);
+            stbi_image_free(pixels);
+
+            for (size_t p = 3; p < byteCount; p += 4) {
+                if (images[i].levels[0][p] != 255) {
+                    hasAlpha[i] = 1;
+                    break;
+                }
+            }
+            images[i].format = chooseFormat(descs[i].usage, hasAlpha[i], false);
+        }
+    });
+
+    for (size_t i = 0; i < count; i++) {
+        if (!errors[i].empty())
+            throw std::runtime_error("failed to load texture " + descs[i].path + ": " + errors[i]);
+    }
+
+    // 2./3. Mips and compression. Each step is parallel inside a texture, so a single
+    // large texture keeps every core busy just like a batch of small ones does.
+    for (size_t i = 0; i < count; i++) {
+        if (fromCache[i] || gpuMips)
+            continue;
+
+        generateMips(images[i], descs[i].usage);
+
+        if (settings_.compress) {
+            images[i].format = chooseFormat(descs[i].usage, hasAlpha[i], true);
+            compress(images[i]);
+        }
+    }
+
+    // 4. Persist freshly built textures
+    jobSystem_.parallelFor(count, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (!fromCache[i] && !gpuMips)
+                writeCache(cacheFiles[i], images[i]);
+        }
+    });
+
+    // 5. Upload. Everything goes out in one batch; the frame that samples these
+    // textures is submitted later on the same queue, so nothing here waits.
+    std::vector<TextureHandle> handles;
+    handles.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        handles.push_back(upload(images[i], gpuMips));
+
+        std::cout << "-- Texture: " << descs[i].path << " (" << images[i].width << "x" << images[i].height
+            << ", " << vk::to_string(images[i].format) << (fromCache[i] ? ", cached" : "") << ")" << std::endl;
+    }
+
+    const uint64_t ticket = uploader_.flush();
+    for (auto handle : handles)
+        textures_[handle].uploadTicket = ticket;
+
+    return handles;
+}
+
+TextureHandle TextureSystem::createSolidColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a, TextureUsage usage) {
+    ImageData image;
+    image.width = 1;
+    image.height = 1;
+    image.format = chooseFormat(usage, a != 255, false);
+    image.levels.push_back({r, g, b, a});
+
+    const TextureHandle handle = upload(image, false);
+    textures_[handle].uploadTicket = uploader_.flush();
+    return handle;
+}
+
+bool TextureSystem::isResident(TextureHandle handle) const {
+    return uploader_.isComplete(textures_[handle].uploadTicket);
+}
+
+void TextureSystem::generateMips(ImageData &image, TextureUsage usage) const {
+    const auto &toLinear = srgbToLinearTable();
+
+    uint32_t width = image.width;
+    uint32_t height = image.height;
+
+    while (width > 1 || height > 1) {
+        const uint32_t dstWidth = std::max(1u, width / 2);
+        const uint32_t dstHeight = std::max(1u, height / 2);
+        const std::vector<uint8_t> &src = image.levels.back();
+        std::vector<uint8_t> dst(static_cast<size_t>(dstWidth) * dstHeight * 4);
+
+        auto texel = [&](uint32_t x, uint32_t y) {
+            return &src[(static_cast<size_t>(std::min(y, height - 1)) * width + std::min(x, width - 1)) * 4];
+        };
+
+        // Aim for ~16k texels per chunk so small levels don't get split pointlessly
+        const size_t rowsPerChunk = std::max<size_t>(1, 16384 / dstWidth);
+        jobSystem_.parallelFor(dstHeight, rowsPerChunk, [&](size_t rowBegin, size_t rowEnd) {
+            for (size_t y = rowBegin; y < rowEnd; y++) {
+                for (uint32_t x = 0; x < dstWidth; x++) {
+                    const uint8_t *taps[4] = {
+                        texel(x * 2, static_cast<uint32_t>(y * 2)), texel(x * 2 + 1, static_cast<uint32_t>(y * 2)),
+                        texel(x * 2, static_cast<uint32_t>(y * 2 + 1)),
+                        texel(x * 2 + 1, static_cast<uint32_t>(y * 2 + 1))
+                    };
+                    uint8_t *out = &dst[(y * dstWidth + x) * 4];
+
+                    float sum[4] = {};
+                    for (const uint8_t *t : taps) {
+                        for (int c = 0; c < 4; c++) {
+                            if (usage == TextureUsage::Color && c < 3)
+                                sum[c] += toLinear[t[c]]; // filter in linear space
+                            else if (usage == TextureUsage::Normal && c < 3)
+                                sum[c] += t[c] / 127.5f - 1.0f;
+                            else
+                                sum[c] += t[c] / 255.0f;
+                        }
+                    }
+                    for (float &s : sum)
+                        s *= 0.25f;
+
+                    if (usage == TextureUsage::Color) {
+                        for (int c = 0; c < 3; c++)
+                            out[c] = linearToSrgb(sum[c]);
+                    } else if (usage == TextureUsage::Normal) {
+                        // Averaged normals shrink; renormalise so lighting doesn't darken with distance
+                        const float len = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+                        const float inv = len > 1e-6f ? 1.0f / len : 0.0f;
+                        for (int c = 0; c < 3; c++)
+                            out[c] = unitToByte(sum[c] * inv * 0.5f + 0.5f);
+                    } else {
+                        for (int c = 0; c < 3; c++)
+                            out[c] = unitToByte(sum[c]);
+                    }
+                    out[3] = unitToByte(sum[3]);
+                }
+            }
+        });
+
+        image.levels.push_back(std::move(dst));
+        width = dstWidth;
+        height = dstHeight;
+    }
+}
+
+void TextureSystem::compress(ImageData &image) const {
+    const auto blockFormat = blockFormatOf(image.format);
+    if (!blockFormat)
+        return;
+
+    for (size_t level = 0; level < image.levels.size(); level++) {
+        const uint32_t width = std::max(1u, image.width >> level);
+        const uint32_t height = std::max(1u, image.height >> level);
+        const uint32_t blockRows = (height + bc::BLOCK_DIM - 1) / bc::BLOCK_DIM;
+
+        std::vector<uint8_t> blocks(bc::compressedSize(*blockFormat, width, height));
+        const uint8_t *rgba = image.levels[level].data();
+
+        jobSystem_.parallelFor(blockRows, 4, [&](size_t begin, size_t end) {
+            bc::compressBlockRows(*blockFormat, rgba, width, height, static_cast<uint32_t>(begin),
+                                  static_cast<uint32_t>(end), blocks.data());
+        });
+
+        image.levels[level] = std::move(blocks);
+    }
+}
+
+TextureHandle TextureSystem::upload(const ImageData &image, bool generateMipsOnGpu) {
+    // The blit chain needs linear filtering on the format; otherwise ship just the top level
+    const bool blit = generateMipsOnGpu && isFormatUsable(image.format, vk::FormatFeatureFlagBits::eBlitSrc |
+                                                                        vk::FormatFeatureFlagBits::eBlitDst |
+                                                                        vk::FormatFeatureFlagBits::eSampledImageFilterLinear);
+    const uint32_t mipLevels = blit ? fullMipCount(image.width, image.height)
+                                    : static_cast<uint32_t>(image.levels.size());
+
+    Texture texture;
+    texture.format = image.format;
+    texture.mipLevels = mipLevels;
+
+    vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+    if (blit)
+        usage |= vk::ImageUsageFlagBits::eTransferSrc;
+
+    VkImageCreateInfo imageInfo = vk::ImageCreateInfo()
+                                  .setImageType(vk::ImageType::e2D)
+                                  .setExtent({image.width, image.height, 1})
+                                  .setMipLevels(mipLevels)
+                                  .setArrayLayers(1)
+                                  .setFormat(image.format)
+                                  .setTiling(vk::ImageTiling::eOptimal)
+                                  .setInitialLayout(vk::ImageLayout::eUndefined)
+                                  .setUsage(usage)
+                                  .setSamples(vk::SampleCountFlagBits::e1)
+                                  .setSharingMode(vk::SharingMode::eExclusive);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    VkImage rawImage;
+    if (vmaCreateImage(allocator_, &imageInfo, &allocInfo, &rawImage, &texture.allocation, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture image!");
+    }
+    texture.image = rawImage;
+
+    auto viewInfo = vk::ImageViewCreateInfo()
+                    .setImage(texture.image)
+                    .setViewType(vk::ImageViewType::e2D)
+                    .setFormat(image.format)
+                    .setSubresourceRange({vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1});
+    texture.view = context_.getDevice().createImageView(viewInfo);
+
+    auto barrier = [&](vk::CommandBuffer cmd, uint32_t baseMip, uint32_t mipCount,
+                       vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+                       vk::PipelineStageFlags2 srcStage, vk::AccessFlags2 srcAccess,
+                       vk::PipelineStageFlags2 dstStage, vk::AccessFlags2 dstAccess) {
+        auto imageBarrier = vk::ImageMemoryBarrier2()
+                            .setSrcStageMask(srcStage)
+                            .setSrcAccessMask(srcAccess)
+                            .setDstStageMask(dstStage)
+                            .setDstAccessMask(dstAccess)
+                            .setOldLayout(oldLayout)
+                            .setNewLayout(newLayout)
+                            .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                            .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                            .setImage(texture.image)
+                            .setSubresourceRange({vk::ImageAspectFlagBits::eColor, baseMip, mipCount, 0, 1});
+        cmd.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(imageBarrier));
+    };
+
+    // Copy every level we have on the CPU (just level 0 on the blit path)
+    const uint32_t uploadLevels = blit ? 1 : mipLevels;
+    for (uint32_t level = 0; level < uploadLevels; level++) {
+        const auto &bytes = image.levels[level];
+        auto span = uploader_.stage(bytes.data(), bytes.size());
+        auto cmd = uploader_.getCommandBuffer();
+
+        if (level == 0) {
+            barrier(cmd, 0, mipLevels, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+                    vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+                    vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite);
+        }
+
+        auto region = vk::BufferImageCopy()
+                      .setBufferOffset(span.offset)
+                      .setImageSubresource({vk::ImageAspectFlagBits::eColor, level, 0, 1})
+                      .setImageExtent({std::max(1u, image.width >> level), std::max(1u, image.height >> level), 1});
+        cmd.copyBufferToImage(span.buffer, texture.image, vk::ImageLayout::eTransferDstOptimal, region);
+    }
+
+    auto cmd = uploader_.getCommandBuffer();
+    const auto shaderRead = vk::PipelineStageFlagBits2::eFragmentShader;
+
+    if (blit) {
+        int32_t mipWidth = static_cast<int32_t>(image.width);
+        int32_t mipHeight = static_cast<int32_t>(image.height);
+
+        for (uint32_t level = 1; level < mipLevels; level++) {
+            const auto srcStage = level == 1 ? vk::PipelineStageFlagBits2::eCopy : vk::PipelineStageFlagBits2::eBlit;
+            barrier(cmd, level - 1, 1, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+                    srcStage, vk::AccessFlagBits2::eTransferWrite,
+                    vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferRead);
+
+            const int32_t nextWidth = std::max(1, mipWidth / 2);
+            const int32_t nextHeight = std::max(1, mipHeight / 2);
+
+            auto blitRegion = vk::ImageBlit()
+                              .setSrcSubresource({vk::ImageAspectFlagBits::eColor, level - 1, 0, 1})
+                              .setSrcOffsets({vk::Offset3D{0, 0, 0}, vk::Offset3D{mipWidth, mipHeight, 1}})
+                              .setDstSubresource({vk::ImageAspectFlagBits::eColor, level, 0, 1})
+                              .setDstOffsets({vk::Offset3D{0, 0, 0}, vk::Offset3D{nextWidth, nextHeight, 1}});
+            cmd.blitImage(texture.image, vk::ImageLayout::eTransferSrcOptimal,
+                          texture.image, vk::ImageLayout::eTransferDstOptimal, blitRegion, vk::Filter::eLinear);
+
+            barrier(cmd, level - 1, 1, vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                    vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eNone,
+                    shaderRead, vk::AccessFlagBits2::eShaderSampledRead);
+
+            mipWidth = nextWidth;
+            mipHeight = nextHeight;
+        }
+
+        const auto lastStage = mipLevels == 1 ? vk::PipelineStageFlagBits2::eCopy : vk::PipelineStageFlagBits2::eBlit;
+        barrier(cmd, mipLevels - 1, 1, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                lastStage, vk::AccessFlagBits2::eTransferWrite,
+                shaderRead, vk::AccessFlagBits2::eShaderSampledRead);
+    } else {
+        barrier(cmd, 0, mipLevels, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite,
+                shaderRead, vk::AccessFlagBits2::eShaderSampledRead);
+    }
+
+    textures_.push_back(texture);
+    return static_cast<TextureHandle>(textures_.size() - 1);
+}
+
+void TextureSystem::createSampler() {
+    const float maxAnisotropy = context_.getPhysicalDevice().getProperties().limits.maxSamplerAnisotropy;
+
+    auto samplerInfo = vk::SamplerCreateInfo()
+                       .setMagFilter(vk::Filter::eLinear)
+                       .setMinFilter(vk::Filter::eLinear)
+                       .setMipmapMode(vk::SamplerMipmapMode::eLinear)
+                       .setAddressModeU(vk::SamplerAddressMode::eRepeat)
+                       .setAddressModeV(vk::SamplerAddressMode::eRepeat)
+                       .setAddressModeW(vk::SamplerAddressMode::eRepeat)
+                       .setAnisotropyEnable(true)
+                       .setMaxAnisotropy(std::min(16.0f, maxAnisotropy))
+                       .setMinLod(0.0f)
+                       .setMaxLod(VK_LOD_CLAMP_NONE);
+
+    sampler_ = context_.getDevice().createSampler(samplerInfo);
+}
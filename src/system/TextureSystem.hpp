@@ -0,0 +1,118 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <vma/vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+class JobSystem;
+class UploadContext;
+class VulkanContext;
+
+using TextureHandle = uint32_t;
+
+// What the texels mean decides both the mip filter and the compressed format
+enum class TextureUsage {
+    Color, // sRGB albedo: BC1, or BC7 when the image has alpha
+    Normal, // tangent-space normal map: BC5 (RG only)
+    Data, // linear masks (roughness, AO, ...): BC7 UNORM
+};
+
+enum class MipGeneration {
+    Cpu, // box filter on the job system; required when compressing
+    Gpu, // blit chain after upload; uncompressed textures only
+};
+
+struct TextureDesc {
+    std::string path;
+    TextureUsage usage = TextureUsage::Color;
+};
+
+struct TextureSettings {
+    bool compress = true;
+    MipGeneration mipGeneration = MipGeneration::Cpu;
+    std::filesystem::path cacheDirectory = "cache/textures";
+};
+
+/**
+ * TextureSystem
+ *
+ * Import pipeline: decode -> mips -> BCn -> disk cache -> staged upload.
+ *
+ *  1. Decode every requested file on the job system (stb_image).
+ *  2. Build the mip chain on the CPU, one level at a time, rows split across threads.
+ *  3. Compress each level to BC1/BC5/BC7, block rows split across threads.
+ *  4. Write the result to the cache so the next run skips steps 1-3.
+ *  5. Record the copies through the UploadContext; nothing waits on the GPU.
+ *
+ * Owns the GPU images, their views and the shared sampler.
+ */
+class TextureSystem {
+public:
+    TextureSystem(VulkanContext &context, VmaAllocator allocator, UploadContext &uploader, JobSystem &jobSystem,
+                  TextureSettings settings = {});
+    ~TextureSystem();
+
+    TextureSystem(const TextureSystem &) = delete;
+    TextureSystem &operator=(const TextureSystem &) = delete;
+
+    // Loads a batch of textures; handles come back in request order
+    std::vector<TextureHandle> loadTextures(const std::vector<TextureDesc> &descs);
+
+    // 1x1 texture, e.g. the white fallback for untextured materials
+    TextureHandle createSolidColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a, TextureUsage usage);
+
+    [[nodiscard]] vk::ImageView getImageView(TextureHandle handle) const { return textures_[handle].view; }
+    [[nodiscard]] vk::Sampler getSampler() const { return sampler_; }
+    [[nodiscard]] uint32_t getTextureCount() const { return static_cast<uint32_t>(textures_.size()); }
+
+    [[nodiscard]] vk::DescriptorImageInfo getDescriptorInfo(TextureHandle handle) const {
+        return {sampler_, textures_[handle].view, vk::ImageLayout::eShaderReadOnlyOptimal};
+    }
+
+    // True once the upload batch carrying this texture has finished on the GPU
+    [[nodiscard]] bool isResident(TextureHandle handle) const;
+
+    // CPU-side result of steps 1-3; also the on-disk cache payload
+    struct ImageData {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        vk::Format format = vk::Format::eUndefined;
+        std::vector<std::vector<uint8_t>> levels;
+    };
+
+private:
+    struct Texture {
+        vk::Image image;
+        VmaAllocation allocation = nullptr;
+        vk::ImageView view;
+        vk::Format format = vk::Format::eUndefined;
+        uint32_t mipLevels = 1;
+        uint64_t uploadTicket = 0;
+    };
+
+    [[nodiscard]] bool isFormatUsable(vk::Format format, vk::FormatFeatureFlags features) const;
+    [[nodiscard]] vk::Format chooseFormat(TextureUsage usage, bool hasAlpha, bool compress) const;
+    [[nodiscard]] std::filesystem::path cachePath(const TextureDesc &desc) const;
+
+    void generateMips(ImageData &image, TextureUsage usage) const;
+    void compress(ImageData &image) const;
+
+    TextureHandle upload(const ImageData &image, bool generateMipsOnGpu);
+    void createSampler();
+
+    VulkanContext &context_;
+    VmaAllocator allocator_;
+    UploadContext &uploader_;
+    JobSystem &jobSystem_;
+    TextureSettings settings_;
+
+    std::vector<Texture> textures_;
+    vk::Sampler sampler_;
+};
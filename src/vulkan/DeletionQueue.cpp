@@ -0,0 +1,34 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "DeletionQueue.hpp"
+
+#include <utility>
+
+void DeletionQueue::push(Deleter deleter) {
+    entries_.push_back({submitted_, std::move(deleter)});
+}
+
+void DeletionQueue::retire(VmaAllocator allocator, vk::Buffer buffer, VmaAllocation allocation) {
+    if (buffer)
+        push([allocator, buffer, allocation] { vmaDestroyBuffer(allocator, buffer, allocation); });
+}
+
+void DeletionQueue::retire(VmaAllocator allocator, vk::Image image, VmaAllocation allocation) {
+    if (image)
+        push([allocator, image, allocation] { vmaDestroyImage(allocator, image, allocation); });
+}
+
+void DeletionQueue::collect(uint64_t completed) {
+    // Popped before it runs: a deleter may retire something else, which lands behind it
+    while (!entries_.empty() && entries_.front().value <= completed) {
+        Deleter deleter = std::move(entries_.front().deleter);
+        entries_.pop_front();
+        deleter();
+    }
+}
+
+void DeletionQueue::flushAll() {
+    collect(UINT64_MAX);
+}
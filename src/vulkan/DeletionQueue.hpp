@@ -0,0 +1,70 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vma/vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+/**
+ * DeletionQueue
+ *
+ * Defers the destruction of GPU objects that submitted work may still use, so
+ * releasing them at runtime (swapchain recreation, render target reallocation,
+ * streaming, pipeline reloads) never has to idle the device.
+ *
+ * Keyed by the frame timeline: the renderer's graphics submissions signal a
+ * timeline semaphore with increasing values and report each one through
+ * setSubmitted(). push() tags a deleter with the latest of them, the last
+ * submission that can reference the object; collect() runs every deleter
+ * whose value the GPU has reached. Values never decrease, so the queue stays
+ * sorted and deleters run in the order they were pushed.
+ *
+ * The retire() helpers cover the common handles; anything else is a lambda.
+ */
+class DeletionQueue {
+public:
+    using Deleter = std::function<void()>;
+
+    DeletionQueue() = default;
+    // Runs whatever is left; the device must be idle by then
+    ~DeletionQueue() { flushAll(); }
+
+    DeletionQueue(const DeletionQueue &) = delete;
+    DeletionQueue &operator=(const DeletionQueue &) = delete;
+
+    // Timeline value the submission just made will signal; later pushes wait for it
+    void setSubmitted(uint64_t value) { submitted_ = value; }
+    [[nodiscard]] uint64_t getSubmitted() const { return submitted_; }
+
+    void push(Deleter deleter);
+
+    // Any vulkan.hpp handle the device destroys (pipelines, views, samplers, descriptor pools, ...)
+    template<typename Handle>
+    void retire(vk::Device device, Handle handle) {
+        if (handle)
+            push([device, handle] { device.destroy(handle); });
+    }
+    void retire(VmaAllocator allocator, vk::Buffer buffer, VmaAllocation allocation);
+    void retire(VmaAllocator allocator, vk::Image image, VmaAllocation allocation);
+
+    // The GPU has reached 'completed' on the timeline: destroys everything tagged up to it
+    void collect(uint64_t completed);
+    // Device idle: destroys everything
+    void flushAll();
+
+    [[nodiscard]] size_t size() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        uint64_t value;
+        Deleter deleter;
+    };
+
+    std::deque<Entry> entries_;
+    uint64_t submitted_ = 0;
+};
@@ -0,0 +1,89 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "DescriptorAllocator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+DescriptorAllocator::DescriptorAllocator(vk::Device device, uint32_t frameCount, std::vector<PoolRatio> ratios,
+                                         uint32_t initialSetsPerPool)
+    : device_(device), ratios_(std::move(ratios)), frames_(frameCount) {
+    for (auto &frame : frames_) {
+        frame.nextPoolSets = std::max(1u, initialSetsPerPool);
+    }
+}
+
+DescriptorAllocator::~DescriptorAllocator() {
+    for (auto &frame : frames_) {
+        for (auto pool : frame.full) {
+            device_.destroyDescriptorPool(pool);
+        }
+        for (auto pool : frame.ready) {
+            device_.destroyDescriptorPool(pool);
+        }
+    }
+}
+
+void DescriptorAllocator::beginFrame(uint32_t frameIndex) {
+    frameIndex_ = frameIndex;
+    Frame &frame = frames_[frameIndex];
+
+    // One reset per pool frees every set it handed out; the pools stay for this slot's next frames
+    frame.ready.insert(frame.ready.end(), frame.full.begin(), frame.full.end());
+    frame.full.clear();
+    for (auto pool : frame.ready) {
+        device_.resetDescriptorPool(pool);
+    }
+}
+
+vk::DescriptorSet DescriptorAllocator::allocate(vk::DescriptorSetLayout layout) {
+    Frame &frame = frames_[frameIndex_];
+
+    // At most one retry: a fresh pool holds at least one set of any layout the ratios cover
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (frame.ready.empty()) {
+            frame.ready.push_back(createPool(frame.nextPoolSets));
+            frame.nextPoolSets = std::min(frame.nextPoolSets * 2, MAX_SETS_PER_POOL);
+        }
+
+        auto allocInfo = vk::DescriptorSetAllocateInfo()
+                         .setDescriptorPool(frame.ready.back())
+                         .setSetLayouts(layout);
+        vk::DescriptorSet set;
+        const vk::Result result = device_.allocateDescriptorSets(&allocInfo, &set);
+        if (result == vk::Result::eSuccess)
+            return set;
+        if (result != vk::Result::eErrorOutOfPoolMemory && result != vk::Result::eErrorFragmentedPool)
+            break;
+
+        // Exhausted: chain the next pool
+        frame.full.push_back(frame.ready.back());
+        frame.ready.pop_back();
+    }
+    throw std::runtime_error("failed to allocate descriptor set!");
+}
+
+uint32_t DescriptorAllocator::getPoolCount() const {
+    size_t count = 0;
+    for (const auto &frame : frames_) {
+        count += frame.full.size() + frame.ready.size();
+    }
+    return static_cast<uint32_t>(count);
+}
+
+vk::DescriptorPool DescriptorAllocator::createPool(uint32_t maxSets) const {
+    std::vector<vk::DescriptorPoolSize> poolSizes;
+    poolSizes.reserve(ratios_.size());
+    for (const auto &ratio : ratios_) {
+        const auto count = static_cast<uint32_t>(std::ceil(ratio.perSet * static_cast<float>(maxSets)));
+        poolSizes.emplace_back(ratio.type, std::max(1u, count));
+    }
+
+    return device_.createDescriptorPool(vk::DescriptorPoolCreateInfo()
+                                        .setPoolSizes(poolSizes)
+                                        .setMaxSets(maxSets));
+}
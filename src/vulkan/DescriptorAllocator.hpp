@@ -0,0 +1,67 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+/**
+ * DescriptorAllocator
+ *
+ * Per-frame descriptor sets, the FrameAllocator counterpart for descriptors.
+ * Every frame in flight owns a chain of pools. allocate() takes sets from the
+ * chain's last pool and, when that pool is exhausted, chains a new one that is
+ * larger than the previous one, so any number of sets per frame works without
+ * sizing the pools up front. beginFrame() resets all of one slot's pools
+ * wholesale and keeps them for reuse. No set is ever freed individually (the
+ * pools are created without eFreeDescriptorSet), so allocation stays a cheap
+ * bump within the pool.
+ *
+ * Sets live until their slot comes round again: write and bind them in the
+ * frame that allocated them. Only needs the device, so it runs without a
+ * window or swapchain (tests/DescriptorTest.cpp).
+ */
+class DescriptorAllocator {
+public:
+    // Descriptors of 'type' a pool holds for each set it is sized for
+    struct PoolRatio {
+        vk::DescriptorType type;
+        float perSet;
+    };
+
+    DescriptorAllocator(vk::Device device, uint32_t frameCount, std::vector<PoolRatio> ratios,
+                        uint32_t initialSetsPerPool);
+    ~DescriptorAllocator();
+
+    DescriptorAllocator(const DescriptorAllocator &) = delete;
+    DescriptorAllocator &operator=(const DescriptorAllocator &) = delete;
+
+    // Resets the pools of 'frameIndex'; call only after that slot's fence has signaled
+    void beginFrame(uint32_t frameIndex);
+
+    // A set of 'layout' valid until this slot's next beginFrame()
+    [[nodiscard]] vk::DescriptorSet allocate(vk::DescriptorSetLayout layout);
+
+    // Pools across every slot; grows while a frame needs more than the existing ones hold
+    [[nodiscard]] uint32_t getPoolCount() const;
+
+private:
+    // Largest pool a chain grows to; later pools stay at this size
+    static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+    struct Frame {
+        std::vector<vk::DescriptorPool> full; // exhausted this frame
+        std::vector<vk::DescriptorPool> ready; // reset, the last one is allocated from
+        uint32_t nextPoolSets = 0; // size of the next pool the chain creates
+    };
+
+    [[nodiscard]] vk::DescriptorPool createPool(uint32_t maxSets) const;
+
+    vk::Device device_;
+    std::vector<PoolRatio> ratios_;
+    std::vector<Frame> frames_;
+    uint32_t frameIndex_ = 0;
+};
@@ -0,0 +1,74 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "DescriptorLayoutCache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+uint64_t fnv1a(uint64_t value, uint64_t hash) {
+    for (int i = 0; i < 8; i++) {
+        hash ^= (value >> (i * 8)) & 0xff;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+}
+
+bool DescriptorLayoutCache::Key::operator==(const Key &other) const {
+    if (flags != other.flags || bindings.size() != other.bindings.size())
+        return false;
+    for (size_t i = 0; i < bindings.size(); i++) {
+        const auto &a = bindings[i];
+        const auto &b = other.bindings[i];
+        // Immutable samplers by pointer: equal arrays at different addresses only cost a second layout
+        if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+            a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags ||
+            a.pImmutableSamplers != b.pImmutableSamplers)
+            return false;
+    }
+    return true;
+}
+
+size_t DescriptorLayoutCache::KeyHash::operator()(const Key &key) const {
+    uint64_t hash = fnv1a(static_cast<uint32_t>(key.flags), 0xcbf29ce484222325ull);
+    for (const auto &binding : key.bindings) {
+        hash = fnv1a(binding.binding, hash);
+        hash = fnv1a(static_cast<uint64_t>(binding.descriptorType) << 32 | binding.descriptorCount, hash);
+        hash = fnv1a(static_cast<uint32_t>(binding.stageFlags), hash);
+    }
+    return static_cast<size_t>(hash);
+}
+
+DescriptorLayoutCache::DescriptorLayoutCache(vk::Device device) : device_(device) {
+}
+
+DescriptorLayoutCache::~DescriptorLayoutCache() {
+    for (const auto &[key, layout] : layouts_) {
+        device_.destroyDescriptorSetLayout(layout);
+    }
+}
+
+vk::DescriptorSetLayout DescriptorLayoutCache::get(const vk::DescriptorSetLayoutCreateInfo &createInfo) {
+    if (createInfo.pNext != nullptr)
+        throw std::runtime_error("descriptor layout cache: pNext chains are not supported!");
+
+    Key key{createInfo.flags, {createInfo.pBindings, createInfo.pBindings + createInfo.bindingCount}};
+    std::sort(key.bindings.begin(), key.bindings.end(),
+              [](const auto &a, const auto &b) { return a.binding < b.binding; });
+
+    std::lock_guard lock(mutex_);
+    if (const auto it = layouts_.find(key); it != layouts_.end())
+        return it->second;
+
+    const auto layout = device_.createDescriptorSetLayout(createInfo);
+    layouts_.emplace(std::move(key), layout);
+    return layout;
+}
+
+size_t DescriptorLayoutCache::size() const {
+    std::lock_guard lock(mutex_);
+    return layouts_.size();
+}
@@ -0,0 +1,53 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+/**
+ * DescriptorLayoutCache
+ *
+ * One vk::DescriptorSetLayout per distinct set of bindings. get() returns the
+ * layout already created for an identical create info - same flags, same
+ * bindings in any order - and creates it only the first time, so systems can
+ * describe the layouts they need without coordinating who owns them, and
+ * pipelines built against them stay compatible. The cache owns every layout
+ * and destroys them with itself; callers never destroy one.
+ *
+ * Create infos with a pNext chain (binding flags) are not supported.
+ */
+class DescriptorLayoutCache {
+public:
+    explicit DescriptorLayoutCache(vk::Device device);
+    ~DescriptorLayoutCache();
+
+    DescriptorLayoutCache(const DescriptorLayoutCache &) = delete;
+    DescriptorLayoutCache &operator=(const DescriptorLayoutCache &) = delete;
+
+    [[nodiscard]] vk::DescriptorSetLayout get(const vk::DescriptorSetLayoutCreateInfo &createInfo);
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    struct Key {
+        vk::DescriptorSetLayoutCreateFlags flags;
+        std::vector<vk::DescriptorSetLayoutBinding> bindings; // sorted by binding number
+
+        bool operator==(const Key &other) const;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+
+    vk::Device device_;
+    mutable std::mutex mutex_;
+    std::unordered_map<Key, vk::DescriptorSetLayout, KeyHash> layouts_;
+};
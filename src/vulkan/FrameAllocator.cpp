@@ -0,0 +1,73 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "FrameAllocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VulkanContext.hpp"
+#include "common/config.hpp"
+
+namespace {
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+}
+
+FrameAllocator::FrameAllocator(VulkanContext &context, VmaAllocator allocator, vk::DeviceSize bytesPerFrame)
+    : allocator_(allocator) {
+    const auto limits = context.getPhysicalDevice().getProperties().limits;
+    alignment_ = std::max({limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment,
+                           limits.nonCoherentAtomSize, vk::DeviceSize(16)});
+
+    // Every region starts aligned, so offsets stay valid dynamic offsets across frames
+    bytesPerFrame_ = alignUp(bytesPerFrame, alignment_);
+
+    // Read by the compute queue too when there is one (light binning)
+    const auto families = context.getSharingFamilies();
+    VkBufferCreateInfo bufferInfo = vk::BufferCreateInfo()
+                                    .setSize(bytesPerFrame_ * engine::MAX_FRAMES_IN_FLIGHT)
+                                    .setUsage(vk::BufferUsageFlagBits::eUniformBuffer |
+                                              vk::BufferUsageFlagBits::eStorageBuffer)
+                                    .setSharingMode(families.size() > 1 ? vk::SharingMode::eConcurrent
+                                                                        : vk::SharingMode::eExclusive)
+                                    .setQueueFamilyIndices(families);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VkBuffer rawBuffer;
+    VmaAllocationInfo resultInfo{};
+    if (vmaCreateBuffer(allocator_, &bufferInfo, &allocInfo, &rawBuffer, &allocation_, &resultInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create frame allocator buffer!");
+    }
+    buffer_ = rawBuffer;
+    mapped_ = static_cast<uint8_t *>(resultInfo.pMappedData);
+}
+
+FrameAllocator::~FrameAllocator() {
+    if (buffer_)
+        vmaDestroyBuffer(allocator_, buffer_, allocation_);
+}
+
+void FrameAllocator::beginFrame(uint32_t frameIndex) {
+    frameBase_ = bytesPerFrame_ * frameIndex;
+    head_ = frameBase_;
+}
+
+FrameAllocator::Allocation FrameAllocator::allocate(vk::DeviceSize size) {
+    const vk::DeviceSize offset = alignUp(head_, alignment_);
+    if (offset + size > frameBase_ + bytesPerFrame_) {
+        throw std::runtime_error("frame allocator out of memory, raise FRAME_ALLOCATOR_SIZE!");
+    }
+    head_ = offset + size;
+    return {mapped_ + offset, offset, size};
+}
+
+void FrameAllocator::flush() {
+    if (head_ > frameBase_)
+        vmaFlushAllocation(allocator_, allocation_, frameBase_, alignUp(head_, alignment_) - frameBase_);
+}
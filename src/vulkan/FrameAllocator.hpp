@@ -0,0 +1,71 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vma/vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+class VulkanContext;
+
+/**
+ * FrameAllocator
+ *
+ * Per-frame linear (bump) allocator for transient GPU data: view uniforms,
+ * per-object transforms, anything that is rewritten every frame.
+ *
+ * One persistently mapped buffer is split into MAX_FRAMES_IN_FLIGHT regions.
+ * beginFrame() rewinds the region of the slot whose fence has just been waited
+ * on, so nothing is ever freed individually and nothing the GPU still reads is
+ * overwritten. Allocations are addressed by their offset into the one buffer,
+ * which is what the dynamic UBO/SSBO descriptors take as dynamic offset.
+ */
+class FrameAllocator {
+public:
+    struct Allocation {
+        void *data = nullptr;
+        vk::DeviceSize offset = 0; // from the start of getBuffer(), i.e. the dynamic offset
+        vk::DeviceSize size = 0;
+    };
+
+    FrameAllocator(VulkanContext &context, VmaAllocator allocator, vk::DeviceSize bytesPerFrame);
+    ~FrameAllocator();
+
+    FrameAllocator(const FrameAllocator &) = delete;
+    FrameAllocator &operator=(const FrameAllocator &) = delete;
+
+    // Rewinds the region of 'frameIndex'; call only after that slot's fence has signaled
+    void beginFrame(uint32_t frameIndex);
+
+    // Aligned to the device's UBO/SSBO offset alignment, so the result can be bound as either
+    Allocation allocate(vk::DeviceSize size);
+
+    template<typename T>
+    T *allocate(size_t count, vk::DeviceSize &offset) {
+        Allocation allocation = allocate(sizeof(T) * count);
+        offset = allocation.offset;
+        return static_cast<T *>(allocation.data);
+    }
+
+    // Makes this frame's writes visible to the device (no-op on coherent memory)
+    void flush();
+
+    [[nodiscard]] vk::Buffer getBuffer() const { return buffer_; }
+    [[nodiscard]] vk::DeviceSize getBytesPerFrame() const { return bytesPerFrame_; }
+    [[nodiscard]] vk::DeviceSize getBytesUsed() const { return head_ - frameBase_; }
+
+private:
+    VmaAllocator allocator_;
+
+    vk::Buffer buffer_;
+    VmaAllocation allocation_ = nullptr;
+    uint8_t *mapped_ = nullptr;
+
+    vk::DeviceSize bytesPerFrame_;
+    vk::DeviceSize alignment_ = 256;
+    vk::DeviceSize frameBase_ = 0;
+    vk::DeviceSize head_ = 0;
+};
@@ -0,0 +1,98 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+/**
+ * Layout of the main render pass, shared by RenderPass (attachments and
+ * subpasses), SwapChain (images and framebuffers), GraphicsPipeline (blend
+ * states) and the renderer (clear values, input attachment descriptors).
+ *
+ * Subpass 0 fills the G-buffer, subpass 1 reads it back as input attachments
+ * and writes the lit result to the scene color target, which the upscale or
+ * temporal resolve pass then samples into the swapchain image. The geometry
+ * subpass also writes the motion vectors the resolve needs (TemporalAA.hpp). All targets are allocated at
+ * MAX_RENDER_SCALE x the swapchain size and only the top-left render area is
+ * used (dynamic resolution, see DynamicResolution). The G-buffer and the
+ * depth/stencil buffer never leave the render pass: they are cleared or
+ * discarded on load, discarded on store, and created transient, so tilers keep
+ * them in on-chip memory. The exception is ambient occlusion (engine::SSAO): it
+ * needs depth and normals of the whole screen before lighting, so while it is on
+ * the pass runs as two compatible halves (RenderPass::getGeometryRenderPass /
+ * getLightingRenderPass) with the G-buffer stored in between. The targets are
+ * reallocated when it is switched (SwapChain::setStoreGBuffer).
+ *
+ * Stencil holds the pixel's shading model + 1 (0 = background), so each
+ * lighting pipeline only touches the pixels of its own model.
+ *
+ * Encoding, 12 bytes per pixel plus depth/stencil (shaders/include/gbuffer.glsl),
+ * plus the 4-byte velocity target, which is stored for the resolve:
+ *   ALBEDO    RGBA8 sRGB      rgb = albedo (lit color for Gouraud)
+ *   NORMAL    RG16 float      octahedral world normal, [-1, 1]
+ *   MATERIAL  RGBA8 uint      r = roughness, g = metalness (x255), ba = material ID (16 bit)
+ * Position is rebuilt from depth, which lighting also reads as an input attachment;
+ * everything else about the surface comes from the material table by ID.
+ */
+namespace gbuffer {
+    enum Attachment : uint32_t {
+        SCENE_COLOR = 0,
+        DEPTH = 1,
+        ALBEDO = 2,
+        NORMAL = 3,
+        MATERIAL = 4,
+        VELOCITY = 5, // not an input of the lighting subpass
+        ATTACHMENT_COUNT
+    };
+
+    enum Subpass : uint32_t {
+        GEOMETRY_SUBPASS = 0,
+        LIGHTING_SUBPASS = 1,
+    };
+
+    // Color targets of the geometry subpass, in location order (= input_attachment_index in lighting)
+    inline constexpr uint32_t TARGET_COUNT = 3;
+    inline constexpr std::array<Attachment, TARGET_COUNT> TARGETS = {ALBEDO, NORMAL, MATERIAL};
+    inline constexpr std::array<vk::Format, TARGET_COUNT> TARGET_FORMATS = {
+        vk::Format::eR8G8B8A8Srgb,
+        vk::Format::eR16G16Sfloat, // always renderable, unlike RG16 unorm
+        vk::Format::eR8G8B8A8Uint,
+    };
+
+    // The geometry subpass writes velocity after the targets
+    inline constexpr uint32_t VELOCITY_LOCATION = TARGET_COUNT;
+
+    // Lit output of both main passes, sampled by the post chain and the upscale / resolve pass at set 1 binding
+    // SCENE_COLOR_BINDING, after the visibility input attachment. Linear HDR radiance: exposure and the tonemap
+    // are only applied on the way to the swapchain (see PostProcess.hpp).
+    inline constexpr vk::Format SCENE_COLOR_FORMAT = vk::Format::eR16G16B16A16Sfloat;
+    inline constexpr uint32_t SCENE_COLOR_BINDING = 5;
+
+    // Depth follows the targets as input attachment / set 1 binding TARGET_COUNT
+    inline constexpr uint32_t DEPTH_INPUT_INDEX = TARGET_COUNT;
+    inline constexpr uint32_t INPUT_COUNT = TARGET_COUNT + 1;
+
+    // What the lighting subpass outputs; anything but LIT shows one decoded G-buffer channel
+    enum class DebugView : uint32_t {
+        LIT = 0,
+        ALBEDO,
+        NORMAL,
+        ROUGHNESS,
+        METALNESS,
+        MATERIAL_ID,
+        DEPTH,
+        POSITION, // reconstructed from depth
+        COUNT
+    };
+
+    inline const char *debugViewName(DebugView view) {
+        constexpr std::array<const char *, static_cast<size_t>(DebugView::COUNT)> names = {
+            "lit", "albedo", "normal", "roughness", "metalness", "material id", "depth", "position"
+        };
+        return names[static_cast<size_t>(view)];
+    }
+}
@@ -0,0 +1,63 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "GpuTimer.hpp"
+
+#include <array>
+#include <iostream>
+
+#include "VulkanContext.hpp"
+
+GpuTimer::GpuTimer(VulkanContext &context, uint32_t frameCount)
+    : device_(context.getDevice()), recorded_(frameCount, 0) {
+    const auto physicalDevice = context.getPhysicalDevice();
+    const auto indices = context.findQueueFamilies(physicalDevice);
+    const uint32_t validBits = physicalDevice.getQueueFamilyProperties()[indices.graphicsFamily.value()]
+                               .timestampValidBits;
+    if (validBits == 0) {
+        std::cout << "-- GPU timer: no timestamp support on the graphics queue" << std::endl;
+        return;
+    }
+    validMask_ = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    periodNs_ = physicalDevice.getProperties().limits.timestampPeriod;
+
+    auto poolInfo = vk::QueryPoolCreateInfo()
+                    .setQueryType(vk::QueryType::eTimestamp)
+                    .setQueryCount(2 * frameCount);
+    queryPool_ = device_.createQueryPool(poolInfo);
+}
+
+GpuTimer::~GpuTimer() {
+    if (queryPool_)
+        device_.destroyQueryPool(queryPool_);
+}
+
+void GpuTimer::begin(vk::CommandBuffer commandBuffer, uint32_t frame) {
+    if (!queryPool_)
+        return;
+    commandBuffer.resetQueryPool(queryPool_, 2 * frame, 2);
+    commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, queryPool_, 2 * frame);
+    recorded_[frame] = 1;
+}
+
+void GpuTimer::end(vk::CommandBuffer commandBuffer, uint32_t frame) const {
+    if (!queryPool_)
+        return;
+    commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, queryPool_, 2 * frame + 1);
+}
+
+std::optional<float> GpuTimer::read(uint32_t frame) const {
+    if (!queryPool_ || !recorded_[frame])
+        return std::nullopt;
+
+    // No wait flag: a frame that was skipped (swapchain recreation) reports not ready instead of blocking
+    std::array<uint64_t, 2> ticks{};
+    const vk::Result result = device_.getQueryPoolResults(queryPool_, 2 * frame, 2, sizeof(ticks), ticks.data(),
+                                                          sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+    if (result != vk::Result::eSuccess)
+        return std::nullopt;
+
+    const uint64_t elapsed = ((ticks[1] & validMask_) - (ticks[0] & validMask_)) & validMask_;
+    return static_cast<float>(static_cast<double>(elapsed) * periodNs_ * 1e-6);
+}
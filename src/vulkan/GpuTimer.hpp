@@ -0,0 +1,48 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+class VulkanContext;
+
+/**
+ * GpuTimer
+ *
+ * GPU time of a frame's command buffer from two timestamp queries, one pair
+ * per frame in flight. begin()/end() bracket the commands of a slot; read()
+ * returns what that slot measured the last time it ran, so call it after the
+ * slot's fence has signaled and before begin() resets the queries. Results
+ * arrive MAX_FRAMES_IN_FLIGHT frames late, which is fine for a controller.
+ *
+ * Queues without timestamp support make every read() empty.
+ */
+class GpuTimer {
+public:
+    GpuTimer(VulkanContext &context, uint32_t frameCount);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    // Outside any render pass: resets the slot's queries and writes the start timestamp
+    void begin(vk::CommandBuffer commandBuffer, uint32_t frame);
+    void end(vk::CommandBuffer commandBuffer, uint32_t frame) const;
+
+    // Milliseconds between begin() and end() of the slot's last submission, if it has completed
+    [[nodiscard]] std::optional<float> read(uint32_t frame) const;
+
+    [[nodiscard]] bool isSupported() const { return static_cast<bool>(queryPool_); }
+
+private:
+    vk::Device device_;
+    vk::QueryPool queryPool_;
+    float periodNs_ = 1.0f; // nanoseconds per tick
+    uint64_t validMask_ = ~0ull;
+    std::vector<uint8_t> recorded_; // per slot: queries written at least once
+};
@@ -0,0 +1,280 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "ShaderLibrary.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Set by CMake to the compiler the build step uses
+#ifndef GLSLANG_VALIDATOR
+#define GLSLANG_VALIDATOR "glslangValidator"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+// How often the watcher checks for stop requests (and, without inotify, for changes)
+constexpr int POLL_INTERVAL_MS = 100;
+// Changes are batched until none arrive for this long, so an editor's save is seen once, complete
+constexpr int DEBOUNCE_MS = 50;
+
+uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::optional<std::vector<char>> readBytes(const fs::path &path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+        return std::nullopt;
+    std::vector<char> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    return bytes;
+}
+
+bool isShaderSource(const fs::path &path) {
+    const auto extension = path.extension();
+    return extension == ".vert" || extension == ".frag" || extension == ".comp";
+}
+
+bool isShaderFile(const fs::path &path) {
+    return isShaderSource(path) || path.extension() == ".glsl";
+}
+}
+
+ShaderLibrary::ShaderLibrary(fs::path sourceDir, fs::path cacheDir)
+    : sourceDir_(std::move(sourceDir)), cacheDir_(std::move(cacheDir)) {
+    fs::create_directories(cacheDir_);
+}
+
+ShaderLibrary::~ShaderLibrary() {
+    stopping_.store(true);
+    if (watcher_.joinable())
+        watcher_.join();
+#ifdef __linux__
+    if (inotify_ >= 0)
+        close(inotify_);
+#endif
+}
+
+std::optional<std::vector<char>> ShaderLibrary::compile(const std::string &name,
+                                                        const std::vector<std::string> &defines) {
+    // The key covers everything the compiler reads, so a hit is always what it would produce
+    uint64_t hash = fnv1a(name.data(), name.size());
+    for (const auto &source : collectSources(name)) {
+        const auto bytes = readBytes(sourceDir_ / source);
+        if (!bytes)
+            throw std::runtime_error("failed to open shader: " + source);
+        hash = fnv1a(source.data(), source.size(), hash);
+        hash = fnv1a(bytes->data(), bytes->size(), hash);
+    }
+    for (const auto &define : defines) {
+        hash = fnv1a(define.data(), define.size() + 1, hash); // with the terminator, so "AB","C" != "A","BC"
+    }
+
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+    const fs::path cached = cacheDir_ / (std::string(key) + ".spv");
+    if (auto spirv = readBytes(cached))
+        return spirv;
+
+    // Written next to the entry and renamed into place, so a failed or interrupted compile never leaves one
+    const fs::path output = cacheDir_ / (std::string(key) + ".tmp");
+    const fs::path log = cacheDir_ / (std::string(key) + ".log");
+    std::ostringstream command;
+    command << '"' << GLSLANG_VALIDATOR << "\" -V -I\"" << (sourceDir_ / "include").string() << '"';
+    for (const auto &define : defines) {
+        command << " -D" << define;
+    }
+    command << " \"" << (sourceDir_ / name).string() << "\" -o \"" << output.string() << "\" > \""
+            << log.string() << "\" 2>&1";
+    std::string commandLine = command.str();
+#ifdef _WIN32
+    commandLine = '"' + commandLine + '"'; // cmd /c strips the outer pair
+#endif
+
+    const int status = std::system(commandLine.c_str());
+    std::error_code ignored;
+    if (status != 0) {
+        const auto message = readBytes(log).value_or(std::vector<char>{});
+        std::cerr << "-- Shader compile failed: " << name << "\n" << std::string(message.begin(), message.end());
+        fs::remove(output, ignored);
+        fs::remove(log, ignored);
+        return std::nullopt;
+    }
+    fs::remove(log, ignored);
+    fs::rename(output, cached);
+    return readBytes(cached);
+}
+
+std::vector<std::string> ShaderLibrary::collectSources(const std::string &file) const {
+    std::vector<std::string> sources = {file};
+    std::unordered_set<std::string> seen = {file};
+    for (size_t next = 0; next < sources.size(); next++) {
+        // Copied: 'sources' grows below
+        const std::string current = sources[next];
+        std::ifstream stream(sourceDir_ / current);
+        std::string line;
+        while (std::getline(stream, line)) {
+            const size_t start = line.find_first_not_of(" \t");
+            if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+                continue;
+            const size_t open = line.find('"', start);
+            const size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos)
+                continue;
+            const auto resolved = resolveInclude(current, line.substr(open + 1, close - open - 1));
+            if (resolved && seen.insert(*resolved).second)
+                sources.push_back(*resolved);
+        }
+    }
+    return sources;
+}
+
+std::optional<std::string> ShaderLibrary::resolveInclude(const std::string &includingFile,
+                                                         const std::string &include) const {
+    // Like glslangValidator: next to the including file first, then the -I directory
+    for (const fs::path &candidate : {fs::path(includingFile).parent_path() / include, fs::path("include") / include}) {
+        if (fs::exists(sourceDir_ / candidate))
+            return candidate.lexically_normal().generic_string();
+    }
+    return std::nullopt;
+}
+
+std::vector<std::string> ShaderLibrary::affectedShaders(const std::vector<std::string> &changed) const {
+    const std::unordered_set<std::string> changedSet(changed.begin(), changed.end());
+    std::vector<std::string> shaders;
+    for (const auto &entry : fs::recursive_directory_iterator(sourceDir_)) {
+        if (!entry.is_regular_file() || !isShaderSource(entry.path()))
+            continue;
+        const std::string name = fs::relative(entry.path(), sourceDir_).generic_string();
+        const auto sources = collectSources(name);
+        if (std::any_of(sources.begin(), sources.end(),
+                        [&](const std::string &source) { return changedSet.contains(source); })) {
+            shaders.push_back(name);
+        }
+    }
+    return shaders;
+}
+
+void ShaderLibrary::watch(ReloadCallback callback) {
+    callback_ = std::move(callback);
+
+#ifdef __linux__
+    inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_ < 0) {
+        std::cerr << "-- Shader hot reload: inotify unavailable" << std::endl;
+        return;
+    }
+    // Saves land as a finished write or as a rename over the file, depending on the editor
+    constexpr uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+    auto addWatch = [&](const fs::path &dir) {
+        const int watch = inotify_add_watch(inotify_, dir.c_str(), mask);
+        if (watch >= 0)
+            watchDirs_[watch] = fs::relative(dir, sourceDir_).generic_string();
+    };
+    addWatch(sourceDir_);
+    for (const auto &entry : fs::recursive_directory_iterator(sourceDir_)) {
+        if (entry.is_directory())
+            addWatch(entry.path());
+    }
+#else
+    for (const auto &entry : fs::recursive_directory_iterator(sourceDir_)) {
+        if (entry.is_regular_file())
+            writeTimes_[fs::relative(entry.path(), sourceDir_).generic_string()] = entry.last_write_time();
+    }
+#endif
+
+    std::cout << "-- Shader hot reload: watching " << sourceDir_.string() << std::endl;
+    watcher_ = std::thread(&ShaderLibrary::watchLoop, this);
+}
+
+void ShaderLibrary::watchLoop() {
+    while (!stopping_.load()) {
+        std::vector<std::string> changed = waitForChanges();
+        // Editors write swap and backup files next to the shaders
+        std::erase_if(changed, [](const std::string &file) { return !isShaderFile(file); });
+        if (changed.empty())
+            continue;
+
+        const auto shaders = affectedShaders(changed);
+        SpirvMap compiled;
+        for (const auto &name : shaders) {
+            try {
+                if (auto spirv = compile(name))
+                    compiled.emplace(name, std::move(*spirv));
+            } catch (const std::exception &e) {
+                std::cerr << "-- Shader compile failed: " << e.what() << std::endl;
+            }
+        }
+        std::cout << "-- Shader hot reload: " << compiled.size() << " of " << shaders.size() << " recompiled"
+                  << std::endl;
+        if (!compiled.empty())
+            callback_(compiled);
+    }
+}
+
+std::vector<std::string> ShaderLibrary::waitForChanges() {
+    std::vector<std::string> changed;
+#ifdef __linux__
+    while (!stopping_.load()) {
+        pollfd descriptor{inotify_, POLLIN, 0};
+        const int ready = poll(&descriptor, 1, changed.empty() ? POLL_INTERVAL_MS : DEBOUNCE_MS);
+        if (ready <= 0) {
+            if (!changed.empty())
+                break; // quiet long enough
+            continue;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(inotify_, buffer, sizeof(buffer))) > 0) {
+            for (const char *cursor = buffer; cursor < buffer + length;) {
+                const auto *event = reinterpret_cast<const inotify_event *>(cursor);
+                const auto dir = watchDirs_.find(event->wd);
+                if (event->len > 0 && dir != watchDirs_.end())
+                    changed.push_back((fs::path(dir->second) / event->name).lexically_normal().generic_string());
+                cursor += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+#else
+    while (!stopping_.load() && changed.empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+        std::error_code error;
+        for (const auto &entry : fs::recursive_directory_iterator(sourceDir_, error)) {
+            if (!entry.is_regular_file())
+                continue;
+            const std::string name = fs::relative(entry.path(), sourceDir_).generic_string();
+            const auto writeTime = entry.last_write_time(error);
+            auto [it, inserted] = writeTimes_.try_emplace(name, writeTime);
+            if (inserted || it->second != writeTime) {
+                it->second = writeTime;
+                changed.push_back(name);
+            }
+        }
+    }
+#endif
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
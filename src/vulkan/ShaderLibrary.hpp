@@ -0,0 +1,77 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * ShaderLibrary
+ *
+ * Runtime side of the shader build. The CMake step still compiles every shader
+ * ahead of time; this recompiles them while the app runs, so edits show up
+ * without a restart.
+ *
+ * - compile(): SPIR-V for one shader, by name relative to the source dir
+ *   ("deferred/lighting.frag"). The cache key hashes the source, every file it
+ *   includes (transitively) and the defines, so an unchanged shader - or one
+ *   changed back - is never compiled twice, across runs as well. Misses run
+ *   the same glslangValidator the build uses.
+ * - watch(): a background thread waits for changes under the source dir
+ *   (inotify on Linux, modification times elsewhere), recompiles every shader
+ *   the changed files reach through #include and hands the results to the
+ *   callback, still on that thread. A shader that fails to compile is logged
+ *   and left out, so the last working version stays in use.
+ */
+class ShaderLibrary {
+public:
+    // Shader name -> SPIR-V, for every shader recompiled after one batch of changes
+    using SpirvMap = std::unordered_map<std::string, std::vector<char>>;
+    using ReloadCallback = std::function<void(const SpirvMap &)>;
+
+    ShaderLibrary(std::filesystem::path sourceDir, std::filesystem::path cacheDir);
+    ~ShaderLibrary();
+
+    ShaderLibrary(const ShaderLibrary &) = delete;
+    ShaderLibrary &operator=(const ShaderLibrary &) = delete;
+
+    // nullopt if the shader does not compile; the compiler output is logged
+    std::optional<std::vector<char>> compile(const std::string &name, const std::vector<std::string> &defines = {});
+
+    void watch(ReloadCallback callback);
+
+private:
+    // 'file' and everything it includes, as paths relative to the source dir; 'file' comes first
+    [[nodiscard]] std::vector<std::string> collectSources(const std::string &file) const;
+    [[nodiscard]] std::optional<std::string> resolveInclude(const std::string &includingFile,
+                                                            const std::string &include) const;
+    // The shaders (not include files) that 'changed' reaches, directly or through #include
+    [[nodiscard]] std::vector<std::string> affectedShaders(const std::vector<std::string> &changed) const;
+
+    void watchLoop();
+    // Blocks until files under the source dir change (or stop), then returns them relative to it
+    std::vector<std::string> waitForChanges();
+
+    std::filesystem::path sourceDir_;
+    std::filesystem::path cacheDir_;
+
+    ReloadCallback callback_;
+    std::thread watcher_;
+    std::atomic<bool> stopping_{false};
+
+#ifdef __linux__
+    int inotify_ = -1;
+    std::unordered_map<int, std::string> watchDirs_; // inotify watch -> directory relative to the source dir
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes_;
+#endif
+};
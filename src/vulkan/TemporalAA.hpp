@@ -0,0 +1,47 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+/**
+ * Layout of the temporal resolve pass, which replaces the upscale pass while
+ * temporal anti-aliasing is on (Renderer::setTemporalAA).
+ *
+ * Every frame is rendered with a different sub-pixel jitter (Camera::haltonJitter)
+ * and both main passes also write a motion vector per pixel: the change in
+ * screen UV since the previous frame, from the previous view-projection and
+ * each object's previous model matrix. The resolve runs at output resolution:
+ * it filters the jittered scene color around each output pixel, reprojects the
+ * history with the motion vectors, clips the history to the color range of the
+ * current neighborhood and blends the two. Below a render scale of 1 the same
+ * filter does the upsampling, and the accumulated history fills in the detail
+ * a single frame is missing.
+ *
+ * The result goes to the swapchain image and to one of two history images; the
+ * other one is the history being read. Both hold output-resolution pixels; the
+ * history images may be larger than the swapchain (they are only reallocated
+ * when it outgrows them, see SwapChain::recreate), so the resolve addresses them
+ * in output pixels and only the top-left output extent is valid.
+ */
+namespace taa {
+    enum Attachment : uint32_t {
+        OUTPUT = 0, // swapchain image
+        HISTORY = 1, // written this frame, read by the next
+        ATTACHMENT_COUNT
+    };
+
+    inline constexpr uint32_t HISTORY_COUNT = 2;
+    inline constexpr vk::Format HISTORY_FORMAT = vk::Format::eR16G16B16A16Sfloat;
+
+    // Motion vectors, in UV units (current - previous); one more stored target of both main passes
+    inline constexpr vk::Format VELOCITY_FORMAT = vk::Format::eR16G16Sfloat;
+
+    // Set 1 bindings, after the scene color (gbuffer::SCENE_COLOR_BINDING); the history is an array of
+    // HISTORY_COUNT, indexed with ViewUniforms::temporal.w
+    inline constexpr uint32_t VELOCITY_BINDING = 6;
+    inline constexpr uint32_t HISTORY_BINDING = 7;
+}
@@ -0,0 +1,227 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#include "UploadContext.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "VulkanContext.hpp"
+
+namespace {
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+}
+
+UploadContext::UploadContext(VulkanContext &context, VmaAllocator allocator, vk::DeviceSize stagingCapacity)
+    : context_(context), allocator_(allocator), capacity_(stagingCapacity) {
+    auto queueFamilyIndices = context_.findQueueFamilies(context_.getPhysicalDevice());
+
+    auto poolInfo = vk::CommandPoolCreateInfo()
+                    .setFlags(vk::CommandPoolCreateFlagBits::eTransient |
+                              vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
+                    .setQueueFamilyIndex(queueFamilyIndices.graphicsFamily.value());
+    commandPool_ = context_.getDevice().createCommandPool(poolInfo);
+
+    VkBufferCreateInfo bufferInfo = vk::BufferCreateInfo()
+                                    .setSize(capacity_)
+                                    .setUsage(vk::BufferUsageFlagBits::eTransferSrc)
+                                    .setSharingMode(vk::SharingMode::eExclusive);
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VkBuffer rawBuffer;
+    VmaAllocationInfo resultInfo{};
+    if (vmaCreateBuffer(allocator_, &bufferInfo, &allocInfo, &rawBuffer, &stagingAllocation_, &resultInfo) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload staging ring!");
+    }
+    stagingBuffer_ = rawBuffer;
+    stagingMapped_ = static_cast<uint8_t *>(resultInfo.pMappedData);
+}
+
+UploadContext::~UploadContext() {
+    auto device = context_.getDevice();
+
+    // Anything still recorded but never flushed is simply dropped
+    if (hasOpenBatch_) {
+        openBatch_.commandBuffer.end();
+        for (auto &[buffer, allocation] : openBatch_.dedicated)
+            vmaDestroyBuffer(allocator_, buffer, allocation);
+        freeCommandBuffers_.push_back(openBatch_.commandBuffer);
+        hasOpenBatch_ = false;
+    }
+
+    while (!inFlight_.empty())
+        retireOldest(true);
+
+    for (auto fence : freeFences_)
+        device.destroyFence(fence);
+
+    if (stagingBuffer_)
+        vmaDestroyBuffer(allocator_, stagingBuffer_, stagingAllocation_);
+
+    // Frees every command buffer allocated from it
+    device.destroyCommandPool(commandPool_);
+}
+
+void UploadContext::openBatch() {
+    if (hasOpenBatch_)
+        return;
+
+    if (freeCommandBuffers_.empty()) {
+        auto allocInfo = vk::CommandBufferAllocateInfo()
+                         .setCommandPool(commandPool_)
+                         .setLevel(vk::CommandBufferLevel::ePrimary)
+                         .setCommandBufferCount(1);
+        freeCommandBuffers_.push_back(context_.getDevice().allocateCommandBuffers(allocInfo)[0]);
+    }
+
+    openBatch_ = Batch{};
+    openBatch_.commandBuffer = freeCommandBuffers_.back();
+    freeCommandBuffers_.pop_back();
+    openBatch_.ticket = nextTicket_++;
+
+    openBatch_.commandBuffer.reset();
+    openBatch_.commandBuffer.begin(vk::CommandBufferBeginInfo().setFlags(
+        vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    hasOpenBatch_ = true;
+}
+
+vk::CommandBuffer UploadContext::getCommandBuffer() {
+    openBatch();
+    return openBatch_.commandBuffer;
+}
+
+UploadContext::StagingSpan UploadContext::stage(const void *data, vk::DeviceSize size, vk::DeviceSize alignment) {
+    openBatch();
+
+    // Too big for the ring: give it its own staging buffer that dies with the batch
+    if (size > capacity_) {
+        VkBufferCreateInfo bufferInfo = vk::BufferCreateInfo()
+                                        .setSize(size)
+                                        .setUsage(vk::BufferUsageFlagBits::eTransferSrc)
+                                        .setSharingMode(vk::SharingMode::eExclusive);
+        VmaAllocationCreateInfo allocInfo{};
+        allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+        allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+        VkBuffer rawBuffer;
+        VmaAllocation allocation;
+        VmaAllocationInfo resultInfo{};
+        if (vmaCreateBuffer(allocator_, &bufferInfo, &allocInfo, &rawBuffer, &allocation, &resultInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create dedicated staging buffer!");
+        }
+        std::memcpy(resultInfo.pMappedData, data, static_cast<size_t>(size));
+        openBatch_.dedicated.emplace_back(rawBuffer, allocation);
+        return {rawBuffer, 0};
+    }
+
+    while (true) {
+        vk::DeviceSize offset = alignUp(head_, alignment);
+        vk::DeviceSize padding = offset - head_;
+        if (offset + size > capacity_) {
+            // Skip the tail end of the ring and wrap around
+            padding = capacity_ - head_;
+            offset = 0;
+        }
+
+        if (usedBytes_ + padding + size <= capacity_) {
+            std::memcpy(stagingMapped_ + offset, data, static_cast<size_t>(size));
+            head_ = offset + size;
+            usedBytes_ += padding + size;
+            openBatch_.ringBytes += padding + size;
+            return {stagingBuffer_, offset};
+        }
+
+        // Ring is full. Reclaim finished work first; only block as a last resort.
+        collect();
+        if (usedBytes_ + padding + size <= capacity_)
+            continue;
+
+        if (inFlight_.empty()) {
+            // Only the open batch holds ring space: push it out so it can be waited on
+            flush();
+            openBatch();
+        }
+        retireOldest(true);
+    }
+}
+
+void UploadContext::uploadBuffer(vk::Buffer dst, const void *data, vk::DeviceSize size,
+                                 vk::PipelineStageFlags2 dstStage, vk::AccessFlags2 dstAccess) {
+    auto span = stage(data, size);
+    auto cmd = getCommandBuffer();
+
+    cmd.copyBuffer(span.buffer, dst, vk::BufferCopy(span.offset, 0, size));
+
+    auto barrier = vk::BufferMemoryBarrier2()
+                   .setSrcStageMask(vk::PipelineStageFlagBits2::eCopy)
+                   .setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+                   .setDstStageMask(dstStage)
+                   .setDstAccessMask(dstAccess)
+                   .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                   .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                   .setBuffer(dst)
+                   .setOffset(0)
+                   .setSize(size);
+    cmd.pipelineBarrier2(vk::DependencyInfo().setBufferMemoryBarriers(barrier));
+}
+
+uint64_t UploadContext::flush() {
+    if (!hasOpenBatch_)
+        return nextTicket_ - 1;
+
+    openBatch_.commandBuffer.end();
+
+    if (freeFences_.empty()) {
+        freeFences_.push_back(context_.getDevice().createFence(vk::FenceCreateInfo()));
+    }
+    openBatch_.fence = freeFences_.back();
+    freeFences_.pop_back();
+
+    auto submitInfo = vk::SubmitInfo().setCommandBuffers(openBatch_.commandBuffer);
+    context_.getGraphicsQueue().submit(submitInfo, openBatch_.fence);
+
+    const uint64_t ticket = openBatch_.ticket;
+    inFlight_.push_back(std::move(openBatch_));
+    hasOpenBatch_ = false;
+    return ticket;
+}
+
+bool UploadContext::isComplete(uint64_t ticket) {
+    collect();
+    return ticket <= completedTicket_;
+}
+
+void UploadContext::collect() {
+    while (!inFlight_.empty() &&
+           context_.getDevice().getFenceStatus(inFlight_.front().fence) == vk::Result::eSuccess) {
+        retireOldest(false);
+    }
+}
+
+void UploadContext::retireOldest(bool wait) {
+    auto device = context_.getDevice();
+    Batch &batch = inFlight_.front();
+
+    if (wait) {
+        (void)device.waitForFences(batch.fence, true, UINT64_MAX);
+    }
+
+    device.resetFences(batch.fence);
+    freeFences_.push_back(batch.fence);
+    freeCommandBuffers_.push_back(batch.commandBuffer);
+
+    for (auto &[buffer, allocation] : batch.dedicated)
+        vmaDestroyBuffer(allocator_, buffer, allocation);
+
+    // Batches retire in submission order, so ring space frees up FIFO as well
+    usedBytes_ -= batch.ringBytes;
+    completedTicket_ = batch.ticket;
+    inFlight_.pop_front();
+}
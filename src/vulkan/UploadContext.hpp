@@ -0,0 +1,95 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <vma/vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+class VulkanContext;
+
+/**
+ * UploadContext
+ *
+ * Non-blocking CPU -> GPU transfer path.
+ *
+ * A single persistently mapped staging ring is carved up in FIFO order. Copies
+ * are recorded into an open batch; flush() submits the batch with its own fence
+ * and returns a ticket immediately. Ring space is recycled once a batch's fence
+ * has signaled (collect()), so the CPU only ever waits when the ring is full.
+ *
+ * Batches are submitted on the graphics queue, so any later frame submission is
+ * ordered after them; the barriers recorded with each copy make the data visible.
+ */
+class UploadContext {
+public:
+    struct StagingSpan {
+        vk::Buffer buffer;
+        vk::DeviceSize offset = 0;
+    };
+
+    UploadContext(VulkanContext &context, VmaAllocator allocator, vk::DeviceSize stagingCapacity = 64ull << 20);
+    ~UploadContext();
+
+    UploadContext(const UploadContext &) = delete;
+    UploadContext &operator=(const UploadContext &) = delete;
+
+    // Copies 'data' into staging memory owned by the open batch.
+    // May roll the open batch over when the ring is full, so fetch the command
+    // buffer with getCommandBuffer() *after* staging.
+    StagingSpan stage(const void *data, vk::DeviceSize size, vk::DeviceSize alignment = 16);
+
+    // Command buffer of the open batch; copies recorded here go out with the next flush()
+    vk::CommandBuffer getCommandBuffer();
+
+    // Staged buffer upload including the barrier towards its first consumer
+    void uploadBuffer(vk::Buffer dst, const void *data, vk::DeviceSize size,
+                      vk::PipelineStageFlags2 dstStage, vk::AccessFlags2 dstAccess);
+
+    // Submits the open batch (if any) and returns the ticket that identifies it
+    uint64_t flush();
+
+    [[nodiscard]] bool isComplete(uint64_t ticket);
+
+    // Recycles ring space and command buffers of every batch the GPU has finished
+    void collect();
+
+private:
+    struct Batch {
+        vk::CommandBuffer commandBuffer;
+        vk::Fence fence;
+        vk::DeviceSize ringBytes = 0;
+        uint64_t ticket = 0;
+        // Oversized uploads that did not fit into the ring
+        std::vector<std::pair<vk::Buffer, VmaAllocation>> dedicated;
+    };
+
+    void openBatch();
+    void retireOldest(bool wait);
+
+    VulkanContext &context_;
+    VmaAllocator allocator_;
+
+    vk::CommandPool commandPool_;
+    std::vector<vk::CommandBuffer> freeCommandBuffers_;
+    std::vector<vk::Fence> freeFences_;
+
+    // Staging ring
+    vk::Buffer stagingBuffer_;
+    VmaAllocation stagingAllocation_ = nullptr;
+    uint8_t *stagingMapped_ = nullptr;
+    vk::DeviceSize capacity_;
+    vk::DeviceSize head_ = 0;
+    vk::DeviceSize usedBytes_ = 0;
+
+    bool hasOpenBatch_ = false;
+    Batch openBatch_;
+    std::deque<Batch> inFlight_;
+
+    uint64_t nextTicket_ = 1;
+    uint64_t completedTicket_ = 0;
+};
@@ -0,0 +1,40 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+/**
+ * Layout of the visibility-buffer render pass, the alternative to the
+ * G-buffer pass (GBuffer.hpp) selected at runtime with Renderer::setRenderMode.
+ *
+ * Subpass 0 rasterizes the scene and stores only which triangle covers each
+ * pixel: (instance index, primitive ID), 8 bytes whatever the material, plus the
+ * motion vector for the temporal resolve (TemporalAA.hpp). Subpass 1
+ * runs once per pixel: it refetches the triangle from the shared vertex/index
+ * buffers, intersects the view ray with it for barycentrics and shades. As in
+ * the G-buffer pass, stencil holds the shading model + 1 and the visibility
+ * target and depth are transient.
+ */
+namespace visbuffer {
+    enum Attachment : uint32_t {
+        SCENE_COLOR = 0,
+        DEPTH = 1,
+        VISIBILITY = 2, // x = ObjectBuffer index (gl_InstanceIndex), y = gl_PrimitiveID
+        VELOCITY = 3, // stored, location 1 of the geometry subpass
+        ATTACHMENT_COUNT
+    };
+
+    enum Subpass : uint32_t {
+        GEOMETRY_SUBPASS = 0,
+        MATERIAL_SUBPASS = 1,
+    };
+
+    inline constexpr vk::Format FORMAT = vk::Format::eR32G32Uint;
+
+    // Set 1 binding of the visibility input attachment; 0..3 belong to the G-buffer pass
+    inline constexpr uint32_t INPUT_BINDING = 4;
+}
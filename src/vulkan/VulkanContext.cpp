@@ -1,6 +1,8 @@
 #include "VulkanContext.hpp"
 #include "Validation.hpp"
 #include "swap_chain.hpp"
+#include "common/config.hpp"
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <set>
@@ -167,6 +169,9 @@ void VulkanContext::createLogicalDevice() {
 
     std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+    graphicsFamily_ = indices.graphicsFamily.value();
+    computeFamily_ = engine::ASYNC_COMPUTE && indices.computeFamily ? *indices.computeFamily : graphicsFamily_;
+    uniqueQueueFamilies.insert(computeFamily_);
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -176,14 +181,54 @@ void VulkanContext::createLogicalDevice() {
     vk::PhysicalDeviceVulkan13Features features13;
     features13.setDynamicRendering(true).setSynchronization2(true);
 
+    // Optional features of the visibility-buffer mode
+    auto supported = physicalDevice_.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+    const bool nonUniformIndexing = supported.get<vk::PhysicalDeviceVulkan12Features>()
+                                    .shaderSampledImageArrayNonUniformIndexing;
+    const bool primitiveId = supported.get<vk::PhysicalDeviceFeatures2>().features.geometryShader;
+    visibilityBufferSupported_ = nonUniformIndexing && primitiveId;
+
+    vk::PhysicalDeviceVulkan12Features features12;
+    features12.setShaderSampledImageArrayNonUniformIndexing(nonUniformIndexing)
+              .setTimelineSemaphore(true) // the frame timeline that deferred deletion is keyed by
+              .setPNext(&features13);
+
+    // Optional: waiting on presents for low-latency pacing. The feature structs are only chained (and
+    // queried) when both extensions exist.
+    std::vector<const char *> extensions = deviceExtensions;
+    vk::PhysicalDevicePresentIdFeaturesKHR presentIdFeatures;
+    vk::PhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures;
+    if (hasDeviceExtension(physicalDevice_, VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+        hasDeviceExtension(physicalDevice_, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+        auto presentSupport = physicalDevice_.getFeatures2<vk::PhysicalDeviceFeatures2,
+                                                           vk::PhysicalDevicePresentIdFeaturesKHR,
+                                                           vk::PhysicalDevicePresentWaitFeaturesKHR>();
+        presentWaitSupported_ = presentSupport.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId &&
+                                presentSupport.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+    }
+    if (presentWaitSupported_) {
+        extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        presentWaitFeatures.setPresentWait(true).setPNext(&features12);
+        presentIdFeatures.setPresentId(true).setPNext(&presentWaitFeatures);
+    }
+
     vk::PhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.setSamplerAnisotropy(true);
+    // Block-compressed textures; TextureSystem falls back to RGBA8 when this is off
+    deviceFeatures.setTextureCompressionBC(physicalDevice_.getFeatures().textureCompressionBC);
+    // Material textures are picked from a sampler array with a push-constant index (required, isDeviceSuitable)
+    deviceFeatures.setShaderSampledImageArrayDynamicIndexing(true);
+    // Shadow casters in front of a cascade's near plane are clamped rather than clipped (CascadedShadowMap)
+    deviceFeatures.setDepthClamp(physicalDevice_.getFeatures().depthClamp);
+    // gl_PrimitiveID in the visibility-buffer geometry pass
+    deviceFeatures.setGeometryShader(primitiveId);
 
     vk::DeviceCreateInfo createInfo;
     createInfo.setQueueCreateInfos(queueCreateInfos)
               .setPEnabledFeatures(&deviceFeatures)
-              .setPEnabledExtensionNames(deviceExtensions)
-              .setPNext(&features13);
+              .setPEnabledExtensionNames(extensions)
+              .setPNext(presentWaitSupported_ ? static_cast<void *>(&presentIdFeatures) : &features12);
 
     if (validation_->isEnabled()) {
         createInfo.setPEnabledLayerNames(validation_->getValidationLayers());
@@ -196,6 +241,20 @@ void VulkanContext::createLogicalDevice() {
 
     graphicsQueue_ = vkDevice_.getQueue(indices.graphicsFamily.value(), 0);
     presentQueue_ = vkDevice_.getQueue(indices.presentFamily.value(), 0);
+    computeQueue_ = vkDevice_.getQueue(computeFamily_, 0);
+    std::cout << "-- Present wait: " << (presentWaitSupported_ ? "available" : "unavailable, pacing on GPU completion")
+              << std::endl;
+    if (hasAsyncCompute()) {
+        std::cout << "-- Async compute: queue family " << computeFamily_ << std::endl;
+    } else {
+        std::cout << "-- Async compute: unavailable, compute runs on the graphics queue" << std::endl;
+    }
+}
+
+std::vector<uint32_t> VulkanContext::getSharingFamilies() const {
+    if (hasAsyncCompute())
+        return {graphicsFamily_, computeFamily_};
+    return {graphicsFamily_};
 }
 
 bool VulkanContext::isDeviceSuitable(vk::PhysicalDevice device) const {
@@ -209,24 +268,35 @@ bool VulkanContext::isDeviceSuitable(vk::PhysicalDevice device) const {
                                                         static_cast<VkSurfaceKHR>(surface_));
     }
 
-    return indices.isComplete() && extensionsSupported && swapChainAdequate;
+    // The material table picks textures from a sampler array with a push-constant index; there is no
+    // fallback for that, so devices without it are not used
+    const bool dynamicTextureIndexing = device.getFeatures().shaderSampledImageArrayDynamicIndexing;
+
+    return indices.isComplete() && extensionsSupported && swapChainAdequate && dynamicTextureIndexing;
 }
 
 QueueFamilyIndices VulkanContext::findQueueFamilies(vk::PhysicalDevice device) const {
     QueueFamilyIndices indices;
     auto queueFamilies = device.getQueueFamilyProperties();
 
-    int i = 0;
+    // First family of each kind. The compute one must lack graphics: queues of the graphics family usually
+    // feed the same hardware queue, so nothing would overlap
+    uint32_t i = 0;
     for (const auto &queueFamily : queueFamilies) {
-        if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics) {
+        if (!indices.graphicsFamily && (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)) {
             indices.graphicsFamily = i;
         }
 
-        if (device.getSurfaceSupportKHR(i, surface_)) {
+        if (!indices.presentFamily && device.getSurfaceSupportKHR(i, surface_)) {
             indices.presentFamily = i;
         }
 
-        if (indices.isComplete())
+        if (!indices.computeFamily && (queueFamily.queueFlags & vk::QueueFlagBits::eCompute) &&
+            !(queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)) {
+            indices.computeFamily = i;
+        }
+
+        if (indices.isComplete() && indices.computeFamily)
             break;
         i++;
     }
@@ -257,6 +327,14 @@ bool VulkanContext::checkDeviceExtensionSupport(vk::PhysicalDevice device) {
     return requiredExtensions.empty();
 }
 
+bool VulkanContext::hasDeviceExtension(vk::PhysicalDevice device, const char *name) {
+    for (const auto &extension : device.enumerateDeviceExtensionProperties()) {
+        if (std::strcmp(extension.extensionName, name) == 0)
+            return true;
+    }
+    return false;
+}
+
 std::vector<const char *> VulkanContext::getRequiredExtensions() const {
     uint32_t glfwExtensionCount = 0;
     const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
@@ -267,15 +345,22 @@ std::vector<const char *> VulkanContext::getRequiredExtensions() const {
 }
 
 uint32_t VulkanContext::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const {
+    if (auto index = tryFindMemoryType(typeFilter, properties))
+        return *index;
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+std::optional<uint32_t> VulkanContext::tryFindMemoryType(uint32_t typeFilter,
+                                                         vk::MemoryPropertyFlags properties) const {
     vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice_.getMemoryProperties();
 
-    for (uint32_t i = 0; i < memProperties.memoryTypes.size(); i++) {
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
         if ((typeFilter & (1 << i)) &&
             (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
             return i;
         }
     }
-    throw std::runtime_error("failed to find suitable memory type!");
+    return std::nullopt;
 }
 
 vk::Format VulkanContext::findSupportedFormat(
@@ -296,6 +381,31 @@ vk::Format VulkanContext::findSupportedFormat(
     throw std::runtime_error("failed to find supported format!");
 }
 
+vk::Format VulkanContext::findShadowMapFormat(bool &linearFiltering) const {
+    // 16 bits are plenty for tight shadow depth ranges and halve the bandwidth;
+    // a format with linear filtering wins over one without
+    const vk::FormatFeatureFlags required = vk::FormatFeatureFlagBits::eDepthStencilAttachment |
+                                            vk::FormatFeatureFlagBits::eSampledImage |
+                                            vk::FormatFeatureFlagBits::eTransferSrc |
+                                            vk::FormatFeatureFlagBits::eTransferDst;
+    std::optional<vk::Format> chosen;
+    linearFiltering = false;
+    for (vk::Format candidate : {vk::Format::eD16Unorm, vk::Format::eD32Sfloat}) {
+        const auto features = physicalDevice_.getFormatProperties(candidate).optimalTilingFeatures;
+        if ((features & required) != required)
+            continue;
+        const bool linear = static_cast<bool>(features & vk::FormatFeatureFlagBits::eSampledImageFilterLinear);
+        if (!chosen || (linear && !linearFiltering)) {
+            chosen = candidate;
+            linearFiltering = linear;
+        }
+    }
+    if (!chosen) {
+        throw std::runtime_error("failed to find a shadow map format!");
+    }
+    return *chosen;
+}
+
 void VulkanContext::DestroyDebugUtilsMessengerEXT(VkDebugUtilsMessengerEXT debugMessenger) const {
     auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(
         instance_, "vkDestroyDebugUtilsMessengerEXT");
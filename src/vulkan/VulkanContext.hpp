@@ -28,7 +28,7 @@ class Validation;
  *  - VkSurfaceKHR (window-system integration; required for device selection)
  *  - VkPhysicalDevice (GPU selection)
  *  - VkDevice (logical device)
- *  - VkQueue(s) (graphics / present)
+ *  - VkQueue(s) (graphics / present, and a dedicated compute queue where the GPU has one)
  *  - Validation layer setup and lifetime management
  *
  * This class intentionally does NOT own short-lived or resize-dependent
@@ -38,6 +38,7 @@ class Validation;
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> computeFamily; // compute without graphics: runs beside the graphics queue
 
     bool isComplete() {
         return graphicsFamily.has_value() && presentFamily.has_value();
@@ -74,7 +75,19 @@ public:
 
     [[nodiscard]] vk::Queue getGraphicsQueue() const { return graphicsQueue_; }
     [[nodiscard]] vk::Queue getPresentQueue() const { return presentQueue_; }
+    // Async compute: a queue of a compute-only family, so its work overlaps the graphics queue's. Without
+    // one (or with ASYNC_COMPUTE off) this is the graphics queue and hasAsyncCompute() is false.
+    [[nodiscard]] vk::Queue getComputeQueue() const { return computeQueue_; }
+    [[nodiscard]] uint32_t getComputeFamily() const { return computeFamily_; }
+    [[nodiscard]] uint32_t getGraphicsFamily() const { return graphicsFamily_; }
+    [[nodiscard]] bool hasAsyncCompute() const { return computeFamily_ != graphicsFamily_; }
+    // Families that share resources written or read on both queues; buffers created with more than one
+    // use concurrent sharing instead of ownership transfers
+    [[nodiscard]] std::vector<uint32_t> getSharingFamilies() const;
     [[nodiscard]] uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const;
+    // Same search without the throw, for optional properties such as eLazilyAllocated
+    [[nodiscard]] std::optional<uint32_t> tryFindMemoryType(uint32_t typeFilter,
+                                                            vk::MemoryPropertyFlags properties) const;
 
     // vk::Format findSupportedFormat(const std::vector<VkFormat> &candidates, VkImageTiling tiling,
     //                              VkFormatFeatureFlags features);
@@ -82,6 +95,17 @@ public:
                                    vk::ImageTiling tiling,
                                    vk::FormatFeatureFlags features) const;
 
+    // Depth format for sampled shadow maps (D16 preferred). 'linearFiltering' reports whether
+    // comparison samplers may filter it linearly (hardware PCF).
+    vk::Format findShadowMapFormat(bool &linearFiltering) const;
+
+    // Visibility-buffer shading needs per-pixel material texture indices (non-uniform indexing) and
+    // gl_PrimitiveID in fragment shaders (geometryShader); both are enabled when present
+    [[nodiscard]] bool supportsVisibilityBuffer() const { return visibilityBufferSupported_; }
+
+    // VK_KHR_present_id + VK_KHR_present_wait: presents carry ids the CPU can wait on (FramePacer)
+    [[nodiscard]] bool supportsPresentWait() const { return presentWaitSupported_; }
+
 private:
     GLFWwindow *window_;
 
@@ -96,6 +120,12 @@ private:
     vk::SurfaceKHR surface_; // vulkan.hpp wrapper for VkSurfaceKHR
     vk::Queue graphicsQueue_; // Returned by vkDevice_.getQueue()
     vk::Queue presentQueue_;
+    vk::Queue computeQueue_;
+    uint32_t graphicsFamily_ = 0;
+    uint32_t computeFamily_ = 0;
+
+    bool visibilityBufferSupported_ = false;
+    bool presentWaitSupported_ = false;
 
     // Debugging
     vk::DebugUtilsMessengerEXT debugMessenger_;
@@ -120,5 +150,6 @@ private:
     void createSurface();
 
     static bool checkDeviceExtensionSupport(vk::PhysicalDevice device);
+    static bool hasDeviceExtension(vk::PhysicalDevice device, const char *name);
     int rateDeviceSuitability(vk::PhysicalDevice device);
 };
\ No newline at end of file
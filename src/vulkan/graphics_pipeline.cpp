@@ -1,10 +1,21 @@
 #include "graphics_pipeline.hpp"
+#include "DeletionQueue.hpp"
+#include "GBuffer.hpp"
 #include "swap_chain.hpp"
+#include "TemporalAA.hpp"
+#include "VisibilityBuffer.hpp"
 #include "VulkanContext.hpp"
+#include "renderer/Uniform.hpp"
 #include "renderer/Vertex.hpp"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
+// Set by CMake to the shaders the build compiles; hot reload watches and recompiles them
+#ifndef SHADER_SOURCE_DIR
+#define SHADER_SOURCE_DIR "shaders"
+#endif
+
 namespace {
 std::vector<char> readFile(const std::string &filename) {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
@@ -19,28 +30,191 @@ std::vector<char> readFile(const std::string &filename) {
 }
 }
 
+std::vector<vk::Pipeline> GraphicsPipeline::Pipelines::handles() const {
+    std::vector<vk::Pipeline> all;
+    auto add = [&](vk::Pipeline pipeline) {
+        if (pipeline)
+            all.push_back(pipeline);
+    };
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        add(geometry[i]);
+        add(lighting[i]);
+        add(visibility[i]);
+        add(visibilityMaterial[i]);
+    }
+    add(shadow);
+    add(upscale);
+    add(temporal);
+    add(lightBinning);
+    for (auto pipeline : ambientOcclusion) {
+        add(pipeline);
+    }
+    add(postProcess);
+    return all;
+}
+
+std::vector<vk::Pipeline> GraphicsPipeline::Pipelines::replacedBy(const Pipelines &next) const {
+    std::vector<vk::Pipeline> replaced = handles();
+    const std::vector<vk::Pipeline> kept = next.handles();
+    std::erase_if(replaced, [&](vk::Pipeline pipeline) {
+        return std::find(kept.begin(), kept.end(), pipeline) != kept.end();
+    });
+    return replaced;
+}
+
 GraphicsPipeline::~GraphicsPipeline() {
     std::cerr << "[Destructor] GraphicsPipeline starting..." << std::endl;
+    // Stops the watcher, so no rebuild runs while the pipelines go
+    shaderLibrary_.reset();
     auto device = context_.getDevice();
-    device.destroyPipeline(graphicsPipeline_);
+    for (auto pipeline : pipelines_.handles()) {
+        device.destroyPipeline(pipeline);
+    }
+    if (pending_) {
+        for (auto pipeline : pending_->replacedBy(pipelines_)) {
+            device.destroyPipeline(pipeline);
+        }
+    }
     std::cerr << "[Destructor] GraphicsPipeline-graphicsPipeline_..." << std::endl;
     device.destroyPipelineLayout(pipelineLayout_);
     std::cerr << "[Destructor] GraphicsPipeline-pipelineLayout_..." << std::endl;
 
 }
 
-void GraphicsPipeline::createGraphicsPipeline() {
-    auto vertShaderCode = readFile("shaders/blinn-phong/blinn-phong.vert.spv");
-    auto fragShaderCode = readFile("shaders/blinn-phong/blinn-phong.frag.spv");
+std::vector<char> GraphicsPipeline::loadShader(const std::string &name) const {
+    // Recompiled since startup, else as the build step compiled it
+    if (auto it = reloaded_.find(name); it != reloaded_.end())
+        return it->second;
+    return readFile("shaders/" + name + ".spv");
+}
+
+void GraphicsPipeline::enableHotReload() {
+    shaderLibrary_ = std::make_unique<ShaderLibrary>(SHADER_SOURCE_DIR, "shaders/cache");
+    shaderLibrary_->watch([this](const ShaderLibrary::SpirvMap &spirv) { rebuild(spirv); });
+}
+
+void GraphicsPipeline::rebuild(const ShaderLibrary::SpirvMap &spirv) {
+    for (const auto &[name, code] : spirv) {
+        reloaded_[name] = code;
+    }
+
+    // Every pipeline group with the shaders it is built from; the optional ones only once they exist
+    struct Group {
+        std::vector<std::string> shaders;
+        std::function<void(Pipelines &)> build;
+    };
+    std::vector<Group> groups = {
+        {{"deferred/gbuffer.vert", "deferred/gbuffer.frag"},
+         [this](Pipelines &out) { buildGeometryPipelines(out); }},
+        {{"deferred/fullscreen.vert", "deferred/lighting.frag"},
+         [this](Pipelines &out) { buildLightingPipelines(out); }},
+        {{"compute/light_binning.comp"}, [this](Pipelines &out) { buildLightBinningPipeline(out); }},
+        {{"compute/ssao.comp", "compute/ssao_blur.comp"},
+         [this](Pipelines &out) { buildAmbientOcclusionPipelines(out); }},
+        {{"compute/hdr_reduce.comp"}, [this](Pipelines &out) { buildPostProcessPipeline(out); }},
+    };
+    if (shadowRenderPass_) {
+        groups.push_back({{"shadow/shadow.vert"}, [this](Pipelines &out) { buildShadowPipeline(out); }});
+    }
+    if (upscaleRenderPass_) {
+        groups.push_back({{"deferred/fullscreen.vert", "post/upscale.frag"}, [this](Pipelines &out) {
+            out.upscale = createPostPipeline(upscaleRenderPass_, "post/upscale.frag", 1);
+        }});
+    }
+    if (temporalRenderPass_) {
+        groups.push_back({{"deferred/fullscreen.vert", "post/taa.frag"}, [this](Pipelines &out) {
+            out.temporal = createPostPipeline(temporalRenderPass_, "post/taa.frag", taa::ATTACHMENT_COUNT);
+        }});
+    }
+    if (visibilityRenderPass_) {
+        groups.push_back({{"visibility/visibility.vert", "visibility/visibility.frag", "deferred/fullscreen.vert",
+                           "visibility/material.frag"},
+                          [this](Pipelines &out) { buildVisibilityPipelines(out); }});
+    }
+
+    // On top of the newest set, whether or not the render thread has picked it up yet
+    Pipelines next;
+    {
+        std::lock_guard lock(reloadMutex_);
+        next = pending_ ? *pending_ : pipelines_;
+    }
+
+    auto device = context_.getDevice();
+    uint32_t rebuilt = 0;
+    for (const auto &group : groups) {
+        if (std::none_of(group.shaders.begin(), group.shaders.end(),
+                         [&](const std::string &shader) { return spirv.contains(shader); }))
+            continue;
+        const Pipelines previous = next;
+        try {
+            group.build(next);
+            rebuilt++;
+        } catch (const std::exception &e) {
+            // The group keeps its last working pipelines
+            for (auto pipeline : next.replacedBy(previous)) {
+                device.destroyPipeline(pipeline);
+            }
+            next = previous;
+            std::cerr << "-- Pipeline rebuild failed: " << e.what() << std::endl;
+        }
+    }
+    if (rebuilt == 0)
+        return;
+
+    std::lock_guard lock(reloadMutex_);
+    if (pending_) {
+        // Replaced before the render thread took it: nothing recorded those, unless they are still current
+        const auto current = pipelines_.handles();
+        for (auto pipeline : pending_->replacedBy(next)) {
+            if (std::find(current.begin(), current.end(), pipeline) == current.end())
+                device.destroyPipeline(pipeline);
+        }
+    }
+    pending_ = next;
+}
+
+void GraphicsPipeline::applyReload(DeletionQueue &deletionQueue) {
+    std::lock_guard lock(reloadMutex_);
+    if (!pending_)
+        return;
+
+    // Frames still in flight may have bound the old ones
+    for (auto pipeline : pipelines_.replacedBy(*pending_)) {
+        deletionQueue.retire(context_.getDevice(), pipeline);
+    }
+    pipelines_ = *pending_;
+    pending_.reset();
+    std::cout << "-- Pipelines reloaded" << std::endl;
+}
+
+void GraphicsPipeline::buildGeometryPipelines(Pipelines &out) const {
+    auto vertShaderCode = loadShader("deferred/gbuffer.vert");
+    auto fragShaderCode = loadShader("deferred/gbuffer.frag");
 
     vk::ShaderModule vertShaderModule = createShaderModule(vertShaderCode);
     vk::ShaderModule fragShaderModule = createShaderModule(fragShaderCode);
 
-    // Shader Stages
-    std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages = {
-        vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, "main"),
-        vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, "main")
+    // Shader Stages: same modules for every permutation, SHADING_MODEL (constant_id 0) differs
+    std::array<uint32_t, SHADING_MODEL_COUNT> shadingModels{};
+    std::array<vk::SpecializationMapEntry, 1> specEntries = {
+        vk::SpecializationMapEntry(0, 0, sizeof(uint32_t))
     };
+    std::array<vk::SpecializationInfo, SHADING_MODEL_COUNT> specInfos;
+    std::array<std::array<vk::PipelineShaderStageCreateInfo, 2>, SHADING_MODEL_COUNT> shaderStages;
+
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        shadingModels[i] = static_cast<uint32_t>(i);
+        specInfos[i] = vk::SpecializationInfo()
+                       .setMapEntries(specEntries)
+                       .setDataSize(sizeof(uint32_t))
+                       .setPData(&shadingModels[i]);
+        shaderStages[i] = {
+            vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, "main",
+                                              &specInfos[i]),
+            vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, "main",
+                                              &specInfos[i])
+        };
+    }
 
     // Vertex Input
     auto bindingDescription = Vertex::getBindingDescription();
@@ -75,32 +249,560 @@ void GraphicsPipeline::createGraphicsPipeline() {
                          .setSampleShadingEnable(false)
                          .setRasterizationSamples(vk::SampleCountFlagBits::e1);
 
-    // Depth/Stencil
+    // Depth/Stencil: the surviving fragment writes its shading model + 1 for the lighting subpass
+    std::array<vk::PipelineDepthStencilStateCreateInfo, SHADING_MODEL_COUNT> depthStencil;
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        auto stencilOp = vk::StencilOpState()
+                         .setFailOp(vk::StencilOp::eKeep)
+                         .setPassOp(vk::StencilOp::eReplace)
+                         .setDepthFailOp(vk::StencilOp::eKeep)
+                         .setCompareOp(vk::CompareOp::eAlways)
+                         .setCompareMask(0xff)
+                         .setWriteMask(0xff)
+                         .setReference(static_cast<uint32_t>(i) + 1);
+        depthStencil[i] = vk::PipelineDepthStencilStateCreateInfo()
+                          .setDepthTestEnable(true)
+                          .setDepthWriteEnable(true)
+                          .setDepthCompareOp(vk::CompareOp::eLess)
+                          .setDepthBoundsTestEnable(false)
+                          .setStencilTestEnable(true)
+                          .setFront(stencilOp)
+                          .setBack(stencilOp);
+    }
+
+    // Color Blending: one opaque write per G-buffer target, then the velocity
+    std::array<vk::PipelineColorBlendAttachmentState, gbuffer::TARGET_COUNT + 1> colorBlendAttachments;
+    colorBlendAttachments.fill(vk::PipelineColorBlendAttachmentState()
+                               .setColorWriteMask(vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+                                                  vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA)
+                               .setBlendEnable(false));
+
+    auto colorBlending = vk::PipelineColorBlendStateCreateInfo()
+                         .setLogicOpEnable(false)
+                         .setAttachments(colorBlendAttachments);
+
+    // Dynamic State
+    std::array<vk::DynamicState, 2> dynamicStates = {
+        vk::DynamicState::eViewport,
+        vk::DynamicState::eScissor
+    };
+    auto dynamicStateInfo = vk::PipelineDynamicStateCreateInfo({}, dynamicStates);
+
+    // Create Pipelines: every permutation in one call so the driver can share the work
+    std::array<vk::GraphicsPipelineCreateInfo, SHADING_MODEL_COUNT> pipelineInfos;
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        pipelineInfos[i] = vk::GraphicsPipelineCreateInfo()
+                           .setStages(shaderStages[i])
+                           .setPVertexInputState(&vertexInputInfo)
+                           .setPInputAssemblyState(&inputAssembly)
+                           .setPViewportState(&viewportState)
+                           .setPRasterizationState(&rasterizer)
+                           .setPMultisampleState(&multisampling)
+                           .setPDepthStencilState(&depthStencil[i])
+                           .setPColorBlendState(&colorBlending)
+                           .setPDynamicState(&dynamicStateInfo)
+                           .setLayout(pipelineLayout_)
+                           .setRenderPass(renderPass_)
+                           .setSubpass(gbuffer::GEOMETRY_SUBPASS);
+    }
+
+    auto result = context_.getDevice().createGraphicsPipelines(nullptr, pipelineInfos);
+    if (result.result != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create geometry pipelines!");
+    }
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        out.geometry[i] = result.value[i];
+    }
+
+    // Shader modules can be destroyed immediately after pipeline creation
+    context_.getDevice().destroyShaderModule(fragShaderModule);
+    context_.getDevice().destroyShaderModule(vertShaderModule);
+}
+
+void GraphicsPipeline::buildLightingPipelines(Pipelines &out) const {
+    auto vertShaderCode = loadShader("deferred/fullscreen.vert");
+    auto fragShaderCode = loadShader("deferred/lighting.frag");
+
+    vk::ShaderModule vertShaderModule = createShaderModule(vertShaderCode);
+    vk::ShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+
+    // Same SHADING_MODEL permutations as the geometry pipelines, fragment stage only
+    std::array<uint32_t, SHADING_MODEL_COUNT> shadingModels{};
+    std::array<vk::SpecializationMapEntry, 1> specEntries = {
+        vk::SpecializationMapEntry(0, 0, sizeof(uint32_t))
+    };
+    std::array<vk::SpecializationInfo, SHADING_MODEL_COUNT> specInfos;
+    std::array<std::array<vk::PipelineShaderStageCreateInfo, 2>, SHADING_MODEL_COUNT> shaderStages;
+
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        shadingModels[i] = static_cast<uint32_t>(i);
+        specInfos[i] = vk::SpecializationInfo()
+                       .setMapEntries(specEntries)
+                       .setDataSize(sizeof(uint32_t))
+                       .setPData(&shadingModels[i]);
+        shaderStages[i] = {
+            vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, "main"),
+            vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, "main",
+                                              &specInfos[i])
+        };
+    }
+
+    // Fullscreen triangle from gl_VertexIndex, no vertex input
+    auto vertexInputInfo = vk::PipelineVertexInputStateCreateInfo();
+
+    auto inputAssembly = vk::PipelineInputAssemblyStateCreateInfo()
+                         .setTopology(vk::PrimitiveTopology::eTriangleList)
+                         .setPrimitiveRestartEnable(false);
+
+    auto viewportState = vk::PipelineViewportStateCreateInfo()
+                         .setViewportCount(1)
+                         .setScissorCount(1);
+
+    auto rasterizer = vk::PipelineRasterizationStateCreateInfo()
+                      .setDepthClampEnable(false)
+                      .setRasterizerDiscardEnable(false)
+                      .setPolygonMode(vk::PolygonMode::eFill)
+                      .setLineWidth(1.0f)
+                      .setCullMode(vk::CullModeFlagBits::eNone)
+                      .setFrontFace(vk::FrontFace::eCounterClockwise)
+                      .setDepthBiasEnable(false);
+
+    auto multisampling = vk::PipelineMultisampleStateCreateInfo()
+                         .setSampleShadingEnable(false)
+                         .setRasterizationSamples(vk::SampleCountFlagBits::e1);
+
+    // No depth test; stencil must equal the model + 1, so background and other models are skipped
+    std::array<vk::PipelineDepthStencilStateCreateInfo, SHADING_MODEL_COUNT> depthStencil;
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        auto stencilOp = vk::StencilOpState()
+                         .setFailOp(vk::StencilOp::eKeep)
+                         .setPassOp(vk::StencilOp::eKeep)
+                         .setDepthFailOp(vk::StencilOp::eKeep)
+                         .setCompareOp(vk::CompareOp::eEqual)
+                         .setCompareMask(0xff)
+                         .setWriteMask(0)
+                         .setReference(static_cast<uint32_t>(i) + 1);
+        depthStencil[i] = vk::PipelineDepthStencilStateCreateInfo()
+                          .setDepthTestEnable(false)
+                          .setDepthWriteEnable(false)
+                          .setDepthBoundsTestEnable(false)
+                          .setStencilTestEnable(true)
+                          .setFront(stencilOp)
+                          .setBack(stencilOp);
+    }
+
+    auto colorBlendAttachment = vk::PipelineColorBlendAttachmentState()
+                                .setColorWriteMask(vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+                                                   vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA)
+                                .setBlendEnable(false);
+
+    auto colorBlending = vk::PipelineColorBlendStateCreateInfo()
+                         .setLogicOpEnable(false)
+                         .setAttachments(colorBlendAttachment);
+
+    std::array<vk::DynamicState, 2> dynamicStates = {
+        vk::DynamicState::eViewport,
+        vk::DynamicState::eScissor
+    };
+    auto dynamicStateInfo = vk::PipelineDynamicStateCreateInfo({}, dynamicStates);
+
+    std::array<vk::GraphicsPipelineCreateInfo, SHADING_MODEL_COUNT> pipelineInfos;
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        pipelineInfos[i] = vk::GraphicsPipelineCreateInfo()
+                           .setStages(shaderStages[i])
+                           .setPVertexInputState(&vertexInputInfo)
+                           .setPInputAssemblyState(&inputAssembly)
+                           .setPViewportState(&viewportState)
+                           .setPRasterizationState(&rasterizer)
+                           .setPMultisampleState(&multisampling)
+                           .setPDepthStencilState(&depthStencil[i])
+                           .setPColorBlendState(&colorBlending)
+                           .setPDynamicState(&dynamicStateInfo)
+                           .setLayout(pipelineLayout_)
+                           .setRenderPass(renderPass_)
+                           .setSubpass(gbuffer::LIGHTING_SUBPASS);
+    }
+
+    auto result = context_.getDevice().createGraphicsPipelines(nullptr, pipelineInfos);
+    if (result.result != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create lighting pipelines!");
+    }
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        out.lighting[i] = result.value[i];
+    }
+
+    context_.getDevice().destroyShaderModule(fragShaderModule);
+    context_.getDevice().destroyShaderModule(vertShaderModule);
+}
+
+void GraphicsPipeline::createVisibilityPipelines(vk::RenderPass visibilityRenderPass) {
+    visibilityRenderPass_ = visibilityRenderPass;
+    buildVisibilityPipelines(pipelines_);
+}
+
+void GraphicsPipeline::buildVisibilityPipelines(Pipelines &out) const {
+    auto device = context_.getDevice();
+    vk::ShaderModule visibilityVert = createShaderModule(loadShader("visibility/visibility.vert"));
+    vk::ShaderModule visibilityFrag = createShaderModule(loadShader("visibility/visibility.frag"));
+    vk::ShaderModule fullscreenVert = createShaderModule(loadShader("deferred/fullscreen.vert"));
+    vk::ShaderModule materialFrag = createShaderModule(loadShader("visibility/material.frag"));
+
+    // The visibility shaders do not depend on the model, only its stencil reference does;
+    // the material shader is specialized like the lighting one
+    std::array<uint32_t, SHADING_MODEL_COUNT> shadingModels{};
+    std::array<vk::SpecializationMapEntry, 1> specEntries = {
+        vk::SpecializationMapEntry(0, 0, sizeof(uint32_t))
+    };
+    std::array<vk::SpecializationInfo, SHADING_MODEL_COUNT> specInfos;
+    std::array<vk::PipelineShaderStageCreateInfo, 2> visibilityStages = {
+        vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, visibilityVert, "main"),
+        vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, visibilityFrag, "main")
+    };
+    std::array<std::array<vk::PipelineShaderStageCreateInfo, 2>, SHADING_MODEL_COUNT> materialStages;
+
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        shadingModels[i] = static_cast<uint32_t>(i);
+        specInfos[i] = vk::SpecializationInfo()
+                       .setMapEntries(specEntries)
+                       .setDataSize(sizeof(uint32_t))
+                       .setPData(&shadingModels[i]);
+        materialStages[i] = {
+            vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, fullscreenVert, "main"),
+            vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, materialFrag, "main",
+                                              &specInfos[i])
+        };
+    }
+
+    // Same vertex buffer as the geometry pipelines, only the position is read; the material pass has none
+    auto bindingDescription = Vertex::getBindingDescription();
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    auto visibilityVertexInput = vk::PipelineVertexInputStateCreateInfo()
+                                 .setVertexBindingDescriptions(bindingDescription)
+                                 .setVertexAttributeDescriptions(attributeDescriptions);
+    auto materialVertexInput = vk::PipelineVertexInputStateCreateInfo();
+
+    auto inputAssembly = vk::PipelineInputAssemblyStateCreateInfo()
+                         .setTopology(vk::PrimitiveTopology::eTriangleList)
+                         .setPrimitiveRestartEnable(false);
+
+    auto viewportState = vk::PipelineViewportStateCreateInfo()
+                         .setViewportCount(1)
+                         .setScissorCount(1);
+
+    auto visibilityRasterizer = vk::PipelineRasterizationStateCreateInfo()
+                                .setDepthClampEnable(false)
+                                .setRasterizerDiscardEnable(false)
+                                .setPolygonMode(vk::PolygonMode::eFill)
+                                .setLineWidth(1.0f)
+                                .setCullMode(vk::CullModeFlagBits::eBack)
+                                .setFrontFace(vk::FrontFace::eCounterClockwise)
+                                .setDepthBiasEnable(false);
+    auto materialRasterizer = vk::PipelineRasterizationStateCreateInfo(visibilityRasterizer)
+                              .setCullMode(vk::CullModeFlagBits::eNone);
+
+    auto multisampling = vk::PipelineMultisampleStateCreateInfo()
+                         .setSampleShadingEnable(false)
+                         .setRasterizationSamples(vk::SampleCountFlagBits::e1);
+
+    // Stencil as in the G-buffer path: written with model + 1, then tested for equality
+    std::array<vk::PipelineDepthStencilStateCreateInfo, SHADING_MODEL_COUNT> visibilityDepthStencil;
+    std::array<vk::PipelineDepthStencilStateCreateInfo, SHADING_MODEL_COUNT> materialDepthStencil;
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        auto writeOp = vk::StencilOpState()
+                       .setFailOp(vk::StencilOp::eKeep)
+                       .setPassOp(vk::StencilOp::eReplace)
+                       .setDepthFailOp(vk::StencilOp::eKeep)
+                       .setCompareOp(vk::CompareOp::eAlways)
+                       .setCompareMask(0xff)
+                       .setWriteMask(0xff)
+                       .setReference(static_cast<uint32_t>(i) + 1);
+        visibilityDepthStencil[i] = vk::PipelineDepthStencilStateCreateInfo()
+                                    .setDepthTestEnable(true)
+                                    .setDepthWriteEnable(true)
+                                    .setDepthCompareOp(vk::CompareOp::eLess)
+                                    .setDepthBoundsTestEnable(false)
+                                    .setStencilTestEnable(true)
+                                    .setFront(writeOp)
+                                    .setBack(writeOp);
+
+        auto testOp = vk::StencilOpState(writeOp)
+                      .setPassOp(vk::StencilOp::eKeep)
+                      .setCompareOp(vk::CompareOp::eEqual)
+                      .setWriteMask(0);
+        materialDepthStencil[i] = vk::PipelineDepthStencilStateCreateInfo()
+                                  .setDepthTestEnable(false)
+                                  .setDepthWriteEnable(false)
+                                  .setDepthBoundsTestEnable(false)
+                                  .setStencilTestEnable(true)
+                                  .setFront(testOp)
+                                  .setBack(testOp);
+    }
+
+    // Opaque writes: the visibility target and velocity, then the scene color
+    auto colorBlendAttachment = vk::PipelineColorBlendAttachmentState()
+                                .setColorWriteMask(vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+                                                   vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA)
+                                .setBlendEnable(false);
+    auto visibilityBlendAttachment = vk::PipelineColorBlendAttachmentState(colorBlendAttachment)
+                                     .setColorWriteMask(vk::ColorComponentFlagBits::eR |
+                                                        vk::ColorComponentFlagBits::eG);
+
+    std::array<vk::PipelineColorBlendAttachmentState, 2> visibilityBlendAttachments = {
+        visibilityBlendAttachment, visibilityBlendAttachment
+    };
+
+    auto visibilityBlending = vk::PipelineColorBlendStateCreateInfo()
+                              .setLogicOpEnable(false)
+                              .setAttachments(visibilityBlendAttachments);
+    auto materialBlending = vk::PipelineColorBlendStateCreateInfo()
+                            .setLogicOpEnable(false)
+                            .setAttachments(colorBlendAttachment);
+
+    std::array<vk::DynamicState, 2> dynamicStates = {
+        vk::DynamicState::eViewport,
+        vk::DynamicState::eScissor
+    };
+    auto dynamicStateInfo = vk::PipelineDynamicStateCreateInfo({}, dynamicStates);
+
+    // Both subpasses' permutations in one call
+    std::array<vk::GraphicsPipelineCreateInfo, 2 * SHADING_MODEL_COUNT> pipelineInfos;
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        pipelineInfos[i] = vk::GraphicsPipelineCreateInfo()
+                           .setStages(visibilityStages)
+                           .setPVertexInputState(&visibilityVertexInput)
+                           .setPInputAssemblyState(&inputAssembly)
+                           .setPViewportState(&viewportState)
+                           .setPRasterizationState(&visibilityRasterizer)
+                           .setPMultisampleState(&multisampling)
+                           .setPDepthStencilState(&visibilityDepthStencil[i])
+                           .setPColorBlendState(&visibilityBlending)
+                           .setPDynamicState(&dynamicStateInfo)
+                           .setLayout(pipelineLayout_)
+                           .setRenderPass(visibilityRenderPass_)
+                           .setSubpass(visbuffer::GEOMETRY_SUBPASS);
+        pipelineInfos[SHADING_MODEL_COUNT + i] = vk::GraphicsPipelineCreateInfo()
+                                                 .setStages(materialStages[i])
+                                                 .setPVertexInputState(&materialVertexInput)
+                                                 .setPInputAssemblyState(&inputAssembly)
+                                                 .setPViewportState(&viewportState)
+                                                 .setPRasterizationState(&materialRasterizer)
+                                                 .setPMultisampleState(&multisampling)
+                                                 .setPDepthStencilState(&materialDepthStencil[i])
+                                                 .setPColorBlendState(&materialBlending)
+                                                 .setPDynamicState(&dynamicStateInfo)
+                                                 .setLayout(pipelineLayout_)
+                                                 .setRenderPass(visibilityRenderPass_)
+                                                 .setSubpass(visbuffer::MATERIAL_SUBPASS);
+    }
+
+    auto result = device.createGraphicsPipelines(nullptr, pipelineInfos);
+    if (result.result != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create visibility buffer pipelines!");
+    }
+    for (size_t i = 0; i < SHADING_MODEL_COUNT; i++) {
+        out.visibility[i] = result.value[i];
+        out.visibilityMaterial[i] = result.value[SHADING_MODEL_COUNT + i];
+    }
+
+    device.destroyShaderModule(materialFrag);
+    device.destroyShaderModule(fullscreenVert);
+    device.destroyShaderModule(visibilityFrag);
+    device.destroyShaderModule(visibilityVert);
+}
+
+void GraphicsPipeline::createShadowPipeline(vk::RenderPass shadowRenderPass, bool depthClamp) {
+    shadowRenderPass_ = shadowRenderPass;
+    shadowDepthClamp_ = depthClamp;
+    buildShadowPipeline(pipelines_);
+}
+
+void GraphicsPipeline::buildShadowPipeline(Pipelines &out) const {
+    auto vertShaderCode = loadShader("shadow/shadow.vert");
+    vk::ShaderModule vertShaderModule = createShaderModule(vertShaderCode);
+
+    // Vertex stage only: depth is all the pass writes
+    auto shaderStage = vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, vertShaderModule,
+                                                         "main");
+
+    // Same vertex buffer as the lit pipelines, only the position is read
+    auto bindingDescription = Vertex::getBindingDescription();
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+
+    auto vertexInputInfo = vk::PipelineVertexInputStateCreateInfo()
+                           .setVertexBindingDescriptions(bindingDescription)
+                           .setVertexAttributeDescriptions(attributeDescriptions);
+
+    auto inputAssembly = vk::PipelineInputAssemblyStateCreateInfo()
+                         .setTopology(vk::PrimitiveTopology::eTriangleList)
+                         .setPrimitiveRestartEnable(false);
+
+    auto viewportState = vk::PipelineViewportStateCreateInfo()
+                         .setViewportCount(1)
+                         .setScissorCount(1);
+
+    // No culling, so open or single-sided meshes still cast; slope-scaled bias against acne
+    auto rasterizer = vk::PipelineRasterizationStateCreateInfo()
+                      .setDepthClampEnable(shadowDepthClamp_)
+                      .setRasterizerDiscardEnable(false)
+                      .setPolygonMode(vk::PolygonMode::eFill)
+                      .setLineWidth(1.0f)
+                      .setCullMode(vk::CullModeFlagBits::eNone)
+                      .setFrontFace(vk::FrontFace::eCounterClockwise)
+                      .setDepthBiasEnable(true)
+                      .setDepthBiasConstantFactor(1.25f)
+                      .setDepthBiasSlopeFactor(1.75f);
+
+    auto multisampling = vk::PipelineMultisampleStateCreateInfo()
+                         .setSampleShadingEnable(false)
+                         .setRasterizationSamples(vk::SampleCountFlagBits::e1);
+
     auto depthStencil = vk::PipelineDepthStencilStateCreateInfo()
                         .setDepthTestEnable(true)
                         .setDepthWriteEnable(true)
-                        .setDepthCompareOp(vk::CompareOp::eLess)
+                        .setDepthCompareOp(vk::CompareOp::eLessOrEqual)
                         .setDepthBoundsTestEnable(false)
                         .setStencilTestEnable(false);
 
-    // Color Blending
+    auto colorBlending = vk::PipelineColorBlendStateCreateInfo()
+                         .setLogicOpEnable(false);
+
+    std::array<vk::DynamicState, 2> dynamicStates = {
+        vk::DynamicState::eViewport,
+        vk::DynamicState::eScissor
+    };
+    auto dynamicStateInfo = vk::PipelineDynamicStateCreateInfo({}, dynamicStates);
+
+    auto pipelineInfo = vk::GraphicsPipelineCreateInfo()
+                        .setStages(shaderStage)
+                        .setPVertexInputState(&vertexInputInfo)
+                        .setPInputAssemblyState(&inputAssembly)
+                        .setPViewportState(&viewportState)
+                        .setPRasterizationState(&rasterizer)
+                        .setPMultisampleState(&multisampling)
+                        .setPDepthStencilState(&depthStencil)
+                        .setPColorBlendState(&colorBlending)
+                        .setPDynamicState(&dynamicStateInfo)
+                        .setLayout(pipelineLayout_)
+                        .setRenderPass(shadowRenderPass_)
+                        .setSubpass(0);
+
+    auto result = context_.getDevice().createGraphicsPipeline(nullptr, pipelineInfo);
+    if (result.result != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create shadow pipeline!");
+    }
+    out.shadow = result.value;
+
+    context_.getDevice().destroyShaderModule(vertShaderModule);
+}
+
+vk::Pipeline GraphicsPipeline::createComputePipeline(const std::string &name,
+                                                    const vk::SpecializationInfo *specialization) const {
+    vk::ShaderModule computeShaderModule = createShaderModule(loadShader(name));
+
+    auto pipelineInfo = vk::ComputePipelineCreateInfo()
+                        .setStage(vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eCompute,
+                                                                    computeShaderModule, "main", specialization))
+                        .setLayout(pipelineLayout_);
+
+    auto result = context_.getDevice().createComputePipeline(nullptr, pipelineInfo);
+    if (result.result != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create compute pipeline!");
+    }
+
+    context_.getDevice().destroyShaderModule(computeShaderModule);
+    return result.value;
+}
+
+void GraphicsPipeline::buildLightBinningPipeline(Pipelines &out) const {
+    out.lightBinning = createComputePipeline("compute/light_binning.comp");
+}
+
+void GraphicsPipeline::buildAmbientOcclusionPipelines(Pipelines &out) const {
+    out.ambientOcclusion[0] = createComputePipeline("compute/ssao.comp");
+
+    // Both blur axes from one module, BLUR_AXIS (constant_id 0) differs
+    auto specEntry = vk::SpecializationMapEntry(0, 0, sizeof(uint32_t));
+    for (uint32_t axis = 0; axis < 2; axis++) {
+        auto specInfo = vk::SpecializationInfo()
+                        .setMapEntries(specEntry)
+                        .setDataSize(sizeof(uint32_t))
+                        .setPData(&axis);
+        out.ambientOcclusion[1 + axis] = createComputePipeline("compute/ssao_blur.comp", &specInfo);
+    }
+}
+
+void GraphicsPipeline::buildPostProcessPipeline(Pipelines &out) const {
+    out.postProcess = createComputePipeline("compute/hdr_reduce.comp");
+}
+
+void GraphicsPipeline::createUpscalePipeline(vk::RenderPass upscaleRenderPass) {
+    upscaleRenderPass_ = upscaleRenderPass;
+    pipelines_.upscale = createPostPipeline(upscaleRenderPass_, "post/upscale.frag", 1);
+}
+
+void GraphicsPipeline::createTemporalPipeline(vk::RenderPass temporalRenderPass) {
+    temporalRenderPass_ = temporalRenderPass;
+    pipelines_.temporal = createPostPipeline(temporalRenderPass_, "post/taa.frag", taa::ATTACHMENT_COUNT);
+}
+
+vk::Pipeline GraphicsPipeline::createPostPipeline(vk::RenderPass renderPass, const std::string &fragmentName,
+                                                  uint32_t colorAttachmentCount) const {
+    vk::ShaderModule vertShaderModule = createShaderModule(loadShader("deferred/fullscreen.vert"));
+    vk::ShaderModule fragShaderModule = createShaderModule(loadShader(fragmentName));
+
+    std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages = {
+        vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, vertShaderModule, "main"),
+        vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, fragShaderModule, "main")
+    };
+
+    auto vertexInputInfo = vk::PipelineVertexInputStateCreateInfo();
+
+    auto inputAssembly = vk::PipelineInputAssemblyStateCreateInfo()
+                         .setTopology(vk::PrimitiveTopology::eTriangleList)
+                         .setPrimitiveRestartEnable(false);
+
+    auto viewportState = vk::PipelineViewportStateCreateInfo()
+                         .setViewportCount(1)
+                         .setScissorCount(1);
+
+    auto rasterizer = vk::PipelineRasterizationStateCreateInfo()
+                      .setDepthClampEnable(false)
+                      .setRasterizerDiscardEnable(false)
+                      .setPolygonMode(vk::PolygonMode::eFill)
+                      .setLineWidth(1.0f)
+                      .setCullMode(vk::CullModeFlagBits::eNone)
+                      .setFrontFace(vk::FrontFace::eCounterClockwise)
+                      .setDepthBiasEnable(false);
+
+    auto multisampling = vk::PipelineMultisampleStateCreateInfo()
+                         .setSampleShadingEnable(false)
+                         .setRasterizationSamples(vk::SampleCountFlagBits::e1);
+
+    // The pass has no depth attachment
+    auto depthStencil = vk::PipelineDepthStencilStateCreateInfo()
+                        .setDepthTestEnable(false)
+                        .setDepthWriteEnable(false)
+                        .setStencilTestEnable(false);
+
     auto colorBlendAttachment = vk::PipelineColorBlendAttachmentState()
                                 .setColorWriteMask(vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
                                                    vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA)
                                 .setBlendEnable(false);
 
+    // The same opaque write to every output
+    std::vector<vk::PipelineColorBlendAttachmentState> colorBlendAttachments(colorAttachmentCount,
+                                                                             colorBlendAttachment);
     auto colorBlending = vk::PipelineColorBlendStateCreateInfo()
                          .setLogicOpEnable(false)
-                         .setAttachments(colorBlendAttachment);
+                         .setAttachments(colorBlendAttachments);
 
-    // Dynamic State
     std::array<vk::DynamicState, 2> dynamicStates = {
         vk::DynamicState::eViewport,
         vk::DynamicState::eScissor
     };
     auto dynamicStateInfo = vk::PipelineDynamicStateCreateInfo({}, dynamicStates);
 
-    // Create Pipeline
+    // Same layout as everything else: the view uniforms carry the scale and jitter, set 1 the inputs
     auto pipelineInfo = vk::GraphicsPipelineCreateInfo()
                         .setStages(shaderStages)
                         .setPVertexInputState(&vertexInputInfo)
@@ -112,18 +814,17 @@ void GraphicsPipeline::createGraphicsPipeline() {
                         .setPColorBlendState(&colorBlending)
                         .setPDynamicState(&dynamicStateInfo)
                         .setLayout(pipelineLayout_)
-                        .setRenderPass(renderPass_)
+                        .setRenderPass(renderPass)
                         .setSubpass(0);
 
     auto result = context_.getDevice().createGraphicsPipeline(nullptr, pipelineInfo);
     if (result.result != vk::Result::eSuccess) {
-        throw std::runtime_error("failed to create graphics pipeline!");
+        throw std::runtime_error("failed to create post-processing pipeline: " + fragmentName);
     }
-    graphicsPipeline_ = result.value;
 
-    // Shader modules can be destroyed immediately after pipeline creation
     context_.getDevice().destroyShaderModule(fragShaderModule);
     context_.getDevice().destroyShaderModule(vertShaderModule);
+    return result.value;
 }
 
 vk::ShaderModule GraphicsPipeline::createShaderModule(const std::vector<char> &code) const {
@@ -134,15 +835,18 @@ vk::ShaderModule GraphicsPipeline::createShaderModule(const std::vector<char> &c
     return context_.getDevice().createShaderModule(createInfo);
 }
 
-void GraphicsPipeline::createPipelineLayout(vk::DescriptorSetLayout dsLayout) {
-    // Push Constant for shading mode
+void GraphicsPipeline::createPipelineLayout(vk::DescriptorSetLayout dsLayout, vk::DescriptorSetLayout gbufferLayout) {
+    // Push Constant for the per-draw material (and, in the shadow pass, cascade) index
     auto pushConstantRange = vk::PushConstantRange()
-                             .setStageFlags(vk::ShaderStageFlagBits::eFragment)
+                             .setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment)
                              .setOffset(0)
-                             .setSize(sizeof(int));
+                             .setSize(sizeof(DrawPushConstants));
+
+    // Set 0: per-frame data shared by every pass; set 1: the G-buffer input attachments
+    std::array<vk::DescriptorSetLayout, 2> setLayouts = {dsLayout, gbufferLayout};
 
     auto pipelineLayoutInfo = vk::PipelineLayoutCreateInfo()
-                              .setSetLayouts(dsLayout)
+                              .setSetLayouts(setLayouts)
                               .setPushConstantRanges(pushConstantRange);
 
     pipelineLayout_ = context_.getDevice().createPipelineLayout(pipelineLayoutInfo);
@@ -3,9 +3,18 @@
 //
 #pragma once
 
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
+#include "ShaderLibrary.hpp"
+#include "system/MaterialSystem.hpp"
+
+class DeletionQueue;
 class SwapChain;
 class VulkanContext;
 
@@ -14,14 +23,19 @@ public:
     GraphicsPipeline(VulkanContext& context,
                      SwapChain& swapChain,
                      vk::RenderPass renderPass,
-                     vk::DescriptorSetLayout descriptorSetLayout)
+                     vk::DescriptorSetLayout descriptorSetLayout,
+                     vk::DescriptorSetLayout gbufferSetLayout)
         : context_(context), swapChain_(swapChain), renderPass_(renderPass) {
 
         // 1. Create the Layout FIRST
-        createPipelineLayout(descriptorSetLayout);
+        createPipelineLayout(descriptorSetLayout, gbufferSetLayout);
 
-        // 2. Create the Pipeline SECOND
-        createGraphicsPipeline();
+        // 2. Create the Pipelines SECOND (one per shading model permutation and subpass)
+        buildGeometryPipelines(pipelines_);
+        buildLightingPipelines(pipelines_);
+        buildLightBinningPipeline(pipelines_);
+        buildAmbientOcclusionPipelines(pipelines_);
+        buildPostProcessPipeline(pipelines_);
     }
 
     ~GraphicsPipeline();
@@ -30,20 +44,116 @@ public:
     GraphicsPipeline(const GraphicsPipeline&) = delete;
     GraphicsPipeline& operator=(const GraphicsPipeline&) = delete;
 
-    [[nodiscard]] vk::Pipeline getPipeline() const { return graphicsPipeline_; }
+    // Geometry subpass: fills the G-buffer and tags the pixels with the model in stencil
+    [[nodiscard]] vk::Pipeline getGeometryPipeline(ShadingModel model) const {
+        return pipelines_.geometry[static_cast<size_t>(model)];
+    }
+    // Lighting subpass: fullscreen triangle, shades the pixels whose stencil matches the model
+    [[nodiscard]] vk::Pipeline getLightingPipeline(ShadingModel model) const {
+        return pipelines_.lighting[static_cast<size_t>(model)];
+    }
     [[nodiscard]] vk::PipelineLayout getPipelineLayout() const { return pipelineLayout_; }
 
+    // Compute: bins the local lights into screen tiles (see LightBinning); same layout, set 0 only
+    [[nodiscard]] vk::Pipeline getLightBinningPipeline() const { return pipelines_.lightBinning; }
+    // Compute: the ambient occlusion passes, indexed by AmbientOcclusion::Pass (occlusion, blur x, blur y)
+    [[nodiscard]] vk::Pipeline getAmbientOcclusionPipeline(uint32_t pass) const {
+        return pipelines_.ambientOcclusion[pass];
+    }
+    // Compute: bloom chain, luminance histogram and exposure in one dispatch (see PostProcess)
+    [[nodiscard]] vk::Pipeline getPostProcessPipeline() const { return pipelines_.postProcess; }
+
+    // Visibility-buffer mode (see VisibilityBuffer.hpp), same layout and permutations as above.
+    // Only created when the device supports it; the getters return null handles otherwise.
+    void createVisibilityPipelines(vk::RenderPass visibilityRenderPass);
+    // Visibility subpass: writes instance + triangle and tags the pixels with the model in stencil
+    [[nodiscard]] vk::Pipeline getVisibilityPipeline(ShadingModel model) const {
+        return pipelines_.visibility[static_cast<size_t>(model)];
+    }
+    // Material subpass: fullscreen triangle, rebuilds and shades the pixels whose stencil matches the model
+    [[nodiscard]] vk::Pipeline getVisibilityMaterialPipeline(ShadingModel model) const {
+        return pipelines_.visibilityMaterial[static_cast<size_t>(model)];
+    }
+
+    // Depth-only caster pipeline for the shadow cascades; same layout as the lit pipelines.
+    // Created separately because the shadow render pass belongs to the renderer.
+    void createShadowPipeline(vk::RenderPass shadowRenderPass, bool depthClamp);
+    [[nodiscard]] vk::Pipeline getShadowPipeline() const { return pipelines_.shadow; }
+
+    // Fullscreen pass that stretches the rendered region of the scene color over the swapchain image
+    void createUpscalePipeline(vk::RenderPass upscaleRenderPass);
+    [[nodiscard]] vk::Pipeline getUpscalePipeline() const { return pipelines_.upscale; }
+
+    // Temporal resolve (see TemporalAA.hpp): writes the swapchain image and the next history
+    void createTemporalPipeline(vk::RenderPass temporalRenderPass);
+    [[nodiscard]] vk::Pipeline getTemporalPipeline() const { return pipelines_.temporal; }
+
+    // Shader hot reload, once every pipeline exists: edited shaders are recompiled (ShaderLibrary) and the
+    // pipelines using them rebuilt on the watcher thread, so rendering carries on meanwhile. A shader or
+    // pipeline that fails keeps its last working version.
+    void enableHotReload();
+    // Swaps in the pipelines rebuilt since the last call; the replaced ones go to 'deletionQueue'.
+    // Between frames, on the thread recording them.
+    void applyReload(DeletionQueue &deletionQueue);
+
 private:
     VulkanContext& context_;
     SwapChain& swapChain_;
 
+    // Every pipeline handle; a hot reload builds a new set and swaps it in whole
+    struct Pipelines {
+        std::array<vk::Pipeline, SHADING_MODEL_COUNT> geometry{};
+        std::array<vk::Pipeline, SHADING_MODEL_COUNT> lighting{};
+        std::array<vk::Pipeline, SHADING_MODEL_COUNT> visibility{};
+        std::array<vk::Pipeline, SHADING_MODEL_COUNT> visibilityMaterial{};
+        vk::Pipeline shadow;
+        vk::Pipeline upscale;
+        vk::Pipeline temporal;
+        vk::Pipeline lightBinning;
+        std::array<vk::Pipeline, 3> ambientOcclusion{};
+        vk::Pipeline postProcess;
+
+        [[nodiscard]] std::vector<vk::Pipeline> handles() const;
+        // The handles of this set that 'next' no longer has
+        [[nodiscard]] std::vector<vk::Pipeline> replacedBy(const Pipelines &next) const;
+    };
+
     // Updated to C++ handles
     vk::PipelineLayout pipelineLayout_;
     vk::RenderPass renderPass_;
-    vk::Pipeline graphicsPipeline_;
+    Pipelines pipelines_; // in use by the renderer
+
+    // Targets of the pipelines created after construction, kept for rebuilding them
+    vk::RenderPass visibilityRenderPass_;
+    vk::RenderPass shadowRenderPass_;
+    bool shadowDepthClamp_ = false;
+    vk::RenderPass upscaleRenderPass_;
+    vk::RenderPass temporalRenderPass_;
+
+    // Hot reload: the watcher thread builds pending_, the render thread swaps it in (applyReload)
+    std::unique_ptr<ShaderLibrary> shaderLibrary_;
+    ShaderLibrary::SpirvMap reloaded_; // shaders recompiled since startup; watcher thread only
+    std::optional<Pipelines> pending_;
+    std::mutex reloadMutex_;
 
-    void createPipelineLayout(vk::DescriptorSetLayout dsLayout);
-    void createGraphicsPipeline();
+    void createPipelineLayout(vk::DescriptorSetLayout dsLayout, vk::DescriptorSetLayout gbufferLayout);
+    // Each writes its pipelines into 'out'
+    void buildGeometryPipelines(Pipelines &out) const;
+    void buildLightingPipelines(Pipelines &out) const;
+    void buildVisibilityPipelines(Pipelines &out) const;
+    void buildShadowPipeline(Pipelines &out) const;
+    void buildLightBinningPipeline(Pipelines &out) const;
+    void buildAmbientOcclusionPipelines(Pipelines &out) const;
+    void buildPostProcessPipeline(Pipelines &out) const;
+    // Recompiled shaders in, their pipeline groups rebuilt into pending_; on the watcher thread
+    void rebuild(const ShaderLibrary::SpirvMap &spirv);
+    // SPIR-V of 'name' ("deferred/lighting.frag"): recompiled if it was, else the build step's
+    [[nodiscard]] std::vector<char> loadShader(const std::string &name) const;
+    [[nodiscard]] vk::Pipeline createComputePipeline(const std::string &name,
+                                                     const vk::SpecializationInfo *specialization = nullptr) const;
+    // Fullscreen triangle, no depth, 'colorAttachmentCount' opaque outputs
+    vk::Pipeline createPostPipeline(vk::RenderPass renderPass, const std::string &fragmentName,
+                                    uint32_t colorAttachmentCount) const;
 
     // Helper returns the C++ wrapper
     vk::ShaderModule createShaderModule(const std::vector<char>& code) const;
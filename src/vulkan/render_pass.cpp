@@ -4,78 +4,361 @@
 
 #include "render_pass.hpp"
 
+#include "GBuffer.hpp"
 #include "swap_chain.hpp"
+#include "TemporalAA.hpp"
+#include "VisibilityBuffer.hpp"
 #include "VulkanContext.hpp"
 #include <array>
 
+namespace {
+// Scene color and velocity: the only attachments that are stored, the upscale / resolve pass samples them
+vk::AttachmentDescription storedColorAttachment(vk::Format format) {
+    return vk::AttachmentDescription()
+           .setFormat(format)
+           .setSamples(vk::SampleCountFlagBits::e1)
+           .setLoadOp(vk::AttachmentLoadOp::eClear)
+           .setStoreOp(vk::AttachmentStoreOp::eStore)
+           .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
+           .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
+           .setInitialLayout(vk::ImageLayout::eUndefined)
+           .setFinalLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+}
+
+// Depth + stencil (shading model per pixel); lives and dies inside the pass
+vk::AttachmentDescription transientDepthAttachment(vk::Format format) {
+    return vk::AttachmentDescription()
+           .setFormat(format)
+           .setSamples(vk::SampleCountFlagBits::e1)
+           .setLoadOp(vk::AttachmentLoadOp::eClear)
+           .setStoreOp(vk::AttachmentStoreOp::eDontCare)
+           .setStencilLoadOp(vk::AttachmentLoadOp::eClear)
+           .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
+           .setInitialLayout(vk::ImageLayout::eUndefined)
+           .setFinalLayout(vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+}
+
+// Written in the first subpass, read in the second at the same pixel, never stored
+vk::AttachmentDescription transientColorAttachment(vk::Format format) {
+    return vk::AttachmentDescription()
+           .setFormat(format)
+           .setSamples(vk::SampleCountFlagBits::e1)
+           .setLoadOp(vk::AttachmentLoadOp::eDontCare)
+           .setStoreOp(vk::AttachmentStoreOp::eDontCare)
+           .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
+           .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
+           .setInitialLayout(vk::ImageLayout::eUndefined)
+           .setFinalLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+}
+
+// Dependencies shared by both passes: the previous frame's attachment use (and the resolve's read of
+// the velocity) before the first subpass, the previous upscale's read of the scene color before this
+// frame's write, and the first subpass' writes before the second one's reads - by region, so each pixel
+// only waits for itself and nothing leaves the tile. The last one orders everything the pass wrote
+// before what reads it afterwards: ambient occlusion between the split halves of the deferred pass
+// and the other half's loads. Every variant of the deferred pass needs the same set to stay compatible.
+std::array<vk::SubpassDependency, 4> twoSubpassDependencies() {
+    return {
+        vk::SubpassDependency()
+        .setSrcSubpass(VK_SUBPASS_EXTERNAL)
+        .setDstSubpass(0)
+        .setSrcStageMask(vk::PipelineStageFlagBits::eFragmentShader |
+                         vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                         vk::PipelineStageFlagBits::eLateFragmentTests)
+        .setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+        .setDstStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                         vk::PipelineStageFlagBits::eEarlyFragmentTests)
+        .setDstAccessMask(vk::AccessFlagBits::eColorAttachmentWrite |
+                          vk::AccessFlagBits::eDepthStencilAttachmentWrite),
+        vk::SubpassDependency()
+        .setSrcSubpass(VK_SUBPASS_EXTERNAL)
+        .setDstSubpass(1)
+        .setSrcStageMask(vk::PipelineStageFlagBits::eFragmentShader |
+                         vk::PipelineStageFlagBits::eColorAttachmentOutput)
+        .setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite)
+        .setDstStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput)
+        .setDstAccessMask(vk::AccessFlagBits::eColorAttachmentWrite),
+        vk::SubpassDependency()
+        .setSrcSubpass(0)
+        .setDstSubpass(1)
+        .setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                         vk::PipelineStageFlagBits::eLateFragmentTests)
+        .setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite |
+                          vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+        .setDstStageMask(vk::PipelineStageFlagBits::eFragmentShader |
+                         vk::PipelineStageFlagBits::eEarlyFragmentTests)
+        .setDstAccessMask(vk::AccessFlagBits::eInputAttachmentRead |
+                          vk::AccessFlagBits::eDepthStencilAttachmentRead)
+        .setDependencyFlags(vk::DependencyFlagBits::eByRegion),
+        vk::SubpassDependency()
+        .setSrcSubpass(1)
+        .setDstSubpass(VK_SUBPASS_EXTERNAL)
+        .setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                         vk::PipelineStageFlagBits::eLateFragmentTests)
+        .setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite |
+                          vk::AccessFlagBits::eDepthStencilAttachmentWrite)
+        .setDstStageMask(vk::PipelineStageFlagBits::eComputeShader |
+                         vk::PipelineStageFlagBits::eFragmentShader |
+                         vk::PipelineStageFlagBits::eEarlyFragmentTests |
+                         vk::PipelineStageFlagBits::eColorAttachmentOutput)
+        .setDstAccessMask(vk::AccessFlagBits::eShaderRead |
+                          vk::AccessFlagBits::eInputAttachmentRead |
+                          vk::AccessFlagBits::eDepthStencilAttachmentRead |
+                          vk::AccessFlagBits::eColorAttachmentRead)
+    };
+}
+}
+
 RenderPass::~RenderPass() {
     if (renderPass_) {
         context_.getDevice().destroyRenderPass(renderPass_);
     }
+    if (geometryRenderPass_) {
+        context_.getDevice().destroyRenderPass(geometryRenderPass_);
+    }
+    if (lightingRenderPass_) {
+        context_.getDevice().destroyRenderPass(lightingRenderPass_);
+    }
+    if (visibilityRenderPass_) {
+        context_.getDevice().destroyRenderPass(visibilityRenderPass_);
+    }
+    if (upscaleRenderPass_) {
+        context_.getDevice().destroyRenderPass(upscaleRenderPass_);
+    }
+    if (temporalRenderPass_) {
+        context_.getDevice().destroyRenderPass(temporalRenderPass_);
+    }
 }
 
 void RenderPass::createRenderPass() {
-    // 1. Color Attachment
+    renderPass_ = createDeferredRenderPass(DeferredPart::Both);
+    geometryRenderPass_ = createDeferredRenderPass(DeferredPart::Geometry);
+    lightingRenderPass_ = createDeferredRenderPass(DeferredPart::Lighting);
+}
+
+vk::RenderPass RenderPass::createDeferredRenderPass(DeferredPart part) const {
+    // 1. Scene color: written by the lighting subpass
+    auto colorAttachment = storedColorAttachment(gbuffer::SCENE_COLOR_FORMAT);
+
+    // 2. Depth + stencil (see GBuffer.hpp)
+    auto depthAttachment = transientDepthAttachment(scDepthFormat);
+
+    // 3. G-buffer targets: every pixel the lighting subpass reads was written (stencil), so
+    // neither the old contents nor the results are ever needed in memory
+    std::array<vk::AttachmentDescription, gbuffer::ATTACHMENT_COUNT> attachments;
+    attachments[gbuffer::SCENE_COLOR] = colorAttachment;
+    attachments[gbuffer::DEPTH] = depthAttachment;
+    for (uint32_t i = 0; i < gbuffer::TARGET_COUNT; i++) {
+        attachments[gbuffer::TARGETS[i]] = transientColorAttachment(gbuffer::TARGET_FORMATS[i]);
+    }
+    attachments[gbuffer::VELOCITY] = storedColorAttachment(taa::VELOCITY_FORMAT);
+
+    // Split halves: only load/store ops and layouts differ, which keeps them compatible with the whole pass.
+    // The geometry half stores depth/stencil and the G-buffer in the layouts the lighting half reads them in
+    // (and ambient occlusion samples them in); scene color is not touched until the lighting half.
+    if (part == DeferredPart::Geometry) {
+        attachments[gbuffer::SCENE_COLOR].setLoadOp(vk::AttachmentLoadOp::eDontCare)
+                                         .setStoreOp(vk::AttachmentStoreOp::eDontCare);
+        attachments[gbuffer::DEPTH].setStoreOp(vk::AttachmentStoreOp::eStore)
+                                   .setStencilStoreOp(vk::AttachmentStoreOp::eStore);
+        for (auto target : gbuffer::TARGETS) {
+            attachments[target].setStoreOp(vk::AttachmentStoreOp::eStore);
+        }
+    } else if (part == DeferredPart::Lighting) {
+        attachments[gbuffer::DEPTH].setLoadOp(vk::AttachmentLoadOp::eLoad)
+                                   .setStencilLoadOp(vk::AttachmentLoadOp::eLoad)
+                                   .setInitialLayout(vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+        for (auto target : gbuffer::TARGETS) {
+            attachments[target].setLoadOp(vk::AttachmentLoadOp::eLoad)
+                               .setInitialLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        }
+        attachments[gbuffer::VELOCITY].setLoadOp(vk::AttachmentLoadOp::eLoad)
+                                      .setInitialLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    }
+
+    // References. Lighting reads the targets plus depth, which is also its (read-only) stencil attachment,
+    // hence the shared layout.
+    std::array<vk::AttachmentReference, gbuffer::TARGET_COUNT + 1> targetWriteRefs;
+    std::array<vk::AttachmentReference, gbuffer::INPUT_COUNT> inputRefs;
+    for (uint32_t i = 0; i < gbuffer::TARGET_COUNT; i++) {
+        targetWriteRefs[i] = vk::AttachmentReference(gbuffer::TARGETS[i], vk::ImageLayout::eColorAttachmentOptimal);
+        inputRefs[i] = vk::AttachmentReference(gbuffer::TARGETS[i], vk::ImageLayout::eShaderReadOnlyOptimal);
+    }
+    inputRefs[gbuffer::DEPTH_INPUT_INDEX] = vk::AttachmentReference(gbuffer::DEPTH,
+                                                                    vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+    targetWriteRefs[gbuffer::VELOCITY_LOCATION] = vk::AttachmentReference(gbuffer::VELOCITY,
+                                                                          vk::ImageLayout::eColorAttachmentOptimal);
+    // Lighting does not touch the velocity, which still has to survive it to the store
+    const uint32_t velocityPreserve = gbuffer::VELOCITY;
+
+    auto colorAttachmentRef = vk::AttachmentReference()
+                              .setAttachment(gbuffer::SCENE_COLOR)
+                              .setLayout(vk::ImageLayout::eColorAttachmentOptimal);
+
+    auto depthAttachmentRef = vk::AttachmentReference()
+                              .setAttachment(gbuffer::DEPTH)
+                              .setLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal);
+
+    // Lighting only stencil-tests, so depth/stencil stays bound read-only
+    auto depthReadOnlyRef = vk::AttachmentReference()
+                            .setAttachment(gbuffer::DEPTH)
+                            .setLayout(vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+
+    // 4. Subpasses: geometry fills the G-buffer, lighting reads it at the same pixel
+    std::array<vk::SubpassDescription, 2> subpasses = {
+        vk::SubpassDescription()
+        .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+        .setColorAttachments(targetWriteRefs)
+        .setPDepthStencilAttachment(&depthAttachmentRef),
+        vk::SubpassDescription()
+        .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+        .setInputAttachments(inputRefs)
+        .setColorAttachments(colorAttachmentRef)
+        .setPDepthStencilAttachment(&depthReadOnlyRef)
+        .setPreserveAttachments(velocityPreserve)
+    };
+
+    // 5. Dependencies (Synchronization)
+    auto dependencies = twoSubpassDependencies();
+
+    // 6. Depth is read as depth only; the stencil aspect stays with the stencil test
+    auto depthInputAspect = vk::InputAttachmentAspectReference()
+                            .setSubpass(gbuffer::LIGHTING_SUBPASS)
+                            .setInputAttachmentIndex(gbuffer::DEPTH_INPUT_INDEX)
+                            .setAspectMask(vk::ImageAspectFlagBits::eDepth);
+    auto inputAspectInfo = vk::RenderPassInputAttachmentAspectCreateInfo()
+                           .setAspectReferences(depthInputAspect);
+
+    // 7. Create the Render Pass
+    auto renderPassInfo = vk::RenderPassCreateInfo()
+                          .setPNext(&inputAspectInfo)
+                          .setAttachments(attachments)
+                          .setSubpasses(subpasses)
+                          .setDependencies(dependencies);
+
+    return context_.getDevice().createRenderPass(renderPassInfo);
+}
+
+void RenderPass::createVisibilityRenderPass() {
+    // Same shape as the G-buffer pass with one 8-byte target (see VisibilityBuffer.hpp)
+    std::array<vk::AttachmentDescription, visbuffer::ATTACHMENT_COUNT> attachments;
+    attachments[visbuffer::SCENE_COLOR] = storedColorAttachment(gbuffer::SCENE_COLOR_FORMAT);
+    attachments[visbuffer::DEPTH] = transientDepthAttachment(scDepthFormat);
+    attachments[visbuffer::VISIBILITY] = transientColorAttachment(visbuffer::FORMAT);
+    attachments[visbuffer::VELOCITY] = storedColorAttachment(taa::VELOCITY_FORMAT);
+
+    std::array<vk::AttachmentReference, 2> geometryWriteRefs = {
+        vk::AttachmentReference(visbuffer::VISIBILITY, vk::ImageLayout::eColorAttachmentOptimal),
+        vk::AttachmentReference(visbuffer::VELOCITY, vk::ImageLayout::eColorAttachmentOptimal)
+    };
+    const uint32_t velocityPreserve = visbuffer::VELOCITY;
+    auto visibilityReadRef = vk::AttachmentReference(visbuffer::VISIBILITY, vk::ImageLayout::eShaderReadOnlyOptimal);
+    auto colorAttachmentRef = vk::AttachmentReference(visbuffer::SCENE_COLOR,
+                                                      vk::ImageLayout::eColorAttachmentOptimal);
+    auto depthAttachmentRef = vk::AttachmentReference(visbuffer::DEPTH,
+                                                      vk::ImageLayout::eDepthStencilAttachmentOptimal);
+    auto depthReadOnlyRef = vk::AttachmentReference(visbuffer::DEPTH, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+
+    std::array<vk::SubpassDescription, 2> subpasses = {
+        vk::SubpassDescription()
+        .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+        .setColorAttachments(geometryWriteRefs)
+        .setPDepthStencilAttachment(&depthAttachmentRef),
+        vk::SubpassDescription()
+        .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+        .setInputAttachments(visibilityReadRef)
+        .setColorAttachments(colorAttachmentRef)
+        .setPDepthStencilAttachment(&depthReadOnlyRef)
+        .setPreserveAttachments(velocityPreserve)
+    };
+
+    auto dependencies = twoSubpassDependencies();
+
+    auto renderPassInfo = vk::RenderPassCreateInfo()
+                          .setAttachments(attachments)
+                          .setSubpasses(subpasses)
+                          .setDependencies(dependencies);
+
+    visibilityRenderPass_ = context_.getDevice().createRenderPass(renderPassInfo);
+}
+
+void RenderPass::createUpscaleRenderPass() {
+    // Every pixel is written by the fullscreen triangle, so the old contents are never loaded
     auto colorAttachment = vk::AttachmentDescription()
                            .setFormat(scColorFormat)
                            .setSamples(vk::SampleCountFlagBits::e1)
-                           .setLoadOp(vk::AttachmentLoadOp::eClear)
+                           .setLoadOp(vk::AttachmentLoadOp::eDontCare)
                            .setStoreOp(vk::AttachmentStoreOp::eStore)
                            .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
                            .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
                            .setInitialLayout(vk::ImageLayout::eUndefined)
                            .setFinalLayout(vk::ImageLayout::ePresentSrcKHR);
 
-    // 2. Depth Attachment
-    auto depthAttachment = vk::AttachmentDescription()
-                           .setFormat(scDepthFormat)
-                           .setSamples(vk::SampleCountFlagBits::e1)
-                           .setLoadOp(vk::AttachmentLoadOp::eClear)
-                           .setStoreOp(vk::AttachmentStoreOp::eDontCare)
-                           .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
-                           .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
-                           .setInitialLayout(vk::ImageLayout::eUndefined)
-                           .setFinalLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal);
+    auto colorAttachmentRef = vk::AttachmentReference(0, vk::ImageLayout::eColorAttachmentOptimal);
 
-    // References
-    auto colorAttachmentRef = vk::AttachmentReference()
-                              .setAttachment(0)
-                              .setLayout(vk::ImageLayout::eColorAttachmentOptimal);
+    auto subpass = vk::SubpassDescription()
+                   .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+                   .setColorAttachments(colorAttachmentRef);
 
-    auto depthAttachmentRef = vk::AttachmentReference()
-                              .setAttachment(1)
-                              .setLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal);
+    // The main pass' scene color writes before the sampling, and the acquire before the swapchain write
+    auto dependency = vk::SubpassDependency()
+                      .setSrcSubpass(VK_SUBPASS_EXTERNAL)
+                      .setDstSubpass(0)
+                      .setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput)
+                      .setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite)
+                      .setDstStageMask(vk::PipelineStageFlagBits::eFragmentShader |
+                                       vk::PipelineStageFlagBits::eColorAttachmentOutput)
+                      .setDstAccessMask(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eColorAttachmentWrite);
+
+    auto renderPassInfo = vk::RenderPassCreateInfo()
+                          .setAttachments(colorAttachment)
+                          .setSubpasses(subpass)
+                          .setDependencies(dependency);
+
+    upscaleRenderPass_ = context_.getDevice().createRenderPass(renderPassInfo);
+}
+
+void RenderPass::createTemporalRenderPass() {
+    // Both outputs are written at every pixel by the fullscreen triangle, so nothing is loaded
+    std::array<vk::AttachmentDescription, taa::ATTACHMENT_COUNT> attachments;
+    attachments[taa::OUTPUT] = vk::AttachmentDescription()
+                               .setFormat(scColorFormat)
+                               .setSamples(vk::SampleCountFlagBits::e1)
+                               .setLoadOp(vk::AttachmentLoadOp::eDontCare)
+                               .setStoreOp(vk::AttachmentStoreOp::eStore)
+                               .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
+                               .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
+                               .setInitialLayout(vk::ImageLayout::eUndefined)
+                               .setFinalLayout(vk::ImageLayout::ePresentSrcKHR);
+    attachments[taa::HISTORY] = vk::AttachmentDescription(attachments[taa::OUTPUT])
+                                .setFormat(taa::HISTORY_FORMAT)
+                                .setFinalLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    std::array<vk::AttachmentReference, taa::ATTACHMENT_COUNT> colorAttachmentRefs = {
+        vk::AttachmentReference(taa::OUTPUT, vk::ImageLayout::eColorAttachmentOptimal),
+        vk::AttachmentReference(taa::HISTORY, vk::ImageLayout::eColorAttachmentOptimal)
+    };
 
-    // 3. Subpass
     auto subpass = vk::SubpassDescription()
                    .setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
-                   .setColorAttachmentCount(1)
-                   .setPColorAttachments(&colorAttachmentRef)
-                   .setPDepthStencilAttachment(&depthAttachmentRef);
+                   .setColorAttachments(colorAttachmentRefs);
 
-    // 4. Dependency (Synchronization)
+    // As for the upscale pass, plus the previous resolve: its history write before this frame's read,
+    // and its read of the image before this frame overwrites it
     auto dependency = vk::SubpassDependency()
                       .setSrcSubpass(VK_SUBPASS_EXTERNAL)
                       .setDstSubpass(0)
-                      .setSrcStageMask(
-                          vk::PipelineStageFlagBits::eColorAttachmentOutput |
-                          vk::PipelineStageFlagBits::eLateFragmentTests)
-                      .setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite)
-                      .setDstStageMask(
-                          vk::PipelineStageFlagBits::eColorAttachmentOutput |
-                          vk::PipelineStageFlagBits::eEarlyFragmentTests)
-                      .setDstAccessMask(
-                          vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite);
-
-    // 5. Create the Render Pass
-    std::array<vk::AttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+                      .setSrcStageMask(vk::PipelineStageFlagBits::eFragmentShader |
+                                       vk::PipelineStageFlagBits::eColorAttachmentOutput)
+                      .setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite)
+                      .setDstStageMask(vk::PipelineStageFlagBits::eFragmentShader |
+                                       vk::PipelineStageFlagBits::eColorAttachmentOutput)
+                      .setDstAccessMask(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eColorAttachmentWrite);
 
     auto renderPassInfo = vk::RenderPassCreateInfo()
                           .setAttachments(attachments)
-                          .setSubpassCount(1)
-                          .setPSubpasses(&subpass)
-                          .setDependencyCount(1)
-                          .setPDependencies(&dependency);
+                          .setSubpasses(subpass)
+                          .setDependencies(dependency);
 
-    renderPass_ = context_.getDevice().createRenderPass(renderPassInfo);
+    temporalRenderPass_ = context_.getDevice().createRenderPass(renderPassInfo);
 }
\ No newline at end of file
@@ -9,6 +9,9 @@
 class VulkanContext;
 class SwapChain;
 
+// The main render passes: G-buffer and lighting subpasses (GBuffer.hpp), and the visibility-buffer
+// alternative (VisibilityBuffer.hpp). Both render into the scene color target; the upscale pass, or the
+// temporal resolve (TemporalAA.hpp) with anti-aliasing on, then samples it into the swapchain image.
 class RenderPass {
 public:
     RenderPass(VulkanContext &context, vk::Format colorFormat, vk::Format depthFormat)
@@ -16,17 +19,43 @@ public:
           scColorFormat(colorFormat),
           scDepthFormat(depthFormat) {
         createRenderPass();
+        createVisibilityRenderPass();
+        createUpscaleRenderPass();
+        createTemporalRenderPass();
     }
 
     ~RenderPass();
 
     [[nodiscard]] vk::RenderPass getRenderPass() const { return renderPass_; }
+    // The G-buffer pass split in two, for work that has to run between geometry and lighting (ambient
+    // occlusion): the first half stores the G-buffer, the second loads it. Both are compatible with
+    // getRenderPass(), so they share its framebuffer and pipelines; each leaves the other's subpass empty.
+    [[nodiscard]] vk::RenderPass getGeometryRenderPass() const { return geometryRenderPass_; }
+    [[nodiscard]] vk::RenderPass getLightingRenderPass() const { return lightingRenderPass_; }
+    [[nodiscard]] vk::RenderPass getVisibilityRenderPass() const { return visibilityRenderPass_; }
+    [[nodiscard]] vk::RenderPass getUpscaleRenderPass() const { return upscaleRenderPass_; }
+    [[nodiscard]] vk::RenderPass getTemporalRenderPass() const { return temporalRenderPass_; }
 
 private:
     VulkanContext &context_;
     vk::Format scColorFormat;
     vk::Format scDepthFormat;
     vk::RenderPass renderPass_;
+    vk::RenderPass geometryRenderPass_;
+    vk::RenderPass lightingRenderPass_;
+    vk::RenderPass visibilityRenderPass_;
+    vk::RenderPass upscaleRenderPass_;
+    vk::RenderPass temporalRenderPass_;
+
+    enum class DeferredPart {
+        Both,
+        Geometry,
+        Lighting,
+    };
 
     void createRenderPass();
+    [[nodiscard]] vk::RenderPass createDeferredRenderPass(DeferredPart part) const;
+    void createVisibilityRenderPass();
+    void createUpscaleRenderPass();
+    void createTemporalRenderPass();
 };
\ No newline at end of file
@@ -3,10 +3,15 @@
 //
 
 #include "swap_chain.hpp"
+#include "render_pass.hpp"
+#include "DeletionQueue.hpp"
 #include "VulkanContext.hpp"
+#include "common/config.hpp"
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <limits>
+#include <utility>
 
 namespace {
 // VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats) {
@@ -54,9 +59,10 @@ vk::SurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormat
 //     return VK_PRESENT_MODE_FIFO_KHR;
 // }
 
-vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR> &availablePresentModes) {
-    // Triple Buffering (Mailbox) is preferred for performance without tearing
-    auto it = std::find(availablePresentModes.begin(), availablePresentModes.end(), vk::PresentModeKHR::eMailbox);
+vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR> &availablePresentModes,
+                                         vk::PresentModeKHR preferred) {
+    // The requested mode (Mailbox by default: triple buffering without tearing) if the surface has it
+    auto it = std::find(availablePresentModes.begin(), availablePresentModes.end(), preferred);
 
     if (it != availablePresentModes.end()) {
         return *it;
@@ -65,6 +71,19 @@ vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR> &
     // Standard V-Sync (FIFO) is guaranteed to be supported by the Vulkan spec
     return vk::PresentModeKHR::eFifo;
 }
+
+// Rounded up, so growing a window a few pixels at a time does not reallocate every frame
+vk::Extent2D roundToGranularity(vk::Extent2D extent) {
+    constexpr uint32_t g = engine::TARGET_GRANULARITY;
+    return {(extent.width + g - 1) / g * g, (extent.height + g - 1) / g * g};
+}
+
+// 'current' has to go if 'required' does not fit in it, or fills less than a quarter of it
+bool needsReallocation(vk::Extent2D current, vk::Extent2D required) {
+    const uint64_t currentArea = static_cast<uint64_t>(current.width) * current.height;
+    const uint64_t requiredArea = static_cast<uint64_t>(required.width) * required.height;
+    return required.width > current.width || required.height > current.height || 4 * requiredArea < currentArea;
+}
 }
 
 SwapChain::~SwapChain() {
@@ -72,30 +91,97 @@ SwapChain::~SwapChain() {
 }
 
 void SwapChain::cleanup() {
-    auto device = context_.getDevice();
+    Retired retired;
+    retireOutputs(retired);
+    retireTargets(retired);
+    retireHistory(retired);
+    retired.swapChain = swapChain_;
+    swapChain_ = nullptr;
+    destroy(retired);
+}
+
+bool SwapChain::recreate(const RenderPass &renderPass, DeletionQueue &deletionQueue) {
+    // Frames in flight may still render to or present the old images, so nothing is destroyed here. The old
+    // swapchain is retired by passing it as oldSwapchain, which also lets the driver reuse its memory.
+    Retired retired;
+    retireOutputs(retired);
+    retired.swapChain = swapChain_;
+    createSwapChain(retired.swapChain);
+    createImageViews();
+
+    // Size-dependent targets lazily: only when they no longer fit (or have become mostly waste)
+    const vk::Extent2D requiredTarget(
+        static_cast<uint32_t>(std::ceil(static_cast<float>(swapChainExtent_.width) * engine::MAX_RENDER_SCALE)),
+        static_cast<uint32_t>(std::ceil(static_cast<float>(swapChainExtent_.height) * engine::MAX_RENDER_SCALE)));
+    const bool targets = needsReallocation(targetExtent_, requiredTarget) || storeGBuffer_ != gbufferStored_;
+    const bool history = needsReallocation(historyExtent_, swapChainExtent_);
+    if (targets) {
+        retireTargets(retired);
+        createTargets();
+        createTargetFramebuffers(renderPass);
+    }
+    if (history) {
+        retireHistory(retired);
+        createHistory();
+    }
+    createOutputFramebuffers(renderPass);
 
-    // Using .destroy() instead of vkDestroy...
-    if (depthImageView)
-        device.destroyImageView(depthImageView);
-    if (depthImage)
-        device.destroyImage(depthImage);
-    if (depthImageMemory)
-        device.freeMemory(depthImageMemory);
+    deletionQueue.push([this, retired]() mutable { destroy(retired); });
+    return targets || history;
+}
 
-    for (auto framebuffer : swapChainFramebuffers_) {
-        device.destroyFramebuffer(framebuffer);
+void SwapChain::retireOutputs(Retired &retired) {
+    retired.views.insert(retired.views.end(), swapChainImageViews_.begin(), swapChainImageViews_.end());
+    swapChainImageViews_.clear();
+    retired.framebuffers.insert(retired.framebuffers.end(), upscaleFramebuffers_.begin(),
+                                upscaleFramebuffers_.end());
+    upscaleFramebuffers_.clear();
+    retired.framebuffers.insert(retired.framebuffers.end(), temporalFramebuffers_.begin(),
+                                temporalFramebuffers_.end());
+    temporalFramebuffers_.clear();
+}
+
+void SwapChain::retireTargets(Retired &retired) {
+    retired.views.push_back(depthOnlyView_);
+    depthOnlyView_ = nullptr;
+    retired.framebuffers.push_back(framebuffer_);
+    framebuffer_ = nullptr;
+    retired.framebuffers.push_back(visibilityFramebuffer_);
+    visibilityFramebuffer_ = nullptr;
+
+    retired.attachments.push_back(std::exchange(depth_, {}));
+    for (auto &target : gbufferTargets_) {
+        retired.attachments.push_back(std::exchange(target, {}));
     }
-    swapChainFramebuffers_.clear();
+    retired.attachments.push_back(std::exchange(visibility_, {}));
+    retired.attachments.push_back(std::exchange(sceneColor_, {}));
+    retired.attachments.push_back(std::exchange(velocity_, {}));
+}
 
-    for (auto imageView : swapChainImageViews_) {
-        device.destroyImageView(imageView);
+void SwapChain::retireHistory(Retired &retired) {
+    for (auto &history : history_) {
+        retired.attachments.push_back(std::exchange(history, {}));
     }
-    swapChainImageViews_.clear();
+}
+
+void SwapChain::destroy(Retired &retired) const {
+    auto device = context_.getDevice();
 
-    if (swapChain_) {
-        device.destroySwapchainKHR(swapChain_);
-        swapChain_ = nullptr;
+    // Framebuffers before the views they reference, the swapchain after its image views
+    for (auto framebuffer : retired.framebuffers) {
+        if (framebuffer)
+            device.destroyFramebuffer(framebuffer);
     }
+    for (auto view : retired.views) {
+        if (view)
+            device.destroyImageView(view);
+    }
+    for (auto &attachment : retired.attachments) {
+        destroyAttachment(attachment);
+    }
+    if (retired.swapChain)
+        device.destroySwapchainKHR(retired.swapChain);
+    retired = {};
 }
 
 bool SwapChain::isDeviceAdequate(vk::PhysicalDevice device, vk::SurfaceKHR surface) {
@@ -112,17 +198,21 @@ SwapChain::SwapChainSupportDetails SwapChain::querySwapChainSupport(vk::Physical
     return details;
 }
 
-void SwapChain::createSwapChain() {
+void SwapChain::createSwapChain(vk::SwapchainKHR oldSwapChain) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(context_.getPhysicalDevice(),
                                                                      context_.getSurface());
 
     vk::SurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-    vk::PresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+    vk::PresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes, presentSettings_.mode);
     vk::Extent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-    uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
-    if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
-        imageCount = swapChainSupport.capabilities.maxImageCount;
+    // Every image beyond the minimum is one more frame that can queue up in front of the display
+    const auto &capabilities = swapChainSupport.capabilities;
+    uint32_t imageCount = presentSettings_.imageCount != 0 ? presentSettings_.imageCount
+                                                           : capabilities.minImageCount + 1;
+    imageCount = std::max(imageCount, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount) {
+        imageCount = capabilities.maxImageCount;
     }
 
     auto createInfo = vk::SwapchainCreateInfoKHR()
@@ -148,7 +238,8 @@ void SwapChain::createSwapChain() {
     createInfo.setPreTransform(swapChainSupport.capabilities.currentTransform)
               .setCompositeAlpha(vk::CompositeAlphaFlagBitsKHR::eOpaque)
               .setPresentMode(presentMode)
-              .setClipped(true);
+              .setClipped(true)
+              .setOldSwapchain(oldSwapChain);
 
     swapChain_ = context_.getDevice().createSwapchainKHR(createInfo);
 
@@ -156,19 +247,20 @@ void SwapChain::createSwapChain() {
     swapChainImages_ = context_.getDevice().getSwapchainImagesKHR(swapChain_);
     swapChainImageFormat_ = surfaceFormat.format;
     swapChainExtent_ = extent;
+
+    if (presentMode != presentMode_ || swapChainImages_.size() != imageCount_) {
+        std::cout << "-- Present mode: " << vk::to_string(presentMode) << ", " << swapChainImages_.size()
+                  << " images" << std::endl;
+    }
+    presentMode_ = presentMode;
+    imageCount_ = static_cast<uint32_t>(swapChainImages_.size());
 }
 
 vk::Extent2D SwapChain::chooseSwapExtent(const vk::SurfaceCapabilitiesKHR &capabilities) const {
     if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
         return capabilities.currentExtent;
     } else {
-        int width, height;
-        glfwGetFramebufferSize(window_, &width, &height);
-
-        vk::Extent2D actualExtent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
-        };
+        vk::Extent2D actualExtent = framebufferSize_;
 
         actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width,
                                         capabilities.maxImageExtent.width);
@@ -197,47 +289,197 @@ vk::ImageView SwapChain::createImageView(vk::Image image, vk::Format format, vk:
     return context_.getDevice().createImageView(viewInfo);
 }
 
-void SwapChain::createFramebuffers(vk::RenderPass renderPass) {
-    swapChainFramebuffers_.resize(swapChainImageViews_.size());
+void SwapChain::createFramebuffers(const RenderPass &renderPass) {
+    createTargetFramebuffers(renderPass);
+    createOutputFramebuffers(renderPass);
+}
+
+void SwapChain::createTargetFramebuffers(const RenderPass &renderPass) {
+    auto device = context_.getDevice();
+
+    std::array<vk::ImageView, gbuffer::ATTACHMENT_COUNT> attachments;
+    attachments[gbuffer::SCENE_COLOR] = sceneColor_.view;
+    attachments[gbuffer::DEPTH] = depth_.view;
+    for (uint32_t t = 0; t < gbuffer::TARGET_COUNT; t++) {
+        attachments[gbuffer::TARGETS[t]] = gbufferTargets_[t].view;
+    }
+    attachments[gbuffer::VELOCITY] = velocity_.view;
+
+    auto framebufferInfo = vk::FramebufferCreateInfo()
+                           .setRenderPass(renderPass.getRenderPass())
+                           .setAttachments(attachments)
+                           .setWidth(targetExtent_.width)
+                           .setHeight(targetExtent_.height)
+                           .setLayers(1);
+    framebuffer_ = device.createFramebuffer(framebufferInfo);
+
+    if (visibility_.view) {
+        std::array<vk::ImageView, visbuffer::ATTACHMENT_COUNT> visibilityAttachments;
+        visibilityAttachments[visbuffer::SCENE_COLOR] = sceneColor_.view;
+        visibilityAttachments[visbuffer::DEPTH] = depth_.view;
+        visibilityAttachments[visbuffer::VISIBILITY] = visibility_.view;
+        visibilityAttachments[visbuffer::VELOCITY] = velocity_.view;
+
+        framebufferInfo.setRenderPass(renderPass.getVisibilityRenderPass())
+                       .setAttachments(visibilityAttachments);
+        visibilityFramebuffer_ = device.createFramebuffer(framebufferInfo);
+    }
+}
+
+void SwapChain::createOutputFramebuffers(const RenderPass &renderPass) {
+    auto device = context_.getDevice();
+
+    upscaleFramebuffers_.resize(swapChainImageViews_.size());
+    for (size_t i = 0; i < swapChainImageViews_.size(); i++) {
+        auto upscaleInfo = vk::FramebufferCreateInfo()
+                           .setRenderPass(renderPass.getUpscaleRenderPass())
+                           .setAttachments(swapChainImageViews_[i])
+                           .setWidth(swapChainExtent_.width)
+                           .setHeight(swapChainExtent_.height)
+                           .setLayers(1);
+        upscaleFramebuffers_[i] = device.createFramebuffer(upscaleInfo);
+    }
 
+    temporalFramebuffers_.resize(swapChainImageViews_.size() * taa::HISTORY_COUNT);
     for (size_t i = 0; i < swapChainImageViews_.size(); i++) {
-        std::array<vk::ImageView, 2> attachments = {
-            swapChainImageViews_[i],
-            depthImageView
-        };
-
-        auto framebufferInfo = vk::FramebufferCreateInfo()
-                               .setRenderPass(renderPass)
-                               .setAttachments(attachments)
-                               .setWidth(swapChainExtent_.width)
-                               .setHeight(swapChainExtent_.height)
-                               .setLayers(1);
-
-        swapChainFramebuffers_[i] = context_.getDevice().createFramebuffer(framebufferInfo);
+        for (uint32_t h = 0; h < taa::HISTORY_COUNT; h++) {
+            std::array<vk::ImageView, taa::ATTACHMENT_COUNT> temporalAttachments;
+            temporalAttachments[taa::OUTPUT] = swapChainImageViews_[i];
+            temporalAttachments[taa::HISTORY] = history_[h].view;
+            auto temporalInfo = vk::FramebufferCreateInfo()
+                                .setRenderPass(renderPass.getTemporalRenderPass())
+                                .setAttachments(temporalAttachments)
+                                .setWidth(swapChainExtent_.width)
+                                .setHeight(swapChainExtent_.height)
+                                .setLayers(1);
+            temporalFramebuffers_[i * taa::HISTORY_COUNT + h] = device.createFramebuffer(temporalInfo);
+        }
     }
 }
 
-void SwapChain::createDepthResources() {
+void SwapChain::chooseGBufferStorage() {
+    // On tilers a transient G-buffer stays in tile memory, and storing it for ambient occlusion would cost
+    // its full size in device memory. There it starts transient and occlusion off (Renderer::initResources).
+    lazyMemory_ = context_.tryFindMemoryType(~0u, vk::MemoryPropertyFlagBits::eDeviceLocal |
+                                                  vk::MemoryPropertyFlagBits::eLazilyAllocated).has_value();
+    storeGBuffer_ = engine::SSAO && !lazyMemory_;
+}
+
+void SwapChain::createTargets() {
     vk::Format depthFormat = findDepthFormat();
 
-    createImage(swapChainExtent_.width, swapChainExtent_.height, depthFormat,
-                vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment,
-                vk::MemoryPropertyFlagBits::eDeviceLocal, depthImage, depthImageMemory);
+    // Sized for the largest render scale; smaller scales (and smaller windows, until the targets are
+    // reallocated) just use less of them
+    targetExtent_ = roundToGranularity(vk::Extent2D(
+        static_cast<uint32_t>(std::ceil(static_cast<float>(swapChainExtent_.width) * engine::MAX_RENDER_SCALE)),
+        static_cast<uint32_t>(std::ceil(static_cast<float>(swapChainExtent_.height) * engine::MAX_RENDER_SCALE))));
+
+    // Shared by every swapchain image: the render pass finishes with them before it ends
+    // Depth is also an input attachment: lighting rebuilds positions from it. With ambient occlusion the
+    // pass is split around it (RenderPass::getGeometryRenderPass), so the G-buffer has to be storable and
+    // depth and normals sampled: none of it can be transient then.
+    const bool stored = storeGBuffer_;
+    gbufferStored_ = stored;
+    lazyAttachments_ = false;
+    const vk::ImageUsageFlags occlusionInput = stored ? vk::ImageUsageFlagBits::eSampled : vk::ImageUsageFlags{};
+    depth_ = createTransientAttachment(depthFormat, vk::ImageUsageFlagBits::eDepthStencilAttachment |
+                                       vk::ImageUsageFlagBits::eInputAttachment | occlusionInput,
+                                       vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil, stored);
+    depthOnlyView_ = createImageView(depth_.image, depthFormat, vk::ImageAspectFlagBits::eDepth);
+    for (uint32_t i = 0; i < gbuffer::TARGET_COUNT; i++) {
+        const bool sampled = gbuffer::TARGETS[i] == gbuffer::NORMAL;
+        gbufferTargets_[i] = createTransientAttachment(gbuffer::TARGET_FORMATS[i],
+                                                       vk::ImageUsageFlagBits::eColorAttachment |
+                                                       vk::ImageUsageFlagBits::eInputAttachment |
+                                                       (sampled ? occlusionInput : vk::ImageUsageFlags{}),
+                                                       vk::ImageAspectFlagBits::eColor, stored);
+    }
+    if (context_.supportsVisibilityBuffer()) {
+        visibility_ = createTransientAttachment(visbuffer::FORMAT, vk::ImageUsageFlagBits::eColorAttachment |
+                                                vk::ImageUsageFlagBits::eInputAttachment,
+                                                vk::ImageAspectFlagBits::eColor, false);
+    }
+
+    sceneColor_ = createSampledAttachment(targetExtent_, gbuffer::SCENE_COLOR_FORMAT);
+    velocity_ = createSampledAttachment(targetExtent_, taa::VELOCITY_FORMAT);
 
-    depthImageView = createImageView(depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth);
+    std::cout << "-- Render targets: " << targetExtent_.width << "x" << targetExtent_.height << ", "
+              << (lazyAttachments_ ? "lazily allocated" : "device local")
+              << (stored ? ", G-buffer stored" : "") << std::endl;
+}
+
+void SwapChain::createHistory() {
+    historyExtent_ = roundToGranularity(swapChainExtent_);
+    for (auto &history : history_) {
+        history = createSampledAttachment(historyExtent_, taa::HISTORY_FORMAT);
+    }
+}
+
+SwapChain::Attachment SwapChain::createTransientAttachment(vk::Format format, vk::ImageUsageFlags usage,
+                                                           vk::ImageAspectFlags aspect, bool stored) {
+    // Lazily allocated memory is only committed if the tile has to spill, which on tilers it never does.
+    // Desktop GPUs have no such memory type and get plain device-local images.
+    Attachment attachment;
+    bool lazy = false;
+    createImage(targetExtent_.width, targetExtent_.height, format, vk::ImageTiling::eOptimal,
+                stored ? usage : usage | vk::ImageUsageFlagBits::eTransientAttachment,
+                stored ? vk::MemoryPropertyFlagBits::eDeviceLocal
+                       : vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated,
+                vk::MemoryPropertyFlagBits::eDeviceLocal, attachment.image, attachment.memory, lazy);
+    attachment.view = createImageView(attachment.image, format, aspect);
+    if (!stored)
+        lazyAttachments_ = lazy;
+    return attachment;
+}
+
+SwapChain::Attachment SwapChain::createSampledAttachment(vk::Extent2D extent, vk::Format format) {
+    Attachment attachment;
+    bool deviceLocal = false;
+    createImage(extent.width, extent.height, format, vk::ImageTiling::eOptimal,
+                vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled,
+                vk::MemoryPropertyFlagBits::eDeviceLocal, vk::MemoryPropertyFlagBits::eDeviceLocal, attachment.image,
+                attachment.memory, deviceLocal);
+    attachment.view = createImageView(attachment.image, format, vk::ImageAspectFlagBits::eColor);
+    return attachment;
+}
+
+void SwapChain::destroyAttachment(Attachment &attachment) const {
+    auto device = context_.getDevice();
+    if (attachment.view)
+        device.destroyImageView(attachment.view);
+    if (attachment.image)
+        device.destroyImage(attachment.image);
+    if (attachment.memory)
+        device.freeMemory(attachment.memory);
+    attachment = {};
+}
+
+std::array<vk::ImageView, gbuffer::INPUT_COUNT> SwapChain::getGBufferViews() const {
+    std::array<vk::ImageView, gbuffer::INPUT_COUNT> views;
+    for (uint32_t i = 0; i < gbuffer::TARGET_COUNT; i++) {
+        views[i] = gbufferTargets_[i].view;
+    }
+    views[gbuffer::DEPTH_INPUT_INDEX] = depthOnlyView_;
+    return views;
 }
 
 vk::Format SwapChain::findDepthFormat() {
+    // Stencil is required: it carries the shading model from the geometry to the lighting subpass.
+    // Ambient occlusion samples the depth as well.
+    vk::FormatFeatureFlags features = vk::FormatFeatureFlagBits::eDepthStencilAttachment;
+    if (engine::SSAO)
+        features |= vk::FormatFeatureFlagBits::eSampledImage;
     return swapChainDepthFormat_ = context_.findSupportedFormat(
-               {vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint},
+               {vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint},
                vk::ImageTiling::eOptimal,
-               vk::FormatFeatureFlagBits::eDepthStencilAttachment
+               features
                );
 }
 
 void SwapChain::createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling,
-                            vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image &image,
-                            vk::DeviceMemory &imageMemory) const {
+                            vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties,
+                            vk::MemoryPropertyFlags fallback, vk::Image &image, vk::DeviceMemory &imageMemory,
+                            bool &usedPreferred) const {
 
     auto imageInfo = vk::ImageCreateInfo()
                      .setImageType(vk::ImageType::e2D)
@@ -255,9 +497,14 @@ void SwapChain::createImage(uint32_t width, uint32_t height, vk::Format format,
 
     vk::MemoryRequirements memRequirements = context_.getDevice().getImageMemoryRequirements(image);
 
+    auto memoryType = context_.tryFindMemoryType(memRequirements.memoryTypeBits, properties);
+    usedPreferred = memoryType.has_value();
+    if (!usedPreferred)
+        memoryType = context_.findMemoryType(memRequirements.memoryTypeBits, fallback);
+
     auto allocInfo = vk::MemoryAllocateInfo()
                      .setAllocationSize(memRequirements.size)
-                     .setMemoryTypeIndex(context_.findMemoryType(memRequirements.memoryTypeBits, properties));
+                     .setMemoryTypeIndex(*memoryType);
 
     imageMemory = context_.getDevice().allocateMemory(allocInfo);
     context_.getDevice().bindImageMemory(image, imageMemory, 0);
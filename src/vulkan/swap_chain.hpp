@@ -2,28 +2,47 @@
 // Created by johnny on 12/25/25.
 //
 #pragma once
+#include <array>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 #include <GLFW/glfw3.h>
 
+#include "GBuffer.hpp"
+#include "common/config.hpp"
+#include "TemporalAA.hpp"
+#include "VisibilityBuffer.hpp"
+
+class DeletionQueue;
+class RenderPass;
 class VulkanContext;
 
 class SwapChain {
 public:
     SwapChain(VulkanContext &context, GLFWwindow *window)
         : context_(context), window_(window) {
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window_, &width, &height);
+        framebufferSize_ = vk::Extent2D(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+        chooseGBufferStorage();
         init();
     }
 
     ~SwapChain();
 
-    // Recreate now uses vk::RenderPass
-    void recreate(vk::RenderPass renderPass) {
-        cleanup();
-        init();
-        createFramebuffers(renderPass);
-    }
+    // What the next swapchain is created with; a mode the surface lacks falls back to FIFO, the image
+    // count is clamped to the surface's range (0 = its minimum + 1)
+    struct PresentSettings {
+        vk::PresentModeKHR mode = vk::PresentModeKHR::eMailbox;
+        uint32_t imageCount = engine::SWAPCHAIN_IMAGE_COUNT;
+    };
 
+    // Replaces the swapchain without idling the device: the new one is created with the current one as
+    // oldSwapchain, and everything tied to the old images is handed to 'deletionQueue'. The render targets
+    // and history images are only reallocated when they no longer fit or waste most of their memory;
+    // returns true if they were, so their descriptors need rewriting.
+    bool recreate(const RenderPass &renderPass, DeletionQueue &deletionQueue);
+
+    // Destroys everything right away; the device must be idle
     void cleanup();
 
     struct SwapChainSupportDetails {
@@ -40,11 +59,54 @@ public:
     vk::Format getColorFormat() const { return swapChainImageFormat_; }
     vk::Extent2D getExtent() const { return swapChainExtent_; }
     vk::SwapchainKHR getHandle() const { return swapChain_; }
+    // Window size in pixels, for surfaces that leave the extent to the swapchain. Passed in because GLFW may
+    // only be queried on the main thread; the constructor reads it there.
+    void setFramebufferSize(vk::Extent2D size) { framebufferSize_ = size; }
+    // Takes effect with the next recreate()
+    void setPresentSettings(const PresentSettings &settings) { presentSettings_ = settings; }
+    [[nodiscard]] const PresentSettings &getPresentSettings() const { return presentSettings_; }
+    // The mode the current swapchain actually uses
+    [[nodiscard]] vk::PresentModeKHR getPresentMode() const { return presentMode_; }
     const std::vector<vk::ImageView> &getImageViews() const { return swapChainImageViews_; }
-    [[nodiscard]] const std::vector<vk::Framebuffer> &getFramebuffers() const { return swapChainFramebuffers_; }
+    // Main passes: one framebuffer each, the scene color target does not depend on the swapchain image.
+    // The visibility one is null when the device cannot run that mode.
+    [[nodiscard]] vk::Framebuffer getFramebuffer() const { return framebuffer_; }
+    [[nodiscard]] vk::Framebuffer getVisibilityFramebuffer() const { return visibilityFramebuffer_; }
+    // Upscale pass, one per swapchain image
+    [[nodiscard]] const std::vector<vk::Framebuffer> &getUpscaleFramebuffers() const { return upscaleFramebuffers_; }
+    // Temporal resolve into swapchain image 'imageIndex' and history image 'history'
+    [[nodiscard]] vk::Framebuffer getTemporalFramebuffer(uint32_t imageIndex, uint32_t history) const {
+        return temporalFramebuffers_[imageIndex * taa::HISTORY_COUNT + history];
+    }
+    // Size of the scene color, G-buffer and depth targets: at least the swapchain extent at MAX_RENDER_SCALE,
+    // rounded up to TARGET_GRANULARITY. Frames render into the top-left part of it, see DynamicResolution.
+    [[nodiscard]] vk::Extent2D getTargetExtent() const { return targetExtent_; }
     [[nodiscard]] vk::Format getDepthFormat() const { return swapChainDepthFormat_; }
 
-    void createFramebuffers(vk::RenderPass renderPass);
+    // Input attachments of the lighting subpass: the G-buffer targets in gbuffer::TARGETS order, then a
+    // depth-only view of the depth/stencil buffer
+    [[nodiscard]] std::array<vk::ImageView, gbuffer::INPUT_COUNT> getGBufferViews() const;
+    // True when the render pass attachments got lazily allocated (tile) memory
+    [[nodiscard]] bool hasLazyAttachments() const { return lazyAttachments_; }
+    // True when the device has lazily allocated memory at all, i.e. transient attachments can stay on chip
+    [[nodiscard]] bool hasLazyMemory() const { return lazyMemory_; }
+    // Stored G-buffer: depth and the targets are kept in memory between the halves of the split main pass and
+    // depth and normals are sampled (ambient occlusion). Otherwise they are transient and never leave the
+    // pass. Takes effect with the next recreate(), which then reallocates the targets.
+    void setStoreGBuffer(bool store) { storeGBuffer_ = store; }
+    [[nodiscard]] bool getStoreGBuffer() const { return storeGBuffer_; }
+    // What the current targets were created as
+    [[nodiscard]] bool isGBufferStored() const { return gbufferStored_; }
+    // Input attachment of the visibility material subpass
+    [[nodiscard]] vk::ImageView getVisibilityView() const { return visibility_.view; }
+    // Lit output of the main pass, sampled by the upscale pass
+    [[nodiscard]] vk::ImageView getSceneColorView() const { return sceneColor_.view; }
+    // Motion vectors of the main pass and the output-sized history images, read by the temporal resolve
+    [[nodiscard]] vk::ImageView getVelocityView() const { return velocity_.view; }
+    [[nodiscard]] vk::ImageView getHistoryView(uint32_t history) const { return history_[history].view; }
+    [[nodiscard]] vk::Image getHistoryImage(uint32_t history) const { return history_[history].image; }
+
+    void createFramebuffers(const RenderPass &renderPass);
 
 private:
     VulkanContext &context_;
@@ -54,34 +116,83 @@ private:
     std::vector<vk::Image> swapChainImages_; // Changed to vk::Image
     vk::Format swapChainImageFormat_;
     vk::Extent2D swapChainExtent_;
+    vk::Extent2D framebufferSize_;
+    PresentSettings presentSettings_{};
+    vk::PresentModeKHR presentMode_ = vk::PresentModeKHR::eFifo;
+    uint32_t imageCount_ = 0;
 
     std::vector<vk::ImageView> swapChainImageViews_;
-    std::vector<vk::Framebuffer> swapChainFramebuffers_;
+    vk::Framebuffer framebuffer_;
+    vk::Framebuffer visibilityFramebuffer_;
+    std::vector<vk::Framebuffer> upscaleFramebuffers_;
+    std::vector<vk::Framebuffer> temporalFramebuffers_; // [image][history]
+    vk::Extent2D targetExtent_;
+    vk::Extent2D historyExtent_; // >= swapChainExtent_, see TemporalAA.hpp
+
+    // Depth/stencil and G-buffer: transient, only ever touched inside the main render pass (unless stored)
+    struct Attachment {
+        vk::Image image;
+        vk::DeviceMemory memory;
+        vk::ImageView view;
+    };
 
-    // Depth Resources
-    vk::Image depthImage;
-    vk::DeviceMemory depthImageMemory;
-    vk::ImageView depthImageView;
+    Attachment depth_;
+    vk::ImageView depthOnlyView_; // descriptors may only see one aspect
+    std::array<Attachment, gbuffer::TARGET_COUNT> gbufferTargets_;
+    Attachment visibility_; // only with VulkanContext::supportsVisibilityBuffer()
+    Attachment sceneColor_; // stored and sampled, so neither transient nor lazily allocated
+    Attachment velocity_; // same, at the target size
+    std::array<Attachment, taa::HISTORY_COUNT> history_; // swapchain size or larger
     vk::Format swapChainDepthFormat_;
+    bool lazyAttachments_ = false;
+    bool lazyMemory_ = false;
+    bool storeGBuffer_ = false; // requested, see setStoreGBuffer()
+    bool gbufferStored_ = false; // current targets
+
+    // Everything one recreate() replaces, destroyed together once no frame in flight uses it
+    struct Retired {
+        vk::SwapchainKHR swapChain;
+        std::vector<vk::ImageView> views;
+        std::vector<vk::Framebuffer> framebuffers;
+        std::vector<Attachment> attachments;
+    };
 
     void init() {
-        createSwapChain();
+        createSwapChain(nullptr);
         createImageViews();
-        createDepthResources();
+        createTargets();
+        createHistory();
     }
 
+    // Initial setStoreGBuffer(): stored with engine::SSAO, unless the device has lazily allocated memory
+    void chooseGBufferStorage();
     void createImageViews();
-    void createSwapChain();
-    void createDepthResources();
+    void createSwapChain(vk::SwapchainKHR oldSwapChain);
+    // Size-dependent images: the main pass targets at targetExtent_, the history at historyExtent_
+    void createTargets();
+    void createHistory();
+    void createTargetFramebuffers(const RenderPass &renderPass);
+    void createOutputFramebuffers(const RenderPass &renderPass);
+    // Move the handles into 'retired' and leave null ones behind
+    void retireOutputs(Retired &retired);
+    void retireTargets(Retired &retired);
+    void retireHistory(Retired &retired);
+    void destroy(Retired &retired) const;
+    // 'stored': kept in memory between render passes instead (setStoreGBuffer), so neither transient nor lazy
+    Attachment createTransientAttachment(vk::Format format, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect,
+                                         bool stored);
+    Attachment createSampledAttachment(vk::Extent2D extent, vk::Format format);
+    void destroyAttachment(Attachment &attachment) const;
 
     vk::ImageView createImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspectFlags) const;
 
     vk::Extent2D chooseSwapExtent(const vk::SurfaceCapabilitiesKHR &capabilities) const;
 
-    // Helper for depth image creation
+    // Helper for attachment image creation; 'properties' is tried first, 'fallback' if no type has it
     void createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling,
                      vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties,
-                     vk::Image &image, vk::DeviceMemory &imageMemory) const;
+                     vk::MemoryPropertyFlags fallback, vk::Image &image, vk::DeviceMemory &imageMemory,
+                     bool &usedPreferred) const;
 
     vk::Format findDepthFormat();
 };
\ No newline at end of file
@@ -0,0 +1,143 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+// DescriptorLayoutCache and DescriptorAllocator against a real device, created headless (no window,
+// no swapchain). Skipped (exit code 77) where no Vulkan device is available.
+
+#include <array>
+#include <cstdio>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "vulkan/DescriptorAllocator.hpp"
+#include "vulkan/DescriptorLayoutCache.hpp"
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+namespace {
+constexpr int SKIPPED = 77;
+
+int failures = 0;
+
+void check(bool condition, const char *what) {
+    if (!condition) {
+        std::fprintf(stderr, "-- FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+vk::DescriptorSetLayoutBinding binding(uint32_t index, vk::DescriptorType type, uint32_t count,
+                                       vk::ShaderStageFlags stages) {
+    return vk::DescriptorSetLayoutBinding()
+           .setBinding(index)
+           .setDescriptorType(type)
+           .setDescriptorCount(count)
+           .setStageFlags(stages);
+}
+
+vk::DescriptorSetLayout testLayoutCache(DescriptorLayoutCache &cache) {
+    const std::vector<vk::DescriptorSetLayoutBinding> bindings = {
+        binding(0, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex),
+        binding(1, vk::DescriptorType::eCombinedImageSampler, 4, vk::ShaderStageFlagBits::eFragment),
+    };
+    const std::vector<vk::DescriptorSetLayoutBinding> reordered = {bindings[1], bindings[0]};
+    std::vector<vk::DescriptorSetLayoutBinding> otherStages = bindings;
+    otherStages[1].setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    const auto layout = cache.get(vk::DescriptorSetLayoutCreateInfo().setBindings(bindings));
+    check(cache.get(vk::DescriptorSetLayoutCreateInfo().setBindings(bindings)) == layout,
+          "the same bindings return the cached layout");
+    check(cache.get(vk::DescriptorSetLayoutCreateInfo().setBindings(reordered)) == layout,
+          "the binding order does not matter");
+    check(cache.get(vk::DescriptorSetLayoutCreateInfo().setBindings(otherStages)) != layout,
+          "different stages get a layout of their own");
+    check(cache.size() == 2, "one layout per distinct set of bindings");
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo flags;
+    bool threw = false;
+    try {
+        (void)cache.get(vk::DescriptorSetLayoutCreateInfo().setBindings(bindings).setPNext(&flags));
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    check(threw, "create infos with a pNext chain are rejected");
+    return layout;
+}
+
+void testAllocator(vk::Device device, vk::DescriptorSetLayout layout) {
+    constexpr uint32_t frameCount = 2;
+    DescriptorAllocator allocator(device, frameCount,
+                                  {{vk::DescriptorType::eUniformBufferDynamic, 1.0f},
+                                   {vk::DescriptorType::eCombinedImageSampler, 4.0f}},
+                                  4);
+
+    // Far more sets than the first pool holds in frame 0, a few in frame 1. After the first round every
+    // pool is reset and reused: the count must stay where it is.
+    const std::array<uint32_t, frameCount> setCounts = {200, 3};
+    uint32_t poolsAfterFirstRound = 0;
+    bool allocated = true;
+    bool stable = true;
+    for (int round = 0; round < 4; round++) {
+        for (uint32_t frame = 0; frame < frameCount; frame++) {
+            allocator.beginFrame(frame);
+            std::set<VkDescriptorSet> sets;
+            for (uint32_t i = 0; i < setCounts[frame]; i++) {
+                const vk::DescriptorSet set = allocator.allocate(layout);
+                allocated &= static_cast<bool>(set) && sets.insert(static_cast<VkDescriptorSet>(set)).second;
+            }
+        }
+        if (round == 0)
+            poolsAfterFirstRound = allocator.getPoolCount();
+        else
+            stable &= allocator.getPoolCount() == poolsAfterFirstRound;
+    }
+    check(allocated, "every allocation returns a distinct set");
+    check(poolsAfterFirstRound >= frameCount, "every frame in flight has pools of its own");
+    check(stable, "resetting a frame reuses its pools instead of creating new ones");
+    std::printf("-- Descriptor allocator: %u pools for %u + %u sets per frame\n", poolsAfterFirstRound,
+                setCounts[0], setCounts[1]);
+}
+}
+
+int main() {
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
+
+    vk::Instance instance;
+    std::vector<vk::PhysicalDevice> physicalDevices;
+    try {
+        const vk::ApplicationInfo appInfo("descriptor_test", 1, "No Engine", 1, VK_API_VERSION_1_3);
+        instance = vk::createInstance(vk::InstanceCreateInfo().setPApplicationInfo(&appInfo));
+        VULKAN_HPP_DEFAULT_DISPATCHER.init(instance);
+        physicalDevices = instance.enumeratePhysicalDevices();
+    } catch (const vk::SystemError &e) {
+        std::printf("-- Descriptor test skipped: %s\n", e.what());
+        if (instance)
+            instance.destroy();
+        return SKIPPED;
+    }
+    if (physicalDevices.empty()) {
+        std::printf("-- Descriptor test skipped: no Vulkan device\n");
+        instance.destroy();
+        return SKIPPED;
+    }
+
+    // Any queue will do; nothing is submitted
+    const float priority = 1.0f;
+    const auto queueInfo = vk::DeviceQueueCreateInfo().setQueueFamilyIndex(0).setQueuePriorities(priority);
+    const vk::Device device = physicalDevices[0].createDevice(vk::DeviceCreateInfo().setQueueCreateInfos(queueInfo));
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(device);
+    {
+        DescriptorLayoutCache cache(device);
+        const auto layout = testLayoutCache(cache);
+        testAllocator(device, layout);
+    }
+    device.destroy();
+    instance.destroy();
+
+    if (failures == 0)
+        std::printf("-- Descriptors: all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
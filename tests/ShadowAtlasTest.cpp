@@ -0,0 +1,171 @@
+//
+// Created by johnny on 10/18/26.
+//
+
+// Atlas packing and shadow scheduling on the CPU, with the engine's atlas configuration.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "common/config.hpp"
+#include "renderer/ShadowAtlas.hpp"
+#include "renderer/ShadowScheduler.hpp"
+
+namespace {
+int failures = 0;
+
+void check(bool condition, const char *what) {
+    if (!condition) {
+        std::fprintf(stderr, "-- FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+bool overlaps(const ShadowAtlas::Tile &a, const ShadowAtlas::Tile &b) {
+    return a.x < b.x + b.size && b.x < a.x + a.size && a.y < b.y + b.size && b.y < a.y + a.size;
+}
+
+ShadowAtlas makeAtlas() {
+    return ShadowAtlas(engine::SHADOW_ATLAS_SIZE, engine::SHADOW_ATLAS_MIN_TILE);
+}
+
+void testAllocateFree() {
+    ShadowAtlas atlas = makeAtlas();
+    const uint32_t tileSize = engine::SHADOW_ATLAS_MAX_TILE;
+    const uint32_t capacity = (engine::SHADOW_ATLAS_SIZE / tileSize) * (engine::SHADOW_ATLAS_SIZE / tileSize);
+
+    std::vector<ShadowAtlas::Tile> tiles;
+    for (uint32_t i = 0; i < capacity; i++) {
+        const auto tile = atlas.allocate(tileSize);
+        check(tile.has_value() && tile->size == tileSize, "a full-size tile fits while the atlas has room");
+        if (tile)
+            tiles.push_back(*tile);
+    }
+    check(!atlas.allocate(engine::SHADOW_ATLAS_MIN_TILE), "a full atlas refuses even the smallest tile");
+    check(atlas.getLargestFreeTile() == 0, "a full atlas has no free tile");
+
+    bool disjoint = true;
+    for (size_t a = 0; a < tiles.size(); a++) {
+        for (size_t b = a + 1; b < tiles.size(); b++)
+            disjoint &= !overlaps(tiles[a], tiles[b]);
+        disjoint &= tiles[a].x + tiles[a].size <= atlas.getSize() && tiles[a].y + tiles[a].size <= atlas.getSize();
+    }
+    check(disjoint, "tiles lie inside the atlas and never overlap");
+
+    // A freed tile is reused at its own size, and split for smaller ones
+    atlas.free(tiles.back());
+    const auto small = atlas.allocate(engine::SHADOW_ATLAS_MIN_TILE);
+    check(small && overlaps(*small, tiles.back()), "a smaller tile is split out of the freed one");
+    check(atlas.getLargestFreeTile() == tileSize / 2, "the rest of the split tile stays available");
+    atlas.free(*small);
+    check(atlas.getLargestFreeTile() == tileSize, "freeing the small tile merges the split back");
+
+    tiles.pop_back();
+    for (const auto &tile : tiles)
+        atlas.free(tile);
+    check(atlas.getAllocatedTexels() == 0, "nothing is allocated once everything is freed");
+    check(atlas.getLargestFreeTile() == atlas.getSize(), "free siblings merge all the way up to the whole atlas");
+    check(atlas.allocate(atlas.getSize()).has_value(), "the whole atlas can be allocated again");
+}
+
+void testRounding() {
+    ShadowAtlas atlas = makeAtlas();
+    const auto tiny = atlas.allocate(1);
+    check(tiny && tiny->size == engine::SHADOW_ATLAS_MIN_TILE, "requests below the minimum get the minimum tile");
+    const auto odd = atlas.allocate(300);
+    check(odd && odd->size == 512, "requests round up to a power of two");
+}
+
+void testPartialMerge() {
+    ShadowAtlas atlas = makeAtlas();
+    const uint32_t quarter = atlas.getSize() / 2;
+    std::vector<ShadowAtlas::Tile> siblings;
+    for (int i = 0; i < 4; i++)
+        siblings.push_back(*atlas.allocate(quarter));
+    for (int i = 0; i < 3; i++)
+        atlas.free(siblings[i]);
+    check(atlas.getLargestFreeTile() == quarter, "three free siblings do not merge while the fourth is in use");
+    atlas.free(siblings[3]);
+    check(atlas.getLargestFreeTile() == atlas.getSize(), "the fourth sibling completes the merge");
+}
+
+ShadowScheduler makeScheduler(ShadowAtlas &atlas) {
+    return ShadowScheduler(atlas, engine::SHADOW_ATLAS_MAX_TILE, engine::SHADOW_ATLAS_UPDATE_BUDGET);
+}
+
+// Runs frames until no light is due; false if that takes unreasonably long
+bool settle(ShadowScheduler &scheduler, std::vector<ShadowScheduler::Request> &requests) {
+    for (int frame = 0; frame < 64; frame++) {
+        const bool idle = scheduler.schedule(requests).empty();
+        for (auto &request : requests)
+            request.dirty = false;
+        if (idle)
+            return true;
+    }
+    return false;
+}
+
+void testSteadyStateWhenFull() {
+    ShadowAtlas atlas = makeAtlas();
+    ShadowScheduler scheduler = makeScheduler(atlas);
+
+    // Fifteen full-size spot lights and one at half coverage leave room for one half-size tile
+    std::vector<ShadowScheduler::Request> requests(16, {1.0f, 1, false});
+    requests[0].importance = 0.5f;
+    check(settle(scheduler, requests), "the initial lights all get rendered");
+
+    // A seventeenth full-size light only fits at half size
+    requests.push_back({1.0f, 1, false});
+    check(settle(scheduler, requests), "the lights settle after a light is added");
+    const auto &added = scheduler.getState(16);
+    check(added.viewCount == 1 && added.tileSize == engine::SHADOW_ATLAS_MAX_TILE / 2,
+          "the added light falls back to the free half-size tile");
+
+    // Nothing changes from here on: no light may be re-placed or re-rendered
+    const ShadowAtlas::Tile tile = added.tiles[0];
+    bool stable = true;
+    for (int frame = 0; frame < 8; frame++) {
+        stable &= scheduler.schedule(requests).empty();
+        stable &= scheduler.getState(16).tiles[0] == tile && scheduler.getState(16).valid;
+    }
+    check(stable, "a light that cannot grow keeps its tile and is not re-rendered");
+
+    // Once a full-size tile frees up it grows, and is rendered once at the new size
+    requests[1].importance = 0.0f;
+    const auto &scheduled = scheduler.schedule(requests);
+    check(scheduler.getState(16).tileSize == engine::SHADOW_ATLAS_MAX_TILE, "the light grows when space frees up");
+    check(std::find(scheduled.begin(), scheduled.end(), 16u) != scheduled.end(), "the grown light is re-rendered");
+    check(settle(scheduler, requests), "the lights settle after the growth");
+}
+
+void testBudget() {
+    ShadowAtlas atlas = makeAtlas();
+    ShadowScheduler scheduler = makeScheduler(atlas);
+
+    const uint64_t tileTexels = uint64_t(engine::SHADOW_ATLAS_MAX_TILE) * engine::SHADOW_ATLAS_MAX_TILE;
+    const auto perFrame = static_cast<size_t>(std::max<uint64_t>(1, engine::SHADOW_ATLAS_UPDATE_BUDGET / tileTexels));
+    std::vector<ShadowScheduler::Request> requests(8, {1.0f, 1, false});
+    const auto &first = scheduler.schedule(requests);
+    check(first.size() == perFrame, "new lights are rendered within the texel budget");
+    check(scheduler.getScheduledTexels() <= std::max(scheduler.getTexelBudget(), tileTexels),
+          "the scheduled texels stay within the budget");
+    check(settle(scheduler, requests), "the remaining lights follow in later frames");
+
+    // Only the flagged light is due
+    requests[5].dirty = true;
+    const auto &next = scheduler.schedule(requests);
+    check(next.size() == 1 && next[0] == 5, "only the light whose casters changed is re-rendered");
+}
+}
+
+int main() {
+    testAllocateFree();
+    testRounding();
+    testPartialMerge();
+    testSteadyStateWhenFull();
+    testBudget();
+    if (failures == 0)
+        std::printf("-- Shadow atlas: all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}